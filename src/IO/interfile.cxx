@@ -42,6 +42,7 @@
 #include "stir/CartesianCoordinate3D.h"
 #include "stir/VoxelsOnCartesianGrid.h"
 #include "stir/ProjDataFromStream.h"
+#include "stir/ProjDataFromMappedFile.h"
 #include "stir/ProjDataInfoCylindricalArcCorr.h"
 #include "stir/Scanner.h"
 #include "stir/Succeeded.h"
@@ -54,6 +55,7 @@
 #include <boost/format.hpp>
 #include <fstream>
 #include <algorithm>
+#include <cstdlib>
 
 #ifndef STIR_NO_NAMESPACES
 using std::cerr;
@@ -71,6 +73,18 @@ using std::ios;
 
 START_NAMESPACE_STIR
 
+// anonymous namespace for local functions
+namespace {
+  // memory-mapping of read-only projection data is enabled by setting
+  // the environment variable STIR_MMAP_PROJDATA to a non-zero value
+  bool
+  use_memory_mapped_proj_data()
+  {
+    const char * const value = std::getenv("STIR_MMAP_PROJDATA");
+    return value != 0 && std::atoi(value) != 0;
+  }
+}
+
 bool 
 is_interfile_signature(const char * const signature)
 {
@@ -578,6 +592,21 @@ read_interfile_PDFS_SPECT(istream& input,
        return 0;
      }
 
+   if (open_mode == ios::in && use_memory_mapped_proj_data())
+     {
+       // read-only access, so we can use a memory-mapped file
+       return new ProjDataFromMappedFile(hdr.get_exam_info_sptr(), 
+                                         hdr.data_info_sptr,
+                                         data_in,
+                                         full_data_file_name,
+                                         hdr.data_offset_each_dataset[0],
+                                         segment_sequence,
+                                         hdr.storage_order,
+                                         hdr.type_of_numbers,
+                                         hdr.file_byte_order,
+                                         static_cast<float>(hdr.image_scaling_factors[0][0]));
+     }
+
    return new ProjDataFromStream(hdr.get_exam_info_sptr(), 
 				 hdr.data_info_sptr,
 				 data_in,
@@ -648,6 +677,21 @@ read_interfile_PDFS(istream& input,
        return 0;
      }
 
+   if (open_mode == ios::in && use_memory_mapped_proj_data())
+     {
+       // read-only access, so we can use a memory-mapped file
+       return new ProjDataFromMappedFile(hdr.get_exam_info_sptr(),
+                                         hdr.data_info_ptr->create_shared_clone(),
+                                         data_in,
+                                         full_data_file_name,
+                                         hdr.data_offset_each_dataset[0],
+                                         hdr.segment_sequence,
+                                         hdr.storage_order,
+                                         hdr.type_of_numbers,
+                                         hdr.file_byte_order,
+                                         static_cast<float>(hdr.image_scaling_factors[0][0]));
+     }
+
    return new ProjDataFromStream(hdr.get_exam_info_sptr(),
 				 hdr.data_info_ptr->create_shared_clone(),
 				 data_in,
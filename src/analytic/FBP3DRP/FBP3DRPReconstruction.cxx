@@ -98,6 +98,10 @@
 #include "stir/recon_buildblock/BackProjectorByBinUsingInterpolation.h"
 #include "stir/recon_buildblock/ForwardProjectorByBinUsingRayTracing.h"
 #include "stir/IO/read_from_file.h"
+#include "stir/num_threads.h"
+#ifdef STIR_OPENMP
+#include <omp.h>
+#endif
 //#include "stir/mash_views.h"
 
 #include <algorithm>
@@ -105,6 +109,7 @@
 #include <iostream>
 #include <numeric>
 #include <string> 
+#include <vector>
 // for asctime()
 #include <ctime>
 
@@ -659,70 +664,114 @@ void FBP3DRPReconstruction::do_3D_Reconstruction(
   shared_ptr<DataSymmetriesForViewSegmentNumbers> symmetries_sptr(
 								  back_projector_sptr->get_symmetries_used()->clone());
 
+  set_num_threads();
+#ifdef STIR_OPENMP
+  // images for the threads other than the master thread (which uses image itself)
+  // they are allocated when a thread needs them, and accumulated into image after every segment
+  std::vector<shared_ptr<VoxelsOnCartesianGrid<float> > > local_image_sptrs(omp_get_max_threads());
+#endif
+
   for (int seg_num= -max_segment_num_to_process; seg_num <= max_segment_num_to_process; seg_num++) 
   {
-
-    // a bool value that will be used to determine if we are starting processing for this segment
-    bool first_view_in_segment = true;
-        
-    const int orig_min_axial_pos_num = proj_data_ptr->get_min_axial_pos_num(seg_num);
-    const int orig_max_axial_pos_num = proj_data_ptr->get_max_axial_pos_num(seg_num);
-            
+    std::vector<ViewSegmentNumbers> vs_nums_to_process;
     for (int view_num=proj_data_ptr->get_min_view_num(); view_num <= proj_data_ptr->get_max_view_num(); ++view_num) {         
       const ViewSegmentNumbers vs_num(view_num, seg_num);
-      if (!symmetries_sptr->is_basic(vs_num))
-	continue;
+      if (symmetries_sptr->is_basic(vs_num))
+	vs_nums_to_process.push_back(vs_num);
+    }
+    // some segment_nums might not need any processing because of the symmetries
+    if (vs_nums_to_process.empty())
+      continue;
 
+    const int orig_min_axial_pos_num = proj_data_ptr->get_min_axial_pos_num(seg_num);
+    const int orig_max_axial_pos_num = proj_data_ptr->get_max_axial_pos_num(seg_num);
     const int new_min_axial_pos_num = 
       proj_data_info_with_missing_data_sptr->get_min_axial_pos_num(seg_num);
     const int new_max_axial_pos_num = 
       proj_data_info_with_missing_data_sptr->get_max_axial_pos_num(seg_num);
 
-      if (first_view_in_segment)
-	{
-	  full_log << "\n--------------------------------\n";
-	  full_log << "PROCESSING SEGMENT  No " << seg_num << endl ;
+    full_log << "\n--------------------------------\n";
+    full_log << "PROCESSING SEGMENT  No " << seg_num << endl ;
 	  
-	  full_log << "Average delta= " <<  input_proj_data_info_cyl().get_average_ring_difference(seg_num)
-		   << " with span= " << input_proj_data_info_cyl().get_max_ring_difference(seg_num) - input_proj_data_info_cyl().get_min_ring_difference(seg_num) +1
-		   << " and extended axial position numbers: min= " << new_min_axial_pos_num << " and max= " << new_max_axial_pos_num  <<endl;
-	  
-	  first_view_in_segment = false;
-	}
-
-      full_log << "\n*************************************************************";
-      full_log << "\n        Processing view " << vs_num.view_num()
-	       << " of segment " << vs_num.segment_num() << endl;
-	      
-      full_log << "\n  - Getting related viewgrams"  << endl;
- 
-      RelatedViewgrams<float> viewgrams = 
-	proj_data_ptr->get_related_viewgrams(vs_num, symmetries_sptr);
-        
-      do_process_viewgrams(
-			   viewgrams,
-			   new_min_axial_pos_num, new_max_axial_pos_num, orig_min_axial_pos_num, orig_max_axial_pos_num,
-			   image);
- 
-                 
-    }    
-    // do some logging etc, but only when this segment had any processing
-    // (some segment_nums might not because of the symmetries)
-    if (!first_view_in_segment)
+    full_log << "Average delta= " <<  input_proj_data_info_cyl().get_average_ring_difference(seg_num)
+	     << " with span= " << input_proj_data_info_cyl().get_max_ring_difference(seg_num) - input_proj_data_info_cyl().get_min_ring_difference(seg_num) +1
+	     << " and extended axial position numbers: min= " << new_min_axial_pos_num << " and max= " << new_max_axial_pos_num  <<endl;
+
+    // the Colsher filter is the same for all views in this segment, so set it up before
+    // the (multi-threaded) loop over the views. The sizes are those of the viewgrams after
+    // arc-correction and do_grow3D_viewgram.
+    do_colsher_filter_set_up(seg_num,
+			     max(new_max_axial_pos_num, orig_max_axial_pos_num) -
+			     min(new_min_axial_pos_num, orig_min_axial_pos_num) + 1,
+			     proj_data_info_with_missing_data_sptr->get_num_tangential_poss());
+
+#ifdef STIR_OPENMP
+#pragma omp parallel for shared(vs_nums_to_process, local_image_sptrs, symmetries_sptr) schedule(dynamic)
+#endif
+    // note: older versions of openmp need an int as loop
+    for (int i=0; i<static_cast<int>(vs_nums_to_process.size()); ++i)
       {
-	full_log << "\n*************************************************************";
-	full_log << "\nEnd of this segment. Current image values:\n"
-		 << "Min= " << image.find_min()
-		 << " Max = " << image.find_max()
-		 << " Sum = " << image.sum() << endl;
-#ifndef PARALLEL
-	if(save_intermediate_files){ 
-	  char *file = new char[output_filename_prefix.size() + 20];
-	  sprintf(file,"%s_afterseg%d",output_filename_prefix.c_str(),seg_num);
-	  do_save_img(file, image);        
-	  delete[] file;
+	const ViewSegmentNumbers vs_num = vs_nums_to_process[i];
+#ifdef STIR_OPENMP
+#pragma omp critical(FBP3DRP_LOG)
+#endif
+	{
+	  full_log << "\n*************************************************************";
+	  full_log << "\n        Processing view " << vs_num.view_num()
+		   << " of segment " << vs_num.segment_num() << endl;
+	      
+	  full_log << "\n  - Getting related viewgrams"  << endl;
 	}
+ 
+	RelatedViewgrams<float> viewgrams;
+#ifdef STIR_OPENMP
+	if (proj_data_ptr->is_thread_safe_for_reading())
+	  viewgrams = proj_data_ptr->get_related_viewgrams(vs_num, symmetries_sptr);
+	else
+	  {
+#pragma omp critical(FBP3DRP_GET_VIEWGRAMS)
+	    viewgrams = proj_data_ptr->get_related_viewgrams(vs_num, symmetries_sptr);
+	  }
+
+	const int thread_num = omp_get_thread_num();
+	if (thread_num != 0 && is_null_ptr(local_image_sptrs[thread_num]))
+	  local_image_sptrs[thread_num].reset(image.get_empty_voxels_on_cartesian_grid());
+	VoxelsOnCartesianGrid<float>& thread_image =
+	  thread_num == 0 ? image : *local_image_sptrs[thread_num];
+#else
+	viewgrams = proj_data_ptr->get_related_viewgrams(vs_num, symmetries_sptr);
+	VoxelsOnCartesianGrid<float>& thread_image = image;
+#endif
+
+	do_process_viewgrams(
+			     viewgrams,
+			     new_min_axial_pos_num, new_max_axial_pos_num, orig_min_axial_pos_num, orig_max_axial_pos_num,
+			     thread_image);
       }
+
+#ifdef STIR_OPENMP
+    // "reduce" the images constructed by the threads
+    for (int i=1; i<static_cast<int>(local_image_sptrs.size()); ++i)
+      if (!is_null_ptr(local_image_sptrs[i]))
+	{
+	  image += *local_image_sptrs[i];
+	  local_image_sptrs[i]->fill(0);
+	}
+#endif
+
+    // do some logging etc
+    full_log << "\n*************************************************************";
+    full_log << "\nEnd of this segment. Current image values:\n"
+	     << "Min= " << image.find_min()
+	     << " Max = " << image.find_max()
+	     << " Sum = " << image.sum() << endl;
+#ifndef PARALLEL
+    if(save_intermediate_files){ 
+      char *file = new char[output_filename_prefix.size() + 20];
+      sprintf(file,"%s_afterseg%d",output_filename_prefix.c_str(),seg_num);
+      do_save_img(file, image);        
+      delete[] file;
+    }
 #endif 
   }
   // Normalise the image
@@ -738,7 +787,6 @@ void FBP3DRPReconstruction::do_3D_Reconstruction(
 
 }
 
-
 // CL 010699 NEW function
 void FBP3DRPReconstruction::do_best_fit(const Sinogram<float> &sino_measured,const Sinogram<float> &sino_calculated)
 {
@@ -810,6 +858,9 @@ void FBP3DRPReconstruction::do_forward_project_view(RelatedViewgrams<float> & vi
   // do not forward project if we don't need to...
   if (new_min_axial_pos_num <= orig_min_axial_pos_num-1)
     {
+#ifdef STIR_OPENMP
+#pragma omp critical(FBP3DRP_LOG)
+#endif
       full_log << "  - Forward projection of missing data first from ring No " 
 	       << new_min_axial_pos_num
 	       << " to "
@@ -822,6 +873,9 @@ void FBP3DRPReconstruction::do_forward_project_view(RelatedViewgrams<float> & vi
 
   if (orig_max_axial_pos_num+1 <= new_max_axial_pos_num)
     {
+#ifdef STIR_OPENMP
+#pragma omp critical(FBP3DRP_LOG)
+#endif
       full_log << "  - Forward projection from ring No "
 	       << orig_max_axial_pos_num+1
 	       << " to " << new_max_axial_pos_num << endl;
@@ -847,66 +901,71 @@ void FBP3DRPReconstruction::do_forward_project_view(RelatedViewgrams<float> & vi
 #endif
 
   if(display_level>2) {
+#ifdef STIR_OPENMP
+#pragma omp critical(FBP3DRP_DISPLAY)
+#endif
     display( viewgrams,viewgrams.find_max(),"Original+Forward projected");
   }
 }
                     
 	
-void FBP3DRPReconstruction::do_colsher_filter_view( RelatedViewgrams<float> & viewgrams)
-{ 
-
-  assert(dynamic_cast<ProjDataInfoCylindricalArcCorr const *>
-	 (viewgrams.get_proj_data_info_ptr()));
-
-  // TODO make into object member instead of static
-  static int prev_seg_num = viewgrams.get_proj_data_info_ptr()->get_min_segment_num()-1;  
 #ifdef NRFFT
-  static ColsherFilter colsher_filter(0,0,0,0,0,0,0,0,0,0);
+static ColsherFilter colsher_filter(0,0,0,0,0,0,0,0,0,0);
 #endif
-  const int seg_num = viewgrams.get_basic_segment_num();
 
-  if (prev_seg_num != seg_num)
-  {
-    prev_seg_num = seg_num;
-    full_log << "  - Constructing Colsher filter for this segment\n";
-    const int nrings = viewgrams.get_num_axial_poss(); 
-    const int nprojs = viewgrams.get_num_tangential_poss();
+void FBP3DRPReconstruction::do_colsher_filter_set_up(const int seg_num,
+						     const int num_axial_poss,
+						     const int num_tangential_poss)
+{ 
+  full_log << "  - Constructing Colsher filter for this segment\n";
     
-    const int width = (int) pow(2., ((int) ceil(log((PadS + 1.) * nprojs) / log(2.))));
-    const int height = (int) pow(2., ((int) ceil(log((PadZ + 1.) * nrings) / log(2.))));	
+  const int width = (int) pow(2., ((int) ceil(log((PadS + 1.) * num_tangential_poss) / log(2.))));
+  const int height = (int) pow(2., ((int) ceil(log((PadZ + 1.) * num_axial_poss) / log(2.))));	
     
+  const ProjDataInfo& proj_data_info = *proj_data_info_with_missing_data_sptr;
     
-    const float theta_max = atan(viewgrams.get_proj_data_info_ptr()->get_tantheta(Bin(max_segment_num_to_process,0,0,0)));
+  const float theta_max = atan(proj_data_info.get_tantheta(Bin(max_segment_num_to_process,0,0,0)));
     
-    const float theta = 
-      static_cast<float>(atan(viewgrams.get_proj_data_info_ptr()->get_tantheta(Bin(seg_num,0,0,0))));
+  const float theta = 
+    static_cast<float>(atan(proj_data_info.get_tantheta(Bin(seg_num,0,0,0))));
     
-    const float sampling_in_s =
-      viewgrams.get_proj_data_info_ptr()->get_sampling_in_s(Bin(seg_num,0,0,0));
-    const float sampling_in_t =
-      viewgrams.get_proj_data_info_ptr()->get_sampling_in_t(Bin(seg_num,0,0,0));
-    full_log << "Colsher filter theta_max = " << theta_max << " theta = " << theta
-      << " d_a = " << sampling_in_s
-	     << " d_b = " << sampling_in_t << endl;
+  const float sampling_in_s =
+    proj_data_info.get_sampling_in_s(Bin(seg_num,0,0,0));
+  const float sampling_in_t =
+    proj_data_info.get_sampling_in_t(Bin(seg_num,0,0,0));
+  full_log << "Colsher filter theta_max = " << theta_max << " theta = " << theta
+	   << " d_a = " << sampling_in_s
+	   << " d_b = " << sampling_in_t << endl;
     
     
 #ifdef NRFFT
-    colsher_filter = 
-      ColsherFilter(height, width, _PI/2 - theta, theta_max, 
-                    sampling_in_s, 
-                    sampling_in_t,
-                    alpha_colsher_axial, fc_colsher_axial,
-                    alpha_colsher_planar, fc_colsher_planar);
+  colsher_filter = 
+    ColsherFilter(height, width, _PI/2 - theta, theta_max, 
+		  sampling_in_s, 
+		  sampling_in_t,
+		  alpha_colsher_axial, fc_colsher_axial,
+		  alpha_colsher_planar, fc_colsher_planar);
 #else
-    if (colsher_filter.set_up(height, width, 
-			      theta, 
-			      sampling_in_s, 
-			      sampling_in_t)
-	!= Succeeded::yes)
-      error("Exiting");
+  if (colsher_filter.set_up(height, width, 
+			    theta, 
+			    sampling_in_s, 
+			    sampling_in_t)
+      != Succeeded::yes)
+    error("Exiting");
 #endif
-  }
+}
+
+void FBP3DRPReconstruction::do_colsher_filter_view( RelatedViewgrams<float> & viewgrams)
+{ 
 
+  assert(dynamic_cast<ProjDataInfoCylindricalArcCorr const *>
+	 (viewgrams.get_proj_data_info_ptr()));
+
+  const int seg_num = viewgrams.get_basic_segment_num();
+
+#ifdef STIR_OPENMP
+#pragma omp critical(FBP3DRP_LOG)
+#endif
   full_log << "  - Apply Colsher filter to complete oblique sinograms" << endl;
 #ifdef NRFFT
 
@@ -941,6 +1000,9 @@ void FBP3DRPReconstruction::do_colsher_filter_view( RelatedViewgrams<float> & vi
 	const int num_ring_differences = 
 	  input_proj_data_info_cyl().get_max_ring_difference(seg_num) - 
 	  input_proj_data_info_cyl().get_min_ring_difference(seg_num) + 1;
+#ifdef STIR_OPENMP
+#pragma omp critical(FBP3DRP_LOG)
+#endif
 	full_log << "  - Multiplying filtered projections by " << num_ring_differences << endl;
 	if (num_ring_differences != 1){
           viewgrams *= static_cast<float>(num_ring_differences);
@@ -948,6 +1010,9 @@ void FBP3DRPReconstruction::do_colsher_filter_view( RelatedViewgrams<float> & vi
       
       }
     if(display_level>2) {
+#ifdef STIR_OPENMP
+#pragma omp critical(FBP3DRP_DISPLAY)
+#endif
       display( viewgrams,viewgrams.find_max(), "Colsher filtered");
     }
 }
@@ -957,6 +1022,9 @@ void FBP3DRPReconstruction::do_3D_backprojection_view(const RelatedViewgrams<flo
                                                         VoxelsOnCartesianGrid<float> &image,
                                                         int new_min_axial_pos_num, int new_max_axial_pos_num)
 { 
+#ifdef STIR_OPENMP
+#pragma omp critical(FBP3DRP_LOG)
+#endif
     full_log << "  - Backproject the filtered Colsher complete sinograms" << endl;
 
     back_projector_sptr->back_project(image, viewgrams,new_min_axial_pos_num, new_max_axial_pos_num);
@@ -29,8 +29,13 @@
 #include "stir/display.h"
 #include "stir/SegmentBySinogram.h"
 #include "stir/stream.h"
+#include "stir/is_null_ptr.h"
 
 #include <algorithm>
+#include <vector>
+#ifdef STIR_OPENMP
+#include <omp.h>
+#endif
 using std::min;
 using std::max;
 
@@ -764,15 +769,21 @@ void make_fan_data(FanProjData& fan_data,
   fan_data = FanProjData(num_rings, num_detectors_per_ring, max_delta, 2*half_fan_size+1);
 
   shared_ptr<SegmentBySinogram<float> > segment_ptr;      
-  Bin bin;
 
-  for (bin.segment_num() = proj_data.get_min_segment_num(); bin.segment_num() <= proj_data.get_max_segment_num();  ++ bin.segment_num())
+  // Segments are read one at a time. Different bins correspond to different detector pairs,
+  // so the sinograms of a segment can be handled in parallel.
+  for (int segment_num = proj_data.get_min_segment_num(); segment_num <= proj_data.get_max_segment_num();  ++segment_num)
   {
-    segment_ptr.reset(new SegmentBySinogram<float>(proj_data.get_segment_by_sinogram(bin.segment_num())));
+    segment_ptr.reset(new SegmentBySinogram<float>(proj_data.get_segment_by_sinogram(segment_num)));
     
-    for (bin.axial_pos_num() = proj_data.get_min_axial_pos_num(bin.segment_num());
-	 bin.axial_pos_num() <= proj_data.get_max_axial_pos_num(bin.segment_num());
-	 ++bin.axial_pos_num())
+#ifdef STIR_OPENMP
+#pragma omp parallel for schedule(dynamic) shared(fan_data, segment_ptr, proj_data_info_ptr)
+#endif
+    for (int axial_pos_num = proj_data.get_min_axial_pos_num(segment_num);
+	 axial_pos_num <= proj_data.get_max_axial_pos_num(segment_num);
+	 ++axial_pos_num)
+    {
+      Bin bin(segment_num, 0, axial_pos_num, 0);
        for (bin.view_num() = 0; bin.view_num() < num_detectors_per_ring/2; bin.view_num()++)
           for (bin.tangential_pos_num() = -half_fan_size;
 	       bin.tangential_pos_num() <= half_fan_size;
@@ -787,6 +798,7 @@ void make_fan_data(FanProjData& fan_data,
 	      fan_data(rb, b, ra, a) =
               (*segment_ptr)[bin.axial_pos_num()][bin.view_num()][bin.tangential_pos_num()];
           }
+    }
   }
 }
 
@@ -845,6 +857,11 @@ void apply_block_norm(FanProjData& fan_data, const BlockData3D& block_data, cons
   const int num_tangential_crystals_per_block = num_tangential_detectors/num_tangential_blocks;
   assert(num_tangential_blocks * num_tangential_crystals_per_block == num_tangential_detectors);
   
+  // As we loop over rb>=ra, all elements for a given ra are stored in fan_data[ra],
+  // so different ra can be handled in parallel.
+#ifdef STIR_OPENMP
+#pragma omp parallel for schedule(dynamic) shared(fan_data, block_data)
+#endif
   for (int ra = fan_data.get_min_ra(); ra <= fan_data.get_max_ra(); ++ra)
     for (int a = fan_data.get_min_a(); a <= fan_data.get_max_a(); ++a)
       // loop rb from ra to avoid double counting
@@ -898,6 +915,10 @@ void apply_geo_norm(FanProjData& fan_data, const GeoData& geo_data, const bool a
 void apply_efficiencies(FanProjData& fan_data, const DetectorEfficiencies& efficiencies, const bool apply)
 {
   const int num_detectors_per_ring = fan_data.get_num_detectors_per_ring();
+  // see apply_block_norm
+#ifdef STIR_OPENMP
+#pragma omp parallel for schedule(dynamic) shared(fan_data, efficiencies)
+#endif
   for (int ra = fan_data.get_min_ra(); ra <= fan_data.get_max_ra(); ++ra)
     for (int a = fan_data.get_min_a(); a <= fan_data.get_max_a(); ++a)
       // loop rb from ra to avoid double counting
@@ -917,6 +938,9 @@ void apply_efficiencies(FanProjData& fan_data, const DetectorEfficiencies& effic
 
 void make_fan_sum_data(Array<2,float>& data_fan_sums, const FanProjData& fan_data)
 {
+#ifdef STIR_OPENMP
+#pragma omp parallel for schedule(dynamic) shared(data_fan_sums, fan_data)
+#endif
   for (int ra = fan_data.get_min_ra(); ra <= fan_data.get_max_ra(); ++ra)
     for (int a = fan_data.get_min_a(); a <= fan_data.get_max_a(); ++a)
       data_fan_sums[ra][a] = fan_data.sum(ra,a);
@@ -935,17 +959,39 @@ void make_fan_sum_data(Array<2,float>& data_fan_sums,
   const int half_fan_size = fan_size/2;
   data_fan_sums.fill(0);
 
+  // When using multiple threads, each thread accumulates in its own array,
+  // which are added at the end. Thread 0 uses data_fan_sums itself.
+#ifdef STIR_OPENMP
+  std::vector< shared_ptr<Array<2,float> > > local_data_fan_sums_sptrs(omp_get_max_threads());
+#endif
+
   shared_ptr<SegmentBySinogram<float> > segment_ptr;      
-  Bin bin;
 
-  for (bin.segment_num() = proj_data.get_min_segment_num(); bin.segment_num() <= proj_data.get_max_segment_num();  ++ bin.segment_num())
+  for (int segment_num = proj_data.get_min_segment_num(); segment_num <= proj_data.get_max_segment_num();  ++segment_num)
   {
-    segment_ptr.reset(new SegmentBySinogram<float>(proj_data.get_segment_by_sinogram(bin.segment_num())));
+    segment_ptr.reset(new SegmentBySinogram<float>(proj_data.get_segment_by_sinogram(segment_num)));
     
-    for (bin.axial_pos_num() = proj_data.get_min_axial_pos_num(bin.segment_num());
-	 bin.axial_pos_num() <= proj_data.get_max_axial_pos_num(bin.segment_num());
-	 ++bin.axial_pos_num())
-       for (bin.view_num() = 0; bin.view_num() < num_detectors_per_ring/2; bin.view_num()++)
+#ifdef STIR_OPENMP
+#pragma omp parallel shared(local_data_fan_sums_sptrs, data_fan_sums, segment_ptr, proj_data_info_ptr)
+#endif
+    {
+      Array<2,float> * data_fan_sums_ptr = &data_fan_sums;
+#ifdef STIR_OPENMP
+      const int thread_num=omp_get_thread_num();
+      if (thread_num!=0)
+        {
+          if (is_null_ptr(local_data_fan_sums_sptrs[thread_num]))
+            local_data_fan_sums_sptrs[thread_num].reset(new Array<2,float>(data_fan_sums.get_index_range()));
+          data_fan_sums_ptr = local_data_fan_sums_sptrs[thread_num].get();
+        }
+#pragma omp for schedule(dynamic)
+#endif
+      for (int axial_pos_num = proj_data.get_min_axial_pos_num(segment_num);
+	   axial_pos_num <= proj_data.get_max_axial_pos_num(segment_num);
+	   ++axial_pos_num)
+      {
+        Bin bin(segment_num, 0, axial_pos_num, 0);
+        for (bin.view_num() = 0; bin.view_num() < num_detectors_per_ring/2; bin.view_num()++)
           for (bin.tangential_pos_num() = -half_fan_size;
 	       bin.tangential_pos_num() <= half_fan_size;
                ++bin.tangential_pos_num())
@@ -957,10 +1003,19 @@ void make_fan_sum_data(Array<2,float>& data_fan_sums,
 
 	    const float value =            
               (*segment_ptr)[bin.axial_pos_num()][bin.view_num()][bin.tangential_pos_num()];
-	    data_fan_sums[ra][a] += value;
-	    data_fan_sums[rb][b] += value;
+	    (*data_fan_sums_ptr)[ra][a] += value;
+	    (*data_fan_sums_ptr)[rb][b] += value;
           }
+      }
+    } // end of parallel section
   }
+
+#ifdef STIR_OPENMP
+  // "reduce" the data accumulated by the threads
+  for (int i=1; i<static_cast<int>(local_data_fan_sums_sptrs.size()); ++i)
+    if (!is_null_ptr(local_data_fan_sums_sptrs[i]))
+      data_fan_sums += *local_data_fan_sums_sptrs[i];
+#endif
 }
 
 void make_fan_sum_data(Array<2,float>& data_fan_sums,
@@ -972,6 +1027,9 @@ void make_fan_sum_data(Array<2,float>& data_fan_sums,
   const int num_detectors_per_ring = 
     data_fan_sums[0].get_length();
 
+#ifdef STIR_OPENMP
+#pragma omp parallel for schedule(dynamic) shared(data_fan_sums, efficiencies)
+#endif
   for (int ra = data_fan_sums.get_min_index(); ra <= data_fan_sums.get_max_index(); ++ra)
     for (int a = data_fan_sums[ra].get_min_index(); a <= data_fan_sums[ra].get_max_index(); ++a)
       {
@@ -984,6 +1042,16 @@ void make_fan_sum_data(Array<2,float>& data_fan_sums,
 }
 
 
+// add all elements of term to sum (which needs to have the same dimensions)
+static void add_fan_data(FanProjData& sum, const FanProjData& term)
+{
+  for (int ra = sum.get_min_ra(); ra <= sum.get_max_ra(); ++ra)
+    for (int a = sum.get_min_a(); a <= sum.get_max_a(); ++a)
+      for (int rb = max(ra,sum.get_min_rb(ra)); rb <= sum.get_max_rb(ra); ++rb)
+        for (int b = sum.get_min_b(a); b <= sum.get_max_b(a); ++b)      
+          sum(ra,a,rb,b) += term(ra,a,rb,b);
+}
+
 void make_block_data(BlockData3D& block_data, const FanProjData& fan_data)
 {
   const int num_axial_detectors = fan_data.get_num_rings();
@@ -996,16 +1064,135 @@ void make_block_data(BlockData3D& block_data, const FanProjData& fan_data)
   assert(num_transaxial_blocks * num_transaxial_crystals_per_block == num_transaxial_detectors);
   
   block_data.fill(0);
+
+  // When using multiple threads, each thread accumulates in its own copy of the block data,
+  // which are added at the end. Thread 0 uses block_data itself.
+  // The copies are made from zero_block_data, as thread 0 might already be modifying block_data.
+#ifdef STIR_OPENMP
+  const BlockData3D zero_block_data(block_data);
+  std::vector< shared_ptr<BlockData3D> > local_block_data_sptrs(omp_get_max_threads());
+#pragma omp parallel shared(local_block_data_sptrs, block_data, fan_data, zero_block_data)
+#endif
+  {
+    BlockData3D * block_data_ptr = &block_data;
+#ifdef STIR_OPENMP
+    const int thread_num=omp_get_thread_num();
+    if (thread_num!=0)
+      {
+        local_block_data_sptrs[thread_num].reset(new BlockData3D(zero_block_data));
+        block_data_ptr = local_block_data_sptrs[thread_num].get();
+      }
+#pragma omp for schedule(dynamic)
+#endif
   for (int ra = fan_data.get_min_ra(); ra <= fan_data.get_max_ra(); ++ra)
     for (int a = fan_data.get_min_a(); a <= fan_data.get_max_a(); ++a)
       // loop rb from ra to avoid double counting
       for (int rb = max(ra,fan_data.get_min_rb(ra)); rb <= fan_data.get_max_rb(ra); ++rb)
         for (int b = fan_data.get_min_b(a); b <= fan_data.get_max_b(a); ++b)      
         {
-          block_data(ra/num_axial_crystals_per_block,a/num_transaxial_crystals_per_block,
-                     rb/num_axial_crystals_per_block,b/num_transaxial_crystals_per_block) +=
+          (*block_data_ptr)(ra/num_axial_crystals_per_block,a/num_transaxial_crystals_per_block,
+                            rb/num_axial_crystals_per_block,b/num_transaxial_crystals_per_block) +=
 	  fan_data(ra,a,rb,b);
         }  
+  } // end of parallel section
+
+#ifdef STIR_OPENMP
+  // "reduce" the data accumulated by the threads
+  for (int i=1; i<static_cast<int>(local_block_data_sptrs.size()); ++i)
+    if (!is_null_ptr(local_block_data_sptrs[i]))
+      add_fan_data(block_data, *local_block_data_sptrs[i]);
+#endif
+}
+
+void make_block_data(BlockData3D& block_data, const ProjData& proj_data)
+{
+  int num_rings;
+  int num_detectors_per_ring;
+  int fan_size;
+  int max_delta;
+  shared_ptr<ProjDataInfoCylindricalNoArcCorr> proj_data_info_ptr =
+    get_fan_info(num_rings, num_detectors_per_ring, max_delta, fan_size, 
+		 *proj_data.get_proj_data_info_ptr());
+  const int half_fan_size = fan_size/2;
+  const int num_axial_blocks = block_data.get_num_rings();
+  const int num_transaxial_blocks = block_data.get_num_detectors_per_ring();
+  const int num_axial_crystals_per_block = num_rings/num_axial_blocks;
+  assert(num_axial_blocks * num_axial_crystals_per_block == num_rings);
+  const int num_transaxial_crystals_per_block = num_detectors_per_ring/num_transaxial_blocks;
+  assert(num_transaxial_blocks * num_transaxial_crystals_per_block == num_detectors_per_ring);
+
+  block_data.fill(0);
+
+  // see make_block_data(BlockData3D&, const FanProjData&)
+#ifdef STIR_OPENMP
+  const BlockData3D zero_block_data(block_data);
+  std::vector< shared_ptr<BlockData3D> > local_block_data_sptrs(omp_get_max_threads());
+#endif
+
+  shared_ptr<SegmentBySinogram<float> > segment_ptr;      
+
+  for (int segment_num = proj_data.get_min_segment_num(); segment_num <= proj_data.get_max_segment_num();  ++segment_num)
+  {
+    segment_ptr.reset(new SegmentBySinogram<float>(proj_data.get_segment_by_sinogram(segment_num)));
+    
+#ifdef STIR_OPENMP
+#pragma omp parallel shared(local_block_data_sptrs, block_data, zero_block_data, segment_ptr, proj_data_info_ptr)
+#endif
+    {
+      BlockData3D * block_data_ptr = &block_data;
+#ifdef STIR_OPENMP
+      const int thread_num=omp_get_thread_num();
+      if (thread_num!=0)
+        {
+          if (is_null_ptr(local_block_data_sptrs[thread_num]))
+            local_block_data_sptrs[thread_num].reset(new BlockData3D(zero_block_data));
+          block_data_ptr = local_block_data_sptrs[thread_num].get();
+        }
+#pragma omp for schedule(dynamic)
+#endif
+      for (int axial_pos_num = proj_data.get_min_axial_pos_num(segment_num);
+	   axial_pos_num <= proj_data.get_max_axial_pos_num(segment_num);
+	   ++axial_pos_num)
+      {
+        Bin bin(segment_num, 0, axial_pos_num, 0);
+        for (bin.view_num() = 0; bin.view_num() < num_detectors_per_ring/2; bin.view_num()++)
+          for (bin.tangential_pos_num() = -half_fan_size;
+	       bin.tangential_pos_num() <= half_fan_size;
+               ++bin.tangential_pos_num())
+          {
+            int ra = 0, a = 0;
+            int rb = 0, b = 0;
+            
+            proj_data_info_ptr->get_det_pair_for_bin(a, ra, b, rb, bin);
+            // make_fan_data stores every value at (ra,a,rb,b) and (rb,b,ra,a), and 
+            // make_block_data(BlockData3D&, const FanProjData&) loops over rb>=ra.
+            // So, we need to add the value once with the smallest ring first,
+            // and twice for detector pairs in the same ring.
+            if (ra > rb)
+              {
+                std::swap(ra, rb);
+                std::swap(a, b);
+              }
+	    const float value =            
+              (*segment_ptr)[bin.axial_pos_num()][bin.view_num()][bin.tangential_pos_num()];
+            (*block_data_ptr)(ra/num_axial_crystals_per_block,a/num_transaxial_crystals_per_block,
+                              rb/num_axial_crystals_per_block,b/num_transaxial_crystals_per_block) +=
+              value;
+            if (ra == rb)
+              (*block_data_ptr)(rb/num_axial_crystals_per_block,b/num_transaxial_crystals_per_block,
+                                ra/num_axial_crystals_per_block,a/num_transaxial_crystals_per_block) +=
+                value;
+          }
+      }
+    } // end of parallel section
+  }
+
+#ifdef STIR_OPENMP
+  // "reduce" the data accumulated by the threads
+  for (int i=1; i<static_cast<int>(local_block_data_sptrs.size()); ++i)
+    if (!is_null_ptr(local_block_data_sptrs[i]))
+      add_fan_data(block_data, *local_block_data_sptrs[i]);
+#endif
 }
 
 void iterate_efficiencies(DetectorEfficiencies& efficiencies,
@@ -1026,6 +1213,11 @@ void iterate_efficiencies(DetectorEfficiencies& efficiencies,
       else
 	{
      	  float denominator = 0;
+          // Efficiencies are updated in place, i.e. later detectors use the updated values
+          // of earlier ones. We therefore only parallelise the sum over the fan.
+#ifdef STIR_OPENMP
+#pragma omp parallel for reduction(+:denominator) shared(efficiencies, model)
+#endif
            for (int rb = model.get_min_rb(ra); rb <= model.get_max_rb(ra); ++rb)
              for (int b = model.get_min_b(a); b <= model.get_max_b(a); ++b)
   	       denominator += efficiencies[rb][b%num_detectors_per_ring]*model(ra,a,rb,b);
@@ -1052,6 +1244,10 @@ void iterate_efficiencies(DetectorEfficiencies& efficiencies,
       else
 	{
      	  float denominator = 0;
+          // see the version with the model
+#ifdef STIR_OPENMP
+#pragma omp parallel for reduction(+:denominator) shared(efficiencies)
+#endif
 	  for (int rb = max(ra-max_ring_diff, 0); rb <= min(ra+max_ring_diff, num_rings-1); ++rb)
              for (int b = a+num_detectors_per_ring/2-half_fan_size; b <= a+num_detectors_per_ring/2+half_fan_size; ++b)
   	       denominator += efficiencies[rb][b%num_detectors_per_ring];
@@ -1104,6 +1300,9 @@ void iterate_block_norm(BlockData3D& norm_block_data,
 float KL(const FanProjData& d1, const FanProjData& d2, const float threshold)
 {
   double sum=0;
+#ifdef STIR_OPENMP
+#pragma omp parallel for schedule(dynamic) reduction(+:sum) shared(d1, d2)
+#endif
   for (int ra = d1.get_min_ra(); ra <= d1.get_max_ra(); ++ra)
     {
       double asum=0;
@@ -0,0 +1,248 @@
+/*!
+
+  \file
+  \ingroup projdata
+  \brief Implementation of class stir::ProjDataFromMappedFile
+
+  \author STIR contributors
+*/
+/*
+    Copyright (C) 2026, STIR contributors
+    This file is part of STIR.
+
+    This file is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.
+
+    This file is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    See STIR/LICENSE.txt for details
+*/
+
+#include "stir/ProjDataFromMappedFile.h"
+#include "stir/Viewgram.h"
+#include "stir/Sinogram.h"
+#include "stir/SegmentBySinogram.h"
+#include "stir/SegmentByView.h"
+#include "stir/IndexRange2D.h"
+#include "stir/Succeeded.h"
+#include "stir/warning.h"
+#include <boost/format.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <cstring>
+
+#ifndef STIR_NO_NAMESPACES
+using std::ios;
+using std::iostream;
+using std::streamoff;
+using std::vector;
+using std::string;
+#endif
+
+START_NAMESPACE_STIR
+
+ProjDataFromMappedFile::
+ProjDataFromMappedFile(shared_ptr<ExamInfo> const& exam_info_sptr,
+		       shared_ptr<ProjDataInfo> const& proj_data_info_ptr,
+		       shared_ptr<iostream> const& s,
+		       const string& data_filename,
+		       const streamoff offs,
+		       const vector<int>& segment_sequence_in_stream,
+		       StorageOrder o,
+		       NumericType data_type,
+		       ByteOrder byte_order,
+		       float scale_factor)
+  :
+  ProjDataFromStream(exam_info_sptr, proj_data_info_ptr,
+		     s,
+		     offs, segment_sequence_in_stream, o, data_type, byte_order, scale_factor),
+  mapped_data_ptr(0)
+{
+  // we only map when we can copy the data directly
+  if (data_type.id != NumericType::FLOAT || data_type.size_in_bytes() != sizeof(float)
+      || !byte_order.is_native_order())
+    return;
+
+  // find size that we will need
+  streamoff num_bytes_needed = offs;
+  for (int segment_num=get_min_segment_num(); segment_num<=get_max_segment_num(); ++segment_num)
+    num_bytes_needed +=
+      static_cast<streamoff>(get_num_axial_poss(segment_num)) *
+      get_num_views() * get_num_tangential_poss() * sizeof(float);
+
+  try
+    {
+      file_mapping_sptr.reset(new boost::interprocess::file_mapping(data_filename.c_str(),
+								    boost::interprocess::read_only));
+      mapped_region_sptr.reset(new boost::interprocess::mapped_region(*file_mapping_sptr,
+								      boost::interprocess::read_only));
+    }
+  catch (std::exception& e)
+    {
+      warning(boost::format("ProjDataFromMappedFile: could not map file %1% (%2%).\n"
+			    "Data will be read via a stream.")
+	      % data_filename % e.what());
+      mapped_region_sptr.reset();
+      file_mapping_sptr.reset();
+      return;
+    }
+
+  if (static_cast<streamoff>(mapped_region_sptr->get_size()) < num_bytes_needed)
+    {
+      warning(boost::format("ProjDataFromMappedFile: file %1% is too small for the projection data.\n"
+			    "Data will be read via a stream.")
+	      % data_filename);
+      mapped_region_sptr.reset();
+      file_mapping_sptr.reset();
+      return;
+    }
+
+  mapped_data_ptr = static_cast<const char *>(mapped_region_sptr->get_address());
+}
+
+bool
+ProjDataFromMappedFile::
+is_mapped() const
+{
+  return mapped_data_ptr != 0;
+}
+
+bool
+ProjDataFromMappedFile::
+is_thread_safe_for_reading() const
+{
+  return is_mapped();
+}
+
+void
+ProjDataFromMappedFile::
+read_rows(Array<2,float>& rows,
+	  const streamoff start_offset, const streamoff intra_rows_offset) const
+{
+  const std::size_t row_size = get_num_tangential_poss() * sizeof(float);
+  const char * current_ptr = mapped_data_ptr + start_offset;
+  for (int i=rows.get_min_index(); i<=rows.get_max_index(); ++i)
+    {
+      // use memcpy as the data in the file are not necessarily aligned
+      std::memcpy(&rows[i][rows[i].get_min_index()], current_ptr, row_size);
+      current_ptr += row_size + intra_rows_offset;
+    }
+  if (get_scale_factor() != 1)
+    rows *= get_scale_factor();
+}
+
+Viewgram<float>
+ProjDataFromMappedFile::
+get_viewgram(const int view_num, const int segment_num,
+	     const bool make_num_tangential_poss_odd) const
+{
+  if (!is_mapped())
+    return ProjDataFromStream::get_viewgram(view_num, segment_num, make_num_tangential_poss_odd);
+
+  const vector<streamoff> offsets = get_offsets(view_num,segment_num);
+
+  Viewgram<float> viewgram(proj_data_info_ptr, view_num, segment_num);
+  read_rows(viewgram, offsets[0] + offsets[1], offsets[2]);
+
+  if (make_num_tangential_poss_odd &&(get_num_tangential_poss()%2==0))
+  {
+    const int new_max_tangential_pos = get_max_tangential_pos_num() + 1;
+
+    viewgram.grow(
+		  IndexRange2D(get_min_axial_pos_num(segment_num),
+			       get_max_axial_pos_num(segment_num),
+			       get_min_tangential_pos_num(),
+			       new_max_tangential_pos));
+  }
+  return viewgram;
+}
+
+Sinogram<float>
+ProjDataFromMappedFile::
+get_sinogram(const int ax_pos_num, const int segment_num,
+	     const bool make_num_tangential_poss_odd) const
+{
+  if (!is_mapped())
+    return ProjDataFromStream::get_sinogram(ax_pos_num, segment_num, make_num_tangential_poss_odd);
+
+  const vector<streamoff> offsets = get_offsets_sino(ax_pos_num,segment_num);
+
+  Sinogram<float> sinogram(proj_data_info_ptr, ax_pos_num, segment_num);
+  read_rows(sinogram, offsets[0] + offsets[1], offsets[2]);
+
+  if (make_num_tangential_poss_odd&&(get_num_tangential_poss()%2==0))
+  {
+    const int new_max_tangential_pos = get_max_tangential_pos_num() + 1;
+
+    sinogram.grow(IndexRange2D(get_min_view_num(),
+			       get_max_view_num(),
+			       get_min_tangential_pos_num(),
+			       new_max_tangential_pos));
+  }
+  return sinogram;
+}
+
+SegmentBySinogram<float>
+ProjDataFromMappedFile::
+get_segment_by_sinogram(const int segment_num) const
+{
+  if (!is_mapped())
+    return ProjDataFromStream::get_segment_by_sinogram(segment_num);
+
+  SegmentBySinogram<float> segment(proj_data_info_ptr, segment_num);
+  for (int ax_pos_num=segment.get_min_axial_pos_num(); ax_pos_num<=segment.get_max_axial_pos_num(); ++ax_pos_num)
+    segment.set_sinogram(get_sinogram(ax_pos_num, segment_num));
+  return segment;
+}
+
+SegmentByView<float>
+ProjDataFromMappedFile::
+get_segment_by_view(const int segment_num) const
+{
+  if (!is_mapped())
+    return ProjDataFromStream::get_segment_by_view(segment_num);
+
+  SegmentByView<float> segment(proj_data_info_ptr, segment_num);
+  for (int view_num=segment.get_min_view_num(); view_num<=segment.get_max_view_num(); ++view_num)
+    segment.set_viewgram(get_viewgram(view_num, segment_num));
+  return segment;
+}
+
+Succeeded
+ProjDataFromMappedFile::
+set_viewgram(const Viewgram<float>&)
+{
+  warning("ProjDataFromMappedFile::set_viewgram: data are read-only");
+  return Succeeded::no;
+}
+
+Succeeded
+ProjDataFromMappedFile::
+set_sinogram(const Sinogram<float>&)
+{
+  warning("ProjDataFromMappedFile::set_sinogram: data are read-only");
+  return Succeeded::no;
+}
+
+Succeeded
+ProjDataFromMappedFile::
+set_segment(const SegmentBySinogram<float>&)
+{
+  warning("ProjDataFromMappedFile::set_segment: data are read-only");
+  return Succeeded::no;
+}
+
+Succeeded
+ProjDataFromMappedFile::
+set_segment(const SegmentByView<float>&)
+{
+  warning("ProjDataFromMappedFile::set_segment: data are read-only");
+  return Succeeded::no;
+}
+
+END_NAMESPACE_STIR
@@ -0,0 +1,168 @@
+/*
+    Copyright (C) 2026, STIR contributors
+    This file is part of STIR.
+
+    This file is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.
+
+    This file is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    See STIR/LICENSE.txt for details
+*/
+/*!
+  \file
+  \ingroup buildblock
+  \brief Implementation of functions for writing and reading binary cache files
+
+  \author STIR contributors
+*/
+
+#include "stir/cache_file.h"
+#include "stir/utilities.h"
+#include "stir/Succeeded.h"
+#include "stir/warning.h"
+#include <boost/format.hpp>
+#include <sstream>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+START_NAMESPACE_STIR
+
+// anonymous namespace for local variables and functions
+namespace {
+  // used to detect byte order problems
+  const boost::uint32_t cache_file_byte_order_check = 0x01020304;
+  // the data start at a multiple of this
+  const std::size_t cache_file_data_alignment = 16;
+  const std::size_t cache_file_magic_size = 8;
+
+  template <typename T>
+  inline void
+  write_value(std::ostream& s, const T value)
+  {
+    s.write(reinterpret_cast<const char *>(&value), sizeof(T));
+  }
+
+  template <typename T>
+  inline bool
+  read_value(std::istream& s, T& value)
+  {
+    s.read(reinterpret_cast<char *>(&value), sizeof(T));
+    return !s.fail();
+  }
+}
+
+std::size_t
+get_cache_file_header_size(const std::string& description)
+{
+  const std::size_t header_size =
+    cache_file_magic_size + 3*sizeof(boost::uint32_t) + sizeof(boost::uint64_t) +
+    sizeof(boost::uint32_t) + description.size();
+  return (header_size + cache_file_data_alignment - 1)/cache_file_data_alignment*cache_file_data_alignment;
+}
+
+std::string
+open_cache_file_for_writing(std::ofstream& s, const std::string& filename)
+{
+  const std::string tmp_filename = create_unique_temporary_file(filename);
+  if (tmp_filename.empty())
+    return tmp_filename;
+  s.open(tmp_filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!s)
+    {
+      warning(boost::format("Error opening %1% for writing cache file %2%") % tmp_filename % filename);
+      std::remove(tmp_filename.c_str());
+      return std::string();
+    }
+  return tmp_filename;
+}
+
+Succeeded
+finish_writing_cache_file(std::ofstream& s, const std::string& tmp_filename,
+                          const std::string& filename)
+{
+  s.close();
+  if (!s)
+    {
+      warning(boost::format("Error writing cache file %1%") % tmp_filename);
+      std::remove(tmp_filename.c_str());
+      return Succeeded::no;
+    }
+  if (!rename_file(tmp_filename, filename))
+    {
+      warning(boost::format("Error renaming %1% to %2%") % tmp_filename % filename);
+      std::remove(tmp_filename.c_str());
+      return Succeeded::no;
+    }
+  return Succeeded::yes;
+}
+
+void
+write_cache_file_header(std::ostream& s, const char * magic, const boost::uint32_t version,
+                        const boost::uint32_t flags, const boost::uint64_t data_size,
+                        const std::string& description)
+{
+  s.write(magic, cache_file_magic_size);
+  write_value(s, version);
+  write_value(s, cache_file_byte_order_check);
+  write_value(s, flags);
+  write_value(s, data_size);
+  write_value(s, static_cast<boost::uint32_t>(description.size()));
+  s.write(description.c_str(), description.size());
+  const std::size_t header_size_without_padding =
+    cache_file_magic_size + 3*sizeof(boost::uint32_t) + sizeof(boost::uint64_t) +
+    sizeof(boost::uint32_t) + description.size();
+  const std::vector<char> padding(get_cache_file_header_size(description) - header_size_without_padding, 0);
+  if (padding.size() > 0)
+    s.write(&padding[0], padding.size());
+}
+
+Succeeded
+read_cache_file_header(std::istream& s, const char * magic, const boost::uint32_t version,
+                       const std::string& description,
+                       boost::uint32_t& flags, boost::uint64_t& data_size)
+{
+  char magic_in_file[cache_file_magic_size];
+  boost::uint32_t version_in_file, byte_order_check, description_size;
+  s.read(magic_in_file, cache_file_magic_size);
+  if (s.fail() ||
+      std::memcmp(magic_in_file, magic, cache_file_magic_size) != 0 ||
+      !read_value(s, version_in_file) || version_in_file != version ||
+      !read_value(s, byte_order_check) || byte_order_check != cache_file_byte_order_check ||
+      !read_value(s, flags) ||
+      !read_value(s, data_size) ||
+      !read_value(s, description_size) || description_size != description.size())
+    return Succeeded::no;
+  std::vector<char> description_in_file(description_size);
+  if (description_size > 0)
+    s.read(&description_in_file[0], description_size);
+  if (s.fail() || std::string(description_in_file.begin(), description_in_file.end()) != description)
+    return Succeeded::no;
+  s.seekg(static_cast<std::streamoff>(get_cache_file_header_size(description)), std::ios::beg);
+  if (s.fail() ||
+      static_cast<boost::uint64_t>(find_remaining_size(s)) != data_size)
+    return Succeeded::no;
+  return Succeeded::yes;
+}
+
+std::string
+get_file_signature(const std::string& filename)
+{
+  struct stat file_status;
+  if (stat(filename.c_str(), &file_status) != 0)
+    return "file not found";
+  std::ostringstream s;
+  s << "size " << static_cast<boost::uint64_t>(file_status.st_size)
+    << ", modified " << static_cast<boost::int64_t>(file_status.st_mtime);
+  return s.str();
+}
+
+END_NAMESPACE_STIR
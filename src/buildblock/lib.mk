@@ -11,6 +11,7 @@ $(dir)_LIB_SOURCES := \
   ProjDataInfoCylindricalNoArcCorr.cxx \
   ArcCorrection.cxx \
   ProjDataFromStream.cxx \
+  ProjDataFromMappedFile.cxx \
   ProjDataGEAdvance.cxx \
   ProjDataInMemory.cxx \
   ProjDataInterfile.cxx \
@@ -28,6 +29,7 @@ $(dir)_LIB_SOURCES := \
   DiscretisedDensity.cxx \
   VoxelsOnCartesianGrid.cxx \
   utilities.cxx \
+  cache_file.cxx \
   interfile_keyword_functions.cxx \
   zoom.cxx \
   NumericType.cxx ByteOrder.cxx \
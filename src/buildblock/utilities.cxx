@@ -27,8 +27,21 @@
 */
 #include "stir/utilities.h"
 #include "stir/IndexRange3D.h"
+#include "stir/warning.h"
+#include <boost/format.hpp>
 #include <iostream>
 #include <fstream>
+#include <cstdio>
+#include <cerrno>
+#if defined(__OS_WIN__)
+#include <process.h>
+#include <io.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#else
+#include <unistd.h>
+#include <fcntl.h>
+#endif
 
 #ifndef STIR_NO_NAMESPACES
 using std::ifstream;
@@ -484,4 +497,61 @@ void * read_stream_in_memory(istream& input, streamsize& file_size)
   return memory;
 }
 
+string
+create_unique_temporary_file(const string& filename)
+{
+  // use the process id and a counter to find a name, and create the file only if it does not exist yet
+  // (note: we do not use mkstemp as the file should get the usual permissions)
+  static unsigned int counter = 0;
+  for (int attempt=0; attempt<100; ++attempt)
+    {
+      unsigned int current_counter;
+#if defined(STIR_OPENMP)
+# if _OPENMP >=201012
+#  pragma omp atomic capture
+# else
+#  pragma omp critical(STIRCREATEUNIQUETEMPORARYFILE)
+# endif
+#endif
+      current_counter = ++counter;
+#if defined(__OS_WIN__)
+      const string tmp_filename =
+        (boost::format("%1%.tmp%2%_%3%") % filename % _getpid() % current_counter).str();
+      const int fd = _open(tmp_filename.c_str(), _O_WRONLY | _O_CREAT | _O_EXCL, _S_IREAD | _S_IWRITE);
+      if (fd != -1)
+        {
+          _close(fd);
+          return tmp_filename;
+        }
+#else
+      const string tmp_filename =
+        (boost::format("%1%.tmp%2%_%3%") % filename % getpid() % current_counter).str();
+      const int fd = open(tmp_filename.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0666);
+      if (fd != -1)
+        {
+          close(fd);
+          return tmp_filename;
+        }
+#endif
+      if (errno != EEXIST)
+        break;
+    }
+  warning(boost::format("Could not create a temporary file for %1%") % filename);
+  return string();
+}
+
+bool
+rename_file(const string& old_filename, const string& new_filename)
+{
+  if (std::rename(old_filename.c_str(), new_filename.c_str()) == 0)
+    return true;
+#if defined(__OS_WIN__)
+  // rename fails when the file exists already
+  std::remove(new_filename.c_str());
+  if (std::rename(old_filename.c_str(), new_filename.c_str()) == 0)
+    return true;
+#endif
+  return false;
+}
+
 END_NAMESPACE_STIR
@@ -94,6 +94,34 @@ SinglesRatesFromSglFile()
 {}
 
 
+// Get the average rates of all singles units.
+std::vector<float>
+SinglesRatesFromSglFile::
+get_singles_rates(const double start_time,
+                  const double end_time) const {
+
+  const int num_singles_units = scanner_sptr->get_num_singles_units();
+
+  int start_slice;
+  int end_slice;
+  double start_fraction;
+  double end_fraction;
+  float total_slices;
+  get_interval_weights(start_slice, end_slice, start_fraction, end_fraction, total_slices,
+                       start_time, end_time);
+
+  std::vector<float> average_singles_rates(num_singles_units);
+  for(int singles_bin = 0 ; singles_bin < num_singles_units ; ++singles_bin) {
+    average_singles_rates[singles_bin] =
+      get_average_singles_rate(singles_bin, start_slice, end_slice,
+                               start_fraction, end_fraction, total_slices);
+  }
+
+  return average_singles_rates;
+}
+
+
+
 // Generate a FramesSinglesRate - containing the average rates
 // for a frame begining at start_time and ending at end_time.
 FrameSinglesRates
@@ -101,16 +129,8 @@ SinglesRatesFromSglFile::
 get_rates_for_frame(double start_time,
                     double end_time) const {
 
-  int num_singles_units = scanner_sptr->get_num_singles_units();
-
-  // Create a temporary vector
-  std::vector<float> average_singles_rates(num_singles_units);
-  
-
-  // Loop over all bins.
-  for(int singles_bin = 0 ; singles_bin < num_singles_units ; ++singles_bin) {
-    average_singles_rates[singles_bin] = get_singles_rate(singles_bin, start_time, end_time);
-  }
+  // Get the averages for all bins.
+  std::vector<float> average_singles_rates = get_singles_rates(start_time, end_time);
   
   // Determine that start and end slice indices.
   int start_slice = get_start_time_slice_index(start_time);
@@ -145,40 +165,12 @@ int
 SinglesRatesFromSglFile::
 get_end_time_slice_index(double t) const {
 
-  int slice_index = 0;
-
-  // Start with an initial estimate.
-  if ( _singles_time_interval != 0 ) {
-    slice_index = static_cast<int>(floor(t / _singles_time_interval));
-  }
+  // _times is sorted, so we can use a binary search for the
+  // first slice that ends at or after t.
+  const int slice_index =
+    static_cast<int>(std::lower_bound(_times.begin(), _times.end(), t) - _times.begin());
 
-  if ( slice_index >= _num_time_slices ) {
-    slice_index = _num_time_slices - 1;
-  } 
-
-
-  // Check estimate and determine whether to look further or backwards.
-  // Note that we could just move fowards first and then backwards but this
-  // method is more intuitive.
-
-  if ( _times[slice_index] < t ) {
-    
-    // Check forwards.
-    while( slice_index < _num_time_slices - 1 &&
-           _times[slice_index] < t ) {
-      slice_index++;
-    }
-
-  } else {
-
-    // Check backwards.
-    while( slice_index > 0 && _times[slice_index - 1] >= t ) {
-      slice_index--;
-    }
-
-  }
-  
-  return(slice_index);
+  return std::min(slice_index, _num_time_slices - 1);
 }
 
 
@@ -190,40 +182,12 @@ int
 SinglesRatesFromSglFile::
 get_start_time_slice_index(double t) const {
 
-  int slice_index = 0;
+  // _times is sorted, so we can use a binary search for the
+  // first slice that ends after t.
+  const int slice_index =
+    static_cast<int>(std::upper_bound(_times.begin(), _times.end(), t) - _times.begin());
 
-  // Start with an initial estimate.
-  if ( _singles_time_interval != 0 ) {
-    slice_index = static_cast<int>(floor(t / _singles_time_interval));
-  }
-
-  if ( slice_index >= _num_time_slices ) {
-    slice_index = _num_time_slices - 1;
-  } 
-
-
-  // Check estimate and determine whether to look further or backwards.
-  // Note that we could just move fowards first and then backwards but this
-  // method is more intuitive.
-
-  if ( _times[slice_index] < t ) {
-    
-    // Check forwards.
-    while( slice_index < _num_time_slices - 1 &&
-           _times[slice_index] <= t ) {
-      slice_index++;
-    }
-
-  } else {
-
-    // Check backwards.
-    while( slice_index > 0 && _times[slice_index - 1] > t ) {
-      slice_index--;
-    }
-
-  }
-  
-  return(slice_index);
+  return std::min(slice_index, _num_time_slices - 1);
 }
 
 
@@ -259,7 +223,13 @@ set_singles_rate(int singles_bin_index, int time_slice, int new_rate) {
   
   if ( singles_bin_index >= 0 && singles_bin_index < total_singles_units &&
        time_slice >= 0 && time_slice < _num_time_slices ) {
+    const int difference = new_rate - _singles[time_slice][singles_bin_index];
     _singles[time_slice][singles_bin_index] = new_rate;
+
+    // Update the running sums for all later slices.
+    for (int slice = time_slice + 1 ; slice <= _num_time_slices ; ++slice) {
+      _cumulative_singles[slice][singles_bin_index] += difference;
+    }
   }
 }
 
@@ -299,9 +269,10 @@ rebin(std::vector<double>& new_end_times) {
     } else {
 
       // Get the singles rate average between start and end times for all bins.
+      const std::vector<float> average_singles_rates = get_singles_rates(start_time, end_time);
       for(int singles_bin = 0 ; singles_bin < total_singles_units ; ++singles_bin ) {
         new_singles[new_slice][singles_bin] = 
-          round(get_singles_rate(singles_bin, start_time, end_time));
+          round(average_singles_rates[singles_bin]);
       }
       
     }
@@ -316,6 +287,7 @@ rebin(std::vector<double>& new_end_times) {
   _singles = new_singles;
   _times = new_end_times;
   _num_time_slices = _times.size();
+  set_up_cumulative_singles();
   
   return(_num_time_slices);
 }
@@ -492,6 +464,8 @@ read_singles_from_sgl_file(const std::string& sgl_filename)
     //TODO resize singles to return array with new sizes
   }
 
+  set_up_cumulative_singles();
+
 #endif
 
   // Return number of time slices read.
@@ -581,83 +555,16 @@ SinglesRatesFromSglFile::
 get_singles_rate(const int singles_bin_index,
                  const double start_time, const double end_time) const {
 
-  // First Calculate an inclusive range. start_time_slice is the 
-  // the first slice with an ending time greater than start_time.
-  // end_time_slice is the first time slice that ends at, or after,
-  // end_time.
-  int start_slice = this->get_start_time_slice_index(start_time);
-  int end_slice = this->get_end_time_slice_index(end_time);
-  
-  
-  // Total contribution from all slices.
-  double total_singles;
-
-
-  if ( start_slice == end_slice ) {
-    // If the start and end slices are the same then just use that time slice.
-    total_singles = static_cast<double>(_singles[start_slice][singles_bin_index]);
-  } else {
-    
-    // Start and end times for starting and ending slices.
-    double slice_start_time;
-    double slice_end_time;
-    double included_duration; 
-    double old_duration;
-    double fraction;
-    
-    
-    // Total slices included (including fractional amounts) in the average.
-    float total_slices;
-        
-    
-
-    // Calculate the fraction of the start_slice to include.
-    slice_start_time = get_slice_start(start_slice);
-    slice_end_time = _times[start_slice];
-    
-    old_duration = slice_end_time - slice_start_time;
-    included_duration = slice_end_time - start_time;
-        
-    fraction = included_duration / old_duration;
-       
-    
-    // Set the total number of contributing bins to this fraction.
-    total_slices = fraction;
-    
-    // Set the total singles so far to be the fraction of the bin.
-    total_singles = fraction * _singles[start_slice][singles_bin_index];
-    
-    
-    
-    // Calculate the fraction of the end_slice to include.
-    slice_start_time = get_slice_start(end_slice);
-    slice_end_time = _times[end_slice];
-        
-    old_duration = slice_end_time - slice_start_time;
-    included_duration = end_time - slice_start_time;
-        
-    fraction = included_duration / old_duration;
-    
-    // Add this fraction to the total of the number of bins contributing.
-    total_slices += fraction;
-    
-    // Add the fraction of the bin to the running total.
-    total_singles += fraction * _singles[end_slice][singles_bin_index];
- 
-    
-    // Add all intervening slices.
-    for(int slice = start_slice + 1; slice < end_slice ; ++slice, total_slices += 1.0) {
-      total_singles += _singles[slice][singles_bin_index];
-    }
-    
-    
-    // Divide by total amount of contributing slices.
-    total_singles = total_singles / total_slices;
-       
-  }
+  int start_slice;
+  int end_slice;
+  double start_fraction;
+  double end_fraction;
+  float total_slices;
+  get_interval_weights(start_slice, end_slice, start_fraction, end_fraction, total_slices,
+                       start_time, end_time);
 
-  return( static_cast<float>(total_singles) );
-  
+  return get_average_singles_rate(singles_bin_index, start_slice, end_slice,
+                                  start_fraction, end_fraction, total_slices);
 }
 
 
@@ -707,6 +614,97 @@ set_time_interval() {
 }
 
 
+void
+SinglesRatesFromSglFile::
+set_up_cumulative_singles() {
+
+  const int total_singles_units = _singles.get_length()==0 ? 0 : _singles[0].get_length();
+
+  _cumulative_singles =
+    Array<2, double>(IndexRange2D(0, _num_time_slices, 0, total_singles_units - 1));
+
+  // First row is zero (the Array constructor initialises to 0).
+  for(int slice = 0 ; slice < _num_time_slices ; ++slice) {
+    for(int singles_bin = 0 ; singles_bin < total_singles_units ; ++singles_bin) {
+      _cumulative_singles[slice + 1][singles_bin] =
+        _cumulative_singles[slice][singles_bin] + _singles[slice][singles_bin];
+    }
+  }
+}
+
+
+
+void
+SinglesRatesFromSglFile::
+get_interval_weights(int& start_slice, int& end_slice,
+                     double& start_fraction, double& end_fraction,
+                     float& total_slices,
+                     const double start_time, const double end_time) const {
+
+  // First Calculate an inclusive range. start_time_slice is the 
+  // the first slice with an ending time greater than start_time.
+  // end_time_slice is the first time slice that ends at, or after,
+  // end_time.
+  start_slice = this->get_start_time_slice_index(start_time);
+  end_slice = this->get_end_time_slice_index(end_time);
+
+  if ( start_slice == end_slice ) {
+    // If the start and end slices are the same then just use that time slice.
+    start_fraction = 1;
+    end_fraction = 0;
+    total_slices = 1;
+    return;
+  }
+
+  // Calculate the fraction of the start_slice to include.
+  {
+    const double slice_start_time = get_slice_start(start_slice);
+    const double slice_end_time = _times[start_slice];
+    start_fraction = (slice_end_time - start_time) / (slice_end_time - slice_start_time);
+  }
+
+  // Calculate the fraction of the end_slice to include.
+  {
+    const double slice_start_time = get_slice_start(end_slice);
+    const double slice_end_time = _times[end_slice];
+    end_fraction = (end_time - slice_start_time) / (slice_end_time - slice_start_time);
+  }
+
+  // Total slices included (including fractional amounts) in the average.
+  total_slices = start_fraction;
+  total_slices += end_fraction;
+  total_slices += end_slice - start_slice - 1;
+}
+
+
+
+inline float
+SinglesRatesFromSglFile::
+get_average_singles_rate(const int singles_bin_index,
+                         const int start_slice, const int end_slice,
+                         const double start_fraction, const double end_fraction,
+                         const float total_slices) const {
+
+  if ( start_slice == end_slice ) {
+    return static_cast<float>(_singles[start_slice][singles_bin_index]);
+  }
+
+  // Partial contributions of the first and last slice.
+  double total_singles = 
+    start_fraction * _singles[start_slice][singles_bin_index] +
+    end_fraction * _singles[end_slice][singles_bin_index];
+
+  // Add all intervening slices using the running sums.
+  total_singles += 
+    _cumulative_singles[end_slice][singles_bin_index] -
+    _cumulative_singles[start_slice + 1][singles_bin_index];
+
+  // Divide by total amount of contributing slices.
+  return static_cast<float>(total_singles / total_slices);
+}
+
+
+
 // get slice start time.
 double 
 SinglesRatesFromSglFile::
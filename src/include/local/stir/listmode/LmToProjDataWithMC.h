@@ -40,6 +40,8 @@ public:
 
   virtual void get_bin_from_event(Bin& bin, const CListEvent&) const;
   virtual void process_new_time_event(const CListTime& time_event);
+  //! returns \c false, as get_bin_from_event() uses the motion set by process_new_time_event()
+  virtual bool can_bin_events_in_parallel() const { return false; }
 
 protected: 
   //! motion information
@@ -93,6 +93,8 @@ protected:
 
   virtual void get_bin_from_event(Bin& bin, const CListEvent&) const;
 
+  //! returns \c false, as the random number generator is used sequentially
+  virtual bool can_bin_events_in_parallel() const { return false; }
 
   // \name parsing variables
   //@{
@@ -72,6 +72,23 @@ Array inherits its numeric operators from NumericVectorWithOffset.
 In particular this means that operator+= etc. potentially grow
 the object. However, as grow() is a virtual function, Array::grow is
 called, which initialises new elements first to 0.
+
+\par Contiguous storage
+
+When an Array is constructed (or resized, or copied) with a regular range, all 
+elements are stored in a single block of memory (in the order in which a
+full_iterator traverses them), and the rows are 'views' into that block. 
+This avoids a memory allocation for every 1D row, and makes copying, I/O etc 
+faster. Use is_contiguous() to find out if this is the case (e.g. after resizing one
+of the rows, this will no longer be the case) and get_full_data_ptr() to access the
+data via a pointer. The block starts at a multiple of 64 bytes (see
+detail::array_data_alignment), i.e. at the start of a cache line, which allows
+aligned SIMD loads and stores.
+
+Note that as a consequence, resize() and grow() of a contiguous array allocate a new block
+and copy all elements into it, even when only one index range changes by a small amount.
+It is therefore best to construct an Array with its final range, instead of growing it
+step by step.
 */
 
 template <int num_dimensions, typename elemT>
@@ -134,17 +151,24 @@ public:
 #ifndef SWIG
   //! Construct an Array from an object of its base_type
   inline Array(const base_type& t);
-#else
-  // swig 2.0.4 gets confused by base_type (due to numeric template arguments)
-  // therefore, we declare this constructor using the "self" type, 
-  // i.e. it's just a copy-constructor.
+#endif
+  // Note: swig 2.0.4 gets confused by base_type (due to numeric template arguments)
+  // therefore, we only declare the copy-constructor for swig.
   // This is less powerful as in C++, but swig-generated interfaces don't need to know about the base_type anyway
+
+  //! copy constructor
+  /*! The new object will be contiguous if the range of \a t is regular (even if \a t itself is not contiguous). */
   inline Array(const self& t);
-#endif
-  
+
   //! virtual destructor, frees up any allocated memory
   inline virtual ~Array();
 
+  //! assignment operator
+  /*! If the index range of \a t is different from the current one, memory is reallocated
+      (which will be contiguous if the range is regular).
+  */
+  inline self& operator=(const self& t);
+
   /*! @name functions returning full_iterators*/
   //@{
   //! start value for iterating through all elements in the array, see full_iterator
@@ -166,15 +190,39 @@ public:
   //! return the total number of elements in this array
   inline size_t size_all() const;	
 
+  //! checks if all elements are stored in a single block of memory
+  /*! The order of the elements in memory is then the same as the order in which
+      full_iterator traverses them.
+  */
+  inline bool is_contiguous() const;
+
+  //! \name access to the data via a pointer
+  /*! These functions can only be used if is_contiguous() is \c true (otherwise
+      error() is called). For an array without elements, 0 is returned.
+      As for VectorWithOffset, you should call the corresponding \c release function
+      when done.
+  */
+  //@{
+  inline elemT* get_full_data_ptr();
+  inline const elemT* get_const_full_data_ptr() const;
+  inline void release_full_data_ptr();
+  inline void release_const_full_data_ptr() const;
+  //@}
+
   /* Implementation note: grow() and resize() are inline such that they are
      defined for any type you happen to use for elemT. Otherwise, we would
      need instantiation in Array.cxx.
   */
   //! change the array to a new range of indices, new elements are set to 0  
+  /*! If the new range is regular, the array will be contiguous afterwards. This
+      allocates a new block of memory and copies all elements into it (unless the
+      array was empty).
+  */
   inline virtual void 
     resize(const IndexRange<num_dimensions>& range);
 
   //! grow the array to a new range of indices, new elements are set to 0  
+  /*! This calls resize(), so has the same cost. */
   virtual inline void 
     grow(const IndexRange<num_dimensions>& range);
   
@@ -239,6 +287,25 @@ public:
   inline const elemT&
     at(const BasicCoordinate<num_dimensions,int> &c) const;
   //@}
+
+private:
+  // allow Array of other dimensions to call the private functions below
+  template <int num_dimensions2, typename elemT2> friend class Array;
+
+  //! block of memory allocated by this object (or 0), used by all elements when contiguous
+  elemT * _allocated_full_data_ptr;
+
+  //! allocate a single block of memory for \a range, and let all elements use it
+  inline void _init_contiguous(const IndexRange<num_dimensions>& range, const bool initialise_with_0);
+  //! reallocate the data as a single block, keeping the current values
+  inline void _make_contiguous();
+  //! let all elements use existing memory, returns a pointer after the last element used
+  inline elemT* _init_with_external_data(const IndexRange<num_dimensions>& range, elemT * const data_ptr);
+  //! find first element and end of the data, returns \c false if the data are not contiguous
+  /*! \a begin_ptr has to be 0 on the first call */
+  inline bool _get_contiguous_data_range(const elemT*& begin_ptr, const elemT*& end_ptr) const;
+  //! check if the index range is the same as for \a t (without constructing IndexRange objects)
+  inline bool _has_same_index_range(const self& t) const;
 };
 
 
@@ -302,6 +369,10 @@ public:
   //! constructor given first and last indices, initialising elements to 0
   inline Array(const int min_index, const int max_index);
 
+  //! constructor using existing data (no initialisation)
+  /*! \see VectorWithOffset for the consequences of using existing data */
+  inline Array(const IndexRange<1>& range, elemT * const data_ptr);
+
   //! constructor from basetype
   inline Array(const NumericVectorWithOffset<elemT,elemT> &il);
   
@@ -330,6 +401,17 @@ public:
   //! return the total number of elements in this array
   inline size_t size_all() const;	
 
+  //! checks if all elements are stored in a single block of memory (always \c true for the 1D case)
+  inline bool is_contiguous() const;
+
+  //! \name access to the data via a pointer (identical to VectorWithOffset::get_data_ptr() etc.)
+  //@{
+  inline elemT* get_full_data_ptr();
+  inline const elemT* get_const_full_data_ptr() const;
+  inline void release_full_data_ptr();
+  inline void release_const_full_data_ptr() const;
+  //@}
+
   //! Array::grow initialises new elements to 0
   inline virtual void grow(const IndexRange<1>& range);
   
@@ -426,7 +508,16 @@ public:
     at(const BasicCoordinate<1,int> &c) const;
   //@}
 
-  
+private:
+  // allow Array of other dimensions to call the private functions below
+  template <int num_dimensions2, typename elemT2> friend class Array;
+
+  //! let the vector use existing memory, returns a pointer after the last element used
+  inline elemT* _init_with_external_data(const IndexRange<1>& range, elemT * const data_ptr);
+  //! see Array<num_dimensions,elemT>
+  inline bool _get_contiguous_data_range(const elemT*& begin_ptr, const elemT*& end_ptr) const;
+  //! check if the index range is the same as for \a t
+  inline bool _has_same_index_range(const self& t) const;
 };
 
 
@@ -31,6 +31,8 @@
 // include for min,max definitions
 #include <algorithm>
 #include "stir/assign.h"
+#include "stir/error.h"
+#include "stir/detail/aligned_allocation.h"
 
 START_NAMESPACE_STIR
 
@@ -38,11 +40,138 @@ START_NAMESPACE_STIR
  inlines for Array<num_dimensions, elemT>
  **********************************************/
 
+template <int num_dimensions, typename elemT>
+elemT*
+Array<num_dimensions, elemT>::
+_init_with_external_data(const IndexRange<num_dimensions>& range, elemT * const data_ptr)
+{
+  // get rid of all current elements (some of these might point into a block of memory
+  // that is going to be deallocated)
+  this->recycle();
+  base_type::resize(range.get_min_index(), range.get_max_index());
+  elemT * current_data_ptr = data_ptr;
+  typename base_type::iterator iter = this->begin();
+  typename IndexRange<num_dimensions>::const_iterator range_iter = range.begin();
+  for (;
+       iter != this->end(); 
+       ++iter, ++range_iter)
+    current_data_ptr = (*iter)._init_with_external_data(*range_iter, current_data_ptr);
+  return current_data_ptr;
+}
+
+template <int num_dimensions, typename elemT>
+void
+Array<num_dimensions, elemT>::
+_init_contiguous(const IndexRange<num_dimensions>& range, const bool initialise_with_0)
+{
+  const std::size_t num_elements = range.size_all();
+  elemT * const new_data_ptr = 
+    detail::allocate_aligned_array<elemT>(num_elements);
+  if (initialise_with_0)
+    for (std::size_t i=0; i<num_elements; ++i)
+      assign(new_data_ptr[i], 0);
+  this->_init_with_external_data(range, new_data_ptr);
+  // we can only deallocate now, as elements might have been using the old memory
+  detail::deallocate_aligned_array(this->_allocated_full_data_ptr);
+  this->_allocated_full_data_ptr = new_data_ptr;
+}
+
+template <int num_dimensions, typename elemT>
+void
+Array<num_dimensions, elemT>::
+_make_contiguous()
+{
+  const IndexRange<num_dimensions> range = this->get_index_range();
+  const std::size_t num_elements = range.size_all();
+  elemT * const new_data_ptr = 
+    detail::allocate_aligned_array<elemT>(num_elements);
+  std::copy(this->begin_all_const(), this->end_all_const(), new_data_ptr);
+  this->_init_with_external_data(range, new_data_ptr);
+  detail::deallocate_aligned_array(this->_allocated_full_data_ptr);
+  this->_allocated_full_data_ptr = new_data_ptr;
+}
+
+template <int num_dimensions, typename elemT>
+bool
+Array<num_dimensions, elemT>::
+_get_contiguous_data_range(const elemT*& begin_ptr, const elemT*& end_ptr) const
+{
+  for (const_iterator iter = this->begin(); iter != this->end(); ++iter)
+    if (!(*iter)._get_contiguous_data_range(begin_ptr, end_ptr))
+      return false;
+  return true;
+}
+
+template <int num_dimensions, typename elemT>
+bool
+Array<num_dimensions, elemT>::
+_has_same_index_range(const self& t) const
+{
+  if (this->size() != t.size())
+    return false;
+  if (this->size() == 0)
+    return true;
+  if (this->get_min_index() != t.get_min_index())
+    return false;
+  for (int i=this->get_min_index(); i<=this->get_max_index(); ++i)
+    if (!this->num[i]._has_same_index_range(t[i]))
+      return false;
+  return true;
+}
+
+template <int num_dimensions, typename elemT>
+bool
+Array<num_dimensions, elemT>::
+is_contiguous() const
+{
+  const elemT* begin_ptr = 0;
+  const elemT* end_ptr = 0;
+  return this->_get_contiguous_data_range(begin_ptr, end_ptr);
+}
+
+template <int num_dimensions, typename elemT>
+elemT*
+Array<num_dimensions, elemT>::
+get_full_data_ptr()
+{
+  return const_cast<elemT*>(this->get_const_full_data_ptr());
+}
+
+template <int num_dimensions, typename elemT>
+const elemT*
+Array<num_dimensions, elemT>::
+get_const_full_data_ptr() const
+{
+  const elemT* begin_ptr = 0;
+  const elemT* end_ptr = 0;
+  if (!this->_get_contiguous_data_range(begin_ptr, end_ptr))
+    error("Array::get_full_data_ptr() called for an array that is not contiguous");
+  return begin_ptr;
+}
+
+template <int num_dimensions, typename elemT>
+void
+Array<num_dimensions, elemT>::
+release_full_data_ptr()
+{}
+
+template <int num_dimensions, typename elemT>
+void
+Array<num_dimensions, elemT>::
+release_const_full_data_ptr() const
+{}
+
 template <int num_dimensions, typename elemT>
 void 
 Array<num_dimensions, elemT>::
 resize(const IndexRange<num_dimensions>& range)
 {
+  if (this->size() == 0 && range.is_regular())
+    {
+      // nothing to keep, so allocate a new block straightaway
+      this->_init_contiguous(range, /* initialise_with_0 = */ true);
+      return;
+    }
   base_type::resize(range.get_min_index(), range.get_max_index());
   typename base_type::iterator iter = this->begin();
   typename IndexRange<num_dimensions>::const_iterator range_iter = range.begin();
@@ -50,6 +179,8 @@ resize(const IndexRange<num_dimensions>& range)
        iter != this->end(); 
        ++iter, ++range_iter)
     (*iter).resize(*range_iter);
+  if (range.is_regular() && !this->is_contiguous())
+    this->_make_contiguous();
 }
 
 template <int num_dimensions, typename elemT>
@@ -62,29 +193,85 @@ grow(const IndexRange<num_dimensions>& range)
 
 template <int num_dimensions, typename elemT>
 Array<num_dimensions, elemT>::Array()
-: base_type()
+: base_type(),
+  _allocated_full_data_ptr(0)
 {}
 
 template <int num_dimensions, typename elemT>
 Array<num_dimensions, elemT>::Array(const IndexRange<num_dimensions>& range)
-: base_type()
+: base_type(),
+  _allocated_full_data_ptr(0)
 {
   grow(range);
 }
 
+#ifndef SWIG
 template <int num_dimensions, typename elemT>
-#ifdef SWIG
-// swig-specific work-around (see Array.h)
-Array<num_dimensions, elemT>::Array(const self& t)
-#else
 Array<num_dimensions, elemT>::Array(const base_type& t)
+: base_type(),
+  _allocated_full_data_ptr(0)
+{
+  // find the index range of t
+  VectorWithOffset<IndexRange<num_dimensions-1> > 
+    range(t.get_min_index(), t.get_max_index());
+  for (int i=t.get_min_index(); i<=t.get_max_index(); ++i)
+    range[i] = t[i].get_index_range();
+  const IndexRange<num_dimensions> index_range(range);
+  if (index_range.is_regular())
+    {
+      this->_init_contiguous(index_range, /* initialise_with_0 = */ false);
+      for (int i=t.get_min_index(); i<=t.get_max_index(); ++i)
+	this->num[i] = t[i];
+    }
+  else
+    base_type::operator=(t);
+}
 #endif
-:  base_type(t)
-{}
+
+template <int num_dimensions, typename elemT>
+Array<num_dimensions, elemT>::Array(const self& t)
+: base_type(),
+  _allocated_full_data_ptr(0)
+{
+  *this = t;
+}
 
 template <int num_dimensions, typename elemT>
 Array<num_dimensions, elemT>::~Array()
-{}
+{
+  // note: the elements might still point into this block of memory, but 
+  // they will not access it anymore.
+  detail::deallocate_aligned_array(this->_allocated_full_data_ptr);
+}
+
+template <int num_dimensions, typename elemT>
+Array<num_dimensions, elemT>&
+Array<num_dimensions, elemT>::operator=(const self& t)
+{
+  if (this == &t)
+    return *this;
+  if (!this->_has_same_index_range(t))
+    {
+      const IndexRange<num_dimensions> range = t.get_index_range();
+      if (!range.is_regular())
+	{
+	  base_type::operator=(t);
+	  return *this;
+	}
+      this->_init_contiguous(range, /* initialise_with_0 = */ false);
+    }
+  // index ranges are now the same
+  const elemT* begin_ptr = 0;
+  const elemT* end_ptr = 0;
+  const elemT* t_begin_ptr = 0;
+  const elemT* t_end_ptr = 0;
+  if (this->_get_contiguous_data_range(begin_ptr, end_ptr) &&
+      t._get_contiguous_data_range(t_begin_ptr, t_end_ptr))
+    std::copy(t_begin_ptr, t_end_ptr, const_cast<elemT*>(begin_ptr));
+  else
+    base_type::operator=(t);
+  return *this;
+}
 
 
 template <int num_dimensions, typename elemT>
@@ -403,6 +590,12 @@ Array<1, elemT>::Array(const int min_index, const int max_index)
 }
 
 
+template <class elemT>
+Array<1, elemT>::Array(const IndexRange<1>& range, elemT * const data_ptr)
+: base_type(range.get_min_index(), range.get_max_index(), 
+	    data_ptr, data_ptr + range.size_all())
+{}
+
 template <class elemT>
 Array<1, elemT>::Array(const base_type &il)
 : base_type(il)
@@ -469,6 +662,76 @@ Array<1, elemT>::size_all() const
   return this->size();
 }
 
+template <typename elemT>
+bool
+Array<1, elemT>::is_contiguous() const
+{
+  return true;
+}
+
+template <typename elemT>
+elemT*
+Array<1, elemT>::get_full_data_ptr()
+{
+  return this->get_data_ptr();
+}
+
+template <typename elemT>
+const elemT*
+Array<1, elemT>::get_const_full_data_ptr() const
+{
+  return this->get_const_data_ptr();
+}
+
+template <typename elemT>
+void
+Array<1, elemT>::release_full_data_ptr()
+{
+  this->release_data_ptr();
+}
+
+template <typename elemT>
+void
+Array<1, elemT>::release_const_full_data_ptr() const
+{
+  this->release_const_data_ptr();
+}
+
+template <typename elemT>
+elemT*
+Array<1, elemT>::
+_init_with_external_data(const IndexRange<1>& range, elemT * const data_ptr)
+{
+  this->init_with_external_data(range.get_min_index(), range.get_max_index(), data_ptr);
+  return data_ptr + range.size_all();
+}
+
+template <typename elemT>
+bool
+Array<1, elemT>::
+_get_contiguous_data_range(const elemT*& begin_ptr, const elemT*& end_ptr) const
+{
+  if (this->size() == 0)
+    return true;
+  const elemT * const first_ptr = &this->num[this->get_min_index()];
+  if (begin_ptr == 0)
+    begin_ptr = first_ptr;
+  else if (first_ptr != end_ptr)
+    return false;
+  end_ptr = first_ptr + this->size();
+  return true;
+}
+
+template <typename elemT>
+bool
+Array<1, elemT>::
+_has_same_index_range(const self& t) const
+{
+  return 
+    this->size() == t.size() &&
+    (this->size() == 0 || this->get_min_index() == t.get_min_index());
+}
+
 template <class elemT>
 elemT
 Array<1, elemT>::sum() const 
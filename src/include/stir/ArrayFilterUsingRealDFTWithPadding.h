@@ -93,7 +93,7 @@ public:
       twice as long as the input and output arrays.
 
       As this function uses fourier_for_real_data(), see there for restrictions 
-      on the possible kernel length, but at time of writing, it has to be a power of 2.
+      on the possible kernel length (at time of writing, the last dimension has to be even).
   */
   Succeeded 
     set_kernel(const Array<num_dimensions, elemT>& real_filter_kernel);
@@ -108,7 +108,7 @@ public:
       twice as long as the input and output arrays.
 
       See fourier() for restrictions on the possible
-      kernel length, but at time of writing, it has to be a power of 2.
+      kernel length.
   */
   Succeeded
     set_kernel_in_frequency_space(const Array<num_dimensions, std::complex<elemT> >& kernel_in_frequency_space);
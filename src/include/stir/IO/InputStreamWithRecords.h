@@ -44,9 +44,10 @@ START_NAMESPACE_STIR
     the function to find out what the size of the record is. In that case, all IO
     handling is completely generic and is implemented in this class.
 
-    Current implementation needs a \c max_size_of_record to allocate enough memory 
-    (on the stack) before reading. This is efficient in many cases, but impractical 
-    in others.
+    Data are read from the stream in large chunks into an internal buffer, and
+    records are initialised directly from this buffer. This avoids a memory
+    allocation and small read operations for every record. The buffer needs to be at least
+    \c max_size_of_record bytes.
 
     \par Requirements
     \c RecordT needs to have the following member functions
@@ -61,13 +62,17 @@ START_NAMESPACE_STIR
                          const OptionsT options);
     \endcode
 
-    \todo Allow choosing between allocation with \c new or on the stack.
+    \warning As data are read ahead, the position of the stream does not correspond to
+    the position of the next record. Use save_get_position() etc, as opposed to
+    manipulating the stream directly.
 */
 template <class RecordT, class OptionsT>
 class InputStreamWithRecords
 {
 public:
   typedef std::vector<std::streampos>::size_type SavedPosition;
+  //! default size (in bytes) of the buffer used for reading
+  static const std::size_t default_buffer_size = 1048576;
   //! Constructor taking a stream
   /*! Data will be assumed to start at the current position reported by seekg().
       If reset() is used, it will go back to this starting position.*/ 
@@ -75,7 +80,8 @@ public:
     InputStreamWithRecords(const shared_ptr<std::istream>& stream_ptr,
                            const std::size_t size_of_record_signature,
                            const std::size_t max_size_of_record, 
-                           const OptionsT& options);
+                           const OptionsT& options,
+                           const std::size_t buffer_size = default_buffer_size);
 
   //! Constructor taking a filename
   /*! File will be opened in binary mode. Data will be assumed to 
@@ -86,7 +92,8 @@ public:
 			   const std::size_t size_of_record_signature,
 			   const std::size_t max_size_of_record, 
 			   const OptionsT& options,
-			   const std::streampos start_of_data = 0);
+			   const std::streampos start_of_data = 0,
+			   const std::size_t buffer_size = default_buffer_size);
 
   virtual ~InputStreamWithRecords() {}
 
@@ -109,6 +116,21 @@ public:
   inline
   Succeeded set_get_position(const SavedPosition&);
 
+  //! get the position in the stream of the next record
+  /*! In contrast to save_get_position(), the returned value can be used with
+      set_stream_position() on another object reading the same data.
+      \return <code>std::streampos(-1)</code> if all data has been read.
+  */
+  inline
+    std::streampos get_stream_position() const;
+
+  //! set the position in the stream for reading the next record
+  /*! \a pos would normally have been obtained with get_stream_position().
+      \warning There is no check if \a pos is the start of a record.
+  */
+  inline
+    Succeeded set_stream_position(const std::streampos& pos);
+
   //! Function that enables the user to store the saved get_positions
   /*! Together with set_saved_get_positions(), this allows 
       reinstating the saved get_positions when 
@@ -136,6 +158,22 @@ private:
   const std::size_t max_size_of_record;
 
   const OptionsT options;
+
+  //! data read from the stream, but not all used yet
+  mutable std::vector<char> buffer;
+  //! position in the stream of the first element of \c buffer
+  mutable std::streampos buffer_start_position;
+  //! position of the next record in the buffer
+  mutable std::size_t position_in_buffer;
+  //! number of bytes in \c buffer that contain data
+  mutable std::size_t size_of_data_in_buffer;
+  //! \c true if there is no more data to read from the stream
+  mutable bool end_of_stream;
+
+  //! move unused data to the start of the buffer, and fill the rest from the stream
+  inline void fill_buffer() const;
+  //! empty buffer, such that the next read starts at \a pos
+  inline void clear_buffer(const std::streampos pos);
 };
 
 END_NAMESPACE_STIR
@@ -28,20 +28,28 @@
 #include "stir/Succeeded.h"
 #include "stir/is_null_ptr.h"
 #include "stir/shared_ptr.h"
-#include "boost/shared_array.hpp"
+#include <algorithm>
 #include <fstream>
+#include <cstring>
 
 START_NAMESPACE_STIR
+
+template <class RecordT, class OptionsT>
+const std::size_t
+InputStreamWithRecords<RecordT, OptionsT>::default_buffer_size;
+
 template <class RecordT, class OptionsT>
 InputStreamWithRecords<RecordT, OptionsT>::
 InputStreamWithRecords(const shared_ptr<std::istream>& stream_ptr,
                        const std::size_t size_of_record_signature,
                        const std::size_t max_size_of_record, 
-                       const OptionsT& options)
+                       const OptionsT& options,
+                       const std::size_t buffer_size)
   : stream_ptr(stream_ptr),
     size_of_record_signature(size_of_record_signature),
     max_size_of_record(max_size_of_record),
-    options(options)
+    options(options),
+    buffer(std::max(buffer_size, max_size_of_record))
 {
   assert(size_of_record_signature<=max_size_of_record);
   if (is_null_ptr(stream_ptr))
@@ -49,6 +57,7 @@ InputStreamWithRecords(const shared_ptr<std::istream>& stream_ptr,
   starting_stream_position = stream_ptr->tellg();
   if (!stream_ptr->good())
     error("InputStreamWithRecords: error in tellg()\n");
+  this->clear_buffer(starting_stream_position);
 }
 
 template <class RecordT, class OptionsT>
@@ -57,12 +66,14 @@ InputStreamWithRecords(const std::string& filename,
                        const std::size_t size_of_record_signature,
                        const std::size_t max_size_of_record,
                        const OptionsT& options, 
-                       const std::streampos start_of_data)
+                       const std::streampos start_of_data,
+                       const std::size_t buffer_size)
   : filename(filename),
     starting_stream_position(start_of_data),
     size_of_record_signature(size_of_record_signature),
     max_size_of_record(max_size_of_record),
-    options(options)
+    options(options),
+    buffer(std::max(buffer_size, max_size_of_record))
 {
   assert(size_of_record_signature<=max_size_of_record);
   std::fstream* s_ptr = new std::fstream;
@@ -73,6 +84,42 @@ InputStreamWithRecords(const std::string& filename,
 	  filename.c_str());
 }
 
+template <class RecordT, class OptionsT>
+void
+InputStreamWithRecords<RecordT, OptionsT>::
+clear_buffer(const std::streampos pos)
+{
+  this->buffer_start_position = pos;
+  this->position_in_buffer = 0;
+  this->size_of_data_in_buffer = 0;
+  this->end_of_stream = false;
+}
+
+template <class RecordT, class OptionsT>
+void
+InputStreamWithRecords<RecordT, OptionsT>::
+fill_buffer() const
+{
+  const std::size_t size_of_remaining_data = 
+    this->size_of_data_in_buffer - this->position_in_buffer;
+  if (size_of_remaining_data>0 && this->position_in_buffer>0)
+    std::memmove(&this->buffer[0], &this->buffer[this->position_in_buffer], size_of_remaining_data);
+  this->buffer_start_position += static_cast<std::streamoff>(this->position_in_buffer);
+  this->position_in_buffer = 0;
+  this->size_of_data_in_buffer = size_of_remaining_data;
+
+  stream_ptr->read(&this->buffer[size_of_remaining_data], 
+                   static_cast<std::streamsize>(this->buffer.size() - size_of_remaining_data));
+  this->size_of_data_in_buffer += static_cast<std::size_t>(stream_ptr->gcount());
+  if (stream_ptr->eof())
+    this->end_of_stream = true;
+  else if (stream_ptr->fail())
+    { 
+      warning("Error after reading from list mode stream in get_next_record");
+      this->end_of_stream = true;
+    }
+}
+
 template <class RecordT, class OptionsT>
 Succeeded
 InputStreamWithRecords<RecordT, OptionsT>::
@@ -81,25 +128,24 @@ get_next_record(RecordT& record) const
   if (is_null_ptr(stream_ptr))
     return Succeeded::no;
 
-  // rely on file caching by the C++ library or the OS
   assert(this->size_of_record_signature <= this->max_size_of_record);
-  boost::shared_array<char> data_sptr(new char[this->max_size_of_record]);
-  char * data_ptr = data_sptr.get();
-  stream_ptr->read(data_ptr, this->size_of_record_signature);
-  if (stream_ptr->gcount()<static_cast<std::streamsize>(this->size_of_record_signature))
+  if (this->size_of_data_in_buffer - this->position_in_buffer < this->max_size_of_record &&
+      !this->end_of_stream)
+    this->fill_buffer();
+
+  const std::size_t size_available = this->size_of_data_in_buffer - this->position_in_buffer;
+  if (size_available < this->size_of_record_signature)
     return Succeeded::no; 
+  const char * const data_ptr = &this->buffer[this->position_in_buffer];
   const std::size_t size_of_record = record.size_of_record_at_ptr(data_ptr, this->size_of_record_signature,options);
   assert(size_of_record <= this->max_size_of_record);
-  if (size_of_record > this->size_of_record_signature)
-    stream_ptr->read(data_ptr + this->size_of_record_signature,
-                     size_of_record - this->size_of_record_signature);
-  if (stream_ptr->eof())
-    return Succeeded::no; 
-  else if (stream_ptr->bad())
-    { 
-      warning("Error after reading from list mode stream in get_next_record");
+  if (size_of_record > size_available)
+    {
+      // incomplete record at the end of the stream
+      this->position_in_buffer = this->size_of_data_in_buffer;
       return Succeeded::no; 
     }
+  this->position_in_buffer += size_of_record;
   return 
     record.init_from_data_ptr(data_ptr, size_of_record,options);
 }
@@ -118,6 +164,7 @@ reset()
   if (stream_ptr->eof()) 
     stream_ptr->clear();
   stream_ptr->seekg(starting_stream_position, std::ios::beg);
+  this->clear_buffer(starting_stream_position);
   if (stream_ptr->bad())
     return Succeeded::no;
   else
@@ -131,22 +178,7 @@ InputStreamWithRecords<RecordT, OptionsT>::
 save_get_position() 
 {
   assert(!is_null_ptr(stream_ptr));
-  // TODO should somehow check if tellg() worked and return an error if it didn't
-  std::streampos pos;
-  if (!stream_ptr->eof())
-    {
-      pos = stream_ptr->tellg();
-      if (!stream_ptr->good())
-	error("InputStreamWithRecords<RecordT, OptionsT>::save_get_position\n"
-	      "Error after getting position in file");
-    }
-  else
-    {
-      // use -1 to signify eof 
-      // (this is probably the behaviour of tellg anyway, but this way we're sure).
-      pos = std::streampos(-1); 
-    }
-  saved_get_positions.push_back(pos);
+  saved_get_positions.push_back(this->get_stream_position());
   return saved_get_positions.size()-1;
 } 
 
@@ -159,11 +191,44 @@ set_get_position(const typename InputStreamWithRecords<RecordT, OptionsT>::Saved
     return Succeeded::no;
 
   assert(pos < saved_get_positions.size());
-  if (saved_get_positions[pos] == std::streampos(-1))
-    stream_ptr->seekg(0, std::ios::end); // go to eof
+  return this->set_stream_position(saved_get_positions[pos]);
+}
+
+template <class RecordT, class OptionsT>
+std::streampos
+InputStreamWithRecords<RecordT, OptionsT>::
+get_stream_position() const
+{
+  // the stream has been read ahead, so find the position from the buffer
+  if (!this->end_of_stream || this->position_in_buffer < this->size_of_data_in_buffer)
+    return this->buffer_start_position + static_cast<std::streamoff>(this->position_in_buffer);
   else
-    stream_ptr->seekg(saved_get_positions[pos]);
-    
+    return std::streampos(-1); // use -1 to signify eof 
+}
+
+template <class RecordT, class OptionsT>
+Succeeded
+InputStreamWithRecords<RecordT, OptionsT>::
+set_stream_position(const std::streampos& pos)
+{
+  if (is_null_ptr(stream_ptr))
+    return Succeeded::no;
+
+  // we might have read up to EOF, but still need to be able to go back
+  if (stream_ptr->eof()) 
+    stream_ptr->clear();
+  if (pos == std::streampos(-1))
+    {
+      stream_ptr->seekg(0, std::ios::end); // go to eof
+      this->clear_buffer(stream_ptr->tellg());
+      this->end_of_stream = true;
+    }
+  else
+    {
+      stream_ptr->seekg(pos);
+      this->clear_buffer(pos);
+    }
+
   if (!stream_ptr->good())
     return Succeeded::no;
   else
@@ -222,6 +222,10 @@ write_basic_interfile(const std::string& filename,
   
   \param openmode Mode for opening the data file. ios::binary will be added by the code.
 
+  When the data are opened read-only (i.e. \a openmode is \c std::ios::in) and the
+  environment variable \c STIR_MMAP_PROJDATA is set to a non-zero value, a
+  ProjDataFromMappedFile object is returned.
+
   \warning it is up to the caller to deallocate the object  
 */
 ProjDataFromStream* read_interfile_PDFS(std::istream& input,
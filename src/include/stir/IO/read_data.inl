@@ -31,6 +31,8 @@
 #include "stir/detail/test_if_1d.h"
 #include "stir/IO/read_data_1d.h"
 #include <typeinfo>
+#include <limits>
+#include <algorithm>
 
 START_NAMESPACE_STIR
 
@@ -70,6 +72,25 @@ namespace detail
 		 IStreamT& s, Array<num_dimensions,elemT>& data, 
 		 const ByteOrder byte_order)
   {
+    if (data.is_contiguous())
+      {
+	// read all data via 1D arrays using the same memory. As the size of a 1D array
+	// is an int, large arrays are read in chunks (of less than 2 GB).
+	const std::size_t num_elements = data.size_all();
+	const std::size_t max_chunk_size =
+	  static_cast<std::size_t>(std::numeric_limits<int>::max())/sizeof(elemT);
+	elemT * const full_data_ptr = data.get_full_data_ptr();
+	Succeeded success = Succeeded::yes;
+	for (std::size_t start=0; start<num_elements && success==Succeeded::yes; start+=max_chunk_size)
+	  {
+	    const std::size_t chunk_size = std::min(max_chunk_size, num_elements-start);
+	    Array<1,elemT> data_1d(IndexRange<1>(static_cast<int>(chunk_size)),
+				   full_data_ptr + start);
+	    success = read_data_1d(s, data_1d, byte_order);
+	  }
+	data.release_full_data_ptr();
+	return success;
+      }
     for (typename Array<num_dimensions,elemT>::iterator iter= data.begin();
 	 iter != data.end();
 	 ++iter)
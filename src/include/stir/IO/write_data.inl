@@ -31,6 +31,8 @@
 #include "stir/detail/test_if_1d.h"
 #include "stir/IO/write_data_1d.h"
 #include <typeinfo>
+#include <limits>
+#include <algorithm>
 
 START_NAMESPACE_STIR
 
@@ -101,6 +103,28 @@ namespace detail
 					  const ByteOrder byte_order,
 					  const bool can_corrupt_data)
   {
+    if (data.is_contiguous())
+      {
+	// write all data via 1D arrays using the same memory. As the size of a 1D array
+	// is an int, large arrays are written in chunks (of less than 2 GB).
+	const std::size_t num_elements = data.size_all();
+	const std::size_t max_chunk_size =
+	  static_cast<std::size_t>(std::numeric_limits<int>::max())/sizeof(elemT);
+	elemT * const full_data_ptr = const_cast<elemT *>(data.get_const_full_data_ptr());
+	Succeeded success = Succeeded::yes;
+	for (std::size_t start=0; start<num_elements && success==Succeeded::yes; start+=max_chunk_size)
+	  {
+	    const std::size_t chunk_size = std::min(max_chunk_size, num_elements-start);
+	    const Array<1,elemT> data_1d(IndexRange<1>(static_cast<int>(chunk_size)),
+					 full_data_ptr + start);
+	    success =
+	      write_data_with_fixed_scale_factor(s, data_1d, output_type, 
+						 scale_factor, byte_order,
+						 can_corrupt_data);
+	  }
+	data.release_const_full_data_ptr();
+	return success;
+      }
     for (typename Array<num_dimensions,elemT>::const_iterator iter= data.begin();
 	 iter != data.end();
 	 ++iter)
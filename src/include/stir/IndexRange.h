@@ -122,6 +122,9 @@ public:
 			 BasicCoordinate<num_dimensions, int>& min,
 			 BasicCoordinate<num_dimensions, int>& max) const;
 
+  //! return the total number of elements in an array with this range
+  inline std::size_t size_all() const;
+
 #ifdef STIR_NO_MUTABLE
   //! checks if the range is 'regular'
   inline bool is_regular();
@@ -161,6 +164,8 @@ public:
   inline int get_min_index() const;
   inline int get_max_index() const;
   inline int get_length() const;
+  //! identical to get_length() (but returns 0 for an empty range)
+  inline std::size_t size_all() const;
 
   inline bool operator==(const IndexRange<1>& range2) const;
 
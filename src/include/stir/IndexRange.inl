@@ -129,6 +129,17 @@ IndexRange<num_dimensions>::
   return true;
 }
 
+template <int num_dimensions>
+std::size_t
+IndexRange<num_dimensions>::
+  size_all() const
+{
+  std::size_t acc=0;
+  for (const_iterator iter=this->begin(); iter!=this->end(); ++iter)
+    acc += iter->size_all();
+  return acc;
+}
+
 #ifdef STIR_NO_MUTABLE
 
 template <int num_dimensions>
@@ -192,6 +203,10 @@ int
 IndexRange<1>::get_length() const
 { return max-min+1; }
 
+std::size_t
+IndexRange<1>::size_all() const
+{ return max<min ? 0 : static_cast<std::size_t>(max-min+1); }
+
 bool
 IndexRange<1>::operator==(const IndexRange<1>& range2) const
 {
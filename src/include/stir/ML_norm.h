@@ -173,6 +173,10 @@ get_fan_info(int& num_rings, int& num_detectors_per_ring,
 	     int& max_ring_diff, int& fan_size, 
 	     const ProjDataInfo& proj_data_info);
 
+//! Makes a FanProjData from the projection data
+/*! The projection data are read one segment at a time. When compiled with OpenMP,
+    the sinograms of each segment are handled in parallel.
+*/
 void make_fan_data(FanProjData& fan_data,
 			const ProjData& proj_data);
 void set_fan_data(ProjData& proj_data,
@@ -193,6 +197,11 @@ void apply_efficiencies(FanProjData& fan_data,
 
 void make_fan_sum_data(Array<2,float>& data_fan_sums, const FanProjData& fan_data);
 
+//! Computes the fan sums directly from the projection data
+/*! This gives the same result as first calling make_fan_data() and then
+    make_fan_sum_data(Array<2,float>&, const FanProjData&), but does not need to keep all 
+    data in memory, as the projection data are read one segment at a time.
+*/
 void make_fan_sum_data(Array<2,float>& data_fan_sums,
 		       const ProjData& proj_data);
 
@@ -203,6 +212,13 @@ void make_fan_sum_data(Array<2,float>& data_fan_sums,
 
 void make_block_data(BlockData3D& block_data, const FanProjData& fan_data);
 
+//! Computes the block data directly from the projection data
+/*! Equivalent to first calling make_fan_data() and then 
+    make_block_data(BlockData3D&, const FanProjData&), but reads the projection data
+    one segment at a time.
+*/
+void make_block_data(BlockData3D& block_data, const ProjData& proj_data);
+
 
 void iterate_efficiencies(DetectorEfficiencies& efficiencies,
 			  const Array<2,float>& data_fan_sums,
@@ -194,6 +194,15 @@ public:
     const shared_ptr<DataSymmetriesForViewSegmentNumbers>& symmetries_ptr,
     const bool make_num_tangential_poss_odd = false) const;   
 
+  //! Returns \c true if the get_* functions can be called by multiple threads at the same time
+  /*! The default implementation returns \c false, such that callers need to make sure 
+      that only one thread reads at a time (e.g. by using an OpenMP critical section).
+
+      A derived class that returns \c true has to make sure that all functions reading data
+      are thread-safe, i.e. get_viewgram(), get_sinogram(), get_segment_by_sinogram() and
+      get_segment_by_view() (get_related_viewgrams() uses get_viewgram()).
+  */
+  virtual bool is_thread_safe_for_reading() const { return false; }
 
   //! set all bins to the same value
   /*! will call error() if setting failed */
@@ -0,0 +1,120 @@
+/*!
+
+  \file
+  \ingroup projdata
+  \brief Declaration of class stir::ProjDataFromMappedFile
+
+  \author STIR contributors
+*/
+/*
+    Copyright (C) 2026, STIR contributors
+    This file is part of STIR.
+
+    This file is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.
+
+    This file is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    See STIR/LICENSE.txt for details
+*/
+#ifndef __stir_ProjDataFromMappedFile_H__
+#define __stir_ProjDataFromMappedFile_H__
+
+#include "stir/ProjDataFromStream.h"
+#include "stir/shared_ptr.h"
+#include <string>
+
+namespace boost { namespace interprocess {
+  class file_mapping;
+  class mapped_region;
+} }
+
+START_NAMESPACE_STIR
+
+template <int num_dimensions, typename elemT> class Array;
+
+/*!
+  \ingroup projdata
+  \brief A class which reads projection data from a read-only memory-mapped file.
+
+  The whole data file is mapped in memory. get_viewgram(), get_sinogram()
+  and the get_segment_by_* functions then copy the data from the mapped region
+  (one \c memcpy per row of tangential positions), avoiding the seeks
+  and the buffering of the stream. The data are still copied into the returned
+  object, as for ProjDataFromStream. This is only done when the data on disk
+  are floats in native byte order. For other data types (or when the mapping failed),
+  the ProjDataFromStream implementation is used.
+
+  As reading from the mapped region does not modify any state, these get_ functions
+  are thread-safe (unlike ProjDataFromStream). This is only the case when
+  is_mapped() returns true (see is_thread_safe_for_reading()).
+
+  \warning The data can only be read. All set_ functions will fail.
+  \see read_interfile_PDFS(), which uses this class when the data are opened
+  with std::ios::in only and the environment variable \c STIR_MMAP_PROJDATA is set
+  to a non-zero value. By default, ProjDataFromStream is used.
+*/
+class ProjDataFromMappedFile : public ProjDataFromStream
+{
+public:
+  //! constructor taking all necessary parameters
+  /*!
+    \param s stream for the data file, used when the data cannot be read from the
+    mapped region (e.g. when they need conversion)
+    \param data_filename name of the file with the binary data (i.e. the file
+    corresponding to \a s).
+    Other parameters are as for ProjDataFromStream.
+  */
+  ProjDataFromMappedFile (shared_ptr<ExamInfo> const& exam_info_sptr,
+			  shared_ptr<ProjDataInfo> const& proj_data_info_ptr,
+			  shared_ptr<std::iostream> const& s,
+			  const std::string& data_filename,
+			  const std::streamoff offs,
+			  const std::vector<int>& segment_sequence_in_stream,
+			  StorageOrder o = Segment_View_AxialPos_TangPos,
+			  NumericType data_type = NumericType::FLOAT,
+			  ByteOrder byte_order = ByteOrder::native,
+			  float scale_factor = 1 );
+
+  //! Returns true if the data are read from the mapped region
+  bool is_mapped() const;
+
+  //! Returns is_mapped()
+  bool is_thread_safe_for_reading() const;
+
+  Viewgram<float> get_viewgram(const int view_num, const int segment_num,const bool make_num_tangential_poss_odd=false) const;
+  Sinogram<float> get_sinogram(const int ax_pos_num, const int segment_num,const bool make_num_tangential_poss_odd=false) const;
+  SegmentBySinogram<float> get_segment_by_sinogram(const int segment_num) const;
+  SegmentByView<float> get_segment_by_view(const int segment_num) const;
+
+  //! Always returns Succeeded::no
+  Succeeded set_viewgram(const Viewgram<float>& v);
+  //! Always returns Succeeded::no
+  Succeeded set_sinogram(const Sinogram<float>& s);
+  //! Always returns Succeeded::no
+  Succeeded set_segment(const SegmentBySinogram<float>&);
+  //! Always returns Succeeded::no
+  Succeeded set_segment(const SegmentByView<float>&);
+
+private:
+  shared_ptr<boost::interprocess::file_mapping> file_mapping_sptr;
+  shared_ptr<boost::interprocess::mapped_region> mapped_region_sptr;
+  //! start of the mapped data (or 0 if we cannot read directly from the mapped region)
+  const char * mapped_data_ptr;
+
+  //! copy rows of floats from the mapped region into a 2D array
+  /*! Rows are read starting at \a start_offset (relative to the start of the file), where
+      consecutive rows are separated by \a intra_rows_offset bytes (on top of the size of a row).
+  */
+  void read_rows(Array<2,float>& rows,
+		 const std::streamoff start_offset, const std::streamoff intra_rows_offset) const;
+};
+
+END_NAMESPACE_STIR
+
+#endif
@@ -166,6 +166,7 @@ private:
   //! Calculate the offset for the given segmnet
   std::streamoff get_offset_segment(const int segment_num) const;
   
+protected:
   //! Calculate offsets for viewgram data  
   std::vector<std::streamoff> get_offsets(const int view_num, const int segment_num) const;
   //! Calculate offsets for sinogram data
@@ -378,6 +378,14 @@ protected:
   
   //! pointer to (*this)[0] (taking get_min_index() into account that is).
   T *num;	
+
+  //! let the vector use existing memory (no initialisation)
+  /*! Any memory owned by the vector is deallocated first. Afterwards, owns_memory_for_data()
+      will return \c false. This is similar to using the constructor with \a data_ptr, but 
+      is needed to do this for existing objects (as in Array).
+  */
+  inline void init_with_external_data(const int min_index, const int max_index, 
+				      T * const data_ptr);
   
   //! Called internally to see if all variables are consistent
   inline void check_state() const;
@@ -89,6 +89,12 @@ class Succeeded;
 	  appropriate voxel sizes, i.e. it is up to the backprojector to perform
 	  the zooming.
 	  - So, no zooming is needed on the final image.
+
+  \par Multi-threading
+  When STIR is compiled with OpenMP, the basic views of every segment are
+  processed in parallel (forward projection of missing data, Colsher filter
+  and backprojection). Threads other than the master thread backproject into
+  their own image, which is added to the output image at the end of every segment.
      
 
 */
@@ -155,6 +161,12 @@ protected:
     void do_forward_project_view(RelatedViewgrams<float> & viewgrams,
                                  int rmin, int rmax,
                                  int orig_min_ring, int orig_max_ring) const; 
+//!  Set up the Colsher filter for a segment.
+    /*! Has to be called before do_colsher_filter_view() for viewgrams in this segment.
+      \a num_axial_poss and \a num_tangential_poss are the sizes of the viewgrams to be filtered.
+    */
+    void do_colsher_filter_set_up(const int seg_num,
+                                  const int num_axial_poss, const int num_tangential_poss);
 //!  Apply Colsher filter to 8 viewgrams.
     void do_colsher_filter_view( RelatedViewgrams<float> & viewgrams);
 //!  3D backprojection implentation for 8 viewgrams.
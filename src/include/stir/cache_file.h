@@ -0,0 +1,103 @@
+/*
+    Copyright (C) 2026, STIR contributors
+    This file is part of STIR.
+
+    This file is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.
+
+    This file is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    See STIR/LICENSE.txt for details
+*/
+/*!
+  \file
+  \ingroup buildblock
+  \brief Declaration of functions for writing and reading binary cache files
+
+  \author STIR contributors
+*/
+
+#ifndef __stir_cache_file_H__
+#define __stir_cache_file_H__
+
+#include "stir/common.h"
+#include <boost/cstdint.hpp>
+#include <string>
+#include <iostream>
+#include <fstream>
+
+START_NAMESPACE_STIR
+
+class Succeeded;
+
+/*!
+  \name Binary cache files
+  \ingroup buildblock
+
+  Some classes store results that are expensive to compute in a binary file, such that
+  a later run can read (or memory-map) them. These functions handle what all these files
+  have in common. A cache file starts with a header
+  - \c magic (8 bytes, identifies the type of file)
+  - \c version (uint32)
+  - a byte order check (uint32). Data are stored in native byte order, so a file
+    written on a computer with a different byte order is not accepted.
+  - \c flags (uint32, their meaning depends on the type of file)
+  - \c data_size (uint64), the number of bytes that follow the header
+  - the size of the description (uint32) and the \c description. The description
+    lists everything that the data depend on. A file with a different description
+    is not accepted.
+  - padding with zeroes up to a multiple of 16 bytes, such that the data are aligned
+    when the file is memory-mapped.
+
+  The file is first written to a temporary file (see create_unique_temporary_file()), which is
+  renamed when it is complete. Other processes therefore never see an incomplete file, even
+  when they write the same cache at the same time.
+*/
+//@{
+
+//! Opens a temporary file for writing the cache file \a filename
+/*! \return the name of the temporary file, or an empty string (after a warning) if it
+    could not be opened. */
+std::string open_cache_file_for_writing(std::ofstream& s, const std::string& filename);
+
+//! Closes the stream and renames the temporary file to \a filename
+/*! The temporary file is removed (after a warning) if writing or renaming failed. */
+Succeeded finish_writing_cache_file(std::ofstream& s, const std::string& tmp_filename,
+                                    const std::string& filename);
+
+//! Writes the header of a cache file
+/*! \a magic has to point to 8 characters. */
+void write_cache_file_header(std::ostream& s, const char * magic, const boost::uint32_t version,
+                             const boost::uint32_t flags, const boost::uint64_t data_size,
+                             const std::string& description);
+
+//! Reads and checks the header of a cache file
+/*! Returns Succeeded::no if \a magic, \a version, the byte order or \a description are
+    different, or if the size of the rest of the file is not \a data_size (i.e.
+    the file is probably incomplete). \a s has to be positioned at the start of the file.
+    On success, it is positioned at the start of the data.
+*/
+Succeeded read_cache_file_header(std::istream& s, const char * magic, const boost::uint32_t version,
+                                 const std::string& description,
+                                 boost::uint32_t& flags, boost::uint64_t& data_size);
+
+//! Returns the size of the header written by write_cache_file_header()
+std::size_t get_cache_file_header_size(const std::string& description);
+
+//! Returns a description of the size and modification time of a file
+/*! This is intended to be added to the description of a cache file, such that the
+    cache is not used when a file it depends on is replaced.
+    Returns "file not found" if the file does not exist.
+*/
+std::string get_file_signature(const std::string& filename);
+
+//@}
+
+END_NAMESPACE_STIR
+
+#endif
@@ -77,6 +77,14 @@ public:
 		    const double start_time, const double end_time) const;
 
 
+ //! Get the average singles rates of all singles units for the interval between start_time and end_time.
+ /*! The result is indexed by singles bin index. This is equivalent to calling
+     get_singles_rate(singles_bin_index, start_time, end_time) for every singles unit,
+     but the time slices and their weights are only determined once.
+ */
+ std::vector<float> get_singles_rates(const double start_time,
+                                      const double end_time) const;
+
  //! Generate a FramesSinglesRate - containing the average rates
  //  for a frame begining at start_time and ending at end_time.
  FrameSinglesRates get_rates_for_frame(double start_time,
@@ -179,6 +187,11 @@ private:
  
  // Indexed by time slice and singles bin index.
  Array<2, int> _singles;
+
+ // Running sums of _singles over time slices, indexed by time slice and singles bin index.
+ // _cumulative_singles[s][b] is the sum of _singles[slice][b] for all slice < s, such that
+ // the sum over any range of time slices costs 2 lookups. It has _num_time_slices+1 rows.
+ Array<2, double> _cumulative_singles;
  
  std::vector<double> _times;
  std::vector<int> _total_prompts;
@@ -202,6 +215,26 @@ private:
 
  // get slice start time.
  double get_slice_start(int slice_index) const;
+
+ // Recompute _cumulative_singles from _singles.
+ void set_up_cumulative_singles();
+
+ // Find the time slices and weights for averaging over the interval between
+ // start_time and end_time. The average is then given by
+ // (start_fraction*singles[start_slice] + sum of singles over the intervening slices
+ //  + end_fraction*singles[end_slice]) / total_slices
+ // where start_fraction=1 and end_fraction=0 if start_slice==end_slice.
+ void get_interval_weights(int& start_slice, int& end_slice,
+                           double& start_fraction, double& end_fraction,
+                           float& total_slices,
+                           const double start_time, const double end_time) const;
+
+ // Compute the average for a single singles unit, given the output of get_interval_weights().
+ inline float
+   get_average_singles_rate(const int singles_bin_index,
+                            const int start_slice, const int end_slice,
+                            const double start_fraction, const double end_fraction,
+                            const float total_slices) const;
  
 
  virtual void set_defaults();
@@ -0,0 +1,113 @@
+/*!
+  \file
+  \ingroup buildblock_detail
+  \brief Functions for use in the implementation of stir::Array to allocate
+  a block of elements at an aligned address.
+
+  \author STIR contributors
+
+*/
+/*
+    Copyright (C) 2026, STIR contributors
+    This file is part of STIR.
+
+    This file is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.
+
+    This file is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    See STIR/LICENSE.txt for details
+*/
+
+#ifndef __stir_detail_aligned_allocation_H__
+#define __stir_detail_aligned_allocation_H__
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace stir {
+  namespace detail {
+    /*! \ingroup buildblock_detail
+       \brief alignment (in bytes) of blocks allocated with allocate_aligned_array()
+
+       This is the size of a cache line on most current processors, which is also
+       sufficient for all SIMD instructions (up to 512 bits).
+    */
+    const std::size_t array_data_alignment = 64;
+
+    /*! \ingroup buildblock_detail
+       \brief allocates and default-initialises \a num_elements objects at an address
+       which is a multiple of array_data_alignment
+
+       The block has to be deallocated with deallocate_aligned_array().
+       Returns 0 if \a num_elements is 0. Throws std::bad_alloc if there is
+       not enough memory.
+
+       Implementation note: this does not rely on \c posix_memalign or similar
+       (which are not available on all systems), but allocates a larger block
+       with \c std::malloc. The start of that block and the number of elements are
+       stored just before the aligned address.
+    */
+    template <typename elemT>
+    inline elemT *
+    allocate_aligned_array(const std::size_t num_elements)
+    {
+      if (num_elements == 0)
+        return 0;
+      const std::size_t header_size = sizeof(void *) + sizeof(std::size_t);
+      char * const raw_ptr =
+        static_cast<char *>(std::malloc(num_elements*sizeof(elemT) + header_size + array_data_alignment));
+      if (raw_ptr == 0)
+        throw std::bad_alloc();
+      const std::size_t offset =
+        (header_size + array_data_alignment - 1) -
+        (reinterpret_cast<std::size_t>(raw_ptr) + header_size + array_data_alignment - 1) % array_data_alignment;
+      char * const aligned_ptr = raw_ptr + offset;
+      reinterpret_cast<void **>(aligned_ptr)[-1] = raw_ptr;
+      reinterpret_cast<std::size_t *>(aligned_ptr - sizeof(void *))[-1] = num_elements;
+
+      elemT * const data_ptr = reinterpret_cast<elemT *>(aligned_ptr);
+      std::size_t i = 0;
+      try
+        {
+          for (; i<num_elements; ++i)
+            new (data_ptr + i) elemT;
+        }
+      catch (...)
+        {
+          while (i>0)
+            data_ptr[--i].~elemT();
+          std::free(raw_ptr);
+          throw;
+        }
+      return data_ptr;
+    }
+
+    /*! \ingroup buildblock_detail
+       \brief destructs the elements and deallocates a block allocated by allocate_aligned_array()
+
+       Does nothing if \a data_ptr is 0.
+    */
+    template <typename elemT>
+    inline void
+    deallocate_aligned_array(elemT * const data_ptr)
+    {
+      if (data_ptr == 0)
+        return;
+      char * const aligned_ptr = reinterpret_cast<char *>(data_ptr);
+      void * const raw_ptr = reinterpret_cast<void **>(aligned_ptr)[-1];
+      const std::size_t num_elements = reinterpret_cast<std::size_t *>(aligned_ptr - sizeof(void *))[-1];
+      for (std::size_t i=num_elements; i>0; --i)
+        data_ptr[i-1].~elemT();
+      std::free(raw_ptr);
+    }
+  }
+}
+
+#endif
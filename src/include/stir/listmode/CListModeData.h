@@ -29,6 +29,8 @@
 #include "stir/Scanner.h"
 #include "stir/shared_ptr.h"
 #include <string>
+#include <vector>
+#include <ios>
 #include <ctime>
 
 # ifdef BOOST_NO_STDC_NAMESPACE
@@ -181,6 +183,19 @@ public:
   virtual 
     Succeeded get_next_record(CListRecord& event) const = 0;
 
+  //! Gets the next records in the listmode sequence
+  /*! Attempts to fill all records in \a records, which have to be of the correct type
+      (i.e. normally obtained via get_empty_record_sptr()). 
+
+      \return the number of records read. This is only less than <code>records.size()</code>
+      at the end of the list mode data (or when an error occured).
+
+      The default implementation calls get_next_record() repeatedly. Derived classes can
+      provide a more efficient version.
+  */
+  virtual
+    std::size_t get_next_records(const std::vector<shared_ptr<CListRecord> >& records) const;
+
   //! Call this function if you want to re-start reading at the beginning.
   virtual 
     Succeeded reset() = 0;
@@ -211,6 +226,29 @@ public:
   virtual
     Succeeded set_get_position(const SavedPosition&) = 0;
 
+  //! Get the position in the file of the next record
+  /*! In contrast to save_get_position(), the position is valid for every
+      CListModeData object reading the same file. It can therefore be stored,
+      as in CListModeDataTimeIndex.
+
+      The default implementation returns Succeeded::no, i.e. the facility
+      is not supported (e.g. when the data is spread over multiple files).
+  */
+  virtual
+    Succeeded get_file_position(std::streampos& pos) const;
+
+  //! Set the position for reading to a value obtained with get_file_position()
+  /*! The default implementation returns Succeeded::no. */
+  virtual
+    Succeeded set_file_position(const std::streampos& pos);
+
+  //! Get the size of the file that get_file_position() refers to
+  /*! This can be used to check if stored positions still correspond to the data.
+      The default implementation returns Succeeded::no.
+  */
+  virtual
+    Succeeded get_file_size(std::streamoff& size) const;
+
   //! Get scanner pointer  
   /*! Returns a pointer to a scanner object that is appropriate for the 
       list mode data that is being read.
@@ -93,6 +93,8 @@ private:
   std::string listmode_filename_prefix;
   mutable unsigned int current_lm_file;
   mutable shared_ptr<InputStreamWithRecords<CListRecordT, bool> > current_lm_data_ptr;
+  //! record that is copied by get_empty_record_sptr()
+  shared_ptr<CListRecordT> empty_record_sptr;
   //! a vector that stores the saved_get_positions for ever .lm file
   mutable std::vector<std::vector<std::streampos> > saved_get_positions_for_each_lm_data;
   typedef std::pair<unsigned int, SavedPosition> GetPosition;
@@ -63,6 +63,11 @@ public:
   virtual 
     Succeeded get_next_record(CListRecord& record) const;
 
+  //! Gets the next records in the listmode sequence
+  /*! Reads the records directly from the underlying (buffered) stream. */
+  virtual
+    std::size_t get_next_records(const std::vector<shared_ptr<CListRecord> >& records) const;
+
   virtual 
     Succeeded reset();
 
@@ -72,6 +77,15 @@ public:
   virtual
     Succeeded set_get_position(const SavedPosition&);
 
+  virtual
+    Succeeded get_file_position(std::streampos& pos) const;
+
+  virtual
+    Succeeded set_file_position(const std::streampos& pos);
+
+  virtual
+    Succeeded get_file_size(std::streamoff& size) const;
+
   //! returns \c true, as ECAT listmode data stores delayed events (and prompts)
   /*! \todo this might depend on the acquisition parameters */
   virtual bool has_delayeds() const { return true; }
@@ -81,6 +95,8 @@ private:
   std::string listmode_filename;
   shared_ptr<InputStreamWithRecords<CListRecordT, bool> > current_lm_data_ptr;
   shared_ptr<ProjDataInfo> proj_data_info_sptr;
+  //! record that is copied by get_empty_record_sptr()
+  shared_ptr<CListRecordT> empty_record_sptr;
   InterfileHeader interfile_parser;
   // members to store info from the interfile header.
   // These tell us something about how the listmode is stored.
@@ -0,0 +1,110 @@
+/*
+    Copyright (C) 2026, STIR contributors
+    This file is part of STIR.
+
+    This file is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.
+
+    This file is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    See STIR/LICENSE.txt for details
+*/
+/*!
+  \file
+  \ingroup listmode
+  \brief Declaration of class stir::CListModeDataTimeIndex
+
+  \author STIR contributors
+*/
+
+#ifndef __stir_listmode_CListModeDataTimeIndex_H__
+#define __stir_listmode_CListModeDataTimeIndex_H__
+
+#include "stir/common.h"
+#include <vector>
+#include <string>
+#include <ios>
+
+START_NAMESPACE_STIR
+
+class CListModeData;
+class Succeeded;
+
+/*!
+  \brief An index of the time records in list mode data
+  \ingroup listmode
+
+  CListModeData::save_get_position() only allows going back to a position that
+  has been read before. This class stores the file positions of time records, such
+  that reading can start (close to) any time without going through all the previous
+  records.
+
+  The index is built in a single pass through the data, and can be written to and read
+  from a (text) file, normally stored next to the list mode data. The file stores the
+  name (see CListModeData::get_name()) and the size (see CListModeData::get_file_size())
+  of the list mode data. read_from_file() refuses an index that was built for other data. Only a time record
+  that is at least \c min_interval_in_secs after the previous entry is stored, to
+  keep the index small.
+
+  Each entry corresponds to the position of a time record, i.e. after setting the
+  position with set_get_position(), the next record read is the time record of the
+  entry.
+
+  \warning Only list mode data that supports CListModeData::get_file_position()
+  and CListModeData::get_file_size() can be indexed.
+  \warning The list mode data is assumed to be in chronological order.
+*/
+class CListModeDataTimeIndex
+{
+public:
+  //! Construct an empty index
+  CListModeDataTimeIndex();
+
+  //! Build the index by going through all records of \a lm_data
+  /*! The data is read from the start, and reset() is called at the end.
+  */
+  Succeeded build(CListModeData& lm_data, const double min_interval_in_secs = 1.);
+
+  //! Read the index from file
+  /*! Fails (with a warning) if the index was not built for \a lm_data, i.e. if the
+      name or the size of the list mode data is different.
+  */
+  Succeeded read_from_file(const std::string& filename, const CListModeData& lm_data);
+
+  //! Write the index to file
+  Succeeded write_to_file(const std::string& filename) const;
+
+  bool is_empty() const
+    { return times.empty(); }
+
+  std::size_t get_num_entries() const
+    { return times.size(); }
+
+  //! Get time (in secs) of the time record of an entry
+  double get_time_in_secs(const std::size_t entry_num) const
+    { return times[entry_num]; }
+
+  //! Find the last entry with a time strictly smaller than \a time_in_secs
+  /*! \return \c false if there is no such entry */
+  bool find_entry_before(std::size_t& entry_num, const double time_in_secs) const;
+
+  //! Set the reading position of \a lm_data to the time record of an entry
+  Succeeded set_get_position(CListModeData& lm_data, const std::size_t entry_num) const;
+
+private:
+  //! name of the list mode data used by build()
+  std::string lm_data_name;
+  //! size of the list mode file used by build()
+  std::streamoff lm_file_size;
+  std::vector<double> times;
+  std::vector<std::streamoff> positions;
+};
+
+END_NAMESPACE_STIR
+
+#endif
@@ -34,6 +34,7 @@
 #include "stir/listmode/CListModeData.h"
 #include "stir/ParsingObject.h"
 #include "stir/TimeFrameDefinitions.h"
+#include "stir/listmode/CListModeDataTimeIndex.h"
 
 #include "stir/recon_buildblock/BinNormalisation.h"
 
@@ -74,6 +75,10 @@ class CListTime;
     ; or a total number of events (if  larger than 0, frame definitions will be ignored)
     ; note that this normally counts the total of prompts-delayeds (see below)
     num_events_to_store := -1
+    ; optional file with a CListModeDataTimeIndex, used to skip directly
+    ; to the start of a frame. It will be created if it does not exist yet,
+    ; and rebuilt if it was created for a different list mode file.
+    time index filename :=
 
   ; parameters relating to prompts and delayeds
 
@@ -108,6 +113,11 @@ class CListTime;
     ; if you're short of RAM (i.e. a single projdata does not fit into memory),
     ; you can use this to process the list mode data in multiple passes.
     num_segments_in_memory := -1
+    ; when using multiple passes, you can avoid reading the list mode data 
+    ; more than once by storing events for the other segments in 
+    ; temporary files (next to the output). This needs at most about twice
+    ; the size of these segments on disk.
+    use scratch files := 0
 
   End := 
   \endverbatim
@@ -194,6 +204,18 @@ protected:
     normalisation or angle info for a rotating scanner.*/
   virtual void get_bin_from_event(Bin& bin, const CListEvent&) const;
 
+  //! Returns \c true if get_bin_from_event() can be called for several events in parallel
+  /*! When binning time frames, events are binned in batches. get_bin_from_event() and
+      do_post_normalisation() are then called from different threads, and possibly after
+      process_new_time_event() has been called for a later time event. (This is avoided
+      if the normalisation is non-trivial.) If one of them calls error() (e.g. in
+      BinNormalisation::get_bin_efficiency()), the other threads stop binning and
+      error() is called again after the batch.
+      The default returns \c true. Derived classes that depend on the order of the events,
+      or on the state set by process_new_time_event(), should return \c false.
+  */
+  virtual bool can_bin_events_in_parallel() const;
+
   //! A function that should return the number of uncompressed bins in the current bin
   /*! \todo it is not compatiable with e.g. HiDAC doesn't belong here anyway
       (more ProjDataInfo?)
@@ -221,10 +243,19 @@ protected:
   //! frame definitions
   /*! Will be read using TimeFrameDefinitions */
   std::string frame_definition_filename;
+  //! file with the time index of the list mode data (optional)
+  std::string time_index_filename;
   bool do_pre_normalisation;
   bool store_prompts;
   bool store_delayeds;
   int num_segments_in_memory;
+  //! if true, events for segments that are not in memory are written to scratch files
+  /*! This avoids reading the list mode data more than once when 
+      num_segments_in_memory is less than the number of segments.
+      Events are accumulated per segment, so the disk space needed does not
+      grow with the number of events.
+  */
+  bool use_scratch_files;
   // TODO make long (or even unsigned long) but can't do this yet because we can't parse longs yet
   int num_events_to_store;
   int max_segment_num_to_process;
@@ -247,6 +278,10 @@ protected:
   //! Time frames
   TimeFrameDefinitions frame_defs;
 
+  //! Index of the time records, used to skip to the start of a frame
+  /*! Empty if not used (or not supported by the list mode data) */
+  CListModeDataTimeIndex time_index;
+
   //! stores the time (in secs) recorded in the previous timing event
   double current_time;
   //! stores the current frame number
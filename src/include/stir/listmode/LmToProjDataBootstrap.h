@@ -89,6 +89,8 @@ protected:
 
   virtual void get_bin_from_event(Bin& bin, const CListEvent&) const;
 
+  //! returns \c false, as events are replicated in the order they are read
+  virtual bool can_bin_events_in_parallel() const { return false; }
 
   // \name parsing variables
   //@{
@@ -85,7 +85,14 @@ inline void inverse_fourier(T& c, const int sign=1)
   \param[in] sign This can be used to implement a different convention for the DFT
 
   \warning Currently, the array has to be indexed from 0.
-  \warning Currently, the length of the array has to be a power of 2.
+
+  Any length is supported. Lengths that are a power of 2 use an in-place
+  radix-2 algorithm. Other lengths use a mixed-radix algorithm, which needs a
+  temporary copy of the data. This is fastest when the length has only small 
+  prime factors (e.g. 2, 3 and 5).
+
+  The twiddle factors for a given length are computed once and cached. This function
+  is thread-safe (when the threads work on different data).
    
   The convention used is as follows.
   For a vector of length \a n, the result is
@@ -180,13 +187,37 @@ inverse_fourier_1d_for_real_data(const Array<1,std::complex<T> >& c, const int s
 
   \brief As inverse_fourier_1d_for_real_data(), but avoiding the copy of the input array.
 
-  \warning destroys values in (and resizes) first argument \a c
+  \warning destroys values in first argument \a c
   \see inverse_fourier_1d_for_real_data()
 */
 template <typename T>
 Array<1,T>
   inverse_fourier_1d_for_real_data_corrupting_input(Array<1,std::complex<T> >& c, const int sign);
 
+/*! \ingroup DFT
+
+  \brief Compute the one-dimensional discrete fourier transform of every row of a real 2D array.
+
+  This gives the same result as calling fourier_1d_for_real_data() for every row, but is
+  faster as the twiddle factors are looked up only once. The result is a regular array.
+
+  \warning \a c has to be a regular array with rows of even length and indexed from 0.
+  The outer index of \a c can start from any value.
+*/
+template <typename T>
+Array<2,std::complex<T> >
+fourier_1d_for_real_data_of_rows(const Array<2,T>& c, const int sign = 1);
+
+/*! \ingroup DFT
+
+  \brief Compute the inverse of fourier_1d_for_real_data_of_rows().
+
+  \warning destroys values in first argument \a c
+*/
+template <typename T>
+Array<2,T>
+inverse_fourier_1d_for_real_data_of_rows_corrupting_input(Array<2,std::complex<T> >& c, const int sign = 1);
+
 /*! \ingroup DFT
 
   \brief Compute discrete fourier transform of a real array (with the last dimensions of even size).
@@ -231,7 +262,7 @@ template <int num_dimensions, typename T>
 
   \brief As inverse_fourier_for_real_data(), but avoiding the copy of the input array.
 
-  \warning destroys values in (and resizes) first argument \a c
+  \warning destroys values in first argument \a c
   \see inverse_fourier_for_real_data()
 */
 template <int num_dimensions, typename T>
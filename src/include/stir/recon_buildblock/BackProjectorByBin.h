@@ -105,6 +105,12 @@ public:
 		   const int min_axial_pos_num, const int max_axial_pos_num,
 		   const int min_tangential_pos_num, const int max_tangential_pos_num);
 
+  //! Get the wall-clock time (in seconds) spent in back_project() since construction
+  /*! When back_project() is called by multiple threads at the same time, the times of
+      all threads are added. The total is updated atomically, so this can be used
+      when projecting in parallel (unlike the CPU timer of the TimedObject base class).
+  */
+  double get_projection_time() const;
 
 protected:
 
@@ -120,7 +126,7 @@ private:
 	    const int start_tang_pos_num,const int end_tang_pos_num,
 	    const int start_view, const int end_view);
 
-
+  double projection_time;
 };
 
 END_NAMESPACE_STIR
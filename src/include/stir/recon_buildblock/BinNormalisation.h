@@ -74,6 +74,10 @@ public:
   /*! With the notation of the class documentation, this returns the factor
     \f$\mathrm{norm}_b \f$. 
 
+    After set_up(), this function has to be safe to call from multiple threads at
+    the same time (it is for instance called in parallel by LmToProjData). Derived
+    classes that store state (e.g. a cache) need to take care of this themselves.
+
     \warning Some derived classes might implement this very inefficiently.
   */
   virtual float get_bin_efficiency(const Bin& bin,const double start_time, const double end_time) const =0;
@@ -41,7 +41,11 @@
 #include "stir/Scanner.h"
 #include "stir/IO/stir_ecat7.h"
 #include "stir/Array.h"
+#include "stir/VectorWithOffset.h"
 #include <string>
+#include <vector>
+#include <utility>
+#include <cstddef>
 
 START_NAMESPACE_STIR
 START_NAMESPACE_ECAT
@@ -72,8 +76,33 @@ START_NAMESPACE_ECAT7
   ; use_dead_time:=1
   ; use_geometric_factors:=1
   ; use_crystal_interference_factors:=1
+
+  ; next keywords can be used to compute the normalisation factors for all bins
+  ; once per time frame, see below
+  ; cache_normalisation_factors:=0
+  ; cache_filename_prefix:=
   End Bin Normalisation From ECAT7:=
   \endverbatim
+
+  \par Caching of the normalisation factors
+  Computing the normalisation factor for a bin involves a loop over all 
+  contributing detector pairs (and hence a lot of look-ups in the singles rates
+  for the dead-time correction). When \c cache_normalisation_factors is set, the
+  factors for all bins are computed when they are first needed for a time frame 
+  (or by set_up() when they do not depend on the time frame), 
+  after which get_bin_efficiency(), apply() and undo() just look them up. 
+  The factors are recomputed when a different time frame is used.
+
+  With OpenMP, the factors are computed in parallel. When the factors for a new time
+  frame are first needed inside a parallel region (e.g. by apply()), one thread computes
+  them (inside a critical section) while the other threads that need them wait.
+
+  When \c cache_filename_prefix is set as well, the factors are written to a file
+  (in native byte order). The name of the file is 
+  constructed from the prefix and the start and end time of the frame (in ms).
+  Later runs memory-map an existing file if it was written for the same
+  parameters, projection data, normalisation file (checked via its size and modification time)
+  and time frame. See cache_file.h for the format of the header.
  
 */
 class BinNormalisationFromECAT7 :
@@ -97,6 +126,14 @@ public:
   virtual Succeeded set_up(const shared_ptr<ProjDataInfo>&);
   float get_bin_efficiency(const Bin& bin, const double start_time, const double end_time) const;
 
+  //! Normalise some data
+  /*! Overloaded to look up the factors only once per call when caching them. */
+  virtual void apply(RelatedViewgrams<float>& viewgrams,const double start_time, const double end_time) const;
+
+  //! Undo the normalisation of some data
+  /*! Overloaded to look up the factors only once per call when caching them. */
+  virtual void undo(RelatedViewgrams<float>& viewgrams,const double start_time, const double end_time) const;
+
   bool use_detector_efficiencies() const;
   bool use_dead_time() const;
   bool use_geometric_factors() const;
@@ -126,9 +163,55 @@ private:
   bool _use_geometric_factors;
   bool _use_crystal_interference_factors;
 
+  bool _cache_normalisation_factors;
+  std::string cache_filename_prefix;
+
+  //! normalisation factors for all bins for one time frame
+  class FactorsCache;
+  //! cached factors for the last time frame (if any)
+  /*! Note: this is a shared_ptr such that other threads can still use
+     the factors for another time frame while they are being replaced. */
+  mutable shared_ptr<FactorsCache> factors_cache_sptr;
+  //! copy of factors_cache_sptr for every thread
+  /*! This allows threads to check if the factors are for the current time frame
+      without needing a critical section. */
+  mutable std::vector<shared_ptr<FactorsCache> > thread_factors_cache_sptrs;
+  //! offset of the first bin of every segment in the cache
+  VectorWithOffset<std::size_t> cache_segment_offsets;
+  //! total number of bins in the cache
+  std::size_t cache_num_bins;
+  //! segment and axial position of the sinograms in the cache (in the order in which they are stored)
+  std::vector<std::pair<int,int> > cache_sinograms;
+  //! description of the parameters (without the time frame), used to check cache files
+  std::string cache_description;
+
   void read_norm_data(const std::string& filename);
   float get_dead_time_efficiency ( const DetectionPosition<>& det_pos,
 				  const double start_time, const double end_time) const;
+  //! computes the normalisation factor for a bin (without using the cache)
+  float compute_bin_efficiency(const Bin& bin, const double start_time, const double end_time) const;
+  //! checks if the factors depend on the time frame
+  bool factors_depend_on_time_frame() const;
+  //! checks if the factors for this bin are stored in the cache
+  bool is_in_cache(const Bin& bin) const;
+  //! checks if the factors for all bins of the viewgrams are stored in the cache
+  bool is_in_cache(const RelatedViewgrams<float>& viewgrams) const;
+  //! returns the cache for this time frame, creating it if necessary
+  /*! The returned cache remains valid until this thread calls this function for another time frame.
+      \a cache_sptr is used to keep the cache alive when this is not guaranteed otherwise
+      (i.e. with nested parallelism).
+  */
+  const FactorsCache& get_factors_cache(const double start_time, const double end_time,
+                                        shared_ptr<FactorsCache>& cache_sptr) const;
+  //! creates the cache for a time frame, reading the factors from file or computing them
+  shared_ptr<FactorsCache> create_factors_cache(const double start_time, const double end_time) const;
+  //! computes the factors for all bins
+  /*! When called outside a parallel region, the sinograms are computed in parallel. */
+  void compute_factors(FactorsCache& cache) const;
+  //! name of the file for the cache for this time frame
+  std::string get_cache_filename(const double start_time, const double end_time) const;
+  //! description of the cache for this time frame, used to check cache files
+  std::string get_cache_description(const double start_time, const double end_time) const;
 
   // parsing stuff
   virtual void set_defaults();
@@ -103,6 +103,13 @@ virtual void set_up(
 
     virtual ~ForwardProjectorByBin();
 
+  //! Get the wall-clock time (in seconds) spent in forward_project() since construction
+  /*! When forward_project() is called by multiple threads at the same time, the times of
+      all threads are added. The total is updated atomically, so this can be used
+      when projecting in parallel (unlike the CPU timer of the TimedObject base class).
+  */
+  double get_projection_time() const;
+
 protected:
   //! This virtual function has to be implemented by the derived class.
   virtual void actual_forward_project(RelatedViewgrams<float>&, 
@@ -110,6 +117,8 @@ protected:
 		  const int min_axial_pos_num, const int max_axial_pos_num,
 		  const int min_tangential_pos_num, const int max_tangential_pos_num) = 0;
 
+private:
+  double projection_time;
 };
 
 END_NAMESPACE_STIR
@@ -65,6 +65,7 @@ class PETCount_rebinned
 #ifdef PARALLEL
     friend PMessage& operator<<(PMessage&, PETCount_rebinned&);
     friend PMessage& operator>>(PMessage&, PETCount_rebinned&);
+#endif
 
     PETCount_rebinned & operator+= (const PETCount_rebinned &rebin)
         {
@@ -73,7 +74,6 @@ class PETCount_rebinned
             ssrb += rebin.ssrb;
             return *this;
         }
-#endif
 // Default constructor by initialising all the elements conter to null
     explicit PETCount_rebinned(int total_v=0, int miss_v =0, int ssrb_v = 0)
         :total(total_v), miss(miss_v), ssrb(ssrb_v)
@@ -85,13 +85,18 @@ class PETCount_rebinned
 /*!
   \class FourierRebinning
   \ingroup recon_buildblock
-  \brief Class for Serial FORE Reconstruction.
+  \brief Class for FORE Reconstruction.
 
+  Segments are read one pair (with opposite ring difference) at a time, so
+  memory use does not depend on the number of segments.
+  When STIR is compiled with OpenMP, the sinograms of a segment pair are processed in
+  parallel (with every thread accumulating in its own copy of the rebinned data in Fourier
+  space), as are the final inverse FFTs of the rebinned sinograms.
 
   The digital implementation of the rebinning is done as follows:
 
   a) Initialise the 2D Fourier transform of all rebinned sinograms Pr(w,k);<BR>
-  b) Process sequentially each pair of oblique sinograms pij and pji for i,j (= 0..2*num_rings-2) as:<BR>
+  b) Process each pair of oblique sinograms pij and pji for i,j (= 0..2*num_rings-2) as:<BR>
 	- merge pij and pji to get a sinogram sampled over 2p;<BR>
 	- calculates the 2D FFT Pij(w,k) of the merged sinogram;<BR>
 	- assign each frequency component (w,k) to the rebinned sinogram of the slice lying closest axially to 
@@ -186,11 +191,16 @@ class FourierRebinning : public   RegisteredParsingObject<
        const float R_field_of_view_mm, const float ratio_ring_spacing_to_ring_radius);
 
 /*!
-  \brief This method takes as input the real 3D data set
-  (in which the number of views have been extended to a number of power of 2)
-  and  returns the rebinned sinograms in Fourier space, their weighting factors
+  \brief This method takes as input one sinogram of a pair of segments with opposite ring difference
+  and adds its contribution to the rebinned sinograms in Fourier space, their weighting factors
   as well as the counter rebinned elements
 
+  The two sinograms are merged to a sinogram sampled over 2*pi, of which the number of views
+  is then extended to \a num_views_pow2. 
+
+  This function does not modify any member variables, so it can be called in parallel
+  for different sinograms (as long as the output arguments are different).
+
   \b Rebinning <BR>
   Assign each frequency component (w,k) to the rebinned sinogram of the slice lying closest axially to
   z - (tk/w) with t=((ring0 -ring1)*ring_spacing/(2*R) with R=ring_radius, 
@@ -198,8 +208,10 @@ class FourierRebinning : public   RegisteredParsingObject<
 */
 
     void do_rebinning(Array<3,std::complex<float> > &FT_rebinned_data, Array<3,float> &Weights_for_FT_rebinned_data,
-                      PETCount_rebinned &count_rebinned, const SegmentBySinogram<float> &segment, const int num_tang_poss_pow2,
-                      const int num_views_pow2, const int num_planes, const float average_ring_difference_in_segment,
+                      PETCount_rebinned &count_rebinned, const SegmentBySinogram<float> &segment,
+                      const SegmentBySinogram<float> &segment_neg, const int axial_pos_num,
+                      const int num_tang_poss_pow2,
+                      const int num_views_pow2, const float average_ring_difference_in_segment,
                       const float half_distance_between_rings, const float sampling_distance_in_s, 
                       const float radial_sampling_freq_w, const float R_field_of_view_mm,
                       const float ratio_ring_spacing_to_ring_radius);
@@ -217,8 +229,8 @@ class FourierRebinning : public   RegisteredParsingObject<
     void do_display_count(PETCount_rebinned &num_rebinned_total);
 
 
-//! This is a function to adjust the number of views of a segment to the next power of 2
-    void do_adjust_nb_views_to_pow2(SegmentBySinogram<float> &segment) ;
+//! This is a function to adjust the number of views of a sinogram (indexed as [view][tangential_pos]) to \a num_views_pow2
+    void do_adjust_nb_views_to_pow2(Array<2,float> &sinogram, const int num_views_pow2) ;
 
 //! This function checks if the steering and input paramters for FORE are inside the possible range of parameters
     Succeeded fore_check_parameters(int num_tang_poss_pow2, int num_views_pow2, int max_segment_num_to_process);
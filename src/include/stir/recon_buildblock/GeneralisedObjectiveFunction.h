@@ -33,6 +33,7 @@
 #include "stir/ParsingObject.h"
 #include "stir/shared_ptr.h"
 #include "stir/recon_buildblock/GeneralisedPrior.h"
+#include "stir/HighResWallClockTimer.h"
 #include <string>
 START_NAMESPACE_STIR
 
@@ -220,6 +221,27 @@ public:
   std::string
     get_objective_function_values_report(const TargetT& current_estimate);
 
+  //! Compute the gradient of the prior
+  /*! This just calls the prior, but keeps track of the time spent for get_timing_report().
+      \a prior_gradient is not scaled with the number of subsets.
+  */
+  void
+    compute_prior_gradient(TargetT& prior_gradient, const TargetT& current_estimate);
+
+  //! \name Timing information
+  /*! get_timing_report() returns information on the time spent in the different
+      stages of the computation since the last call to reset_timing_report().
+      The string is a comma-separated list of JSON members (i.e. <tt>"name": value</tt>),
+      such that it can be inserted in a JSON object. Derived classes that
+      redefine these functions have to call the base class version.
+
+      The base class version only reports the time spent in compute_prior_gradient().
+  */
+  //@{
+  virtual void reset_timing_report();
+  virtual std::string get_timing_report();
+  //@}
+
   //! Return the number of subsets in-use
   int get_num_subsets() const;
 
@@ -270,6 +292,9 @@ protected:
 
   shared_ptr<GeneralisedPrior<TargetT> > prior_sptr;
 
+  //! wall-clock time spent computing the gradient of the prior
+  HighResWallClockTimer prior_gradient_timer;
+
   //! sets any default values
   /*! Has to be called by set_defaults in the leaf-class */
   virtual void set_defaults();
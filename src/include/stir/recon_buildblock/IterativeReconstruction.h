@@ -78,8 +78,20 @@ START_NAMESPACE_STIR
   ; write objective function value to stderr at certain subiterations
   ; default value of 0 means: do not write it at all.
   report_objective_function_values_interval:=0
+
+  ; write timing information to this file (default: empty, i.e. no timing report)
+  ; see below
+  timing report filename :=
   \endverbatim
 
+  \par Timing report
+  If a timing report filename is set, the file is overwritten at set_up(), and
+  after every subiteration one line is appended to it. Each line is a JSON object
+  with the subiteration number, the (wall-clock and CPU) time spent in 
+  update_estimate() and end_of_iteration_processing(), and the members
+  returned by GeneralisedObjectiveFunction::get_timing_report(). 
+  This makes it easy to analyse where the time goes with a script.
+
   \todo move subset things somewhere else
   \todo all the <code>compute</code> functions should be <code>const</code>.
  */
@@ -319,6 +331,9 @@ protected:
    */
   int report_objective_function_values_interval;
 
+  //! name of the file to which the timing report is written (empty for none)
+  std::string timing_report_filename;
+
   //! prompts the user to enter parameter values manually
   virtual void ask_parameters();
 
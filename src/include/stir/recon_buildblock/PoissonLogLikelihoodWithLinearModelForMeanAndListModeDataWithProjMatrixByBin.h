@@ -33,6 +33,8 @@
 #include "stir/recon_buildblock/PoissonLogLikelihoodWithLinearModelForMeanAndListModeData.h"
 #include "stir/recon_buildblock/ProjMatrixByBin.h" 
 #include "stir/ProjDataInMemory.h"
+#include <boost/cstdint.hpp>
+#include <vector>
 START_NAMESPACE_STIR
 
 
@@ -47,6 +49,25 @@ START_NAMESPACE_STIR
   If the list mode data is binned (with LmToProjData) without merging
   any bins, then the log likelihood computed from list mode data and
   projection data will be identical.
+
+  \par Caching the events
+
+  Normally, every call to compute_sub_gradient_without_penalty_plus_sensitivity()
+  reads and decodes the list mode data, and looks up the additive term for
+  every event. When setting the keyword <tt>cache list mode events</tt>, this
+  is only done once for the current time frame: the measured bins and their
+  additive term are stored in memory (16 bytes per event), and all other calls
+  go through this cache. The cache can also be written to file (keyword
+  <tt>list mode cache filename</tt>), such that a subsequent reconstruction of
+  the same data does not need to decode the list mode data at all.
+  If the file already exists, it is read instead of the list mode data.
+  The file (see cache_file.h) starts with a description of the size of the records,
+  the list mode and additive data filenames together with the size and modification
+  time of these files, the maximum ring difference and the time frame.
+  The file is ignored when this description does not match, or when the file is incomplete.
+  \warning The cache file is not portable between different types of computers.
+  \warning For Interfile data, only the header file is checked. The cache file has to be
+  removed when only the binary data file is replaced.
 */
 
 template <typename TargetT>
@@ -79,6 +100,16 @@ public:
 
   int set_num_subsets(const int new_num_subsets);
 
+  //! \name Timing information
+  /*! Adds the number of events processed, the time spent reading the list mode data and 
+      processing the events, and the number of cache hits and misses of the projection matrix.
+      \see GeneralisedObjectiveFunction::get_timing_report()
+  */
+  //@{
+  virtual void reset_timing_report();
+  virtual std::string get_timing_report();
+  //@}
+
 protected:
   virtual double
     actual_compute_objective_function_without_penalty(const TargetT& current_estimate,
@@ -113,6 +144,11 @@ protected:
   //! ProjDataInfo
   shared_ptr<ProjDataInfo> proj_data_info_cyl_uncompressed_ptr; 
 
+  //! if \c true, decoded events are kept in memory
+  bool cache_lm_events;
+  //! file used to store the cache (if not empty)
+  std::string cache_filename;
+
   //! sets any default values
   /*! Has to be called by set_defaults in the leaf-class */
   virtual void set_defaults();
@@ -122,6 +158,45 @@ protected:
   virtual bool post_processing();
 
   virtual bool actual_subsets_are_approximately_balanced(std::string& warning_message) const;
+
+private:
+  //! compact representation of a measured bin and its additive term
+  struct BinAndCorr
+  {
+    boost::int16_t segment_num;
+    boost::int16_t view_num;
+    boost::int16_t axial_pos_num;
+    boost::int16_t tangential_pos_num;
+    float bin_value;
+    float additive_value;
+  };
+
+  //! events of the current time frame (only used when \c cache_lm_events is \c true)
+  std::vector<BinAndCorr> record_cache;
+  //! time frame number corresponding to \c record_cache (0 if not filled)
+  int cached_frame_num;
+
+  //! description of the data in the cache, used to check if the cache file can be used
+  std::string get_cache_description() const;
+  //! read record_cache from \c cache_filename
+  Succeeded read_cache_from_file();
+  //! write record_cache to \c cache_filename
+  Succeeded write_cache_to_file() const;
+
+  //! add the contribution of \a events to the gradient
+  /*! The events are distributed over the threads, each thread accumulating in its own image
+      (see \a local_gradient_sptrs). Thread 0 uses \a gradient itself.
+  */
+  void process_events(TargetT& gradient, const TargetT& current_estimate,
+                      const std::vector<BinAndCorr>& events,
+                      std::vector<shared_ptr<TargetT> >& local_gradient_sptrs);
+
+  //! \name variables used for get_timing_report()
+  //@{
+  double num_events_processed;
+  HighResWallClockTimer list_mode_reading_timer;
+  HighResWallClockTimer event_processing_timer;
+  //@}
 };
 
 END_NAMESPACE_STIR
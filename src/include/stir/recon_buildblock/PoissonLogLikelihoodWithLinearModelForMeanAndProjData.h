@@ -33,13 +33,12 @@
 #include "stir/recon_buildblock/ProjectorByBinPair.h"
 #include "stir/recon_buildblock/BinNormalisation.h"
 #include "stir/TimeFrameDefinitions.h"
-#ifdef STIR_MPI
-#include "stir/recon_buildblock/distributable.h" // for  RPC_process_related_viewgrams_type
-#endif
+#include "stir/recon_buildblock/distributable.h" // for  RPC_process_related_viewgrams_type and DistributableComputationTimings
 
 START_NAMESPACE_STIR
 
 class DistributedCachingInformation;
+class ProjMatrixByBin;
 
 //#ifdef STIR_MPI_CLASS_DEFINITION
 //#define PoissonLogLikelihoodWithLinearModelForMeanAndProjData PoissonLogLikelihoodWithLinearModelForMeanAndProjData_MPI
@@ -226,6 +225,17 @@ public:
   virtual void
     add_subset_sensitivity(TargetT& sensitivity, const int subset_num) const;
 
+  //! \name Timing information
+  /*! Adds times spent reading projection data, normalisation and processing (i.e.
+      projecting), the number of bins processed, the (wall-clock) times spent in the
+      forward and back projectors and, when using a ProjMatrixByBin, the number of cache hits and misses. 
+      \see GeneralisedObjectiveFunction::get_timing_report()
+  */
+  //@{
+  virtual void reset_timing_report();
+  virtual std::string get_timing_report();
+  //@}
+
  protected:
   virtual Succeeded 
     set_up_before_sensitivity(shared_ptr <TargetT > const& target_sptr);
@@ -354,6 +364,13 @@ protected:
  private:
   shared_ptr<DataSymmetriesForViewSegmentNumbers> symmetries_sptr;
 
+  //! timing information collected by distributable_computation()
+  DistributableComputationTimings distributable_timings;
+  //! projection times when reset_timing_report() was called
+  double forward_projection_time_at_reset, back_projection_time_at_reset;
+  //! the projection matrix used by the projectors (if any)
+  shared_ptr<ProjMatrixByBin> get_proj_matrix_sptr() const;
+
   void
     add_view_seg_to_sensitivity(TargetT& sensitivity, const ViewSegmentNumbers& view_seg_nums) const;
 };
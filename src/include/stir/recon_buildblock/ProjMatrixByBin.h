@@ -41,6 +41,7 @@
 #include <boost/cstdint.hpp>
 //#include <map>
 #include <boost/unordered_map.hpp>
+#include <string>
 #ifdef STIR_OPENMP
 #include <omp.h>
 #endif
@@ -52,6 +53,11 @@
 #define STIR_MUTABLE_CONST const
 #endif
 
+namespace boost { namespace interprocess {
+  class file_mapping;
+  class mapped_region;
+} }
+
 START_NAMESPACE_STIR
 
 /* TODO 
@@ -74,16 +80,45 @@ class Bin;
   This functionality will probably be moved to a new class 
   ProjMatrixByBinWithCache. (TODO)
 
+  The cache is organised per view/segment. Its size can be limited. When the 
+  limit is exceeded, the cache for the least recently used view/segment is
+  cleared. Statistics on cache hits, misses and evictions can be obtained.
+
   \par Parsing parameters
 
   The following parameters can be set (default values are indicated):
   \verbatim
   disable caching := false
   store only basic bins in cache := true
+  maximum cache size in MB := 0
   \endverbatim
   The 2nd option allows to cache the whole matrix. This results in the fastest
   behaviour IF your system does not start swapping. The default choice caches 
   only the 'basic' bins, and computes symmetry related bins from the 'basic' ones.
+  The 3rd option limits the memory used by the cache (0 means no limit). 
+  Note that the size of the cache is only estimated.
+
+  \par Persistent cache
+
+  Optionally, the content of the cache can be stored on disk and reused
+  in a later run by setting
+  \verbatim
+  persistent cache filename := some_file.pmcache
+  \endverbatim
+  If this file exists and was written for the same projection matrix 
+  (i.e. same parameters, projection data info and image geometry), 
+  it will be memory-mapped by set_up(), and elements found in the file will 
+  not be recomputed. Otherwise, write_persistent_cache() computes the elements of 
+  all bins and writes them to this file. This is done after set_up() by the projectors
+  using the matrix.
+  The file starts with the header of all STIR cache files (see cache_file.h), which
+  contains a description of the projection matrix and a flag that says if all bins are present.
+  It is followed by an index of all bins and then the elements of all bins.
+  When reading, the file is ignored if its size or the index is not consistent. Data are 
+  stored in native byte order, so the file cannot be shared between 
+  different types of computers (it will be ignored if the byte order differs).
+  If bins had to be removed from the cache due to the size limit, the persistent
+  cache is not written.
 */
 class ProjMatrixByBin :  
   public RegisteredObject<ProjMatrixByBin>,  
@@ -92,7 +127,7 @@ class ProjMatrixByBin :
 {
 public:
   
-  virtual ~ProjMatrixByBin() {}
+  virtual ~ProjMatrixByBin();
 
   //! To be called before any calculation is performed
   /*! Note that get_proj_matrix_elems_for_one_bin() will expect objects of
@@ -139,7 +174,11 @@ public:
   const char * const file_name_without_extension);
   */
   
-  //void set_maximum_cache_size(const unsigned long size){;}        
+  //! Set the maximum (approximate) amount of memory used by the cache
+  /*! 0 means no limit. */
+  void set_maximum_cache_size(const std::size_t num_bytes);
+  //! Get the maximum (approximate) amount of memory used by the cache
+  std::size_t get_maximum_cache_size() const;
   /* TODO
   void set_subset_usage(const SubsetInfo&, const int num_access_times);
   */
@@ -153,6 +192,39 @@ public:
   //! Remove all elements from the cache
   void clear_cache() STIR_MUTABLE_CONST;
 
+  //! Write the content of the cache to file
+  /*! This uses the format of the persistent cache. The file can only be used
+      for a projection matrix which is set-up in the same way as this one.
+      It is marked as complete only if write_persistent_cache() (or fill_cache())
+      computed all bins and nothing was removed from the cache since. */
+  Succeeded write_cache_to_file(const std::string& filename) const;
+
+  //! Compute the elements of all bins that are not in the cache yet
+  /*! Has to be called after set_up(). With OpenMP, the computation is done in parallel. */
+  void fill_cache() STIR_MUTABLE_CONST;
+
+  //! Compute all bins and write them to the persistent cache
+  /*! Does nothing if no persistent cache filename was set, or if set_up() could
+      use an existing persistent cache. Returns Succeeded::no (and does not write
+      the file) if bins were removed from the cache due to the size limit,
+      or if writing failed.
+
+      Has to be called after set_up(), outside of any parallel region.
+  */
+  Succeeded write_persistent_cache() STIR_MUTABLE_CONST;
+
+  //! \name cache statistics
+  /*! Note that with OpenMP, these might not be exact. */
+  //@{
+  boost::uint64_t get_num_cache_hits() const;
+  boost::uint64_t get_num_cache_misses() const;
+  //! number of times that the cache of a view/segment was cleared to reduce memory usage
+  boost::uint64_t get_num_cache_evictions() const;
+  //! approximate amount of memory currently used by the cache (in bytes)
+  std::size_t get_cache_size_in_bytes() const;
+  void reset_cache_statistics() STIR_MUTABLE_CONST;
+  //@}
+
   
 protected:
   shared_ptr<DataSymmetriesForBins> symmetries_ptr;
@@ -191,6 +263,10 @@ protected:
 
   bool cache_disabled;  
   bool cache_stores_only_basic_bins;
+  //! maximum size of the cache (0 means no limit)
+  double max_cache_size_in_MB;
+  //! name of the file used for the persistent cache (empty if none)
+  std::string persistent_cache_filename;
 
   /*! \brief The method that tries to get data from the cache.
   
@@ -207,6 +283,9 @@ protected:
     STIR_MUTABLE_CONST;
 
 private:
+  //! not copyable, as the cache (and its OpenMP locks) cannot be shared
+  ProjMatrixByBin(const ProjMatrixByBin&);            // Not defined
+  ProjMatrixByBin& operator=(const ProjMatrixByBin&); // Not defined
   
   typedef boost::uint32_t CacheKey;
 
@@ -221,11 +300,78 @@ private:
 #endif
     VectorWithOffset<VectorWithOffset<MapProjMatrixElemsForOneBin> > cache_collection;
 #ifdef STIR_OPENMP
+  //! locks for each element of cache_collection (also used for cache_num_bytes and cache_last_access)
 #ifndef STIR_NO_MUTABLE
   mutable
 #endif
   VectorWithOffset<VectorWithOffset<omp_lock_t> > cache_locks;
+  //! destroy all locks in cache_locks
+  void destroy_cache_locks();
+#endif
+
+  //! approximate number of bytes stored in each element of cache_collection
+#ifndef STIR_NO_MUTABLE
+  mutable
+#endif
+    VectorWithOffset<VectorWithOffset<std::size_t> > cache_num_bytes;
+  //! value of the access counter when each element of cache_collection was last used
+#ifndef STIR_NO_MUTABLE
+  mutable
 #endif
+    VectorWithOffset<VectorWithOffset<boost::uint64_t> > cache_last_access;
+#ifndef STIR_NO_MUTABLE
+  mutable
+#endif
+    std::size_t total_cache_num_bytes;
+#ifndef STIR_NO_MUTABLE
+  mutable
+#endif
+    boost::uint64_t num_cache_hits, num_cache_misses, num_cache_evictions;
+  //! number of times that bins were removed from the cache since set_up() (not reset by reset_cache_statistics())
+#ifndef STIR_NO_MUTABLE
+  mutable
+#endif
+    boost::uint64_t num_cache_removals_since_set_up;
+  //! true if fill_cache() was called since set_up()
+#ifndef STIR_NO_MUTABLE
+  mutable
+#endif
+    bool cache_was_filled;
+  //! counter used to keep track of when the cache for a view/segment was last used
+#ifndef STIR_NO_MUTABLE
+  mutable
+#endif
+    boost::uint64_t cache_access_counter;
+
+  //! clear cache for least recently used views/segments until the cache size is within bounds
+  /*! The cache for \a bin will not be cleared. To avoid having to do this again for the
+      next insertion, the cache is reduced to 90% of its maximum size.
+  */
+  void reduce_cache_size(const Bin& bin) STIR_MUTABLE_CONST;
+
+  //! location and size of the elements of a bin in the persistent cache
+  struct PersistentCacheEntry
+  {
+    const char * data_ptr;
+    boost::uint32_t num_elems;
+  };
+  typedef boost::unordered_map<CacheKey, PersistentCacheEntry> MapPersistentCacheEntries;
+
+  //! description of the matrix, used to check if the persistent cache can be used
+  std::string persistent_cache_description;
+  //! projection data info passed to set_up(), used by fill_cache()
+  shared_ptr<ProjDataInfo> proj_data_info_for_cache_sptr;
+  //! index of all bins in the persistent cache (organised as cache_collection)
+  VectorWithOffset<VectorWithOffset<MapPersistentCacheEntries> > persistent_cache_index;
+  shared_ptr<boost::interprocess::file_mapping> persistent_cache_file_mapping_sptr;
+  shared_ptr<boost::interprocess::mapped_region> persistent_cache_mapped_region_sptr;
+
+  //! map the persistent cache and fill in the index
+  /*! Will return Succeeded::no if the file does not exist or does not correspond to
+      the current projection matrix. */
+  Succeeded read_persistent_cache();
+  //! fill \a probabilities from the persistent cache (if the bin is present)
+  Succeeded get_proj_matrix_elems_for_one_bin_from_persistent_cache(ProjMatrixElemsForOneBin& probabilities) const;
 
   //! create the key for caching
   // KT 15/05/2002 not static anymore as it uses cache_stores_only_basic_bins
@@ -34,6 +34,7 @@
 #include "stir/IndexRange.h"
 #include "stir/shared_ptr.h"
 #include <iostream>
+#include <vector>
 
 
 #include "stir/recon_buildblock/SPECTUB_Tools.h"
@@ -53,6 +54,15 @@ class Bin;
 
   \warning this class currently only works with VoxelsOnCartesianGrid. 
 
+  \par Parallel computation
+
+  The matrix elements are computed per "UB-subset", which is a single view. When
+  using OpenMP, different views can be computed by different threads at the same time
+  (e.g. in the parallel loop over views of the projectors, or by set_up() when all views
+  are precomputed). When a view is computed outside a parallel section, its image rows
+  are distributed over the threads instead. When \c keep_all_views_in_cache is not set,
+  computing a view clears the cache, so only one view is computed at a time.
+
   \par Sample parameter file
 
 \verbatim
@@ -79,6 +89,10 @@ class Bin;
 
     ; if next variable is set to 0, only a single view is kept in memory
    keep all views in cache:=1
+    ; if next variable is set to 1, the matrix elements of all views are computed
+    ; by set_up() (in parallel when using OpenMP), instead of when they are first needed.
+    ; This needs all views to be kept in the cache.
+   precompute all views:=0
 
 End Projection Matrix By Bin SPECT UB Parameters:=
 \endverbatim
@@ -122,6 +136,7 @@ class ProjMatrixByBinSPECTUB :
   std::string mask_type;
   std::string mask_file;
   bool keep_all_views_in_cache; //!< if set to false, only a single view is kept in memory
+  bool precompute_all_views; //!< if set to true, all views are computed by set_up()
 
   // explicitly list necessary members for image details (should use an Info object instead)
   CartesianCoordinate3D<float> voxel_size;
@@ -165,8 +180,14 @@ class ProjMatrixByBinSPECTUB :
 
 	
   void compute_one_subset(const int kOS) const;
+  //! compute all subsets, in parallel when using OpenMP
+  void compute_all_subsets();
   void delete_UB_SPECT_arrays();
-  mutable std::vector<bool> subset_already_processed;
+#ifdef STIR_OPENMP
+  //! locks per subset, such that a subset is only computed by one thread (when keeping all views)
+  mutable std::vector<omp_lock_t> subset_locks;
+  void destroy_subset_locks();
+#endif
 };
 
 END_NAMESPACE_STIR
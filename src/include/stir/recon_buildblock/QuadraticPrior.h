@@ -61,6 +61,9 @@ START_NAMESPACE_STIR
 
   By default, a 3x3 or 3x3x3 neigbourhood is used where the weights are set to 
   x-voxel_size divided by the Euclidean distance between the points.
+
+  The image (and \f$\kappa\f$) needs to have a regular index range. Computations
+  are multi-threaded over planes when STIR is compiled with OpenMP.
  
   \par Parsing
   These are the keywords that can be used in addition to the ones in GeneralPrior.
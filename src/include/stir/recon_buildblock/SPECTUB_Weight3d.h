@@ -33,7 +33,7 @@
   Med. Phys. 40, 092502 (2013); http://dx.doi.org/10.1118/1.4816676
 
   \todo Variables wm, wmh and Rrad are currently global variables. This means that this code would be very dangerous
-  in a parallel setting.
+  in a parallel setting. wm_calculation() therefore only reads wmh, and stores the matrix in its \c wm argument.
 */
 
 namespace SPECTUB {
@@ -48,7 +48,18 @@ namespace SPECTUB {
   extern float * Rrad;  //! radii per view
 
 
-void wm_calculation( const int kOS,
+//! compute the weight matrix for subset \a kOS
+/*! The matrix is stored in \a wm (and not in the global variable), such that
+    different subsets can be computed in parallel. Its val, col and ne arrays need to be
+    allocated for NITEMS elements per row. If \c wm.do_save_STIR is set, the projection
+    indices na, nb and ns are filled in as well. (The image indices nx, ny and nz do not
+    depend on the subset and are not filled in).
+
+    With OpenMP, the image rows are distributed over the threads. The elements of
+    every row of the matrix are stored in the same order as in the serial code.
+*/
+void wm_calculation( wm_da_type& wm,
+					const int kOS,
 					const angle_type *const ang, 
 					voxel_type vox, 
 					bin_type bin, 
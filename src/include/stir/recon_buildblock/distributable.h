@@ -59,6 +59,37 @@ const int task_do_distributable_loglikelihood_computation=43;
 const int task_do_distributable_sensitivity_computation=44;
 //!@}
 
+//! Timing information collected by distributable_computation()
+/*! \ingroup distributable
+    Times are wall-clock times in seconds. When using multiple threads, they are
+    summed over all threads (i.e. they are 'thread-seconds'). distributable_computation()
+    adds to the current values, so you need to call reset() yourself.
+
+    When STIR_MPI is defined, only the total time is filled in.
+*/
+struct DistributableComputationTimings
+{
+  DistributableComputationTimings() { reset(); }
+  void reset()
+  {
+    reading_time = 0.;
+    normalisation_time = 0.;
+    processing_time = 0.;
+    total_time = 0.;
+    num_bins = 0.;
+  }
+  //! time spent reading projection data (including the additive term)
+  double reading_time;
+  //! time spent constructing the multiplicative viewgrams
+  double normalisation_time;
+  //! time spent in the call-back function (normally mostly projections)
+  double processing_time;
+  //! total time of distributable_computation() (not summed over threads)
+  double total_time;
+  //! number of bins that were processed
+  double num_bins;
+};
+
 //! set-up parameters before calling distributable_computation()
 /*!
     \ingroup distributable
@@ -150,6 +181,7 @@ typedef  void RPC_process_related_viewgrams_type (
   \param end_time_of_frame is passed to normalise_sptr
   \param RPC_process_related_viewgrams function that does the actual work.
   \param caching_info_ptr ignored unless STIR_MPI=1, in which case it enables caching of viewgrams at the slave side  
+  \param timings_ptr if non-zero, timing information will be added to this object
   \warning There is NO check that the resulting subsets are balanced.
 
   \warning The function assumes that \a min_segment_num, \a max_segment_num are such that
@@ -181,7 +213,8 @@ void distributable_computation(
                                const double start_time_of_frame,
                                const double end_time_of_frame,
                                RPC_process_related_viewgrams_type * RPC_process_related_viewgrams,
-                               DistributedCachingInformation* caching_info_ptr);
+                               DistributedCachingInformation* caching_info_ptr,
+                               DistributableComputationTimings* timings_ptr = 0);
 
 
   /*! \name Tag-names currently used by stir::distributable_computation and related functions0
@@ -0,0 +1,169 @@
+#ifndef __stir_scatter_IterativeScatterEstimation_H__
+#define __stir_scatter_IterativeScatterEstimation_H__
+
+/*
+    Copyright (C) 2026, STIR contributors
+    This file is part of STIR.
+
+    This file is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.
+
+    This file is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    See STIR/LICENSE.txt for details
+*/
+/*!
+  \file
+  \ingroup scatter
+  \brief Definition of class stir::IterativeScatterEstimation.
+
+  \author STIR contributors
+*/
+
+#include "stir/scatter/ScatterEstimationByBin.h"
+#include "stir/recon_buildblock/IterativeReconstruction.h"
+#include "stir/ParsingObject.h"
+#include "stir/shared_ptr.h"
+#include <string>
+
+START_NAMESPACE_STIR
+
+class Succeeded;
+class ProjData;
+class BinNormalisation;
+
+/*!
+  \ingroup scatter
+  \brief Estimate the scatter by alternating image reconstruction and scatter simulation
+
+  This class implements the loop that is otherwise run by the \c estimate_scatter.sh script,
+  but in a single process:
+  <ol>
+  <li> reconstruct an activity image (or read an initial one)
+  <li> compute a (down-sampled) single scatter estimate with ScatterEstimationByBin
+  <li> upsample the scatter estimate and fit it to the tails of the data with
+       ScatterEstimationByBin::upsample_and_fit_scatter_estimate()
+  <li> reconstruct again with the scatter (and background) in the additive term
+       of the objective function
+  <li> go back to step 2
+  </ol>
+
+  As the same ScatterEstimationByBin object is used for all iterations, the scatter points,
+  the detection points and the cached integrals over the attenuation image are only computed
+  once. Only the integrals over the activity image are recomputed in every iteration. The
+  data to fit (emission minus background), the tail mask and the normalisation are
+  read and set-up once as well.
+
+  The reconstruction is currently an OSMAPOSLReconstruction with an objective
+  function of type PoissonLogLikelihoodWithLinearModelForMeanAndProjData. Its input data
+  and additive sinogram are overwritten by this class. Note that its normalisation
+  needs to include the attenuation correction factors, as the scatter estimate
+  is multiplied with it (after adding the background) to obtain the additive sinogram.
+
+  \par Parsing parameters
+
+  \verbatim
+  Iterative Scatter Estimation Parameters :=
+    ; emission data (prompts)
+    input file :=
+    ; background (e.g. randoms) in the emission data, defaults to none
+    background projdata filename :=
+    ; weights for the tail fit (e.g. created with create_tail_mask_from_ACFs)
+    tail mask filename :=
+    ; detector efficiencies used for the tail fit, i.e. without attenuation
+    ; defaults to none
+    scatter normalisation type :=
+    ; parameter file for ScatterEstimationByBin. Its activity image and output
+    ; filenames do not have to be set
+    scatter simulation parameter filename :=
+    ; parameter file for OSMAPOSL
+    reconstruction parameter filename :=
+    ; if not set, the initial activity image is reconstructed without scatter correction
+    initial activity image filename :=
+    number of scatter iterations := 5
+    ; see ScatterEstimationByBin::upsample_and_fit_scatter_estimate
+    minimum scale factor := .4
+    maximum scale factor := 100
+    half filter width := 3
+    remove interleaving := 1
+    ; prefixes for output files. The iteration number will be appended
+    unscaled scatter estimate output filename prefix := scatter_estimate_wrong_scale
+    scatter estimate output filename prefix := scatter_estimate
+    activity image output filename prefix := activity_image
+  End Iterative Scatter Estimation Parameters :=
+  \endverbatim
+*/
+class IterativeScatterEstimation : public ParsingObject
+{
+ public:
+  typedef DiscretisedDensity<3,float> TargetT;
+
+  //! Default constructor (calls set_defaults())
+  IterativeScatterEstimation();
+
+  //! run all iterations
+  /*! The final activity image and scatter estimate are the ones of the last iteration. */
+  virtual Succeeded process_data();
+
+  //! get the activity image of the last iteration
+  const shared_ptr<TargetT>& get_activity_image_sptr() const;
+
+ protected:
+  virtual void set_defaults();
+  virtual void initialise_keymap();
+  virtual bool post_processing();
+
+  //! \name parsing variables
+  //@{
+  std::string input_filename;
+  std::string background_proj_data_filename;
+  std::string tail_mask_filename;
+  std::string scatter_simulation_parameter_filename;
+  std::string reconstruction_parameter_filename;
+  std::string initial_activity_image_filename;
+  int num_scatter_iterations;
+  float min_scale_factor;
+  float max_scale_factor;
+  int half_filter_width;
+  bool remove_interleaving;
+  std::string unscaled_scatter_output_filename_prefix;
+  std::string scatter_output_filename_prefix;
+  std::string activity_image_output_filename_prefix;
+  //@}
+
+  shared_ptr<ProjData> input_proj_data_sptr;
+  shared_ptr<ProjData> background_proj_data_sptr;
+  shared_ptr<ProjData> tail_mask_proj_data_sptr;
+  shared_ptr<BinNormalisation> scatter_normalisation_sptr;
+
+  shared_ptr<ScatterEstimationByBin> scatter_simulation_sptr;
+  shared_ptr<IterativeReconstruction<TargetT> > reconstruction_sptr;
+
+ private:
+  //! emission data minus background, used for the tail fit
+  shared_ptr<ProjData> data_to_fit_sptr;
+  //! sinogram passed to the reconstruction as additive term
+  shared_ptr<ProjData> additive_proj_data_sptr;
+  shared_ptr<TargetT> activity_image_sptr;
+
+  //! sets input, additive term and normalisation up for the reconstruction, and calls its set_up()
+  /*! This is only done once. \a activity_image_sptr has to be set before. */
+  Succeeded set_up_reconstruction();
+
+  //! set additive sinogram to norm*(scatter + background)
+  /*! If \a scatter_proj_data_ptr is 0, only the background is used. The sinogram is
+      then passed to the objective function of the reconstruction. */
+  void set_additive_proj_data(const ProjData * const scatter_proj_data_ptr);
+
+  //! reconstruct (updating \a activity_image_sptr) and write output with the given suffix
+  Succeeded reconstruct(const int iteration_num);
+};
+
+END_NAMESPACE_STIR
+
+#endif
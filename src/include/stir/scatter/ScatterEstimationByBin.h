@@ -70,6 +70,13 @@ class BinNormalisation;
 
   \todo This class should be split into a generic class and one specific to PET single scatter.
 
+  \par Multi-threading
+  When compiled with OpenMP, the scatter points are sampled in parallel over image planes,
+  the cached integrals between scatter points and detectors are computed in parallel
+  over the scatter points before any scatter estimate is computed, and bins are processed
+  in parallel. If \a random_seed is set, the estimated scatter does not depend
+  on the number of threads.
+
   \par References
   This implementation is described in the following
   <ol>
@@ -157,6 +164,9 @@ class ScatterEstimationByBin : public ParsingObject
 
   //@}
 
+  //! get the output of the last call to process_data()
+  const shared_ptr<ProjData>& get_output_proj_data_sptr() const;
+
   virtual Succeeded process_data();
 
   // TODO write_log can't be const because parameter_info isn't const
@@ -176,10 +186,17 @@ class ScatterEstimationByBin : public ParsingObject
   /*! This was first recommended by Watson. It is recommended to leave this on, as otherwise
      discretisation errors are more obvious.
 
-     Note that the random generator is seeded via date/time, so re-running the scatter 
-     simulation will give a slightly different result if this boolean is on.
+     Note that by default the random generator is seeded via date/time, so re-running the scatter 
+     simulation will give a slightly different result if this boolean is on. 
+     Use \a random_seed to get reproducible results.
   */
   bool random;
+  //! seed for the random generator used for moving the scatter points
+  /*! If zero (the default), the seed is determined from the date/time. 
+      Every image plane uses its own generator (with a seed derived from this one), such
+      that the scatter points do not depend on the number of threads.
+  */
+  int random_seed;
   //! boolean to see if we need to cache the integrals
   /*! By default, we cache the integrals over the emission and attenuation image. If you run out
       of memory, you can switch this off, but performance will suffer dramatically.
@@ -229,6 +246,8 @@ class ScatterEstimationByBin : public ParsingObject
   //! find scatter points
   /*! This function sets scatt_points_vector and scatter_volume. It will also
       remove any cached integrals as they would be incorrect otherwise.
+
+      When compiled with OpenMP, image planes are handled in parallel. See \a random_seed.
   */
   void 
     sample_scatter_points();
@@ -259,6 +278,13 @@ class ScatterEstimationByBin : public ParsingObject
 
   unsigned 
     find_in_detection_points_vector(const CartesianCoordinate3D<float>& coord) const;
+
+  //! find the detection points for all bins in the template projection data
+  /*! This fills \a detection_points_vector (in the order of the bins), such that
+      the detector numbers do not depend on the order in which bins are processed.
+  */
+  void
+    set_up_detection_points_vector();
   // private:
   const ProjDataInfoCylindricalNoArcCorr * proj_data_info_ptr;
   CartesianCoordinate3D<float>  shift_detector_coordinates_to_origin;
@@ -389,6 +415,15 @@ class ScatterEstimationByBin : public ParsingObject
       call remove_cache_for_scattpoint_det_integrals_over_activity() first. 
   */
   void initialise_cache_for_scattpoint_det_integrals_over_activity();
+
+  //! compute all integrals that are not yet in the cache
+  /*! This is done in parallel over the scatter points (when compiled with OpenMP).
+      Attenuation integrals that are already in the cache are not recomputed.
+      Does nothing if \a use_cache is \c false.
+
+      \warning \a detection_points_vector needs to be complete, see set_up_detection_points_vector().
+  */
+  void precompute_cache_for_scattpoint_det_integrals();
 };
 
 
@@ -171,6 +171,27 @@ void * read_stream_in_memory(std::istream& input, std::streamsize& file_size);
  */
 std::streamsize find_remaining_size (std::istream& input);
 
+/*!
+ \brief Create a new (empty) file with a unique name starting with \a filename
+
+ This is intended to be used to write a file first to a temporary file in the
+ same directory, and then use rename_file() such that other processes never see
+ an incomplete file, even when they write the same file at the same time.
+
+ \return the name of the new file, or an empty string (after a warning) if
+   the file could not be created.
+ */
+std::string create_unique_temporary_file(const std::string& filename);
+
+/*!
+ \brief Rename a file, replacing \a new_filename if it exists already
+
+ On most systems, replacing the file is atomic. However, on Windows an existing file has
+ to be removed first.
+ \return \c true if successful
+ */
+bool rename_file(const std::string& old_filename, const std::string& new_filename);
+
 //! opens a stream for reading binary data. Calls error() when it does not succeed.
 /*! \warning probably does not work if you are not in the C-locale */
 template <class IFSTREAM>
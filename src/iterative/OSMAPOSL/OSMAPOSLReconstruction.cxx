@@ -436,7 +436,7 @@ update_estimate(TargetT &current_image_estimate)
       
       
       this->objective_function_sptr->
-        get_prior_ptr()->compute_gradient(*denominator_ptr, current_image_estimate); 
+        compute_prior_gradient(*denominator_ptr, current_image_estimate); 
       
       typename TargetT::full_iterator denominator_iter = denominator_ptr->begin_all();
       const typename TargetT::full_iterator denominator_end = denominator_ptr->end_all();
@@ -24,7 +24,9 @@
 */
 
 #include "stir/listmode/CListModeData.h"
+#include "stir/listmode/CListRecord.h"
 #include "stir/ExamInfo.h"
+#include "stir/Succeeded.h"
 #include "stir/is_null_ptr.h"
 
 START_NAMESPACE_STIR
@@ -51,6 +53,38 @@ CListModeData::get_exam_info_sptr() const
   return exam_info_sptr;
 }
 
+std::size_t
+CListModeData::
+get_next_records(const std::vector<shared_ptr<CListRecord> >& records) const
+{
+  std::size_t num_records_read = 0;
+  while (num_records_read < records.size() &&
+         this->get_next_record(*records[num_records_read]) == Succeeded::yes)
+    ++num_records_read;
+  return num_records_read;
+}
+
+Succeeded
+CListModeData::
+get_file_position(std::streampos&) const
+{
+  return Succeeded::no;
+}
+
+Succeeded
+CListModeData::
+set_file_position(const std::streampos&)
+{
+  return Succeeded::no;
+}
+
+Succeeded
+CListModeData::
+get_file_size(std::streamoff&) const
+{
+  return Succeeded::no;
+}
+
 const Scanner* 
 CListModeData::
 get_scanner_ptr() const
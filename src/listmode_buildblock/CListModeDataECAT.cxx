@@ -126,6 +126,7 @@ CListModeDataECAT(const std::string& listmode_filename_prefix)
     {
       error("CListModeDataECAT: Unsupported scanner in %s", listmode_filename_prefix.c_str());
     }
+  this->empty_record_sptr.reset(new CListRecordT);
 
   if (open_lm_file(1) == Succeeded::no)
     error("CListModeDataECAT: error opening the first listmode file for filename %s\n",
@@ -146,7 +147,8 @@ shared_ptr <CListRecord>
 CListModeDataECAT<CListRecordT>::
 get_empty_record_sptr() const
 {
-  shared_ptr<CListRecord> sptr(new CListRecordT);
+  // copy, such that all records share the scanner and its lookup tables
+  shared_ptr<CListRecord> sptr(new CListRecordT(*this->empty_record_sptr));
   return sptr;
 }
 
@@ -28,6 +28,7 @@
 #include "stir/listmode/CListRecordECAT8_32bit.h"
 #include "stir/ExamInfo.h"
 #include "stir/Succeeded.h"
+#include "stir/utilities.h"
 #include "stir/info.h"
 #include "stir/warning.h"
 #include "stir/error.h"
@@ -87,6 +88,7 @@ CListModeDataECAT8_32bit(const std::string& listmode_filename)
 								this->number_of_views,
 								this->number_of_projections,
 								/* arc_correction*/false));
+  this->empty_record_sptr.reset(new CListRecordT(this->proj_data_info_sptr));
 
   if (this->open_lm_file() == Succeeded::no)
     error("CListModeDataECAT8_32bit: error opening the first listmode file for filename %s\n",
@@ -105,7 +107,8 @@ shared_ptr <CListRecord>
 CListModeDataECAT8_32bit::
 get_empty_record_sptr() const
 {
-  shared_ptr<CListRecord> sptr(new CListRecordT(this->proj_data_info_sptr));
+  // copy, such that all records share the scanner and its lookup tables
+  shared_ptr<CListRecord> sptr(new CListRecordT(*this->empty_record_sptr));
   return sptr;
 }
 
@@ -139,6 +142,18 @@ get_next_record(CListRecord& record_of_general_type) const
   return current_lm_data_ptr->get_next_record(record);
  }
 
+std::size_t
+CListModeDataECAT8_32bit::
+get_next_records(const std::vector<shared_ptr<CListRecord> >& records) const
+{
+  std::size_t num_records_read = 0;
+  while (num_records_read < records.size() &&
+         current_lm_data_ptr->
+           get_next_record(static_cast<CListRecordT&>(*records[num_records_read])) == Succeeded::yes)
+    ++num_records_read;
+  return num_records_read;
+}
+
 
 Succeeded
 CListModeDataECAT8_32bit::
@@ -164,5 +179,32 @@ set_get_position(const CListModeDataECAT8_32bit::SavedPosition& pos)
     current_lm_data_ptr->set_get_position(pos);
 }
 
+Succeeded
+CListModeDataECAT8_32bit::
+get_file_position(std::streampos& pos) const
+{
+  pos = current_lm_data_ptr->get_stream_position();
+  return Succeeded::yes;
+}
+
+Succeeded
+CListModeDataECAT8_32bit::
+set_file_position(const std::streampos& pos)
+{
+  return
+    current_lm_data_ptr->set_stream_position(pos);
+}
+
+Succeeded
+CListModeDataECAT8_32bit::
+get_file_size(std::streamoff& size) const
+{
+  std::ifstream s(interfile_parser.data_file_name.c_str(), std::ios::in | std::ios::binary);
+  if (!s)
+    return Succeeded::no;
+  size = find_remaining_size(s);
+  return Succeeded::yes;
+}
+
 } // namespace ecat
 END_NAMESPACE_STIR
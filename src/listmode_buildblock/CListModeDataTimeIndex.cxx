@@ -0,0 +1,184 @@
+/*
+    Copyright (C) 2026, STIR contributors
+    This file is part of STIR.
+
+    This file is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.
+
+    This file is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    See STIR/LICENSE.txt for details
+*/
+/*!
+  \file
+  \ingroup listmode
+  \brief Implementation of class stir::CListModeDataTimeIndex
+
+  \author STIR contributors
+*/
+
+#include "stir/listmode/CListModeDataTimeIndex.h"
+#include "stir/listmode/CListModeData.h"
+#include "stir/listmode/CListRecord.h"
+#include "stir/Succeeded.h"
+#include "stir/shared_ptr.h"
+#include "stir/info.h"
+#include "stir/warning.h"
+#include <boost/format.hpp>
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+START_NAMESPACE_STIR
+
+//! first line of an index file
+static const char * const time_index_signature = "STIR list mode time index";
+
+CListModeDataTimeIndex::
+CListModeDataTimeIndex()
+  : lm_file_size(0)
+{}
+
+Succeeded
+CListModeDataTimeIndex::
+build(CListModeData& lm_data, const double min_interval_in_secs)
+{
+  this->times.resize(0);
+  this->positions.resize(0);
+
+  this->lm_data_name = lm_data.get_name();
+  if (lm_data.get_file_size(this->lm_file_size) == Succeeded::no)
+    {
+      warning(boost::format("CListModeDataTimeIndex: list mode data %1% does not support file positions")
+              % lm_data.get_name());
+      return Succeeded::no;
+    }
+  if (lm_data.reset() == Succeeded::no)
+    return Succeeded::no;
+
+  shared_ptr<CListRecord> record_sptr = lm_data.get_empty_record_sptr();
+  CListRecord& record = *record_sptr;
+  while (true)
+    {
+      std::streampos pos;
+      if (lm_data.get_file_position(pos) == Succeeded::no)
+        {
+          warning(boost::format("CListModeDataTimeIndex: list mode data %1% does not support file positions")
+                  % lm_data.get_name());
+          this->times.resize(0);
+          this->positions.resize(0);
+          return Succeeded::no;
+        }
+      if (lm_data.get_next_record(record) == Succeeded::no)
+        break;
+      if (record.is_time())
+        {
+          const double time = record.time().get_time_in_secs();
+          if (this->times.empty() || time >= this->times.back() + min_interval_in_secs)
+            {
+              this->times.push_back(time);
+              this->positions.push_back(static_cast<std::streamoff>(pos));
+            }
+        }
+    }
+  info(boost::format("CListModeDataTimeIndex: %1% entries for list mode data %2%")
+       % this->times.size() % lm_data.get_name());
+  return lm_data.reset();
+}
+
+Succeeded
+CListModeDataTimeIndex::
+read_from_file(const std::string& filename, const CListModeData& lm_data)
+{
+  this->times.resize(0);
+  this->positions.resize(0);
+
+  std::ifstream s(filename.c_str());
+  if (!s)
+    return Succeeded::no;
+  std::string signature;
+  std::getline(s, signature);
+  std::getline(s, this->lm_data_name);
+  std::size_t num_entries = 0;
+  if (signature != time_index_signature || !(s >> this->lm_file_size >> num_entries))
+    {
+      warning(boost::format("CListModeDataTimeIndex: %1% is not a list mode time index") % filename);
+      return Succeeded::no;
+    }
+  std::streamoff lm_file_size_of_data;
+  if (this->lm_data_name != lm_data.get_name() ||
+      lm_data.get_file_size(lm_file_size_of_data) == Succeeded::no ||
+      this->lm_file_size != lm_file_size_of_data)
+    {
+      warning(boost::format("CListModeDataTimeIndex: %1% was built for different list mode data "
+                            "(%2%, size %3%). Ignoring it.")
+              % filename % this->lm_data_name % this->lm_file_size);
+      return Succeeded::no;
+    }
+  this->times.resize(num_entries);
+  this->positions.resize(num_entries);
+  for (std::size_t i=0; i<num_entries; ++i)
+    s >> this->times[i] >> this->positions[i];
+  if (!s)
+    {
+      warning(boost::format("CListModeDataTimeIndex: error reading %1% entries from %2%")
+              % num_entries % filename);
+      this->times.resize(0);
+      this->positions.resize(0);
+      return Succeeded::no;
+    }
+  return Succeeded::yes;
+}
+
+Succeeded
+CListModeDataTimeIndex::
+write_to_file(const std::string& filename) const
+{
+  std::ofstream s(filename.c_str());
+  if (!s)
+    {
+      warning(boost::format("CListModeDataTimeIndex: error opening %1% for writing") % filename);
+      return Succeeded::no;
+    }
+  s << time_index_signature << '\n'
+    << this->lm_data_name << '\n'
+    << this->lm_file_size << '\n'
+    << this->times.size() << '\n'
+    << std::setprecision(15);
+  for (std::size_t i=0; i<this->times.size(); ++i)
+    s << this->times[i] << ' ' << this->positions[i] << '\n';
+  if (!s)
+    {
+      warning(boost::format("CListModeDataTimeIndex: error writing %1%") % filename);
+      return Succeeded::no;
+    }
+  return Succeeded::yes;
+}
+
+bool
+CListModeDataTimeIndex::
+find_entry_before(std::size_t& entry_num, const double time_in_secs) const
+{
+  // first entry with a time that is not smaller
+  const std::vector<double>::const_iterator iter =
+    std::lower_bound(this->times.begin(), this->times.end(), time_in_secs);
+  if (iter == this->times.begin())
+    return false;
+  entry_num = static_cast<std::size_t>(iter - this->times.begin()) - 1;
+  return true;
+}
+
+Succeeded
+CListModeDataTimeIndex::
+set_get_position(CListModeData& lm_data, const std::size_t entry_num) const
+{
+  assert(entry_num < this->positions.size());
+  return lm_data.set_file_position(std::streampos(this->positions[entry_num]));
+}
+
+END_NAMESPACE_STIR
@@ -76,16 +76,27 @@ FRAME_BASED_DT_CORR:
 #include "stir/Array.h"
 #include "stir/IndexRange3D.h"
 #endif
+#include "stir/IO/read_data.h"
+#include "stir/IO/write_data.h"
 #include "stir/IO/read_from_file.h"
 #include "stir/ParsingObject.h"
 #include "stir/TimeFrameDefinitions.h"
 #include "stir/CPUTimer.h"
 #include "stir/recon_buildblock/TrivialBinNormalisation.h"
 #include "stir/is_null_ptr.h"
+#include "stir/info.h"
+#include <boost/cstdint.hpp>
+#include <boost/format.hpp>
+#ifdef STIR_OPENMP
+#include <omp.h>
+#endif
 
 #include <fstream>
 #include <iostream>
 #include <vector>
+#include <string>
+#include <exception>
+#include <cstdio>
 
 #ifndef STIR_NO_NAMESPACES
 using std::string;
@@ -111,6 +122,82 @@ typedef SegmentByView<elem_type> segment_type;
 #else
 #error does not work at the moment
 #endif
+//! compact representation of a binned event, used for the scratch files
+/*! The value includes the normalisation factor and the event increment. */
+struct ScratchEvent
+{
+  boost::int16_t segment_num;
+  boost::int16_t view_num;
+  boost::int16_t axial_pos_num;
+  boost::int16_t tangential_pos_num;
+  float value;
+};
+
+//! compact representation of an event binned by one of the threads
+/*! \c value is the value after post-normalisation, i.e. without the event increment. */
+struct BinnedEvent
+{
+  boost::int16_t segment_num;
+  boost::int16_t view_num;
+  boost::int16_t axial_pos_num;
+  boost::int16_t tangential_pos_num;
+  float value;
+  boost::int8_t event_increment;
+  bool is_prompt;
+};
+
+//! maximum number of events that are binned in parallel
+/*! Kept moderate as every record object can hold scanner-specific data. */
+static const std::size_t max_num_events_in_batch = 10000;
+
+//! stores the events of one segment that is not in memory during the first pass
+/*! Events are collected in a small buffer, which is appended to a file of ScratchEvent
+    records. When this file would become larger than the segment itself, its records are
+    added to a partial segment, which is kept in a second file. The disk space is
+    therefore at most about twice the size of the segment, independent of the number of
+    events. As events are always added in the order of the list mode data, the final
+    segment is identical to the one obtained by binning all events in memory.
+*/
+class ScratchSegment
+{
+public:
+  ScratchSegment(const string& filename_prefix,
+                 const shared_ptr<ProjDataInfo>& proj_data_info_sptr,
+                 const int segment_num);
+  //! removes the scratch files
+  ~ScratchSegment();
+
+  void add_event(const ScratchEvent& event)
+  {
+    buffer.push_back(event);
+    if (buffer.size() == max_num_events_in_buffer)
+      flush_buffer();
+  }
+
+  //! adds all events to \a segment, which has to be zero
+  void add_to(segment_type& segment);
+
+private:
+  static const std::size_t max_num_events_in_buffer = 4096;
+
+  const string filename_prefix;
+  const shared_ptr<ProjDataInfo> proj_data_info_sptr;
+  const int segment_num;
+  string events_filename;
+  string partial_segment_filename;
+  vector<ScratchEvent> buffer;
+  std::size_t num_events_in_file;
+  std::size_t max_num_events_in_file;
+
+  void flush_buffer();
+  void merge_events_into_partial_segment();
+  void add_events_in_file(segment_type& segment) const;
+
+  // not copyable, as it owns the files
+  ScratchSegment(const ScratchSegment&);
+  ScratchSegment& operator=(const ScratchSegment&);
+};
+
 /******************** Prototypes  for local routines ************************/
 
 
@@ -156,7 +243,8 @@ set_defaults()
   post_normalisation_ptr.reset(new TrivialBinNormalisation);
   do_pre_normalisation =0;
   num_events_to_store = 0;
-  
+  use_scratch_files = false;
+  time_index_filename = "";
 }
 
 void 
@@ -168,12 +256,14 @@ initialise_keymap()
   parser.add_key("template_projdata", &template_proj_data_name);
   parser.add_key("frame_definition file",&frame_definition_filename);
   parser.add_key("num_events_to_store",&num_events_to_store);
+  parser.add_key("time index filename",&time_index_filename);
   parser.add_key("output filename prefix",&output_filename_prefix);
   parser.add_parsing_key("Bin Normalisation type for pre-normalisation", &normalisation_ptr);
   parser.add_parsing_key("Bin Normalisation type for post-normalisation", &post_normalisation_ptr);
   parser.add_key("maximum absolute segment number to process", &max_segment_num_to_process); 
   parser.add_key("do pre normalisation ", &do_pre_normalisation);
   parser.add_key("num_segments_in_memory", &num_segments_in_memory);
+  parser.add_key("use scratch files", &use_scratch_files);
 
   //if (lm_data_ptr->has_delayeds()) TODO we haven't read the CListModeData yet, so cannot access has_delayeds() yet
   // one could add the next 2 keywords as part of a callback function for the 'input file' keyword.
@@ -345,6 +435,16 @@ post_processing()
       frame_defs = TimeFrameDefinitions(frame_times);
     }
 
+  if (do_time_frame && time_index_filename.size()!=0)
+    {
+      if (time_index.read_from_file(time_index_filename, *lm_data_ptr) == Succeeded::no)
+        {
+          info(boost::format("LmToProjData: building time index %1%") % time_index_filename);
+          if (time_index.build(*lm_data_ptr) == Succeeded::yes)
+            time_index.write_to_file(time_index_filename);
+        }
+    }
+
 #ifdef FRAME_BASED_DT_CORR
   cerr << "LmToProjData Using FRAME_BASED_DT_CORR\n";
 #else
@@ -403,6 +503,8 @@ get_bin_from_event(Bin& bin, const CListEvent& event) const
      const double end_time =frame_defs.get_end_time(current_frame_num);
 #endif
      
+      // note: normalisation_ptr has been set up in post_processing(), so this can be
+      // called by multiple threads (see BinNormalisation::get_bin_efficiency())
       const float bin_efficiency = 
 	normalisation_ptr->get_bin_efficiency(uncompressed_bin,start_time,end_time);
       // TODO remove arbitrary number. Supposes that these bin_efficiencies are around 1
@@ -460,7 +562,8 @@ do_post_normalisation(Bin& bin) const
 	  const double start_time = frame_defs.get_start_time(current_frame_num);
 	  const double end_time =frame_defs.get_end_time(current_frame_num);
 #endif
-	  const float bin_efficiency = post_normalisation_ptr->get_bin_efficiency(bin,start_time,end_time);
+	  const float bin_efficiency =
+	    post_normalisation_ptr->get_bin_efficiency(bin,start_time,end_time);
 	  // TODO remove arbitrary number. Supposes that these bin_efficiencies are around 1
 	  if (bin_efficiency < 1.E-10)
 	    {
@@ -492,6 +595,13 @@ get_compression_count(const Bin& bin) const
 
 }
 
+bool
+LmToProjData::
+can_bin_events_in_parallel() const
+{
+  return true;
+}
+
 /**************************************************************
  Empty functions for new time events and new time frames.
 ***************************************************************/
@@ -535,6 +645,29 @@ process_data()
   shared_ptr <CListRecord> record_sptr = lm_data_ptr->get_empty_record_sptr();
   CListRecord& record = *record_sptr;
 
+  /* When binning time frames, events are processed in batches: records are read sequentially
+     (handling time events), the events are then binned in parallel, and finally the binned events
+     are added to the segments (or scratch files) sequentially, in the order of the list mode data.
+     Therefore the result is identical to processing the events one by one.
+  */
+  const bool bin_events_in_batches =
+    do_time_frame && !interactive && can_bin_events_in_parallel();
+  // if the normalisation depends on current_time, batches cannot span a time event
+  const bool binning_depends_on_time =
+    !normalisation_ptr->is_trivial() || !post_normalisation_ptr->is_trivial();
+  vector<shared_ptr<CListRecord> > records;
+  if (bin_events_in_batches)
+    {
+      records.resize(max_num_events_in_batch);
+      for (std::size_t i=0; i<records.size(); ++i)
+        records[i] = lm_data_ptr->get_empty_record_sptr();
+    }
+#ifdef STIR_OPENMP
+  vector<vector<BinnedEvent> > binned_events_per_thread(omp_get_max_threads());
+#else
+  vector<vector<BinnedEvent> > binned_events_per_thread(1);
+#endif
+
   /* Here starts the main loop which will store the listmode data. */
   for (current_frame_num = 1;
        current_frame_num<=frame_defs.get_num_frames();
@@ -568,6 +701,23 @@ process_data()
       const double start_time = frame_defs.get_start_time(current_frame_num);
       const double end_time = frame_defs.get_end_time(current_frame_num);
 
+      // scratch files for the segments that are not in memory during the first pass
+      // (only used when use_scratch_files is true)
+      const bool spill_to_scratch_files =
+        use_scratch_files && !interactive && num_segments_in_memory < proj_data_ptr->get_num_segments();
+      VectorWithOffset<shared_ptr<ScratchSegment> >
+        scratch_segments(proj_data_ptr->get_min_segment_num(), proj_data_ptr->get_max_segment_num());
+      if (spill_to_scratch_files)
+        {
+          for (int segment_num=proj_data_ptr->get_min_segment_num() + num_segments_in_memory;
+               segment_num<=proj_data_ptr->get_max_segment_num();
+               ++segment_num)
+            scratch_segments[segment_num].reset(
+              new ScratchSegment((boost::format("%1%_f%2%_seg%3%") 
+                                  % output_filename_prefix % current_frame_num % segment_num).str(),
+                                 template_proj_data_info_ptr, segment_num));
+        }
+
       /*
 	 For each start_segment_index, we check which events occur in the
 	 segments between start_segment_index and 
@@ -592,6 +742,22 @@ process_data()
 	   long more_events = 
 	     do_time_frame? 1 : num_events_to_store;
 
+	   if (spill_to_scratch_files && start_segment_index != proj_data_ptr->get_min_segment_num())
+	     {
+	       // all events for these segments have been stored in scratch files during the first pass
+	       cerr << "\nProcessing next batch of segments from scratch files\n";
+	       for (int segment_num=start_segment_index; segment_num<=end_segment_index; ++segment_num)
+		 {
+		   scratch_segments[segment_num]->add_to(*segments[segment_num]);
+		   scratch_segments[segment_num].reset();
+		 }
+
+	       save_and_delete_segments(output, segments, 
+					start_segment_index, end_segment_index, 
+					*proj_data_ptr);  
+	       continue;
+	     }
+
 	   if (start_segment_index != proj_data_ptr->get_min_segment_num())
 	     {
 	       // we're going once more through the data (for the next batch of segments)
@@ -608,6 +774,16 @@ process_data()
 	       // need to set it. In fact, setting it to start_time would be wrong
 	       // as we first might have to skip some events before we get to start_time.
 	       // So, let's do that now.
+	       // If we have a time index, first go to the last indexed time record before start_time
+	       // (but never backwards).
+	       std::size_t entry_num;
+	       if (!time_index.is_empty() &&
+		   time_index.find_entry_before(entry_num, start_time) &&
+		   time_index.get_time_in_secs(entry_num) > current_time)
+		 {
+		   if (time_index.set_get_position(*lm_data_ptr, entry_num) == Succeeded::no)
+		     error("LmToProjData: error setting position from time index %s\n", time_index_filename.c_str());
+		 }
 	       while (current_time < start_time && 
 		      lm_data_ptr->get_next_record(record) == Succeeded::yes) 
 		 {
@@ -618,6 +794,182 @@ process_data()
 	       frame_start_positions[current_frame_num] = 
 		 lm_data_ptr->save_get_position();
 	     }
+	   if (bin_events_in_batches)
+	     {
+	       bool end_of_frame = false;
+	       // a time event that needs to be handled after binning the current batch
+	       bool time_record_is_pending = false;
+	       std::size_t pending_record_num = 0;
+	       while (!end_of_frame)
+		 {
+		   // read the next batch of events (handling time events)
+		   std::size_t num_events_in_batch = 0;
+		   while (num_events_in_batch < max_num_events_in_batch)
+		     {
+		       CListRecord& current_record = *records[num_events_in_batch];
+		       if (time_record_is_pending)
+			 time_record_is_pending = false; // it has been moved to this slot already
+		       else if (lm_data_ptr->get_next_record(current_record) == Succeeded::no) 
+			 {
+			   // no more events in file for some reason
+			   end_of_frame = true;
+			   break;
+			 }
+		       if (current_record.is_time())
+			 {
+			   if (binning_depends_on_time && num_events_in_batch>0)
+			     {
+			       time_record_is_pending = true;
+			       pending_record_num = num_events_in_batch;
+			       break;
+			     }
+			   current_time = current_record.time().get_time_in_secs();
+			   if (current_time >= end_time)
+			     {
+			       end_of_frame = true;
+			       break;
+			     }
+			   assert(current_time>=start_time);
+			   process_new_time_event(current_record.time());
+			 }
+		       if (current_record.is_event())
+			 ++num_events_in_batch;
+		     }
+
+		   // bin the events in parallel
+		   // we cannot throw inside a parallel region (e.g. when the normalisation
+		   // calls error()), so keep the first error message
+		   bool error_occurred = false;
+		   string error_message;
+#ifdef STIR_OPENMP
+#pragma omp parallel shared(binned_events_per_thread, records, num_events_in_batch, proj_data_ptr, error_occurred, error_message)
+#endif
+		   {
+		     string thread_error_message;
+#ifdef STIR_OPENMP
+		     vector<BinnedEvent>& binned_events = binned_events_per_thread[omp_get_thread_num()];
+#else
+		     vector<BinnedEvent>& binned_events = binned_events_per_thread[0];
+#endif
+		     binned_events.resize(0);
+		     // a static schedule gives every thread a contiguous range of events,
+		     // which are added in order of the thread number below
+#ifdef STIR_OPENMP
+#pragma omp for schedule(static)
+#endif
+		     for (int i=0; i<static_cast<int>(num_events_in_batch); ++i)
+		       {
+			 // after an error, skip the remaining events of this thread
+			 if (!thread_error_message.empty())
+			   continue;
+			 try
+			   {
+			     const CListRecord& current_record = *records[i];
+			     Bin bin;
+			     // set value in case the event decoder doesn't touch it
+			     // otherwise it would be 0 and all events will be ignored
+			     bin.set_bin_value(1);
+			     get_bin_from_event(bin, current_record.event());
+			     // check if it's inside the range we want to store
+			     if (bin.get_bin_value()<=0
+			         || bin.tangential_pos_num()< proj_data_ptr->get_min_tangential_pos_num()
+			         || bin.tangential_pos_num()> proj_data_ptr->get_max_tangential_pos_num()
+			         || bin.axial_pos_num()<proj_data_ptr->get_min_axial_pos_num(bin.segment_num())
+			         || bin.axial_pos_num()>proj_data_ptr->get_max_axial_pos_num(bin.segment_num())
+			         ) 
+			       continue;
+			     assert(bin.view_num()>=proj_data_ptr->get_min_view_num());
+			     assert(bin.view_num()<=proj_data_ptr->get_max_view_num());
+
+			     const bool is_prompt = current_record.event().is_prompt();
+			     const int event_increment =
+			       is_prompt
+			       ? ( store_prompts ? 1 : 0 ) // it's a prompt
+			       :  delayed_increment;//it is a delayed-coincidence event
+			     if (event_increment==0)
+			       continue;
+			     // events for other segments are only needed for the scratch files
+			     if ((bin.segment_num() < start_segment_index || bin.segment_num() > end_segment_index)
+			         && !spill_to_scratch_files)
+			       continue;
+
+			     do_post_normalisation(bin);
+			     BinnedEvent binned_event;
+			     binned_event.segment_num = static_cast<boost::int16_t>(bin.segment_num());
+			     binned_event.view_num = static_cast<boost::int16_t>(bin.view_num());
+			     binned_event.axial_pos_num = static_cast<boost::int16_t>(bin.axial_pos_num());
+			     binned_event.tangential_pos_num = static_cast<boost::int16_t>(bin.tangential_pos_num());
+			     binned_event.value = bin.get_bin_value();
+			     binned_event.event_increment = static_cast<boost::int8_t>(event_increment);
+			     binned_event.is_prompt = is_prompt;
+			     binned_events.push_back(binned_event);
+			   }
+			 catch (std::string& msg)
+			   {
+			     thread_error_message = msg;
+			   }
+			 catch (std::exception& e)
+			   {
+			     thread_error_message = e.what();
+			   }
+		       }
+		     if (!thread_error_message.empty())
+		       {
+#ifdef STIR_OPENMP
+#pragma omp critical (LMTOPROJDATA_ERROR)
+#endif
+			 if (!error_occurred)
+			   {
+			     error_occurred = true;
+			     error_message = thread_error_message;
+			   }
+		       }
+		   } // end of parallel section
+		   if (error_occurred)
+		     error(error_message);
+
+		   // add the binned events to the segments (or scratch files)
+		   for (std::size_t thread_num=0; thread_num<binned_events_per_thread.size(); ++thread_num)
+		     {
+		       const vector<BinnedEvent>& binned_events = binned_events_per_thread[thread_num];
+		       for (vector<BinnedEvent>::const_iterator iter = binned_events.begin();
+			    iter != binned_events.end();
+			    ++iter)
+			 {
+			   num_stored_events += iter->event_increment;
+			   if (iter->is_prompt)
+			     ++num_prompts_in_frame;
+			   else
+			     ++num_delayeds_in_frame;
+
+			   if (iter->segment_num >= start_segment_index && iter->segment_num<=end_segment_index)
+			     {
+			       if (num_stored_events%500000L==0) cout << "\r" << num_stored_events << " events stored" << flush;
+			       (*segments[iter->segment_num])[iter->view_num][iter->axial_pos_num][iter->tangential_pos_num] += 
+				 iter->value * iter->event_increment;
+			     }
+			   else
+			     {
+			       // store it for a later batch of segments
+			       ScratchEvent scratch_event;
+			       scratch_event.segment_num = iter->segment_num;
+			       scratch_event.view_num = iter->view_num;
+			       scratch_event.axial_pos_num = iter->axial_pos_num;
+			       scratch_event.tangential_pos_num = iter->tangential_pos_num;
+			       scratch_event.value = iter->value * iter->event_increment;
+			       scratch_segments[iter->segment_num]->add_event(scratch_event);
+			     }
+			 }
+		     }
+
+		   if (time_record_is_pending)
+		     records[0].swap(records[pending_record_num]);
+		 } // end of loop over batches
+
+	       time_of_last_stored_event = 
+		 max(time_of_last_stored_event,current_time); 
+	     }
+	   else
 	   {      
 	     // loop over all events in the listmode file
 	     while (more_events)
@@ -692,6 +1044,25 @@ process_data()
 			       bin.get_bin_value() * 
 			       event_increment;
 			   }
+			 else if (spill_to_scratch_files)
+			   {
+			     // store it for a later batch of segments
+			     do_post_normalisation(bin);
+			 
+			     num_stored_events += event_increment;
+			     if (record.event().is_prompt())
+			       ++num_prompts_in_frame;
+			     else
+			       ++num_delayeds_in_frame;
+
+			     ScratchEvent scratch_event;
+			     scratch_event.segment_num = static_cast<boost::int16_t>(bin.segment_num());
+			     scratch_event.view_num = static_cast<boost::int16_t>(bin.view_num());
+			     scratch_event.axial_pos_num = static_cast<boost::int16_t>(bin.axial_pos_num());
+			     scratch_event.tangential_pos_num = static_cast<boost::int16_t>(bin.tangential_pos_num());
+			     scratch_event.value = bin.get_bin_value() * event_increment;
+			     scratch_segments[bin.segment_num()]->add_event(scratch_event);
+			   }
 		       }
 		     else 	// event is rejected for some reason
 		       {
@@ -733,6 +1104,126 @@ process_data()
 
 /************************* Local helper routines *************************/
 
+const std::size_t ScratchSegment::max_num_events_in_buffer;
+
+ScratchSegment::
+ScratchSegment(const string& filename_prefix,
+               const shared_ptr<ProjDataInfo>& proj_data_info_sptr,
+               const int segment_num)
+  : filename_prefix(filename_prefix),
+    proj_data_info_sptr(proj_data_info_sptr),
+    segment_num(segment_num),
+    num_events_in_file(0)
+{
+  this->events_filename = create_unique_temporary_file(filename_prefix);
+  if (this->events_filename.empty())
+    error("LmToProjData: error creating scratch file for segment %d\n", segment_num);
+  this->buffer.reserve(max_num_events_in_buffer);
+  // merge when the events take more space than the segment
+  const std::size_t num_bins =
+    static_cast<std::size_t>(proj_data_info_sptr->get_num_views()) *
+    proj_data_info_sptr->get_num_axial_poss(segment_num) *
+    proj_data_info_sptr->get_num_tangential_poss();
+  this->max_num_events_in_file =
+    max(num_bins*sizeof(elem_type)/sizeof(ScratchEvent), max_num_events_in_buffer);
+}
+
+ScratchSegment::
+~ScratchSegment()
+{
+  std::remove(this->events_filename.c_str());
+  if (!this->partial_segment_filename.empty())
+    std::remove(this->partial_segment_filename.c_str());
+}
+
+void
+ScratchSegment::
+flush_buffer()
+{
+  if (this->buffer.empty())
+    return;
+  if (this->num_events_in_file + this->buffer.size() > this->max_num_events_in_file)
+    this->merge_events_into_partial_segment();
+  ofstream s(this->events_filename.c_str(), ios::out|ios::binary|ios::app);
+  s.write(reinterpret_cast<const char *>(&this->buffer[0]),
+          static_cast<std::streamsize>(this->buffer.size()*sizeof(ScratchEvent)));
+  if (!s)
+    error("LmToProjData: error writing scratch file %s\n", this->events_filename.c_str());
+  this->num_events_in_file += this->buffer.size();
+  this->buffer.resize(0);
+}
+
+void
+ScratchSegment::
+add_events_in_file(segment_type& segment) const
+{
+  if (this->num_events_in_file == 0)
+    return;
+  ifstream s(this->events_filename.c_str(), ios::in|ios::binary);
+  vector<ScratchEvent> events(max_num_events_in_buffer);
+  std::size_t num_events_to_read = this->num_events_in_file;
+  while (num_events_to_read > 0)
+    {
+      const std::size_t num_events = min(num_events_to_read, events.size());
+      s.read(reinterpret_cast<char *>(&events[0]),
+             static_cast<std::streamsize>(num_events*sizeof(ScratchEvent)));
+      if (!s)
+        error("LmToProjData: error reading scratch file %s\n", this->events_filename.c_str());
+      for (std::size_t i=0; i<num_events; ++i)
+        segment[events[i].view_num][events[i].axial_pos_num][events[i].tangential_pos_num] +=
+          events[i].value;
+      num_events_to_read -= num_events;
+    }
+}
+
+void
+ScratchSegment::
+merge_events_into_partial_segment()
+{
+  segment_type segment = this->proj_data_info_sptr->get_empty_segment_by_view(this->segment_num);
+  if (this->partial_segment_filename.empty())
+    {
+      this->partial_segment_filename = create_unique_temporary_file(this->filename_prefix);
+      if (this->partial_segment_filename.empty())
+        error("LmToProjData: error creating scratch file for segment %d\n", this->segment_num);
+    }
+  else
+    {
+      ifstream s(this->partial_segment_filename.c_str(), ios::in|ios::binary);
+      if (!s || read_data(s, segment) == Succeeded::no)
+        error("LmToProjData: error reading scratch file %s\n", this->partial_segment_filename.c_str());
+    }
+  this->add_events_in_file(segment);
+  {
+    ofstream s(this->partial_segment_filename.c_str(), ios::out|ios::binary|ios::trunc);
+    if (!s || write_data(s, segment) == Succeeded::no)
+      error("LmToProjData: error writing scratch file %s\n", this->partial_segment_filename.c_str());
+  }
+  // empty the file with the events
+  ofstream s(this->events_filename.c_str(), ios::out|ios::binary|ios::trunc);
+  if (!s)
+    error("LmToProjData: error writing scratch file %s\n", this->events_filename.c_str());
+  this->num_events_in_file = 0;
+}
+
+void
+ScratchSegment::
+add_to(segment_type& segment)
+{
+  if (!this->partial_segment_filename.empty())
+    {
+      ifstream s(this->partial_segment_filename.c_str(), ios::in|ios::binary);
+      if (!s || read_data(s, segment) == Succeeded::no)
+        error("LmToProjData: error reading scratch file %s\n", this->partial_segment_filename.c_str());
+    }
+  this->add_events_in_file(segment);
+  for (vector<ScratchEvent>::const_iterator iter = this->buffer.begin();
+       iter != this->buffer.end();
+       ++iter)
+    segment[iter->view_num][iter->axial_pos_num][iter->tangential_pos_num] += iter->value;
+  this->buffer.resize(0);
+}
+
 
 void 
 allocate_segments( VectorWithOffset<segment_type *>& segments,
@@ -5,6 +5,7 @@ dir := listmode_buildblock
 $(dir)_LIB_SOURCES = \
 	CListEvent.cxx \
 	CListModeData.cxx \
+	CListModeDataTimeIndex.cxx \
 	LmToProjData.cxx \
 	LmToProjDataBootstrap.cxx \
 	CListModeDataECAT8_32bit.cxx \
@@ -26,11 +26,16 @@
 #include "stir/round.h"
 #include "stir/modulo.h"
 #include "stir/array_index_functions.h"
+#include "stir/IndexRange2D.h"
+#include "stir/shared_ptr.h"
+#include "stir/error.h"
+#include <map>
+#include <vector>
 START_NAMESPACE_STIR
 
 
 template <typename T>
-static void bitreversal(VectorWithOffset<T>& data)
+static void bitreversal(T& data)
 {
   const int n=data.get_length();
   int   j=1;
@@ -47,73 +52,123 @@ static void bitreversal(VectorWithOffset<T>& data)
   }
 }
 
-/* We cache factors exp(i*_PI/pow(2,k)). They will be computed during the first
-   call of the Fourier functions, and then stored in static arrays.
+namespace detail {
+
+/* A FourierPlan contains everything that depends only on the length of the
+   transform, i.e. the factorisation of the length and the twiddle factors.
+   Plans are constructed once by get_fourier_plan() and never modified afterwards,
+   such that they can be used by multiple threads at the same time.
 */
-// exparray[k][i] = exp(i*_PI/pow(2,k))
-typedef VectorWithOffset<VectorWithOffset<std::complex<float> > > exparray_t;
-static   exparray_t exparray;
+class FourierPlan
+{
+public:
+  explicit FourierPlan(const int length);
+
+  int get_length() const
+  { return length; }
+
+  bool is_power_of_2() const
+  { return power_of_2; }
+
+  //! factors (all prime) such that their product is the length
+  const std::vector<int>& get_factors() const
+  { return factors; }
+
+  //! returns exp(sign*2*pi*i*t/length), for 0<=t<length
+  std::complex<float> twiddle(const int t, const int sign) const
+  {
+    assert(t>=0 && t<length);
+    return sign==1 ? twiddles[t] : std::conj(twiddles[t]);
+  }
+
+  //! returns exp(sign*pi*i*t/length), for 0<=t<=length/2 (used for DFTs of real data)
+  std::complex<float> half_twiddle(const int t, const int sign) const
+  {
+    assert(t>=0 && t<=length/2);
+    return sign==1 ? half_twiddles[t] : std::conj(half_twiddles[t]);
+  }
 
-static void init_exparray(const int k, const int pow2k)
+private:
+  int length;
+  bool power_of_2;
+  std::vector<int> factors;
+  std::vector<std::complex<float> > twiddles;
+  std::vector<std::complex<float> > half_twiddles;
+};
+
+FourierPlan::
+FourierPlan(const int length_v)
+  : length(length_v)
 {
-  if (exparray.get_max_index() >= k && exparray[k].size()>0)
-    return;
-
-  if (exparray.get_max_index() <k)
-    exparray.grow(0, k);
-  exparray[k].grow(0,pow2k-1);
-  for (int i=0; i< pow2k; ++i)
-    exparray[k][i]= std::exp(std::complex<float>(0, static_cast<float>((i*_PI)/pow2k)));
+  assert(length>0);
+  power_of_2 = (length & (length-1)) == 0;
+  {
+    int remaining = length;
+    for (int p=2; p*p<=remaining; ++p)
+      while (remaining%p == 0)
+        {
+          factors.push_back(p);
+          remaining /= p;
+        }
+    if (remaining>1)
+      factors.push_back(remaining);
+  }
+  // compute in double precision, such that the factors are accurate for large lengths
+  twiddles.resize(length);
+  for (int t=0; t<length; ++t)
+    {
+      const double angle = (2*_PI*t)/length;
+      twiddles[t] = std::complex<float>(static_cast<float>(cos(angle)), static_cast<float>(sin(angle)));
+    }
+  half_twiddles.resize(length/2+1);
+  for (int t=0; t<=length/2; ++t)
+    {
+      const double angle = (_PI*t)/length;
+      half_twiddles[t] = std::complex<float>(static_cast<float>(cos(angle)), static_cast<float>(sin(angle)));
+    }
 }
 
-// expminarray[k][i] = exp(-i*_PI/pow(2,k))
-// obviously just the complex conjugate of exparray
-static   exparray_t expminarray;
+/* Plans are cached for every length that has been used. The cache is only
+   accessed inside a critical section, while the plans themselves are const.
+*/
+typedef std::map<int, shared_ptr<const FourierPlan> > fourier_plan_cache_t;
+static fourier_plan_cache_t fourier_plan_cache;
 
-static void init_expminarray(const int k, const int pow2k)
+static shared_ptr<const FourierPlan>
+get_fourier_plan(const int length)
 {
-  if (expminarray.get_max_index() >= k && expminarray[k].size()>0)
-    return;
-
-  if (expminarray.get_max_index() <k)
-    expminarray.grow(0, k);
-  expminarray[k].grow(0,pow2k-1);
-  for (int i=0; i< pow2k; ++i)
-    expminarray[k][i]= std::exp(std::complex<float>(0, static_cast<float>(-(i*_PI)/pow2k)));
+  shared_ptr<const FourierPlan> plan_sptr;
+#ifdef STIR_OPENMP
+#pragma omp critical(FOURIERPLANCACHE)
+#endif
+  {
+    const fourier_plan_cache_t::const_iterator iter = fourier_plan_cache.find(length);
+    if (iter != fourier_plan_cache.end())
+      plan_sptr = iter->second;
+    else
+      {
+        plan_sptr.reset(new FourierPlan(length));
+        fourier_plan_cache[length] = plan_sptr;
+      }
+  }
+  return plan_sptr;
 }
 
-
-/* First we define 1D fourier transforms of vectors with almost arbitrary
-   element types.
+/* In-place radix-2 FFT, only for lengths that are a power of 2.
    This is almost a straightforward 1D FFT implementation. The only tricky bit
    is to make sure that all operations are written in a way that is defined
    (and efficient) in the case that the element type is a vector again.
 */
-
 template <typename T>
-void fourier_1d(T& c, const int sign)
+static void fourier_1d_radix_2(T& c, const FourierPlan& plan, const int sign)
 {
-  if (c.size()==0) return;
-  assert(c.get_min_index()==0);
-  assert(sign==1 || sign ==-1);
   bitreversal(c);
-  // find 'nn' which is such that length==2^nn
-  const int nn=round(log(static_cast<double>(c.size()))/log(2.));
-  if (c.get_length()!= round(pow(2.,nn)))
-    error ("fourier_1d called with array length %d which is not 2^%d\n", c.size(), nn);
-
-  int k=0;
-  int pow2k = 1; // will be updated to be round(pow(2,k))
-  const int pow2nn=c.get_length(); // ==round(pow(2,nn)); 
-  for (; k<nn; ++k, pow2k*=2)
+  const int n=c.get_length();
+  for (int pow2k = 1; pow2k<n; pow2k*=2)
   {
-    if (sign==1)
-      init_exparray(k,pow2k);
-    else
-      init_expminarray(k,pow2k);
-    const exparray_t& cur_exparray =
-      sign==1? exparray : expminarray;      
-    for (int j=0; j< pow2nn;j+= pow2k*2) 
+    // twiddle factors are exp(sign*i*pi*i/pow2k)
+    const int twiddle_step = n/(2*pow2k);
+    for (int j=0; j< n;j+= pow2k*2) 
       for (int i=0; i< pow2k; ++i)
       {
         typename T::reference c1= c[i + j];
@@ -122,7 +177,7 @@ void fourier_1d(T& c, const int sign)
         typename T::value_type const t1 = c1; 
 	/* here is what we have to do:
             typename T::value_type const t2 = 
-              c2*cur_exparray[k][i];
+              c2*twiddle;
             c1 = t1+t2; c2 = t1-t2;
 	 however, this would create an unnecessary copy of t2, which is 
 	 potentially large.
@@ -132,7 +187,7 @@ void fourier_1d(T& c, const int sign)
 	 loops over the same data.
 	 Using expression templates would speed this up.
 	*/
-        c2 *= cur_exparray[k][i];
+        c2 *= plan.twiddle(i*twiddle_step, sign);
         c1 += c2;
         c2 *= -1;
         c2 += t1;
@@ -140,6 +195,114 @@ void fourier_1d(T& c, const int sign)
   }
 }
 
+/* One pass of the mixed-radix (Stockham autosort) FFT.
+   At this stage, the data consist of 'stride' interleaved sequences of length
+   'sub_length'. Each of these is split into 'radix' sequences of length 
+   sub_length/radix (decimation in frequency), which are interleaved again in 
+   the output. After the last pass, the output is in natural order.
+   As the twiddle factors are the same for all sequences, the innermost loop
+   runs over the interleaved sequences.
+*/
+template <typename OutT, typename InT>
+static void
+mixed_radix_pass(OutT& out, const InT& in, 
+                 const int radix, const int sub_length, const int stride,
+                 const FourierPlan& plan, const int sign,
+                 typename InT::value_type& tmp)
+{
+  const int n = plan.get_length();
+  const int m = sub_length/radix;
+  // step in the twiddle factors for exp(sign*2*pi*i/radix)
+  const int radix_step = n/radix;
+  for (int j=0; j<m; ++j)
+    for (int k=0; k<radix; ++k)
+      {
+        // exp(sign*2*pi*i*j*k/sub_length)
+        const std::complex<float> twiddle = plan.twiddle(stride*j*k, sign);
+        for (int q=0; q<stride; ++q)
+          {
+            typename OutT::reference result = out[q + stride*(k + radix*j)];
+            result = in[q + stride*j];
+            if (radix==2)
+              {
+                if (k==0)
+                  result += in[q + stride*(j + m)];
+                else
+                  result -= in[q + stride*(j + m)];
+              }
+            else
+              {
+                for (int r=1; r<radix; ++r)
+                  {
+                    tmp = in[q + stride*(j + r*m)];
+                    tmp *= plan.twiddle(radix_step*((r*k)%radix), sign);
+                    result += tmp;
+                  }
+              }
+            if (j*k != 0)
+              result *= twiddle;
+          }
+      }
+}
+
+/* Mixed-radix FFT for any length. This needs a work array of the same size as
+   the data (the passes alternate between the data and the work array).
+*/
+template <typename T>
+static void fourier_1d_mixed_radix(T& c, const FourierPlan& plan, const int sign)
+{
+  typedef typename T::value_type value_type;
+  const int n = c.get_length();
+  VectorWithOffset<value_type> work(0, n-1);
+  value_type tmp;
+  bool result_in_work = false;
+  int sub_length = n;
+  int stride = 1;
+  for (std::vector<int>::const_iterator radix_iter = plan.get_factors().begin();
+       radix_iter != plan.get_factors().end();
+       ++radix_iter)
+    {
+      const int radix = *radix_iter;
+      if (result_in_work)
+        mixed_radix_pass(c, work, radix, sub_length, stride, plan, sign, tmp);
+      else
+        mixed_radix_pass(work, c, radix, sub_length, stride, plan, sign, tmp);
+      result_in_work = !result_in_work;
+      sub_length /= radix;
+      stride *= radix;
+    }
+  if (result_in_work)
+    for (int i=0; i<n; ++i)
+      c[i] = work[i];
+}
+
+template <typename T>
+static void fourier_1d_with_plan(T& c, const FourierPlan& plan, const int sign)
+{
+  assert(c.get_length() == plan.get_length());
+  if (plan.is_power_of_2())
+    fourier_1d_radix_2(c, plan, sign);
+  else
+    fourier_1d_mixed_radix(c, plan, sign);
+}
+
+} // end of namespace detail
+
+/* First we define 1D fourier transforms of vectors with almost arbitrary
+   element types.
+*/
+
+template <typename T>
+void fourier_1d(T& c, const int sign)
+{
+  if (c.size()<=1) return;
+  assert(c.get_min_index()==0);
+  assert(sign==1 || sign ==-1);
+  const shared_ptr<const detail::FourierPlan> plan_sptr =
+    detail::get_fourier_plan(c.get_length());
+  detail::fourier_1d_with_plan(c, *plan_sptr, sign);
+}
+
 namespace detail {
 
 /* A class that does the recursion for multi-dimensional arrays.
@@ -219,45 +382,43 @@ fourier(T& c, const int sign)
 
 
 
+namespace detail {
+
+/* DFT of a real array v of length 2n, storing the result in c (with indices 0...n).
+   The plan has to be for length n.
+*/
 template <typename T>
-Array<1,std::complex<T> >
-fourier_1d_for_real_data(const Array<1,T>& v, const int sign)
-//Array<1,std::complex<typename T::value_type> >
-//fourier_1d_for_real_data(const T& v, const int sign)
+static void
+fourier_1d_for_real_data_with_plan(Array<1,std::complex<T> >& c, const Array<1,T>& v,
+                                   const FourierPlan& plan, const int sign)
 {
-  //typedef std::complex<typename T::value_type> complex_t;
   typedef std::complex<T> complex_t;
-  if (v.size()==0) return Array<1,complex_t>();
+  const int n = plan.get_length();
   assert(v.get_min_index()==0);
-  assert(sign==1 || sign ==-1);
-  if (v.size()%2!=0)
-    error("fourier_1d_of_real can only handle arrays of even length.\n");
-
-  Array<1,complex_t> c;
-  const unsigned int n = static_cast<unsigned int>(v.size()/2);
-  // we reserve a range of 0,n here, such that 
-  // resize(n) later doesn't reallocate and copy
-  c.reserve(n+1);
-  c.resize(n);
+  assert(v.get_length()==2*n);
+  assert(c.get_min_index()==0);
+  assert(c.get_length()==n+1);
   // fill in complex numbers.
   // note: we need to divide by 2 in the final result. To save
   // some time, we do that already here.
-  for (int i=0; i<c.get_length(); ++i)
+  for (int i=0; i<n; ++i)
     c[i] =  complex_t(v[2*i]/2, v[2*i+1]/2);
 
-  fourier_1d(c, sign);
+  {
+    // do the complex DFT on the first n elements of c
+    Array<1,complex_t> c_first_n(IndexRange<1>(0,n-1), c.get_data_ptr());
+    fourier_1d_with_plan(c_first_n, plan, sign);
+    c.release_data_ptr();
+  }
 
-  //cout << "C: " << c;
-  c.resize(n+1);
-  for (unsigned int i=1; i<=n/2; ++i)
+  for (int i=1; i<=n/2; ++i)
     {
       const complex_t t1 = 
 	(c[i]+std::conj(c[n-i]));
-      // TODO could get exp() from static exparray
-      // the nice thing about this code that it works even when the length is not a power of 2
-      // (but of course, the call to fourier_1d would currently abort in that case)
+      // exp(i*(sign*i*pi/n - pi/2))
+      const std::complex<float> w = plan.half_twiddle(i, sign) * std::complex<float>(0,-1);
       const complex_t t2 = 			   
-	std::exp(complex_t(0, static_cast<T>(sign*(i*_PI)/n-_PI/2)))*
+	complex_t(w.real(), w.imag())*
 	(c[i]-std::conj(c[n-i]));
 
       c[i] = (t1 + t2);
@@ -268,21 +429,22 @@ fourier_1d_for_real_data(const Array<1,T>& v, const int sign)
     c[0]=(c0_copy.real() + c0_copy.imag())*2;
     c[n]=(c0_copy.real() - c0_copy.imag())*2;
   }
-  return c;
 }
 
-
+/* Inverse of the above, storing the result in v (which has to have length 2n).
+   Values in c are overwritten.
+*/
 template <typename T>
-Array<1,T>
-inverse_fourier_1d_for_real_data_corrupting_input(Array<1,std::complex<T> >& c, const int sign)
+static void
+inverse_fourier_1d_for_real_data_with_plan(Array<1,T>& v, Array<1,std::complex<T> >& c,
+                                           const FourierPlan& plan, const int sign)
 {
   typedef std::complex<T> complex_t;
-  if (c.size()==0) return Array<1,T>();
+  const int n = plan.get_length();
   assert(c.get_min_index()==0);
-  assert(sign==1 || sign ==-1);
-  const int n = c.get_length()-1;
-  if (n%2!=0)
-    error("inverse_fourier_1d_of_real_data can only handle arrays of even length.\n");
+  assert(c.get_length()==n+1);
+  assert(v.get_min_index()==0);
+  assert(v.get_length()==2*n);
 
   /* Problematic asserts to check that the imaginary part of c[0] and c[n] is 0
      Trouble is that it could be only approximately 0 (e.g. when calling 
@@ -298,9 +460,10 @@ inverse_fourier_1d_for_real_data_corrupting_input(Array<1,std::complex<T> >& c,
   for (int i=1; i<=n/2; ++i)
     {
       const complex_t t1 = (c[i]+std::conj(c[n-i]));
-      // TODO could get exp() from static exparray
+      // exp(i*(-sign*i*pi/n + pi/2))
+      const std::complex<float> w = plan.half_twiddle(i, -sign) * std::complex<float>(0,1);
       const complex_t t2 = 			   
-	std::exp(complex_t(0, static_cast<T>(-sign*(i*_PI)/n+_PI/2)))*
+	complex_t(w.real(), w.imag())*
 	(c[i]-std::conj(c[n-i]));
 
       c[i] = (t1 + t2);
@@ -312,17 +475,97 @@ inverse_fourier_1d_for_real_data_corrupting_input(Array<1,std::complex<T> >& c,
 		   );
   }
 
-  // now get rid of c[n] 
-  c.resize(n);
-  //cout << "\nC: " << c/4;
-  inverse_fourier(c, sign);
-  // extract real numbers.
-  Array<1,T> v(2*n);
+  {
+    // do the inverse complex DFT on the first n elements of c (i.e. ignoring c[n])
+    Array<1,complex_t> c_first_n(IndexRange<1>(0,n-1), c.get_data_ptr());
+    fourier_1d_with_plan(c_first_n, plan, -sign);
+    c.release_data_ptr();
+  }
+  // extract real numbers (including normalisation of the inverse DFT)
   for (int i=0; i<n; ++i)
     {
-      v[2*i]= c[i].real()/2;
-      v[2*i+1]= c[i].imag()/2;
+      v[2*i]= c[i].real()/(2*n);
+      v[2*i+1]= c[i].imag()/(2*n);
     }
+}
+
+} // end of namespace detail
+
+template <typename T>
+Array<1,std::complex<T> >
+fourier_1d_for_real_data(const Array<1,T>& v, const int sign)
+{
+  typedef std::complex<T> complex_t;
+  if (v.size()==0) return Array<1,complex_t>();
+  assert(v.get_min_index()==0);
+  assert(sign==1 || sign ==-1);
+  if (v.size()%2!=0)
+    error("fourier_1d_of_real can only handle arrays of even length.\n");
+
+  const int n = static_cast<int>(v.size()/2);
+  Array<1,complex_t> c(0, n);
+  const shared_ptr<const detail::FourierPlan> plan_sptr = detail::get_fourier_plan(n);
+  detail::fourier_1d_for_real_data_with_plan(c, v, *plan_sptr, sign);
+  return c;
+}
+
+
+template <typename T>
+Array<1,T>
+inverse_fourier_1d_for_real_data_corrupting_input(Array<1,std::complex<T> >& c, const int sign)
+{
+  if (c.size()==0) return Array<1,T>();
+  assert(c.get_min_index()==0);
+  assert(sign==1 || sign ==-1);
+  const int n = c.get_length()-1;
+  Array<1,T> v(2*n);
+  if (n==0)
+    return v;
+  const shared_ptr<const detail::FourierPlan> plan_sptr = detail::get_fourier_plan(n);
+  detail::inverse_fourier_1d_for_real_data_with_plan(v, c, *plan_sptr, sign);
+  return v;
+}
+
+template <typename T>
+Array<2,std::complex<T> >
+fourier_1d_for_real_data_of_rows(const Array<2,T>& v, const int sign)
+{
+  typedef std::complex<T> complex_t;
+  if (v.size()==0) return Array<2,complex_t>();
+  assert(sign==1 || sign ==-1);
+  BasicCoordinate<2,int> min_index, max_index;
+  if (!v.get_regular_range(min_index, max_index) || min_index[2]!=0)
+    error("fourier_1d_for_real_data_of_rows can only handle regular arrays with rows starting from index 0.\n");
+  const int length = max_index[2]+1;
+  if (length%2!=0)
+    error("fourier_1d_for_real_data_of_rows can only handle rows of even length.\n");
+
+  const int n = length/2;
+  Array<2,complex_t> c(IndexRange2D(min_index[1], max_index[1], 0, n));
+  if (n==0)
+    return c;
+  const shared_ptr<const detail::FourierPlan> plan_sptr = detail::get_fourier_plan(n);
+  for (int i=min_index[1]; i<=max_index[1]; ++i)
+    detail::fourier_1d_for_real_data_with_plan(c[i], v[i], *plan_sptr, sign);
+  return c;
+}
+
+template <typename T>
+Array<2,T>
+inverse_fourier_1d_for_real_data_of_rows_corrupting_input(Array<2,std::complex<T> >& c, const int sign)
+{
+  if (c.size()==0) return Array<2,T>();
+  assert(sign==1 || sign ==-1);
+  BasicCoordinate<2,int> min_index, max_index;
+  if (!c.get_regular_range(min_index, max_index) || min_index[2]!=0)
+    error("inverse_fourier_1d_for_real_data_of_rows can only handle regular arrays with rows starting from index 0.\n");
+  const int n = max_index[2];
+  Array<2,T> v(IndexRange2D(min_index[1], max_index[1], 0, 2*n-1));
+  if (n==0)
+    return v;
+  const shared_ptr<const detail::FourierPlan> plan_sptr = detail::get_fourier_plan(n);
+  for (int i=min_index[1]; i<=max_index[1]; ++i)
+    detail::inverse_fourier_1d_for_real_data_with_plan(v[i], c[i], *plan_sptr, sign);
   return v;
 }
 
@@ -386,6 +629,27 @@ struct fourier_for_real_data_auxiliary
 // specialisation for the one-dimensional case
 #ifndef BOOST_NO_TEMPLATE_PARTIAL_SPECIALIZATION
 
+// specialisation for the two-dimensional case, doing all rows at once
+template <typename elemT>
+struct fourier_for_real_data_auxiliary<2,elemT>
+{
+  static Array<2,std::complex<elemT> >
+  do_fourier_for_real_data(const Array<2,elemT >& c, const int sign)
+  {
+    Array<2,std::complex<elemT> > array =
+      fourier_1d_for_real_data_of_rows(c, sign);
+    fourier_1d(array, sign);
+    return array;
+  }
+  static Array<2,elemT>
+  do_inverse_fourier_for_real_data_corrupting_input(Array<2,std::complex<elemT> >& c, const int sign)
+  {
+    inverse_fourier_1d(c, sign);
+    return
+      inverse_fourier_1d_for_real_data_of_rows_corrupting_input(c, sign);
+  }
+};
+
 template <typename elemT>
 struct fourier_for_real_data_auxiliary<1,elemT>
 {
@@ -523,6 +787,18 @@ template
 void 
 fourier<>(VectorWithOffset<std::complex<float> >& c, const int sign);
 
+template
+void 
+fourier<>(Array<2,std::complex<float> >& c, const int sign);
+
+template
+void 
+fourier<>(Array<1,std::complex<float> >& c, const int sign);
+
+template
+void 
+fourier_1d<>(Array<1,std::complex<float> >& c, const int sign);
+
 #define INSTANTIATE(d,type) \
  template \
  Array<d,std::complex<type> > \
@@ -542,4 +818,20 @@ INSTANTIATE(2,float);
 INSTANTIATE(3,float);
 #undef INSTANTIATE
 
+template
+Array<2,std::complex<float> >
+fourier_1d_for_real_data_of_rows<>(const Array<2,float>& v, const int sign);
+template
+Array<2,float>
+inverse_fourier_1d_for_real_data_of_rows_corrupting_input<>(Array<2,std::complex<float> >& c, const int sign);
+template
+Array<1,std::complex<float> >
+fourier_1d_for_real_data<>(const Array<1,float>& v, const int sign);
+template
+Array<1,float>
+inverse_fourier_1d_for_real_data_corrupting_input<>(Array<1,std::complex<float> >& c, const int sign);
+template
+Array<1,float>
+inverse_fourier_1d_for_real_data<>(const Array<1,std::complex<float> >& c, const int sign);
+
 END_NAMESPACE_STIR
@@ -34,6 +34,7 @@
 #include "stir/recon_buildblock/find_basic_vs_nums_in_subsets.h"
 #include "stir/RelatedViewgrams.h"
 #include "stir/ProjData.h"
+#include "stir/HighResWallClockTimer.h"
 #include <vector>
 #ifdef STIR_OPENMP
 #include "stir/is_null_ptr.h"
@@ -44,6 +45,7 @@
 START_NAMESPACE_STIR
 
 BackProjectorByBin::BackProjectorByBin()
+  : projection_time(0.)
 {
 }
 
@@ -82,8 +84,13 @@ BackProjectorByBin::back_project(DiscretisedDensity<3,float>& image,
         const ViewSegmentNumbers vs=vs_nums_to_process[i];
 #ifdef STIR_OPENMP
         RelatedViewgrams<float> viewgrams;
+        if (proj_data.is_thread_safe_for_reading())
+          viewgrams = proj_data.get_related_viewgrams(vs, symmetries_sptr);
+        else
+          {
 #pragma omp critical (BACKPROJECTORBYBIN_GETVIEWGRAMS)
-        viewgrams = proj_data.get_related_viewgrams(vs, symmetries_sptr);
+            viewgrams = proj_data.get_related_viewgrams(vs, symmetries_sptr);
+          }
 #else
         const RelatedViewgrams<float> viewgrams = 
           proj_data.get_related_viewgrams(vs, symmetries_sptr);
@@ -144,6 +151,8 @@ back_project(DiscretisedDensity<3,float>& density,
     return;
 
   start_timers();
+  HighResWallClockTimer wall_clock_timer;
+  wall_clock_timer.start();
 
   // first check symmetries    
   {
@@ -169,7 +178,20 @@ back_project(DiscretisedDensity<3,float>& density,
 	     max_axial_pos_num,
 	     min_tangential_pos_num,
 	     max_tangential_pos_num);
+  wall_clock_timer.stop();
   stop_timers();
+  const double time = wall_clock_timer.value();
+#ifdef STIR_OPENMP
+#pragma omp atomic
+#endif
+  this->projection_time += time;
+}
+
+double
+BackProjectorByBin::
+get_projection_time() const
+{
+  return this->projection_time;
 }
 
 
@@ -108,6 +108,8 @@ set_up(const shared_ptr<ProjDataInfo>& proj_data_info_ptr,
 
 {    	   
   proj_matrix_ptr->set_up(proj_data_info_ptr, image_info_ptr);
+  // computes and writes all elements if a persistent cache was requested but not found
+  proj_matrix_ptr->write_persistent_cache();
 }
 
 const DataSymmetriesForViewSegmentNumbers *
@@ -49,8 +49,21 @@
 #include "stir/Bin.h"
 #include "stir/display.h"
 #include "stir/is_null_ptr.h"
+#include "stir/info.h"
+#include "stir/warning.h"
+#include "stir/Succeeded.h"
+#include "stir/cache_file.h"
+#include <boost/format.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
 #include <algorithm>
 #include <fstream>
+#include <sstream>
+#include <vector>
+#ifdef STIR_OPENMP
+#include <omp.h>
+#endif
 
 #ifndef STIR_NO_NAMESPACES
 using std::ofstream;
@@ -156,9 +169,151 @@ set_detection_axial_coords(const ProjDataInfoCylindricalNoArcCorr *proj_data_inf
 
 
 
+
+// first bytes of a cache file (see cache_file.h for the rest of the header)
+static const char cache_file_magic[8] = { 'S','T','I','R','N','R','M','C' };
+static const boost::uint32_t cache_file_version = 2;
+
+// index of a bin in the cache (sinogram order for every segment)
+static inline
+std::size_t
+cache_index(const Bin& bin, const ProjDataInfo& proj_data_info,
+            const VectorWithOffset<std::size_t>& segment_offsets)
+{
+  assert(bin.segment_num() >= segment_offsets.get_min_index());
+  assert(bin.segment_num() <= segment_offsets.get_max_index());
+  return segment_offsets[bin.segment_num()] +
+    (static_cast<std::size_t>(bin.axial_pos_num() - proj_data_info.get_min_axial_pos_num(bin.segment_num())) *
+     proj_data_info.get_num_views() +
+     (bin.view_num() - proj_data_info.get_min_view_num())) *
+    proj_data_info.get_num_tangential_poss() +
+    (bin.tangential_pos_num() - proj_data_info.get_min_tangential_pos_num());
+}
+
 } // end of namespace detail
 
 
+//
+// FactorsCache
+//
+
+class BinNormalisationFromECAT7::FactorsCache
+{
+public:
+  FactorsCache(const double start_time_v, const double end_time_v, const bool depends_on_time_frame_v)
+    : data_ptr(0), start_time(start_time_v), end_time(end_time_v), depends_on_time_frame(depends_on_time_frame_v)
+  {}
+
+  bool is_for_time_frame(const double start_time_v, const double end_time_v) const
+  {
+    return !depends_on_time_frame || (start_time == start_time_v && end_time == end_time_v);
+  }
+
+  double get_start_time() const
+  { return start_time; }
+  double get_end_time() const
+  { return end_time; }
+
+  //! factors for all bins (see detail::cache_index())
+  const float * get_data_ptr() const
+  { return data_ptr; }
+
+  //! allocates memory for the factors, which then need to be computed
+  void allocate(const std::size_t num_bins)
+  {
+    data.resize(num_bins);
+    data_ptr = num_bins==0 ? 0 : &data[0];
+  }
+
+  //! pointer to the memory allocated by allocate()
+  float * get_allocated_data_ptr()
+  { return data.size()==0 ? 0 : &data[0]; }
+
+  //! sets the name of the file where the factors are stored and the description used to check it
+  void set_file(const std::string& filename_v, const std::string& description_v)
+  {
+    filename = filename_v;
+    description = description_v;
+  }
+
+  //! memory-maps the cache file, checking if it was written with the same description
+  Succeeded map_file(const std::size_t num_bins);
+
+  //! writes the factors to the cache file (if any)
+  void write_to_file(const std::size_t num_bins) const;
+
+private:
+  std::vector<float> data;
+  shared_ptr<boost::interprocess::file_mapping> file_mapping_sptr;
+  shared_ptr<boost::interprocess::mapped_region> mapped_region_sptr;
+  const float * data_ptr;
+  double start_time;
+  double end_time;
+  bool depends_on_time_frame;
+  std::string filename;
+  std::string description;
+};
+
+Succeeded
+BinNormalisationFromECAT7::FactorsCache::
+map_file(const std::size_t num_bins)
+{
+  {
+    std::ifstream s(filename.c_str(), std::ios::in | std::ios::binary);
+    if (!s)
+      return Succeeded::no;
+    boost::uint32_t flags;
+    boost::uint64_t data_size;
+    if (read_cache_file_header(s, detail::cache_file_magic, detail::cache_file_version,
+                               description, flags, data_size) == Succeeded::no ||
+        data_size != num_bins*sizeof(float))
+      return Succeeded::no;
+  }
+  shared_ptr<boost::interprocess::file_mapping> new_file_mapping_sptr;
+  shared_ptr<boost::interprocess::mapped_region> new_mapped_region_sptr;
+  try
+    {
+      new_file_mapping_sptr.reset(new boost::interprocess::file_mapping(filename.c_str(),
+                                                                        boost::interprocess::read_only));
+      new_mapped_region_sptr.reset(new boost::interprocess::mapped_region(*new_file_mapping_sptr,
+                                                                          boost::interprocess::read_only));
+    }
+  catch (std::exception& e)
+    {
+      warning(boost::format("BinNormalisationFromECAT7: could not map cache file %1% (%2%)")
+              % filename % e.what());
+      return Succeeded::no;
+    }
+
+  // the file might have been replaced since we read the header
+  const std::size_t data_offset = get_cache_file_header_size(description);
+  if (new_mapped_region_sptr->get_size() != data_offset + num_bins*sizeof(float))
+    return Succeeded::no;
+
+  file_mapping_sptr = new_file_mapping_sptr;
+  mapped_region_sptr = new_mapped_region_sptr;
+  data_ptr =
+    reinterpret_cast<const float *>(static_cast<const char *>(mapped_region_sptr->get_address()) + data_offset);
+  std::vector<float>().swap(data);
+  return Succeeded::yes;
+}
+
+void
+BinNormalisationFromECAT7::FactorsCache::
+write_to_file(const std::size_t num_bins) const
+{
+  if (filename.size() == 0)
+    return;
+  std::ofstream s;
+  const std::string tmp_filename = open_cache_file_for_writing(s, filename);
+  if (tmp_filename.size() == 0)
+    return;
+  write_cache_file_header(s, detail::cache_file_magic, detail::cache_file_version,
+                          0, num_bins*sizeof(float), description);
+  if (num_bins > 0)
+    s.write(reinterpret_cast<const char *>(data_ptr), num_bins*sizeof(float));
+  finish_writing_cache_file(s, tmp_filename, filename);
+}
 
 
 //
@@ -175,6 +330,8 @@ BinNormalisationFromECAT7::set_defaults()
   this->_use_dead_time = true;
   this->_use_geometric_factors = true;
   this->_use_crystal_interference_factors = true;  
+  this->_cache_normalisation_factors = false;
+  this->cache_filename_prefix = "";
 }
 
 void 
@@ -190,6 +347,8 @@ initialise_keymap()
   this->parser.add_key("use_dead_time", &this->_use_dead_time);
   this->parser.add_key("use_geometric_factors", &this->_use_geometric_factors);
   this->parser.add_key("use_crystal_interference_factors", &this->_use_crystal_interference_factors);
+  this->parser.add_key("cache_normalisation_factors", &this->_cache_normalisation_factors);
+  this->parser.add_key("cache_filename_prefix", &this->cache_filename_prefix);
   this->parser.add_stop_key("End Bin Normalisation From ECAT7");
 }
 
@@ -211,6 +370,7 @@ BinNormalisationFromECAT7()
 BinNormalisationFromECAT7::
 BinNormalisationFromECAT7(const std::string& filename)
 {
+  set_defaults();
   read_norm_data(filename);
 }
 
@@ -240,6 +400,49 @@ set_up(const shared_ptr<ProjDataInfo>& proj_data_info_ptr_v)
 
   mash = scanner_ptr->get_num_detectors_per_ring()/2/proj_data_info_ptr->get_num_views();
 
+  this->factors_cache_sptr.reset();
+  this->thread_factors_cache_sptrs.clear();
+  if (this->_cache_normalisation_factors)
+    {
+      this->cache_segment_offsets.resize(proj_data_info_ptr->get_min_segment_num(),
+                                         proj_data_info_ptr->get_max_segment_num());
+      this->cache_num_bins = 0;
+      this->cache_sinograms.clear();
+      for (int segment_num=proj_data_info_ptr->get_min_segment_num();
+           segment_num<=proj_data_info_ptr->get_max_segment_num();
+           ++segment_num)
+        {
+          this->cache_segment_offsets[segment_num] = this->cache_num_bins;
+          this->cache_num_bins +=
+            static_cast<std::size_t>(proj_data_info_ptr->get_num_axial_poss(segment_num)) *
+            proj_data_info_ptr->get_num_views() * proj_data_info_ptr->get_num_tangential_poss();
+          for (int axial_pos_num=proj_data_info_ptr->get_min_axial_pos_num(segment_num);
+               axial_pos_num<=proj_data_info_ptr->get_max_axial_pos_num(segment_num);
+               ++axial_pos_num)
+            this->cache_sinograms.push_back(std::make_pair(segment_num, axial_pos_num));
+        }
+#ifdef STIR_OPENMP
+      this->thread_factors_cache_sptrs.resize(omp_get_max_threads());
+#else
+      this->thread_factors_cache_sptrs.resize(1);
+#endif
+
+      // include size and modification time of the norm file, such that a cache file
+      // is not used after the norm file is replaced
+      std::ostringstream s;
+      s << this->parameter_info() << '\n'
+        << proj_data_info_ptr->parameter_info() << '\n'
+        << "normalisation file: " << get_file_signature(this->normalisation_ECAT7_filename) << '\n';
+      this->cache_description = s.str();
+
+      // compute the factors now if they will be the same for every time frame
+      if (!this->factors_depend_on_time_frame())
+        {
+          shared_ptr<FactorsCache> cache_sptr;
+          this->get_factors_cache(0., 0., cache_sptr);
+        }
+    }
+
   return Succeeded::yes;
 }
 
@@ -469,10 +672,287 @@ use_crystal_interference_factors() const
   return this->_use_crystal_interference_factors;
 }
 
-#if 1
+bool
+BinNormalisationFromECAT7::
+factors_depend_on_time_frame() const
+{
+  return this->use_dead_time() && !is_null_ptr(this->singles_rates_ptr);
+}
+
+bool
+BinNormalisationFromECAT7::
+is_in_cache(const Bin& bin) const
+{
+  const ProjDataInfo& proj_data_info = *this->proj_data_info_ptr;
+  return
+    bin.segment_num() >= proj_data_info.get_min_segment_num() &&
+    bin.segment_num() <= proj_data_info.get_max_segment_num() &&
+    bin.axial_pos_num() >= proj_data_info.get_min_axial_pos_num(bin.segment_num()) &&
+    bin.axial_pos_num() <= proj_data_info.get_max_axial_pos_num(bin.segment_num()) &&
+    bin.view_num() >= proj_data_info.get_min_view_num() &&
+    bin.view_num() <= proj_data_info.get_max_view_num() &&
+    bin.tangential_pos_num() >= proj_data_info.get_min_tangential_pos_num() &&
+    bin.tangential_pos_num() <= proj_data_info.get_max_tangential_pos_num();
+}
+
+bool
+BinNormalisationFromECAT7::
+is_in_cache(const RelatedViewgrams<float>& viewgrams) const
+{
+  for (RelatedViewgrams<float>::const_iterator iter = viewgrams.begin(); iter != viewgrams.end(); ++iter)
+    {
+      if (!this->is_in_cache(Bin(iter->get_segment_num(), iter->get_view_num(),
+                                 iter->get_min_axial_pos_num(), iter->get_min_tangential_pos_num())) ||
+          !this->is_in_cache(Bin(iter->get_segment_num(), iter->get_view_num(),
+                                 iter->get_max_axial_pos_num(), iter->get_max_tangential_pos_num())))
+        return false;
+    }
+  return true;
+}
+
+std::string
+BinNormalisationFromECAT7::
+get_cache_filename(const double start_time, const double end_time) const
+{
+  if (!this->factors_depend_on_time_frame())
+    return this->cache_filename_prefix + ".nrmcache";
+  // use a fixed number of digits, such that different time frames give different names
+  return boost::str(boost::format("%1%_%2$.0f_%3$.0f.nrmcache")
+                    % this->cache_filename_prefix % (start_time*1000) % (end_time*1000));
+}
+
+std::string
+BinNormalisationFromECAT7::
+get_cache_description(const double start_time, const double end_time) const
+{
+  std::ostringstream s;
+  s.precision(17);
+  s << this->cache_description;
+  if (this->factors_depend_on_time_frame())
+    s << "time frame: " << start_time << ", " << end_time << '\n';
+  return s.str();
+}
+
+const BinNormalisationFromECAT7::FactorsCache&
+BinNormalisationFromECAT7::
+get_factors_cache(const double start_time, const double end_time,
+                  shared_ptr<FactorsCache>& cache_sptr) const
+{
+  // find the copy of factors_cache_sptr for this thread
+  // (thread numbers are not unique with nested parallelism, so we cannot use it then)
+  shared_ptr<FactorsCache> * thread_cache_sptr_ptr = 0;
+#ifdef STIR_OPENMP
+  const int thread_num = omp_get_thread_num();
+  if (omp_get_active_level() <= 1 &&
+      thread_num < static_cast<int>(this->thread_factors_cache_sptrs.size()))
+    thread_cache_sptr_ptr = &this->thread_factors_cache_sptrs[thread_num];
+#else
+  thread_cache_sptr_ptr = &this->thread_factors_cache_sptrs[0];
+#endif
+  // it is only set when all factors are computed, so we can use it straightaway
+  if (thread_cache_sptr_ptr != 0 &&
+      !is_null_ptr(*thread_cache_sptr_ptr) &&
+      (*thread_cache_sptr_ptr)->is_for_time_frame(start_time, end_time))
+    return **thread_cache_sptr_ptr;
+
+  // The factors are computed inside the critical section. Other threads that need
+  // them wait there, and only get the cache when all factors are present.
+  // (we cannot throw inside a critical section, so errors are reported afterwards)
+  bool error_occurred = false;
+  std::string error_message;
+#ifdef STIR_OPENMP
+#pragma omp critical(BINNORMALISATIONFROMECAT7_CACHE)
+#endif
+  {
+    try
+      {
+        if (is_null_ptr(this->factors_cache_sptr) ||
+            !this->factors_cache_sptr->is_for_time_frame(start_time, end_time))
+          this->factors_cache_sptr = this->create_factors_cache(start_time, end_time);
+        cache_sptr = this->factors_cache_sptr;
+      }
+    catch (std::string& msg)
+      {
+        error_occurred = true;
+        error_message = msg;
+      }
+    catch (std::exception& e)
+      {
+        error_occurred = true;
+        error_message = e.what();
+      }
+  }
+  if (error_occurred)
+    error(boost::format("BinNormalisationFromECAT7: error computing the normalisation factors (%1%)")
+          % error_message);
+
+  if (thread_cache_sptr_ptr != 0)
+    *thread_cache_sptr_ptr = cache_sptr;
+  return *cache_sptr;
+}
+
+shared_ptr<BinNormalisationFromECAT7::FactorsCache>
+BinNormalisationFromECAT7::
+create_factors_cache(const double start_time, const double end_time) const
+{
+  const bool depends_on_time_frame = this->factors_depend_on_time_frame();
+  shared_ptr<FactorsCache> cache_sptr(new FactorsCache(start_time, end_time, depends_on_time_frame));
+
+  if (this->cache_filename_prefix.size() != 0)
+    {
+      const std::string filename = this->get_cache_filename(start_time, end_time);
+      cache_sptr->set_file(filename, this->get_cache_description(start_time, end_time));
+      if (cache_sptr->map_file(this->cache_num_bins) == Succeeded::yes)
+        {
+          info(boost::format("BinNormalisationFromECAT7: using normalisation factors from %1%") % filename);
+          return cache_sptr;
+        }
+    }
+
+  if (depends_on_time_frame)
+    info(boost::format("BinNormalisationFromECAT7: computing normalisation factors for time frame %1% - %2%")
+         % start_time % end_time);
+  else
+    info("BinNormalisationFromECAT7: computing normalisation factors");
+
+  cache_sptr->allocate(this->cache_num_bins);
+  this->compute_factors(*cache_sptr);
+  cache_sptr->write_to_file(this->cache_num_bins);
+  return cache_sptr;
+}
+
+void
+BinNormalisationFromECAT7::
+compute_factors(FactorsCache& cache) const
+{
+  const ProjDataInfo& proj_data_info = *this->proj_data_info_ptr;
+  float * const data_ptr = cache.get_allocated_data_ptr();
+  const int num_sinograms = static_cast<int>(this->cache_sinograms.size());
+  // we cannot throw inside a parallel region, so keep the first error message
+  bool error_occurred = false;
+  std::string error_message;
+#ifdef STIR_OPENMP
+#pragma omp parallel for schedule(dynamic) if(!omp_in_parallel())
+#endif
+  for (int sinogram_index = 0; sinogram_index < num_sinograms; ++sinogram_index)
+    {
+      try
+        {
+          Bin bin(this->cache_sinograms[sinogram_index].first, proj_data_info.get_min_view_num(),
+                  this->cache_sinograms[sinogram_index].second, proj_data_info.get_min_tangential_pos_num());
+          float * current_ptr =
+            data_ptr + detail::cache_index(bin, proj_data_info, this->cache_segment_offsets);
+          for (bin.view_num()=proj_data_info.get_min_view_num();
+               bin.view_num()<=proj_data_info.get_max_view_num();
+               ++bin.view_num())
+            for (bin.tangential_pos_num()=proj_data_info.get_min_tangential_pos_num();
+                 bin.tangential_pos_num()<=proj_data_info.get_max_tangential_pos_num();
+                 ++bin.tangential_pos_num())
+              *current_ptr++ = this->compute_bin_efficiency(bin, cache.get_start_time(), cache.get_end_time());
+        }
+      catch (std::string& msg)
+        {
+#ifdef STIR_OPENMP
+#pragma omp critical(BINNORMALISATIONFROMECAT7_ERROR)
+#endif
+          if (!error_occurred)
+            {
+              error_occurred = true;
+              error_message = msg;
+            }
+        }
+      catch (std::exception& e)
+        {
+#ifdef STIR_OPENMP
+#pragma omp critical(BINNORMALISATIONFROMECAT7_ERROR)
+#endif
+          if (!error_occurred)
+            {
+              error_occurred = true;
+              error_message = e.what();
+            }
+        }
+    }
+  if (error_occurred)
+    error(error_message);
+}
+
+float 
+BinNormalisationFromECAT7::
+get_bin_efficiency(const Bin& bin, const double start_time, const double end_time) const
+{
+  if (!this->_cache_normalisation_factors || !this->is_in_cache(bin))
+    return this->compute_bin_efficiency(bin, start_time, end_time);
+
+  shared_ptr<FactorsCache> cache_sptr;
+  return
+    this->get_factors_cache(start_time, end_time, cache_sptr).get_data_ptr()
+    [detail::cache_index(bin, *this->proj_data_info_ptr, this->cache_segment_offsets)];
+}
+
+void 
+BinNormalisationFromECAT7::
+apply(RelatedViewgrams<float>& viewgrams, const double start_time, const double end_time) const
+{
+  // note: viewgrams with a larger tangential range (e.g. after making the number of 
+  // tangential positions odd) are handled by the base class
+  if (!this->_cache_normalisation_factors || !this->is_in_cache(viewgrams))
+    {
+      BinNormalisation::apply(viewgrams, start_time, end_time);
+      return;
+    }
+
+  shared_ptr<FactorsCache> cache_sptr;
+  const FactorsCache& cache = this->get_factors_cache(start_time, end_time, cache_sptr);
+  for (RelatedViewgrams<float>::iterator iter = viewgrams.begin(); iter != viewgrams.end(); ++iter)
+    {
+      Bin bin(iter->get_segment_num(), iter->get_view_num(), 0, iter->get_min_tangential_pos_num());
+      for (bin.axial_pos_num()= iter->get_min_axial_pos_num(); 
+           bin.axial_pos_num()<=iter->get_max_axial_pos_num(); 
+           ++bin.axial_pos_num())
+        {
+          const float * factors_ptr =
+            cache.get_data_ptr() + detail::cache_index(bin, *this->proj_data_info_ptr, this->cache_segment_offsets);
+          Array<1,float>& row = (*iter)[bin.axial_pos_num()];
+          for (int tangential_pos_num = row.get_min_index(); tangential_pos_num <= row.get_max_index(); ++tangential_pos_num)
+            row[tangential_pos_num] /= std::max(1.E-20F, *factors_ptr++);
+        }
+    }
+}
+
+void 
+BinNormalisationFromECAT7::
+undo(RelatedViewgrams<float>& viewgrams, const double start_time, const double end_time) const
+{
+  // note: viewgrams with a larger tangential range (e.g. after making the number of 
+  // tangential positions odd) are handled by the base class
+  if (!this->_cache_normalisation_factors || !this->is_in_cache(viewgrams))
+    {
+      BinNormalisation::undo(viewgrams, start_time, end_time);
+      return;
+    }
+
+  shared_ptr<FactorsCache> cache_sptr;
+  const FactorsCache& cache = this->get_factors_cache(start_time, end_time, cache_sptr);
+  for (RelatedViewgrams<float>::iterator iter = viewgrams.begin(); iter != viewgrams.end(); ++iter)
+    {
+      Bin bin(iter->get_segment_num(), iter->get_view_num(), 0, iter->get_min_tangential_pos_num());
+      for (bin.axial_pos_num()= iter->get_min_axial_pos_num(); 
+           bin.axial_pos_num()<=iter->get_max_axial_pos_num(); 
+           ++bin.axial_pos_num())
+        {
+          const float * factors_ptr =
+            cache.get_data_ptr() + detail::cache_index(bin, *this->proj_data_info_ptr, this->cache_segment_offsets);
+          Array<1,float>& row = (*iter)[bin.axial_pos_num()];
+          for (int tangential_pos_num = row.get_min_index(); tangential_pos_num <= row.get_max_index(); ++tangential_pos_num)
+            row[tangential_pos_num] *= *factors_ptr++;
+        }
+    }
+}
+
 float 
 BinNormalisationFromECAT7::
-get_bin_efficiency(const Bin& bin, const double start_time, const double end_time) const {
+compute_bin_efficiency(const Bin& bin, const double start_time, const double end_time) const {
 
 
   // TODO disable when not HR+ or HR++
@@ -629,7 +1109,6 @@ get_bin_efficiency(const Bin& bin, const double start_time, const double end_tim
   }
   return total_efficiency;
 }
-#endif
 
 
 float 
@@ -39,15 +39,58 @@
 #include "stir/ProjData.h"
 #include "stir/DiscretisedDensity.h"
 #include "stir/Succeeded.h"
+#include "stir/HighResWallClockTimer.h"
 #include "stir/info.h"
 #include "stir/error.h"
 #include <boost/format.hpp>
 #include <iostream>
+#include <vector>
+#include <string>
+#include <exception>
 
 START_NAMESPACE_STIR
 
+namespace {
+  // number of related viewgrams that a thread accumulates before writing them
+  const std::size_t num_related_viewgrams_per_write = 8;
+
+  // writes all viewgrams to proj_data, returns false if any of the writes failed
+  bool
+  set_related_viewgrams(ProjData& proj_data, const std::vector<RelatedViewgrams<float> >& viewgrams_to_write)
+  {
+    bool all_written = true;
+    for (std::vector<RelatedViewgrams<float> >::const_iterator iter = viewgrams_to_write.begin();
+         iter != viewgrams_to_write.end();
+         ++iter)
+      {
+        if (!(proj_data.set_related_viewgrams(*iter) == Succeeded::yes))
+          all_written = false;
+      }
+    return all_written;
+  }
+
+  // writes all viewgrams to proj_data and empties the vector, returns false if any of the writes failed
+  /* With OpenMP, writes are done in a critical section. By writing a batch of viewgrams
+     at once, the number of times that threads have to wait for each other is reduced.
+  */
+  bool
+  write_related_viewgrams(ProjData& proj_data, std::vector<RelatedViewgrams<float> >& viewgrams_to_write)
+  {
+    if (viewgrams_to_write.empty())
+      return true;
+    bool all_written;
+#ifdef STIR_OPENMP
+#pragma omp critical (FORWARDPROJ_SETVIEWGRAMS)
+#endif
+    all_written = set_related_viewgrams(proj_data, viewgrams_to_write);
+    viewgrams_to_write.clear();
+    return all_written;
+  }
+} // end of anonymous namespace
+
 
 ForwardProjectorByBin::ForwardProjectorByBin()
+  : projection_time(0.)
 {
 }
 
@@ -70,28 +113,61 @@ ForwardProjectorByBin::forward_project(ProjData& proj_data,
     detail::find_basic_vs_nums_in_subset(*proj_data.get_proj_data_info_ptr(), *symmetries_sptr,
                                          proj_data.get_min_segment_num(), proj_data.get_max_segment_num(),
                                          0, 1/*subset_num, num_subsets*/);
+  // we cannot throw inside a parallel region, so keep the first error message
+  bool error_occurred = false;
+  std::string error_message;
+#ifdef STIR_OPENMP
+#pragma omp parallel shared(proj_data, image, symmetries_sptr, error_occurred, error_message)
+#endif
+  {
+    // viewgrams that are computed by this thread, but not yet written
+    std::vector<RelatedViewgrams<float> > viewgrams_to_write;
+    viewgrams_to_write.reserve(num_related_viewgrams_per_write);
+    std::string thread_error_message;
 #ifdef STIR_OPENMP
-#pragma omp parallel for  shared(proj_data, image, symmetries_sptr) schedule(runtime)  
+#pragma omp for schedule(runtime)  
 #endif
     // note: older versions of openmp need an int as loop
-  for (int i=0; i<static_cast<int>(vs_nums_to_process.size()); ++i)
-    {
-      const ViewSegmentNumbers vs=vs_nums_to_process[i];
+    for (int i=0; i<static_cast<int>(vs_nums_to_process.size()); ++i)
+      {
+        const ViewSegmentNumbers vs=vs_nums_to_process[i];
 
-      info(boost::format("Processing view %1% of segment %2%") % vs.view_num() % vs.segment_num());
+        info(boost::format("Processing view %1% of segment %2%") % vs.view_num() % vs.segment_num());
       
-      RelatedViewgrams<float> viewgrams = 
-        proj_data.get_empty_related_viewgrams(vs, symmetries_sptr);
-      forward_project(viewgrams, image);	  
+        try
+          {
+            viewgrams_to_write.push_back(proj_data.get_empty_related_viewgrams(vs, symmetries_sptr));
+            forward_project(viewgrams_to_write.back(), image);
+          }
+        catch (std::string& msg)
+          {
+            thread_error_message = msg;
+          }
+        catch (std::exception& e)
+          {
+            thread_error_message = e.what();
+          }
+        if (viewgrams_to_write.size() >= num_related_viewgrams_per_write &&
+            !write_related_viewgrams(proj_data, viewgrams_to_write))
+          thread_error_message = "Error set_related_viewgrams in forward projecting";
+      }
+    // write remaining viewgrams
+    if (!write_related_viewgrams(proj_data, viewgrams_to_write))
+      thread_error_message = "Error set_related_viewgrams in forward projecting";
+    if (!thread_error_message.empty())
+      {
 #ifdef STIR_OPENMP
-#pragma omp critical (FORWARDPROJ_SETVIEWGRAMS)
+#pragma omp critical (FORWARDPROJ_ERROR)
 #endif
-      {
-        if (!(proj_data.set_related_viewgrams(viewgrams) == Succeeded::yes))
-          error("Error set_related_viewgrams in forward projecting");
+        if (!error_occurred)
+          {
+            error_occurred = true;
+            error_message = thread_error_message;
+          }
       }
-    }   
-  
+  }
+  if (error_occurred)
+    error(error_message);
 }
 
 void 
@@ -129,6 +205,8 @@ forward_project(RelatedViewgrams<float>& viewgrams,
     return;
 
   start_timers();
+  HighResWallClockTimer wall_clock_timer;
+  wall_clock_timer.start();
 
   // first check symmetries    
   {
@@ -153,7 +231,20 @@ forward_project(RelatedViewgrams<float>& viewgrams,
 	     max_axial_pos_num,
 	     min_tangential_pos_num,
 	     max_tangential_pos_num);
+  wall_clock_timer.stop();
   stop_timers();
+  const double time = wall_clock_timer.value();
+#ifdef STIR_OPENMP
+#pragma omp atomic
+#endif
+  this->projection_time += time;
+}
+
+double
+ForwardProjectorByBin::
+get_projection_time() const
+{
+  return this->projection_time;
 }
 
 
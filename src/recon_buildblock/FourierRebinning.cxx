@@ -51,6 +51,11 @@
 #include "stir/numerics/fourier.h"
 #include "stir/interpolate.h"
 #include "stir/info.h"
+#include "stir/is_null_ptr.h"
+#include <vector>
+#ifdef STIR_OPENMP
+#include <omp.h>
+#endif
 
 #define POSITIVE_Z_SHIFT -1
 #define NEGATIVE_Z_SHIFT 1
@@ -137,8 +142,10 @@ rebin()
   //CL Initialise the 2D Fourier transform of all rebinned sinograms P(w,k)=0
    const int num_planes = proj_data_sptr->get_proj_data_info_ptr()->get_scanner_ptr()->get_num_rings()*2-1;
 
-  Array<3,std::complex<float> > FT_rebinned_data(IndexRange3D(0, num_planes-1, 0, num_views_pow2-1, 0, num_tang_poss_pow2-1));
-  Array<3,float> Weights_for_FT_rebinned_data(IndexRange3D(0, num_planes-1, 0,num_views_pow2-1, 0,num_tang_poss_pow2-1));
+  //CON only the positive frequencies in k (i.e. 0..num_views_pow2/2) are needed
+  const IndexRange3D FT_rebinned_range(0, num_planes-1, 0, num_views_pow2/2, 0, num_tang_poss_pow2-1);
+  Array<3,std::complex<float> > FT_rebinned_data(FT_rebinned_range);
+  Array<3,float> Weights_for_FT_rebinned_data(FT_rebinned_range);
   //CON some statistics
   PETCount_rebinned num_rebinned(0,0,0);
 
@@ -181,81 +188,92 @@ rebin()
     error("FORE Rebinning :: Setup failed "); 
    };
   
+  //CON When using multiple threads, each thread accumulates in its own FT_rebinned_data and weights,
+  //CON which are added at the end. Thread 0 uses FT_rebinned_data itself.
+#ifdef STIR_OPENMP
+  std::vector< shared_ptr<Array<3,std::complex<float> > > > local_FT_rebinned_data_sptrs(omp_get_max_threads());
+  std::vector< shared_ptr<Array<3,float> > > local_weights_sptrs(omp_get_max_threads());
+#endif
+
   //CON Loop over all positive segments. Negative segments (those with negative (opposite) ring differences
   //CON will be merged with the positive segment 180 degree sinograms to form a 360 degree segment.  
+  //CON Only one pair of segments is in memory at any time. The sinograms of this pair
+  //CON are processed in parallel.
    for (int seg_num=0; seg_num <=max_segment_num_to_process ; seg_num++){
                    
     info(boost::format("FORE Rebinning :: Processing segment No %1% *") % seg_num);
 
-     // TODO at present, the processing is done by segment. However, it's fairly easy to
-     // change this to by sinogram (the rebinning call below will do everything 
-     // as a loop over axial_pos anyway).
-     // This would save some memory overhead, and increase potential for parallelisation later.
-     // (The parallelised version of FORE in PARAPET was organised this way).
-
      //CON get one (positive) segment 
-     SegmentBySinogram<float> segment = proj_data_sptr->get_segment_by_sinogram(seg_num);
+     const SegmentBySinogram<float> segment = proj_data_sptr->get_segment_by_sinogram(seg_num);
+     //CON Get the corresponding (negative) segment with the same absolute but opposite obliqueness   
+     const SegmentBySinogram<float> segment_neg = proj_data_sptr->get_segment_by_sinogram(-seg_num);
 
      //CON Retrieve some segment dependent properties needed for the rebinning kernel
      const ProjDataInfoCylindrical& proj_data_info_cylindrical = dynamic_cast<const ProjDataInfoCylindrical&>(*segment.get_proj_data_info_ptr());
      const float average_ring_difference_in_segment = proj_data_info_cylindrical.get_average_ring_difference(segment.get_segment_num());
-   
-    
-     //CL Form a 360 degree sinogram by merging two 180 degree segments  with opposite ring difference
-     //CL to get a new segment sampled over 2*pi (where 0 < view < pi)
-     //CON See DeFrise paper (exact and approximate rebinning algorithms for 3D PET data), Sec IV,C (p153)
-     //KT TODO this is currently not a good idea, as all ProjDataInfo classes assume that
-     //KT views go from 0 to Pi.
-     //CON Get the corresponding (negative) segment with the same absolute but opposite obliqueness   
-     const SegmentBySinogram<float> segment_neg = proj_data_sptr->get_segment_by_sinogram(-seg_num);
-     //CON Expand the (positive) segment such that the two segments can be merged
-     segment.grow(IndexRange3D(segment.get_min_axial_pos_num(), segment.get_max_axial_pos_num(),
-            0,2*segment.get_num_views()-1, segment.get_min_tangential_pos_num(), segment.get_max_tangential_pos_num()
-            ));
-  
-    
-     //CON merge the two segments to form "360 degrees" sinograms   
-     const int min_tangential_pos_num = std::max(segment_neg.get_min_tangential_pos_num(),
-                                                 -segment.get_max_tangential_pos_num());
-
-
-     const int max_tangential_pos_num = std::min(segment_neg.get_max_tangential_pos_num(),
-                                                -segment.get_min_tangential_pos_num());
-
 
-     for (int ring = segment.get_min_axial_pos_num(); ring <= segment.get_max_axial_pos_num(); ring++)
-       for (int view = segment_neg.get_min_view_num(); view <= segment_neg.get_max_view_num(); view++)
-         for( int tangential_pos_num = min_tangential_pos_num; tangential_pos_num<=max_tangential_pos_num; tangential_pos_num++)   
-         segment[ring][view+segment_neg.get_num_views()][tangential_pos_num] = segment_neg[ring][view][-tangential_pos_num];
-      
-    // CON in debug mode visualize the segment	     
-      if(fore_debug_level>=2)  
-	{
-	  char s[100];
-	  sprintf(s, "(extended) segment by sinogram %d",segment.get_segment_num());
-	  display(segment, segment.find_max(), s);
-	}
-	
-    //CON the sinogramm dimensions need to have a dimension which is a power of 2 (required by the FFT algorithm) 
-    //CON for s (radial coordinate) pad the sinogramm with zeros to form a larger array. 
-    //CON the phi (azimuthal cordinate (view)) coordinate is periodic. The samples need to be interpolated to the
-    //CON to the new matrix size. Do this by linear interpolation.             
-    //CON -> DeFrise p. 153 Sec IV.C
-    do_adjust_nb_views_to_pow2(segment);
+     const int min_axial_pos_num = segment.get_min_axial_pos_num();
+     const int max_axial_pos_num = segment.get_max_axial_pos_num();
+     std::vector<PETCount_rebinned> local_counts(max_axial_pos_num - min_axial_pos_num + 1);
 
-    
-    //CON The sinogramm data is now in the required format and ready for rebinning.       
-    //CON The rebinned data is stored in a 3 dimensional array of complex numbers (FT_rebinned_data).
-    //CON FT_rebinned_data[plane][w(FT of s)][k(FT of phi)] 
-    //CON Weight has the same dimensions. It stores normalisation factors (floats)
-    //CON to take into account the variable number of contributions to each frequency.     
-    do_rebinning(FT_rebinned_data, Weights_for_FT_rebinned_data, num_rebinned, segment,
-                 num_tang_poss_pow2, num_views_pow2, num_planes, average_ring_difference_in_segment,
-                 half_distance_between_rings, sampling_distance_in_s, radial_sampling_freq_w, R_field_of_view_mm,
-	         ratio_ring_spacing_to_ring_radius);
-  
+#ifdef STIR_OPENMP
+#pragma omp parallel shared(local_FT_rebinned_data_sptrs, local_weights_sptrs, local_counts, FT_rebinned_data, Weights_for_FT_rebinned_data)
+#endif
+     {
+       Array<3,std::complex<float> > * FT_rebinned_data_ptr = &FT_rebinned_data;
+       Array<3,float> * weights_ptr = &Weights_for_FT_rebinned_data;
+#ifdef STIR_OPENMP
+       const int thread_num=omp_get_thread_num();
+       if (thread_num!=0)
+         {
+           if (is_null_ptr(local_FT_rebinned_data_sptrs[thread_num]))
+             {
+               local_FT_rebinned_data_sptrs[thread_num].reset(new Array<3,std::complex<float> >(FT_rebinned_range));
+               local_weights_sptrs[thread_num].reset(new Array<3,float>(FT_rebinned_range));
+             }
+           FT_rebinned_data_ptr = local_FT_rebinned_data_sptrs[thread_num].get();
+           weights_ptr = local_weights_sptrs[thread_num].get();
+         }
+#pragma omp for schedule(dynamic)
+#endif
+       for (int axial_pos_num = min_axial_pos_num; axial_pos_num <= max_axial_pos_num; axial_pos_num++)
+         {
+           //CON The rebinned data is stored in a 3 dimensional array of complex numbers (FT_rebinned_data).
+           //CON FT_rebinned_data[plane][k(FT of phi)][w(FT of s)] 
+           //CON Weight has the same dimensions. It stores normalisation factors (floats)
+           //CON to take into account the variable number of contributions to each frequency.     
+           do_rebinning(*FT_rebinned_data_ptr, *weights_ptr, local_counts[axial_pos_num - min_axial_pos_num],
+                        segment, segment_neg, axial_pos_num,
+                        num_tang_poss_pow2, num_views_pow2, average_ring_difference_in_segment,
+                        half_distance_between_rings, sampling_distance_in_s, radial_sampling_freq_w, R_field_of_view_mm,
+                        ratio_ring_spacing_to_ring_radius);
+         }
+     } // end of parallel section
+
+     PETCount_rebinned num_rebinned_in_segment(0,0,0);
+     for (std::vector<PETCount_rebinned>::const_iterator iter = local_counts.begin(); iter != local_counts.end(); ++iter)
+       num_rebinned_in_segment += *iter;
+     num_rebinned += num_rebinned_in_segment;
+
+     if(fore_debug_level > 0){
+       info(boost::format("Total rebinned: %1%\n"
+                          "Total missed: %2%\n"
+                          "Total rebinned SSRB: %3%") 
+            % num_rebinned_in_segment.total % num_rebinned_in_segment.miss % num_rebinned_in_segment.ssrb);
+     }
  }  //CON end loop over segments.
 
+#ifdef STIR_OPENMP
+  //CON "reduce" the data accumulated by the threads
+  for (int i=1; i<static_cast<int>(local_FT_rebinned_data_sptrs.size()); ++i)
+    if (!is_null_ptr(local_FT_rebinned_data_sptrs[i]))
+      {
+        FT_rebinned_data += *local_FT_rebinned_data_sptrs[i];
+        Weights_for_FT_rebinned_data += *local_weights_sptrs[i];
+      }
+  local_FT_rebinned_data_sptrs.clear();
+  local_weights_sptrs.clear();
+#endif
 
   //CON Some statistics 
   std::cout << "\nFORE Rebinning :: Total rebinning count: \n";
@@ -265,7 +283,11 @@ rebin()
   //CL now finally fill in the new sinogram s
   SegmentBySinogram<float> sino2D_rebinned = rebinned_proj_data_sptr->get_empty_segment_by_sinogram(0);
 
-  
+
+  //CON planes are independent, so can be done in parallel
+#ifdef STIR_OPENMP
+#pragma omp parallel for schedule(dynamic) shared(sino2D_rebinned, FT_rebinned_data, Weights_for_FT_rebinned_data)
+#endif
   for (int plane=FT_rebinned_data.get_min_index();plane <= FT_rebinned_data.get_max_index(); plane++){
    
    if(plane%10==0) info(boost::format("FORE Rebinning :: Inv FFT rebinned z-position (slice) = %1%") % plane);
@@ -278,8 +300,6 @@ rebin()
   //CON before the inv. FFT can be applied this is not much overhead and it can be left like it was done when still 
   //CON using the numerical receipies FFT code.       
    Array<2, std::complex<float> > FT_rebinned_sinogram(IndexRange2D(0,num_tang_poss_pow2-1,0,num_views_pow2/2));
-  //CON fourier_for_real_data will resize the array to its appropriate dimensions
-   Array<2,float> rebinned_sinogram(IndexRange2D(0,1,0,1));
  
   //CON Normalise the rebinned sinograms by applying the weight factors
   //CON See DeFrise IV.D p154.   
@@ -293,6 +313,9 @@ rebin()
  }
        
  if(fore_debug_level>=3)  
+#ifdef STIR_OPENMP
+#pragma omp critical(FOREDISPLAY)
+#endif
     {
       char s[100];
       Array<2,float> real(FT_rebinned_sinogram.get_index_range());
@@ -309,7 +332,7 @@ rebin()
     }
   
   //CON inverse FFT the rebinned sinograms  
-    rebinned_sinogram = inverse_fourier_for_real_data(FT_rebinned_sinogram); 
+    const Array<2,float> rebinned_sinogram = inverse_fourier_for_real_data_corrupting_input(FT_rebinned_sinogram); 
 
    //CL Keep only one half of data [o.._PI]
     for (int i=0;i<(int)(num_views_pow2/2);i++) 
@@ -348,55 +371,76 @@ void
 FourierRebinning::
 do_rebinning(Array<3,std::complex<float> > &FT_rebinned_data, Array<3,float> &Weights_for_FT_rebinned_data,
              PETCount_rebinned &count_rebinned, 
-             const SegmentBySinogram<float> &segment, const int num_tang_poss_pow2,
-             const int num_views_pow2, const int num_planes, const float average_ring_difference_in_segment,
+             const SegmentBySinogram<float> &segment, const SegmentBySinogram<float> &segment_neg,
+             const int axial_pos_num,
+             const int num_tang_poss_pow2, const int num_views_pow2, const float average_ring_difference_in_segment,
              const float half_distance_between_rings, const float sampling_distance_in_s, 
              const float radial_sampling_freq_w, const float R_field_of_view_mm,
              const float ratio_ring_spacing_to_ring_radius)
- 
- 
  {
-   const int local_rebinned = count_rebinned.total;
-   const int local_miss= count_rebinned.miss;
-   const int local_ssrb= count_rebinned.ssrb;
-
-//CON Loop over all slices, FFT the sinograms and call the actual rebinning kernel.
-   for (int axial_pos_num = segment.get_min_axial_pos_num(); axial_pos_num <= segment.get_max_axial_pos_num() ;axial_pos_num++)   
+   if(axial_pos_num%10 == 0)  info(boost::format("FORE Rebinning z (slice) = %1%") % axial_pos_num);   
+
+   //CL Form a 360 degree sinogram by merging two 180 degree sinograms with opposite ring difference
+   //CL to get a new sinogram sampled over 2*pi (where 0 < view < pi)
+   //CON See DeFrise paper (exact and approximate rebinning algorithms for 3D PET data), Sec IV,C (p153)
+   //KT TODO this is currently not a good idea, as all ProjDataInfo classes assume that
+   //KT views go from 0 to Pi.
+   //CON merged_sinogram[view][tangential_pos_num]
+   const int num_views = segment.get_num_views();
+   Array<2,float> merged_sinogram(IndexRange2D(0, 2*num_views-1,
+                                               segment.get_min_tangential_pos_num(), segment.get_max_tangential_pos_num()));
+   for (int view = segment.get_min_view_num(); view <= segment.get_max_view_num(); view++)
+     merged_sinogram[view - segment.get_min_view_num()] = segment[axial_pos_num][view];
+
+   const int min_tangential_pos_num = std::max(segment_neg.get_min_tangential_pos_num(),
+                                               -segment.get_max_tangential_pos_num());
+   const int max_tangential_pos_num = std::min(segment_neg.get_max_tangential_pos_num(),
+                                               -segment.get_min_tangential_pos_num());
+   for (int view = segment_neg.get_min_view_num(); view <= segment_neg.get_max_view_num(); view++)
+     for( int tangential_pos_num = min_tangential_pos_num; tangential_pos_num<=max_tangential_pos_num; tangential_pos_num++)   
+       merged_sinogram[view - segment_neg.get_min_view_num() + num_views][tangential_pos_num] =
+         segment_neg[axial_pos_num][view][-tangential_pos_num];
+
+   // CON in debug mode visualize the merged sinogram
+   if(fore_debug_level>=2 && axial_pos_num == segment.get_min_axial_pos_num())
+#ifdef STIR_OPENMP
+#pragma omp critical(FOREDISPLAY)
+#endif
      {
-
-      if(axial_pos_num%10 == 0)  info(boost::format("FORE Rebinning z (slice) = %1%") % axial_pos_num);   
-      Array<2,float> current_sinogram(IndexRange2D(0,num_tang_poss_pow2-1,0,num_views_pow2-1));
+       char s[100];
+       sprintf(s, "(extended) sinogram for segment %d",segment.get_segment_num());
+       display(merged_sinogram, s, merged_sinogram.find_max());
+     }
+
+   //CON the sinogramm dimensions need to have a dimension which is a power of 2 (required by the FFT algorithm) 
+   //CON for s (radial coordinate) pad the sinogramm with zeros to form a larger array. 
+   //CON the phi (azimuthal cordinate (view)) coordinate is periodic. The samples need to be interpolated to the
+   //CON to the new matrix size. Do this by linear interpolation.             
+   //CON -> DeFrise p. 153 Sec IV.C
+   do_adjust_nb_views_to_pow2(merged_sinogram, num_views_pow2);
+
+   Array<2,float> current_sinogram(IndexRange2D(0,num_tang_poss_pow2-1,0,num_views_pow2-1));
   
   //CL Calculate the 2D FFT of P(w,k) of the merged segment
-  //CON copy the sinogram data of slice axial_pos_num from the segment array to slicedata
+  //CON copy the sinogram data from merged_sinogram to current_sinogram
   //CON the sinogram is flipped. This will taken account for in the rebinning, where the assignment of the FFT
   //CON coefficients are assigned opposite.
-     for (int j = 0; j < segment.get_num_tangential_poss(); j++) 
-      for (int i = 0; i < num_views_pow2; i++) 
-        current_sinogram[j][i] = segment[axial_pos_num][i][j + segment.get_min_tangential_pos_num()];
+   for (int j = 0; j < segment.get_num_tangential_poss(); j++) 
+     for (int i = 0; i < num_views_pow2; i++) 
+       current_sinogram[j][i] = merged_sinogram[i][j + segment.get_min_tangential_pos_num()];
        
   //CON FFT slicedata
    const Array<2,std::complex<float> > FT_current_sinogram = fourier_for_real_data(current_sinogram);
 
   //CON determine the axial position of the middle of the LOR in mm relative to Bin(segment=0,view=0,axial_pos=0,tang_pos=0)  
-    const ProjDataInfo& proj_data_info = *segment.get_proj_data_info_ptr();
-    const float z_in_mm = proj_data_info.get_m(Bin(segment.get_segment_num(),0,axial_pos_num,0)) - proj_data_info.get_m(Bin(0,0,0,0));
+   const ProjDataInfo& proj_data_info = *segment.get_proj_data_info_ptr();
+   const float z_in_mm = proj_data_info.get_m(Bin(segment.get_segment_num(),0,axial_pos_num,0)) - proj_data_info.get_m(Bin(0,0,0,0));
 
   //CON Call the rebinning kernel.                                                             
-    rebinning(FT_rebinned_data,Weights_for_FT_rebinned_data,count_rebinned,FT_current_sinogram,
-              z_in_mm, average_ring_difference_in_segment, num_views_pow2,
-              num_tang_poss_pow2,half_distance_between_rings,sampling_distance_in_s,radial_sampling_freq_w,
-              R_field_of_view_mm,ratio_ring_spacing_to_ring_radius);
-
- }//CL End of loop of axial_pos_num
-     
-    if(fore_debug_level > 0){
-      info(boost::format("Total rebinned: %1%\n"
-                         "Total missed: %2%\n"
-                         "Total rebinned SSRB: %3%") 
-           % (count_rebinned.total - local_rebinned) % (count_rebinned.miss - local_miss) % (count_rebinned.ssrb - local_ssrb) );
-   }
-
+   rebinning(FT_rebinned_data,Weights_for_FT_rebinned_data,count_rebinned,FT_current_sinogram,
+             z_in_mm, average_ring_difference_in_segment, num_views_pow2,
+             num_tang_poss_pow2,half_distance_between_rings,sampling_distance_in_s,radial_sampling_freq_w,
+             R_field_of_view_mm,ratio_ring_spacing_to_ring_radius);
 }
 
 
@@ -598,35 +642,22 @@ do_display_count(PETCount_rebinned &count)
 
 void 
 FourierRebinning::
-do_adjust_nb_views_to_pow2(SegmentBySinogram<float> &segment) 
+do_adjust_nb_views_to_pow2(Array<2,float> &sinogram, const int num_views_pow2) 
 {
 // Adjustment of the number of views to a power of two
 //CON Use the STIR overlap_interpolate method and remove the simlar private implementation (adjust_pow2) here.      
-  const int num_views_pow2 = stir::round(pow(2.,((int)ceil(log ((float)segment.get_num_views())/log(2.)))));
   const float offset_for_overlap_interpolate = 0.F;
+  const int num_views = sinogram.get_length();
       
-    if (num_views_pow2 == segment.get_num_views()) 
-        return; 
-
-    //CON Create the projection data info ptr for the resized segment
-    shared_ptr<ProjDataInfo> out_proj_data_info_sptr(segment.get_proj_data_info_ptr()->clone());
-    out_proj_data_info_sptr->set_num_views(num_views_pow2);
-    //CON the re-dimensioned segment      
-    SegmentBySinogram<float> out_segment = 
-      out_proj_data_info_sptr->get_empty_segment_by_sinogram(segment.get_segment_num());
-
-    for (int axial_pos_num = segment.get_min_axial_pos_num(); axial_pos_num <= segment.get_max_axial_pos_num();
-             axial_pos_num++) 
-    {
-        const Sinogram<float> sino2D = segment.get_sinogram(axial_pos_num);
-        Sinogram<float> out_sino2D = out_segment.get_sinogram(axial_pos_num);
-      
-        float extension_factor = static_cast<float>(out_sino2D.get_num_views())/ static_cast<float>(sino2D.get_num_views());
-	overlap_interpolate(out_sino2D, sino2D,extension_factor,offset_for_overlap_interpolate,true);
-   
-      out_segment.set_sinogram(out_sino2D);
-    }
-    segment = out_segment;
+  if (num_views_pow2 == num_views) 
+    return; 
+
+  //CON the re-dimensioned sinogram
+  Array<2,float> out_sinogram(IndexRange2D(0, num_views_pow2-1,
+                                           sinogram[0].get_min_index(), sinogram[0].get_max_index()));
+  const float extension_factor = static_cast<float>(num_views_pow2)/ static_cast<float>(num_views);
+  overlap_interpolate(out_sinogram, sinogram, extension_factor, offset_for_overlap_interpolate, true);
+  sinogram = out_sinogram;
 }
 
 Succeeded FourierRebinning::
@@ -32,6 +32,7 @@
 #include "stir/Succeeded.h"
 #include "stir/modelling/ParametricDiscretisedDensity.h"
 #include "stir/modelling/KineticParameters.h"
+#include <sstream>
 
 using std::string;
 
@@ -146,7 +147,7 @@ compute_sub_gradient(TargetT& gradient,
    if (!this->prior_is_zero())
      {
        shared_ptr<TargetT>  prior_gradient_sptr(gradient.get_empty_copy());
-       this->prior_sptr->compute_gradient(*prior_gradient_sptr, current_estimate);
+       this->compute_prior_gradient(*prior_gradient_sptr, current_estimate);
 
        // (*prior_gradient_sptr)/= num_subsets;
        // gradient -= *prior_gradient_sptr;
@@ -348,6 +349,34 @@ get_objective_function_values_report(const TargetT& current_estimate)
   return s.str();
 }
 
+template <typename TargetT>
+void
+GeneralisedObjectiveFunction<TargetT>::
+compute_prior_gradient(TargetT& prior_gradient, const TargetT& current_estimate)
+{
+  this->prior_gradient_timer.start();
+  this->prior_sptr->compute_gradient(prior_gradient, current_estimate);
+  this->prior_gradient_timer.stop();
+}
+
+template <typename TargetT>
+void
+GeneralisedObjectiveFunction<TargetT>::
+reset_timing_report()
+{
+  this->prior_gradient_timer.reset();
+}
+
+template <typename TargetT>
+std::string
+GeneralisedObjectiveFunction<TargetT>::
+get_timing_report()
+{
+  std::ostringstream s;
+  s << "\"prior_gradient_time\": " << this->prior_gradient_timer.value();
+  return s.str();
+}
+
 template<typename TargetT>
 bool
 GeneralisedObjectiveFunction<TargetT>::
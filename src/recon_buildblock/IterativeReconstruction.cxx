@@ -34,6 +34,7 @@
 // for time(), used as seed for random stuff
 #include <ctime>
 #include <iostream>
+#include <fstream>
 #include <sstream>
 
 #include "stir/recon_buildblock/IterativeReconstruction.h"
@@ -47,6 +48,8 @@
 #include "stir/modelling/KineticParameters.h"
 
 #include "stir/TextWriter.h"
+#include "stir/CPUTimer.h"
+#include "stir/HighResWallClockTimer.h"
 
 #ifndef STIR_NO_NAMESPACES
 using std::cerr;
@@ -78,6 +81,7 @@ IterativeReconstruction<TargetT>::set_defaults()
 //MJ 02/08/99 added subset randomization
   this->randomise_subset_order = false;
   this->report_objective_function_values_interval = 0;
+  this->timing_report_filename = "";
 
 }
 
@@ -98,6 +102,7 @@ IterativeReconstruction<TargetT>::initialise_keymap()
   this->parser.add_parsing_key("inter-iteration filter type", &inter_iteration_filter_ptr);
   this->parser.add_key("report objective function values interval",
 		       &this->report_objective_function_values_interval);
+  this->parser.add_key("timing report filename", &this->timing_report_filename);
 }
 
 template <typename TargetT>
@@ -425,8 +430,34 @@ reconstruct(shared_ptr<TargetT > const& target_data_sptr)
 
   for(subiteration_num=start_subiteration_num;subiteration_num<=num_subiterations && this->terminate_iterations==false; subiteration_num++)
   {
+    if (this->timing_report_filename.empty())
+      {
+        this->update_estimate(*target_data_sptr);
+        this->end_of_iteration_processing(*target_data_sptr);
+        continue;
+      }
+
+    this->objective_function_sptr->reset_timing_report();
+    HighResWallClockTimer update_timer;
+    CPUTimer update_CPU_timer;
+    update_timer.start(); update_CPU_timer.start();
     this->update_estimate(*target_data_sptr);
+    update_timer.stop(); update_CPU_timer.stop();
+
+    HighResWallClockTimer end_of_iteration_timer;
+    end_of_iteration_timer.start();
     this->end_of_iteration_processing(*target_data_sptr);
+    end_of_iteration_timer.stop();
+
+    std::ofstream report(this->timing_report_filename.c_str(), std::ios::app);
+    report << "{\"subiteration\": " << this->subiteration_num
+           << ", \"update_estimate_time\": " << update_timer.value()
+           << ", \"update_estimate_CPU_time\": " << update_CPU_timer.value()
+           << ", \"end_of_iteration_processing_time\": " << end_of_iteration_timer.value()
+           << ", " << this->objective_function_sptr->get_timing_report()
+           << "}" << endl;
+    if (!report)
+      warning("Error writing timing report to %s", this->timing_report_filename.c_str());
   }
 
   this->stop_timers();
@@ -485,6 +516,14 @@ set_up(shared_ptr<TargetT > const& target_data_sptr)
   if (this->start_subiteration_num<1)
     { warning("Range error in starting subiteration number"); return Succeeded::no; }
   
+  if (!this->timing_report_filename.empty())
+    {
+      // overwrite any existing file
+      std::ofstream report(this->timing_report_filename.c_str());
+      if (!report)
+        { warning("Cannot open timing report file %s", this->timing_report_filename.c_str()); return Succeeded::no; }
+    }
+
   ////////////////// subset order
 
   // KT 05/07/2000 made randomise_subset_order int
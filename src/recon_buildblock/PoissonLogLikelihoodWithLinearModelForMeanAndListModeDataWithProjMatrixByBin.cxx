@@ -33,16 +33,33 @@
 #include "stir/listmode/CListRecord.h"
 #include "stir/Viewgram.h"
 #include "stir/info.h"
+#include "stir/is_null_ptr.h"
+#include "stir/cache_file.h"
 #include <boost/format.hpp>
+#include <boost/cstdint.hpp>
 
 #ifdef STIR_MPI
 #include "stir/recon_buildblock/distributed_functions.h"
 #endif
 
 
+#ifdef STIR_OPENMP
+#include <omp.h>
+#endif
+
 #include <vector>
+#include <sstream>
+#include <fstream>
+#include <limits>
 START_NAMESPACE_STIR
 
+// anonymous namespace for local variables
+namespace {
+  // first bytes of the list mode cache file
+  const char lm_cache_magic[8] = { 'S','T','I','R','L','M','C','\0' };
+  const boost::uint32_t lm_cache_version = 2;
+}
+
 template<typename TargetT>
 const char * const 
 PoissonLogLikelihoodWithLinearModelForMeanAndListModeDataWithProjMatrixByBin<TargetT>::
@@ -52,6 +69,7 @@ registered_name =
 template <typename TargetT> 
 PoissonLogLikelihoodWithLinearModelForMeanAndListModeDataWithProjMatrixByBin<TargetT>:: 
 PoissonLogLikelihoodWithLinearModelForMeanAndListModeDataWithProjMatrixByBin() 
+  : num_events_processed(0)
 { 
   this->set_defaults(); 
 } 
@@ -66,6 +84,10 @@ set_defaults()
   this->additive_projection_data_filename ="0"; 
   this->max_ring_difference_num_to_process =-1;
   this->PM_sptr.reset(new  ProjMatrixByBinUsingRayTracing()); 
+  this->cache_lm_events = false;
+  this->cache_filename = "";
+  this->record_cache.resize(0);
+  this->cached_frame_num = 0;
 } 
  
 template <typename TargetT> 
@@ -79,6 +101,8 @@ initialise_keymap()
   this->parser.add_key("max ring difference num to process", &this->max_ring_difference_num_to_process);
   this->parser.add_parsing_key("Matrix type", &this->PM_sptr); 
   this->parser.add_key("additive sinogram",&this->additive_projection_data_filename); 
+  this->parser.add_key("cache list mode events", &this->cache_lm_events);
+  this->parser.add_key("list mode cache filename", &this->cache_filename);
  
    
 } 
@@ -114,6 +138,11 @@ set_up_before_sensitivity(shared_ptr <TargetT > const& target_sptr)
  
   // set projector to be used for the calculations    
   this->PM_sptr->set_up(this->proj_data_info_cyl_uncompressed_ptr->create_shared_clone(),target_sptr); 
+  // computes and writes all elements if a persistent cache was requested but not found
+  this->PM_sptr->write_persistent_cache();
+  // the additive term might have changed
+  this->record_cache.resize(0);
+  this->cached_frame_num = 0;
   return Succeeded::yes;
 } 
  
@@ -193,6 +222,79 @@ construct_target_ptr() const
 
 } 
  
+template <typename TargetT> 
+std::string
+PoissonLogLikelihoodWithLinearModelForMeanAndListModeDataWithProjMatrixByBin<TargetT>:: 
+get_cache_description() const
+{
+  std::ostringstream s;
+  s.precision(17);
+  s << "record size: " << sizeof(BinAndCorr) << '\n'
+    << "list mode filename: " << this->list_mode_filename << '\n'
+    << "list mode file: " << get_file_signature(this->list_mode_filename) << '\n'
+    << "additive projection data filename: " << this->additive_projection_data_filename << '\n'
+    << "additive projection data: "
+    << (this->additive_projection_data_filename == "0" ? std::string("none")
+        : get_file_signature(this->additive_projection_data_filename)) << '\n'
+    << "maximum ring difference: " << this->max_ring_difference_num_to_process << '\n'
+    << "time frame: " << this->frame_defs.get_start_time(this->current_frame_num)
+    << ", " << this->frame_defs.get_end_time(this->current_frame_num) << '\n';
+  return s.str();
+}
+
+template <typename TargetT> 
+Succeeded
+PoissonLogLikelihoodWithLinearModelForMeanAndListModeDataWithProjMatrixByBin<TargetT>:: 
+read_cache_from_file()
+{
+  std::ifstream s(this->cache_filename.c_str(), std::ios::in | std::ios::binary);
+  if (!s)
+    return Succeeded::no;
+
+  boost::uint32_t flags;
+  boost::uint64_t data_size;
+  if (read_cache_file_header(s, lm_cache_magic, lm_cache_version, this->get_cache_description(),
+                             flags, data_size) == Succeeded::no ||
+      data_size % sizeof(BinAndCorr) != 0)
+    {
+      warning(boost::format("List mode cache %1% is incomplete, has an incompatible format, "
+                            "or does not correspond to the current data or time frame. Ignoring it.")
+              % this->cache_filename);
+      return Succeeded::no;
+    }
+  const boost::uint64_t num_events = data_size/sizeof(BinAndCorr);
+  this->record_cache.resize(static_cast<std::size_t>(num_events));
+  if (num_events > 0)
+    s.read(reinterpret_cast<char *>(&this->record_cache[0]),
+           static_cast<std::streamsize>(data_size));
+  if (!s)
+    {
+      warning(boost::format("Error reading list mode cache %1%. Ignoring it.") % this->cache_filename);
+      this->record_cache.resize(0);
+      return Succeeded::no;
+    }
+  info(boost::format("Read %1% events from list mode cache %2%") % num_events % this->cache_filename);
+  return Succeeded::yes;
+}
+
+template <typename TargetT> 
+Succeeded
+PoissonLogLikelihoodWithLinearModelForMeanAndListModeDataWithProjMatrixByBin<TargetT>:: 
+write_cache_to_file() const
+{
+  std::ofstream s;
+  const std::string tmp_filename = open_cache_file_for_writing(s, this->cache_filename);
+  if (tmp_filename.empty())
+    return Succeeded::no;
+  const boost::uint64_t data_size = this->record_cache.size()*sizeof(BinAndCorr);
+  write_cache_file_header(s, lm_cache_magic, lm_cache_version, 0, data_size,
+                          this->get_cache_description());
+  if (data_size > 0)
+    s.write(reinterpret_cast<const char *>(&this->record_cache[0]),
+            static_cast<std::streamsize>(data_size));
+  return finish_writing_cache_file(s, tmp_filename, this->cache_filename);
+}
+
 template <typename TargetT> 
 void 
 PoissonLogLikelihoodWithLinearModelForMeanAndListModeDataWithProjMatrixByBin<TargetT>:: 
@@ -200,7 +302,20 @@ compute_sub_gradient_without_penalty_plus_sensitivity(TargetT& gradient,
                                          const TargetT &current_estimate,  
                                          const int subset_num) 
 { 
+  std::vector< shared_ptr<TargetT> > local_gradient_sptrs;
+#ifdef STIR_OPENMP
+  local_gradient_sptrs.resize(omp_get_max_threads());
+#endif
 
+  if (this->cache_lm_events && this->cached_frame_num != this->current_frame_num)
+    {
+      this->record_cache.resize(0);
+      if (!this->cache_filename.empty() && this->read_cache_from_file() == Succeeded::yes)
+        this->cached_frame_num = this->current_frame_num;
+    }
+
+  if (!this->cache_lm_events || this->cached_frame_num != this->current_frame_num)
+  {
   const double start_time = this->frame_defs.get_start_time(this->current_frame_num);
   const double end_time = this->frame_defs.get_end_time(this->current_frame_num);
   //go to the beginning of this frame
@@ -208,50 +323,189 @@ compute_sub_gradient_without_penalty_plus_sensitivity(TargetT& gradient,
   // TODO implement function that will do this for a random time
   this->list_mode_data_sptr->reset();
   double current_time = 0.;
-  ProjMatrixElemsForOneBin proj_matrix_row; 
-  shared_ptr<CListRecord> record_sptr = this->list_mode_data_sptr->get_empty_record_sptr(); 
-  CListRecord& record = *record_sptr; 
-  //  int count_of_events=0;
-  //int in_the_range =0;
-  while (this->list_mode_data_sptr->get_next_record(record) == Succeeded::yes) 
-  { 
-    //count_of_events++;
-    if(record.is_time())
-      {
-        current_time = record.time().get_time_in_secs();
-      }
-    if (current_time >= end_time)
+
+  // records are read from the list mode data in chunks
+  const std::size_t num_records_in_chunk = 1000;
+  std::vector<shared_ptr<CListRecord> > records(num_records_in_chunk);
+  for (std::size_t i=0; i<num_records_in_chunk; ++i)
+    records[i] = this->list_mode_data_sptr->get_empty_record_sptr();
+  std::size_t num_records_read = 0;
+  std::size_t record_num = 0;
+
+  // Events are processed in batches: the list mode data is read (and decoded) 
+  // sequentially, after which the bins in the batch are distributed over the threads.
+  // When filling the cache, all events of the frame are read in a single batch.
+  const std::size_t max_num_events_in_batch =
+    this->cache_lm_events ? std::numeric_limits<std::size_t>::max() : 100000;
+  std::vector<BinAndCorr> batch_events;
+  std::vector<BinAndCorr>& events =
+    this->cache_lm_events ? this->record_cache : batch_events;
+  if (!this->cache_lm_events)
+    events.reserve(max_num_events_in_batch);
+
+  bool more_events = true;
+  while (more_events)
+  {
+    // read next batch of prompts in the current frame
+    this->list_mode_reading_timer.start();
+    events.resize(0);
+    while (events.size() < max_num_events_in_batch)
       {
-        break; // get out of while loop
-      }
-    if (current_time < start_time)
-      continue;
-    if (record.is_event() && record.event().is_prompt()) 
-      { 
-        Bin measured_bin; 
-        record.event().get_bin(measured_bin, *proj_data_info_cyl_uncompressed_ptr); 
-        if (measured_bin.get_bin_value() <= 0)
-          continue;      
-        this->PM_sptr->get_proj_matrix_elems_for_one_bin(proj_matrix_row, measured_bin); 
-        //in_the_range++;
-        Bin fwd_bin; 
-        proj_matrix_row.forward_project(fwd_bin,current_estimate); 
-        // additive sinogram 
-        if (!is_null_ptr(this->additive_proj_data_sptr))
+        if (record_num == num_records_read)
           {
-            float add_value = this->additive_proj_data_sptr->get_bin_value(measured_bin);
-            float value= fwd_bin.get_bin_value()+add_value;         
-            fwd_bin.set_bin_value(value);
+            num_records_read = this->list_mode_data_sptr->get_next_records(records);
+            record_num = 0;
+            if (num_records_read == 0)
+              {
+                more_events = false;
+                break;
+              }
           }
-        float  measured_div_fwd = measured_bin.get_bin_value()/fwd_bin.get_bin_value();
-        measured_bin.set_bin_value(measured_div_fwd);
-        proj_matrix_row.back_project(gradient, measured_bin); 
-         
-      } 
+        const CListRecord& record = *records[record_num++];
+        if(record.is_time())
+          {
+            current_time = record.time().get_time_in_secs();
+          }
+        if (current_time >= end_time)
+          {
+            more_events = false;
+            break;
+          }
+        if (current_time < start_time)
+          continue;
+        if (record.is_event() && record.event().is_prompt()) 
+          { 
+            Bin measured_bin; 
+            record.event().get_bin(measured_bin, *proj_data_info_cyl_uncompressed_ptr); 
+            if (measured_bin.get_bin_value() <= 0)
+              continue;
+            BinAndCorr event;
+            event.segment_num = static_cast<boost::int16_t>(measured_bin.segment_num());
+            event.view_num = static_cast<boost::int16_t>(measured_bin.view_num());
+            event.axial_pos_num = static_cast<boost::int16_t>(measured_bin.axial_pos_num());
+            event.tangential_pos_num = static_cast<boost::int16_t>(measured_bin.tangential_pos_num());
+            event.bin_value = measured_bin.get_bin_value();
+            // additive sinogram 
+            event.additive_value =
+              is_null_ptr(this->additive_proj_data_sptr)
+              ? 0.F
+              : this->additive_proj_data_sptr->get_bin_value(measured_bin);
+            events.push_back(event);
+          }
+      }
+    this->list_mode_reading_timer.stop();
+    if (!this->cache_lm_events)
+      this->process_events(gradient, current_estimate, events, local_gradient_sptrs);
+  }
+
+  if (this->cache_lm_events)
+    {
+      this->cached_frame_num = this->current_frame_num;
+      info(boost::format("Cached %1% events of time frame %2%")
+           % this->record_cache.size() % this->current_frame_num);
+      if (!this->cache_filename.empty())
+        this->write_cache_to_file();
+    }
   }
-  //  cerr << " The number_of_events " << count_of_events << "   ";
-  //cerr << " The number of events proecessed "  << in_the_range << "  ";
-    
+
+  if (this->cache_lm_events)
+    this->process_events(gradient, current_estimate, this->record_cache, local_gradient_sptrs);
+
+#ifdef STIR_OPENMP
+  // "reduce" data constructed by threads
+  for (int i=1; i<static_cast<int>(local_gradient_sptrs.size()); ++i)
+    if(!is_null_ptr(local_gradient_sptrs[i])) // only accumulate if a thread filled something in
+      gradient += *(local_gradient_sptrs[i]);
+#endif
+}
+
+template <typename TargetT> 
+void 
+PoissonLogLikelihoodWithLinearModelForMeanAndListModeDataWithProjMatrixByBin<TargetT>:: 
+process_events(TargetT& gradient, const TargetT& current_estimate,
+               const std::vector<BinAndCorr>& events,
+               std::vector<shared_ptr<TargetT> >& local_gradient_sptrs)
+{
+  this->num_events_processed += events.size();
+  this->event_processing_timer.start();
+
+  // Each thread accumulates in its own image, which are added to gradient at the end.
+  // Thread 0 uses gradient itself, such that a run with 1 thread gives identical
+  // results to the serial code.
+#ifdef STIR_OPENMP
+#pragma omp parallel shared(local_gradient_sptrs, events, gradient, current_estimate)
+#endif
+    {
+      // note: initialise the bin to avoid compiler warnings (it will be overwritten)
+      ProjMatrixElemsForOneBin proj_matrix_row(Bin(0,0,0,0)); 
+      TargetT* gradient_ptr = &gradient;
+#ifdef STIR_OPENMP
+      const int thread_num=omp_get_thread_num();
+      if (thread_num!=0)
+        {
+          if(is_null_ptr(local_gradient_sptrs[thread_num]))
+            local_gradient_sptrs[thread_num].reset(gradient.get_empty_copy());
+          gradient_ptr = local_gradient_sptrs[thread_num].get();
+        }
+#pragma omp for schedule(static)
+#endif
+      // note: older versions of openmp need an int as loop
+      for (int i=0; i<static_cast<int>(events.size()); ++i)
+        {
+          const BinAndCorr& event = events[i];
+          Bin measured_bin(event.segment_num, event.view_num,
+                           event.axial_pos_num, event.tangential_pos_num,
+                           event.bin_value);
+          this->PM_sptr->get_proj_matrix_elems_for_one_bin(proj_matrix_row, measured_bin); 
+          // forward_project() accumulates, so start from 0
+          Bin fwd_bin(measured_bin);
+          fwd_bin.set_bin_value(0.F);
+          proj_matrix_row.forward_project(fwd_bin,current_estimate); 
+          if (!is_null_ptr(this->additive_proj_data_sptr))
+            {
+              float value= fwd_bin.get_bin_value()+event.additive_value;         
+              fwd_bin.set_bin_value(value);
+            }
+          float  measured_div_fwd = measured_bin.get_bin_value()/fwd_bin.get_bin_value();
+          measured_bin.set_bin_value(measured_div_fwd);
+          proj_matrix_row.back_project(*gradient_ptr, measured_bin); 
+        }
+    } // end of parallel section
+
+  this->event_processing_timer.stop();
+}
+
+template <typename TargetT> 
+void 
+PoissonLogLikelihoodWithLinearModelForMeanAndListModeDataWithProjMatrixByBin<TargetT>:: 
+reset_timing_report()
+{
+  base_type::reset_timing_report();
+  this->num_events_processed = 0;
+  this->list_mode_reading_timer.reset();
+  this->event_processing_timer.reset();
+  if (!is_null_ptr(this->PM_sptr))
+    this->PM_sptr->reset_cache_statistics();
+}
+
+template <typename TargetT> 
+std::string
+PoissonLogLikelihoodWithLinearModelForMeanAndListModeDataWithProjMatrixByBin<TargetT>:: 
+get_timing_report()
+{
+  std::ostringstream s;
+  const double total_time =
+    this->list_mode_reading_timer.value() + this->event_processing_timer.value();
+  s << base_type::get_timing_report()
+    << ", \"list_mode_reading_time\": " << this->list_mode_reading_timer.value()
+    << ", \"event_processing_time\": " << this->event_processing_timer.value()
+    << ", \"num_events\": " << this->num_events_processed
+    << ", \"events_per_second\": " << (total_time > 0 ? this->num_events_processed/total_time : 0.);
+  if (!is_null_ptr(this->PM_sptr))
+    s << ", \"proj_matrix_cache_hits\": " << this->PM_sptr->get_num_cache_hits()
+      << ", \"proj_matrix_cache_misses\": " << this->PM_sptr->get_num_cache_misses()
+      << ", \"proj_matrix_cache_evictions\": " << this->PM_sptr->get_num_cache_evictions();
+  return s.str();
 }
 
 #  ifdef _MSC_VER
@@ -54,6 +54,9 @@
 #include "stir/recon_buildblock/ProjMatrixByBinUsingRayTracing.h"
 #endif
 #include "stir/recon_buildblock/ProjectorByBinPairUsingSeparateProjectors.h"
+#include "stir/recon_buildblock/ProjectorByBinPairUsingProjMatrixByBin.h"
+#include "stir/recon_buildblock/BackProjectorByBinUsingProjMatrixByBin.h"
+#include "stir/recon_buildblock/ProjMatrixByBin.h"
 
 
 #include "stir/Viewgram.h"
@@ -295,6 +298,8 @@ post_processing()
 template <typename TargetT>
 PoissonLogLikelihoodWithLinearModelForMeanAndProjData<TargetT>::
 PoissonLogLikelihoodWithLinearModelForMeanAndProjData()
+  : forward_projection_time_at_reset(0.),
+    back_projection_time_at_reset(0.)
 {
   this->set_defaults();
 }
@@ -640,7 +645,8 @@ compute_sub_gradient_without_penalty_plus_sensitivity(TargetT& gradient,
                                  this->zero_seg0_end_planes!=0, 
                                  NULL, 
                                  this->additive_proj_data_sptr 
-                                 , caching_info_ptr
+                                 , caching_info_ptr,
+                                 &this->distributable_timings
                                  );
   
 
@@ -668,13 +674,73 @@ actual_compute_objective_function_without_penalty(const TargetT& current_estimat
                                          this->normalisation_sptr, 
                                          this->get_time_frame_definitions().get_start_time(this->get_time_frame_num()),
                                          this->get_time_frame_definitions().get_end_time(this->get_time_frame_num()),
-                                         this->caching_info_ptr
+                                         this->caching_info_ptr,
+                                         &this->distributable_timings
                                          );
                 
     
   return accum;
 }
 
+template<typename TargetT>
+shared_ptr<ProjMatrixByBin>
+PoissonLogLikelihoodWithLinearModelForMeanAndProjData<TargetT>::
+get_proj_matrix_sptr() const
+{
+  const ProjectorByBinPairUsingProjMatrixByBin * proj_matrix_pair_ptr =
+    dynamic_cast<const ProjectorByBinPairUsingProjMatrixByBin *>(this->projector_pair_ptr.get());
+  if (!is_null_ptr(proj_matrix_pair_ptr))
+    return proj_matrix_pair_ptr->get_proj_matrix_sptr();
+  BackProjectorByBinUsingProjMatrixByBin * back_projector_ptr =
+    dynamic_cast<BackProjectorByBinUsingProjMatrixByBin *>(this->projector_pair_ptr->get_back_projector_sptr().get());
+  if (!is_null_ptr(back_projector_ptr))
+    return back_projector_ptr->get_proj_matrix_sptr();
+  return shared_ptr<ProjMatrixByBin>();
+}
+
+template<typename TargetT>
+void
+PoissonLogLikelihoodWithLinearModelForMeanAndProjData<TargetT>::
+reset_timing_report()
+{
+  base_type::reset_timing_report();
+  this->distributable_timings.reset();
+  this->forward_projection_time_at_reset =
+    this->projector_pair_ptr->get_forward_projector_sptr()->get_projection_time();
+  this->back_projection_time_at_reset =
+    this->projector_pair_ptr->get_back_projector_sptr()->get_projection_time();
+  const shared_ptr<ProjMatrixByBin> proj_matrix_sptr = this->get_proj_matrix_sptr();
+  if (!is_null_ptr(proj_matrix_sptr))
+    proj_matrix_sptr->reset_cache_statistics();
+}
+
+template<typename TargetT>
+std::string
+PoissonLogLikelihoodWithLinearModelForMeanAndProjData<TargetT>::
+get_timing_report()
+{
+  std::ostringstream s;
+  s << base_type::get_timing_report()
+    << ", \"projdata_reading_time\": " << this->distributable_timings.reading_time
+    << ", \"normalisation_time\": " << this->distributable_timings.normalisation_time
+    << ", \"projection_processing_time\": " << this->distributable_timings.processing_time
+    << ", \"distributable_computation_time\": " << this->distributable_timings.total_time
+    << ", \"num_bins\": " << this->distributable_timings.num_bins
+    << ", \"bins_per_second\": "
+    << (this->distributable_timings.total_time > 0 ?
+        this->distributable_timings.num_bins/this->distributable_timings.total_time : 0.)
+    << ", \"forward_projection_time\": "
+    << this->projector_pair_ptr->get_forward_projector_sptr()->get_projection_time() - this->forward_projection_time_at_reset
+    << ", \"back_projection_time\": "
+    << this->projector_pair_ptr->get_back_projector_sptr()->get_projection_time() - this->back_projection_time_at_reset;
+  const shared_ptr<ProjMatrixByBin> proj_matrix_sptr = this->get_proj_matrix_sptr();
+  if (!is_null_ptr(proj_matrix_sptr))
+    s << ", \"proj_matrix_cache_hits\": " << proj_matrix_sptr->get_num_cache_hits()
+      << ", \"proj_matrix_cache_misses\": " << proj_matrix_sptr->get_num_cache_misses()
+      << ", \"proj_matrix_cache_evictions\": " << proj_matrix_sptr->get_num_cache_evictions();
+  return s.str();
+}
+
 #if 0
 template<typename TargetT>
 float 
@@ -883,7 +949,8 @@ void distributable_compute_gradient(const shared_ptr<ForwardProjectorByBin>& for
                                     bool zero_seg0_end_planes,
                                     double* log_likelihood_ptr,
                                     shared_ptr<ProjData> const& additive_binwise_correction,
-                                    DistributedCachingInformation* caching_info_ptr
+                                    DistributedCachingInformation* caching_info_ptr,
+                                    DistributableComputationTimings* timings_ptr
                                     )
 {
         
@@ -899,7 +966,8 @@ void distributable_compute_gradient(const shared_ptr<ForwardProjectorByBin>& for
                               additive_binwise_correction,
                               /* normalisation info to be ignored */ shared_ptr<BinNormalisation>(), 0., 0.,
                               &RPC_process_related_viewgrams_gradient,
-                              caching_info_ptr
+                              caching_info_ptr,
+                              timings_ptr
                               );
 }
 
@@ -918,7 +986,8 @@ void distributable_accumulate_loglikelihood(
                                             shared_ptr<BinNormalisation> const& normalisation_sptr,
                                             const double start_time_of_frame,
                                             const double end_time_of_frame,
-                                            DistributedCachingInformation* caching_info_ptr
+                                            DistributedCachingInformation* caching_info_ptr,
+                                            DistributableComputationTimings* timings_ptr
                                             )
                                             
 {
@@ -936,7 +1005,8 @@ void distributable_accumulate_loglikelihood(
                                     start_time_of_frame,
                                     end_time_of_frame,
                                     &RPC_process_related_viewgrams_accumulate_loglikelihood,
-                                    caching_info_ptr
+                                    caching_info_ptr,
+                                    timings_ptr
                                     );
 }
 
@@ -32,6 +32,26 @@
 
 #include "stir/recon_buildblock/ProjMatrixByBin.h"
 #include "stir/recon_buildblock/ProjMatrixElemsForOneBin.h"
+#include "stir/DiscretisedDensityOnCartesianGrid.h"
+#include "stir/ProjDataInfo.h"
+#include "stir/Coordinate3D.h"
+#include "stir/Succeeded.h"
+#include "stir/is_null_ptr.h"
+#include "stir/stream.h"
+#include "stir/cache_file.h"
+#include "stir/info.h"
+#include "stir/warning.h"
+#include "stir/error.h"
+#include <boost/format.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <cstring>
+#include <exception>
 
 // define a local preprocessor symbol to keep code relatively clean
 #ifdef STIR_NO_MUTABLE
@@ -46,6 +66,8 @@ void ProjMatrixByBin::set_defaults()
 {
   cache_disabled=false;
   cache_stores_only_basic_bins=true;
+  max_cache_size_in_MB=0;
+  persistent_cache_filename="";
 }
 
 void 
@@ -53,18 +75,36 @@ ProjMatrixByBin::initialise_keymap()
 {
   parser.add_key("disable caching", &cache_disabled);
   parser.add_key("store_only_basic_bins_in_cache", &cache_stores_only_basic_bins);
+  parser.add_key("maximum cache size in MB", &max_cache_size_in_MB);
+  parser.add_key("persistent cache filename", &persistent_cache_filename);
 }
 
 bool
 ProjMatrixByBin::post_processing()
 {
+  if (max_cache_size_in_MB < 0)
+    {
+      warning("ProjMatrixByBin: maximum cache size in MB has to be non-negative");
+      return true;
+    }
   return false;
 }
 
 ProjMatrixByBin::ProjMatrixByBin()
+  : total_cache_num_bytes(0),
+    num_cache_hits(0), num_cache_misses(0), num_cache_evictions(0),
+    num_cache_removals_since_set_up(0), cache_was_filled(false),
+    cache_access_counter(0)
 { 
   set_defaults();
 }
+
+ProjMatrixByBin::~ProjMatrixByBin()
+{
+#ifdef STIR_OPENMP
+  destroy_cache_locks();
+#endif
+}
  
 void 
 ProjMatrixByBin::
@@ -86,6 +126,45 @@ ProjMatrixByBin::
 does_cache_store_only_basic_bins() const
 { return cache_stores_only_basic_bins; }
 
+void
+ProjMatrixByBin::
+set_maximum_cache_size(const std::size_t num_bytes)
+{ max_cache_size_in_MB = static_cast<double>(num_bytes)/(1024.*1024.); }
+
+std::size_t
+ProjMatrixByBin::
+get_maximum_cache_size() const
+{ return static_cast<std::size_t>(max_cache_size_in_MB*1024*1024); }
+
+boost::uint64_t
+ProjMatrixByBin::
+get_num_cache_hits() const
+{ return num_cache_hits; }
+
+boost::uint64_t
+ProjMatrixByBin::
+get_num_cache_misses() const
+{ return num_cache_misses; }
+
+boost::uint64_t
+ProjMatrixByBin::
+get_num_cache_evictions() const
+{ return num_cache_evictions; }
+
+std::size_t
+ProjMatrixByBin::
+get_cache_size_in_bytes() const
+{ return total_cache_num_bytes; }
+
+void
+ProjMatrixByBin::
+reset_cache_statistics() STIR_MUTABLE_CONST
+{
+  num_cache_hits = 0;
+  num_cache_misses = 0;
+  num_cache_evictions = 0;
+}
+
 void 
 ProjMatrixByBin::
 clear_cache() STIR_MUTABLE_CONST
@@ -101,11 +180,49 @@ clear_cache() STIR_MUTABLE_CONST
            j<=this->cache_collection[i].get_max_index();
            ++j)
         {
+          std::size_t num_bytes;
+#ifdef STIR_OPENMP
+          omp_set_lock(&this->cache_locks[i][j]);
+#endif
           this->cache_collection[i][j].clear();
+          num_bytes = this->cache_num_bytes[i][j];
+          this->cache_num_bytes[i][j] = 0;
+#ifdef STIR_OPENMP
+          omp_unset_lock(&this->cache_locks[i][j]);
+#endif
+          // other threads might be inserting elements, so subtract what we removed
+          // (atomic read/capture need OpenMP 3.1. Otherwise, all accesses to
+          // total_cache_num_bytes use the same critical section)
+#if defined(STIR_OPENMP)
+# if _OPENMP >=201012
+#  pragma omp atomic
+# else
+#  pragma omp critical(PROJMATRIXBYBINTOTALCACHESIZE)
+# endif
+#endif
+          this->total_cache_num_bytes -= num_bytes;
+          if (num_bytes != 0)
+            {
+#ifdef STIR_OPENMP
+#pragma omp atomic
+#endif
+              ++this->num_cache_removals_since_set_up;
+            }
         }
     }
 }
 
+#ifdef STIR_OPENMP
+void
+ProjMatrixByBin::
+destroy_cache_locks()
+{
+  for (int i=this->cache_locks.get_min_index(); i<=this->cache_locks.get_max_index(); ++i)
+    for (int j=this->cache_locks[i].get_min_index(); j<=this->cache_locks[i].get_max_index(); ++j)
+      omp_destroy_lock(&this->cache_locks[i][j]);
+}
+#endif
+
 /*
 void  
 ProjMatrixByBin::
@@ -121,7 +238,7 @@ void
 ProjMatrixByBin::
 set_up(		 
     const shared_ptr<ProjDataInfo>& proj_data_info_sptr,
-    const shared_ptr<DiscretisedDensity<3,float> >& /*density_info_ptr*/ // TODO should be Info only
+    const shared_ptr<DiscretisedDensity<3,float> >& density_info_ptr // TODO should be Info only
     )
 {
   const int min_view_num = proj_data_info_sptr->get_min_view_num();
@@ -131,7 +248,17 @@ set_up(
 
   this->cache_collection.recycle();
   this->cache_collection.resize(min_view_num, max_view_num);
+  this->cache_num_bytes.recycle();
+  this->cache_num_bytes.resize(min_view_num, max_view_num);
+  this->cache_last_access.recycle();
+  this->cache_last_access.resize(min_view_num, max_view_num);
+  this->total_cache_num_bytes = 0;
+  this->cache_access_counter = 0;
+  this->num_cache_removals_since_set_up = 0;
+  this->cache_was_filled = false;
+  this->proj_data_info_for_cache_sptr = proj_data_info_sptr;
 #ifdef STIR_OPENMP
+  destroy_cache_locks();
   this->cache_locks.recycle();
   this->cache_locks.resize(min_view_num, max_view_num);
 #endif
@@ -139,12 +266,400 @@ set_up(
   for (int view_num=min_view_num; view_num<=max_view_num; ++view_num)
     {
       this->cache_collection[view_num].resize(min_segment_num, max_segment_num);
+      this->cache_num_bytes[view_num].resize(min_segment_num, max_segment_num);
+      this->cache_num_bytes[view_num].fill(0);
+      this->cache_last_access[view_num].resize(min_segment_num, max_segment_num);
+      this->cache_last_access[view_num].fill(0);
 #ifdef STIR_OPENMP
       this->cache_locks[view_num].resize(min_segment_num, max_segment_num);
       for (int seg_num = min_segment_num; seg_num <=max_segment_num; ++seg_num)
         omp_init_lock(&this->cache_locks[view_num][seg_num]);
 #endif
     }
+
+  // construct description of the matrix to check if the persistent cache can be used
+  {
+    std::ostringstream s;
+    s << this->ParsingObject::parameter_info() << '\n'
+      << proj_data_info_sptr->parameter_info() << '\n';
+    if (!is_null_ptr(density_info_ptr))
+      {
+        s << "density origin: " << density_info_ptr->get_origin() << '\n';
+        const DiscretisedDensityOnCartesianGrid<3,float> * cartesian_density_ptr =
+          dynamic_cast<const DiscretisedDensityOnCartesianGrid<3,float> *>(density_info_ptr.get());
+        if (!is_null_ptr(cartesian_density_ptr))
+          s << "grid spacing: " << cartesian_density_ptr->get_grid_spacing() << '\n';
+        BasicCoordinate<3,int> min_indices, max_indices;
+        if (density_info_ptr->get_regular_range(min_indices, max_indices))
+          s << "index range: " << min_indices << ", " << max_indices << '\n';
+        else
+          {
+            for (int z=density_info_ptr->get_min_index(); z<=density_info_ptr->get_max_index(); ++z)
+              for (int y=(*density_info_ptr)[z].get_min_index(); y<=(*density_info_ptr)[z].get_max_index(); ++y)
+                s << "index range (" << z << ',' << y << "): "
+                  << (*density_info_ptr)[z][y].get_min_index() << ", "
+                  << (*density_info_ptr)[z][y].get_max_index() << '\n';
+          }
+      }
+    this->persistent_cache_description = s.str();
+  }
+
+  this->persistent_cache_index.recycle();
+  this->persistent_cache_mapped_region_sptr.reset();
+  this->persistent_cache_file_mapping_sptr.reset();
+  if (this->persistent_cache_filename.size()!=0 && !this->cache_disabled)
+    {
+      if (read_persistent_cache() == Succeeded::yes)
+        info(boost::format("ProjMatrixByBin: using persistent cache %1%") % this->persistent_cache_filename);
+      else
+        info(boost::format("ProjMatrixByBin: persistent cache %1% not found (or not valid for this projection matrix).\n"
+                           "It will be written by write_persistent_cache().")
+             % this->persistent_cache_filename);
+    }
+}
+
+// anonymous namespace for local functions
+namespace {
+
+  // first bytes of the persistent cache file (see cache_file.h for the rest of the header)
+  const char persistent_cache_magic[8] = { 'S','T','I','R','P','M','C','\0' };
+  const boost::uint32_t persistent_cache_version = 4;
+  // value of the flags in the header if all bins are present
+  const boost::uint32_t persistent_cache_is_complete_flag = 1;
+  // size of the record in the index (segment, view, axial_pos, tangential_pos, number of elements, offset)
+  const std::size_t persistent_cache_index_record_size = 5*sizeof(boost::int32_t) + sizeof(boost::uint64_t);
+  // size of the record for an element (3 coordinates and value)
+  const std::size_t persistent_cache_elem_record_size = 3*sizeof(boost::int16_t) + sizeof(float);
+
+  template <typename T>
+  inline void
+  write_value(std::ostream& s, const T value)
+  {
+    s.write(reinterpret_cast<const char *>(&value), sizeof(T));
+  }
+
+  // note: uses memcpy as the data in the file are not necessarily aligned
+  template <typename T>
+  inline T
+  read_value(const char *& ptr)
+  {
+    T value;
+    std::memcpy(&value, ptr, sizeof(T));
+    ptr += sizeof(T);
+    return value;
+  }
+
+} // end of anonymous namespace
+
+Succeeded
+ProjMatrixByBin::
+write_cache_to_file(const std::string& filename) const
+{
+  // all bins are present if they were all computed, and none were removed since
+  const bool is_complete = this->cache_was_filled && this->num_cache_removals_since_set_up == 0;
+  // count number of entries and elements
+  boost::uint64_t num_entries = 0;
+  boost::uint64_t num_elems = 0;
+  for (int view_num=this->cache_collection.get_min_index();
+       view_num<=this->cache_collection.get_max_index();
+       ++view_num)
+    for (int segment_num=this->cache_collection[view_num].get_min_index();
+         segment_num<=this->cache_collection[view_num].get_max_index();
+         ++segment_num)
+      {
+        const MapProjMatrixElemsForOneBin& cache = this->cache_collection[view_num][segment_num];
+        num_entries += cache.size();
+        for (const_MapProjMatrixElemsForOneBinIterator iter = cache.begin(); iter != cache.end(); ++iter)
+          num_elems += iter->second.size();
+      }
+  const boost::uint64_t data_size =
+    sizeof(boost::uint64_t) + num_entries*persistent_cache_index_record_size + num_elems*persistent_cache_elem_record_size;
+
+  std::ofstream s;
+  const std::string tmp_filename = open_cache_file_for_writing(s, filename);
+  if (tmp_filename.empty())
+    return Succeeded::no;
+
+  write_cache_file_header(s, persistent_cache_magic, persistent_cache_version,
+                          is_complete ? persistent_cache_is_complete_flag : 0,
+                          data_size, this->persistent_cache_description);
+  write_value(s, num_entries);
+
+  // index (offsets are from the start of the file)
+  boost::uint64_t offset =
+    get_cache_file_header_size(this->persistent_cache_description) + sizeof(boost::uint64_t) +
+    num_entries*persistent_cache_index_record_size;
+  for (int view_num=this->cache_collection.get_min_index();
+       view_num<=this->cache_collection.get_max_index();
+       ++view_num)
+    for (int segment_num=this->cache_collection[view_num].get_min_index();
+         segment_num<=this->cache_collection[view_num].get_max_index();
+         ++segment_num)
+      {
+        const MapProjMatrixElemsForOneBin& cache = this->cache_collection[view_num][segment_num];
+        for (const_MapProjMatrixElemsForOneBinIterator iter = cache.begin(); iter != cache.end(); ++iter)
+          {
+            const Bin bin = iter->second.get_bin();
+            write_value(s, static_cast<boost::int32_t>(bin.segment_num()));
+            write_value(s, static_cast<boost::int32_t>(bin.view_num()));
+            write_value(s, static_cast<boost::int32_t>(bin.axial_pos_num()));
+            write_value(s, static_cast<boost::int32_t>(bin.tangential_pos_num()));
+            write_value(s, static_cast<boost::uint32_t>(iter->second.size()));
+            write_value(s, offset);
+            offset += iter->second.size()*persistent_cache_elem_record_size;
+          }
+      }
+
+  // elements
+  for (int view_num=this->cache_collection.get_min_index();
+       view_num<=this->cache_collection.get_max_index();
+       ++view_num)
+    for (int segment_num=this->cache_collection[view_num].get_min_index();
+         segment_num<=this->cache_collection[view_num].get_max_index();
+         ++segment_num)
+      {
+        const MapProjMatrixElemsForOneBin& cache = this->cache_collection[view_num][segment_num];
+        for (const_MapProjMatrixElemsForOneBinIterator iter = cache.begin(); iter != cache.end(); ++iter)
+          {
+            for (ProjMatrixElemsForOneBin::const_iterator element_ptr = iter->second.begin();
+                 element_ptr != iter->second.end();
+                 ++element_ptr)
+              {
+                write_value(s, static_cast<boost::int16_t>(element_ptr->coord1()));
+                write_value(s, static_cast<boost::int16_t>(element_ptr->coord2()));
+                write_value(s, static_cast<boost::int16_t>(element_ptr->coord3()));
+                write_value(s, element_ptr->get_value());
+              }
+          }
+      }
+  return finish_writing_cache_file(s, tmp_filename, filename);
+}
+
+Succeeded
+ProjMatrixByBin::
+read_persistent_cache()
+{
+  // check the header first
+  boost::uint32_t flags;
+  boost::uint64_t data_size;
+  {
+    std::ifstream s(this->persistent_cache_filename.c_str(), std::ios::in | std::ios::binary);
+    if (!s)
+      return Succeeded::no;
+    if (read_cache_file_header(s, persistent_cache_magic, persistent_cache_version,
+                               this->persistent_cache_description, flags, data_size) == Succeeded::no)
+      return Succeeded::no;
+  }
+  try
+    {
+      this->persistent_cache_file_mapping_sptr.reset(
+         new boost::interprocess::file_mapping(this->persistent_cache_filename.c_str(),
+                                               boost::interprocess::read_only));
+      this->persistent_cache_mapped_region_sptr.reset(
+         new boost::interprocess::mapped_region(*this->persistent_cache_file_mapping_sptr,
+                                                boost::interprocess::read_only));
+    }
+  catch (std::exception& e)
+    {
+      warning(boost::format("ProjMatrixByBin: could not map persistent cache %1% (%2%)")
+              % this->persistent_cache_filename % e.what());
+      this->persistent_cache_mapped_region_sptr.reset();
+      this->persistent_cache_file_mapping_sptr.reset();
+      return Succeeded::no;
+    }
+
+  const char * const start_ptr =
+    static_cast<const char *>(this->persistent_cache_mapped_region_sptr->get_address());
+  const char * const end_ptr = start_ptr + this->persistent_cache_mapped_region_sptr->get_size();
+  const boost::uint64_t file_size = static_cast<boost::uint64_t>(end_ptr - start_ptr);
+  const std::size_t header_size = get_cache_file_header_size(this->persistent_cache_description);
+  // the file might have been replaced since we read the header
+  bool valid = file_size == header_size + data_size && data_size >= sizeof(boost::uint64_t);
+  const char * current_ptr = start_ptr + header_size;
+  boost::uint64_t num_entries = 0;
+  if (valid)
+    {
+      num_entries = read_value<boost::uint64_t>(current_ptr);
+      valid =
+        static_cast<boost::uint64_t>(end_ptr - current_ptr)/persistent_cache_index_record_size >= num_entries;
+    }
+  if (!valid)
+    {
+      this->persistent_cache_mapped_region_sptr.reset();
+      this->persistent_cache_file_mapping_sptr.reset();
+      return Succeeded::no;
+    }
+
+  // fill in index
+  this->persistent_cache_index.resize(this->cache_collection.get_min_index(),
+                                      this->cache_collection.get_max_index());
+  for (int view_num=this->cache_collection.get_min_index();
+       view_num<=this->cache_collection.get_max_index();
+       ++view_num)
+    this->persistent_cache_index[view_num].resize(this->cache_collection[view_num].get_min_index(),
+                                                  this->cache_collection[view_num].get_max_index());
+  // the elements follow the index, in the same order
+  boost::uint64_t expected_offset =
+    static_cast<boost::uint64_t>(current_ptr - start_ptr) + num_entries*persistent_cache_index_record_size;
+  for (boost::uint64_t i=0; i<num_entries; ++i)
+    {
+      Bin bin;
+      bin.segment_num() = read_value<boost::int32_t>(current_ptr);
+      bin.view_num() = read_value<boost::int32_t>(current_ptr);
+      bin.axial_pos_num() = read_value<boost::int32_t>(current_ptr);
+      bin.tangential_pos_num() = read_value<boost::int32_t>(current_ptr);
+      PersistentCacheEntry entry;
+      entry.num_elems = read_value<boost::uint32_t>(current_ptr);
+      const boost::uint64_t offset = read_value<boost::uint64_t>(current_ptr);
+      entry.data_ptr = start_ptr + offset;
+      if (offset != expected_offset ||
+          (file_size - offset)/persistent_cache_elem_record_size < entry.num_elems ||
+          bin.view_num() < this->persistent_cache_index.get_min_index() ||
+          bin.view_num() > this->persistent_cache_index.get_max_index() ||
+          bin.segment_num() < this->persistent_cache_index[bin.view_num()].get_min_index() ||
+          bin.segment_num() > this->persistent_cache_index[bin.view_num()].get_max_index())
+        {
+          warning(boost::format("ProjMatrixByBin: persistent cache %1% is corrupt. It will be ignored.")
+                  % this->persistent_cache_filename);
+          this->persistent_cache_index.recycle();
+          this->persistent_cache_mapped_region_sptr.reset();
+          this->persistent_cache_file_mapping_sptr.reset();
+          return Succeeded::no;
+        }
+      this->persistent_cache_index[bin.view_num()][bin.segment_num()].
+        insert(MapPersistentCacheEntries::value_type(cache_key(bin), entry));
+      expected_offset += entry.num_elems*persistent_cache_elem_record_size;
+    }
+  if (expected_offset != file_size)
+    {
+      warning(boost::format("ProjMatrixByBin: persistent cache %1% is corrupt. It will be ignored.")
+              % this->persistent_cache_filename);
+      this->persistent_cache_index.recycle();
+      this->persistent_cache_mapped_region_sptr.reset();
+      this->persistent_cache_file_mapping_sptr.reset();
+      return Succeeded::no;
+    }
+  if ((flags & persistent_cache_is_complete_flag) == 0)
+    info(boost::format("ProjMatrixByBin: persistent cache %1% does not contain all bins. Missing bins will be computed.")
+         % this->persistent_cache_filename);
+  return Succeeded::yes;
+}
+
+void
+ProjMatrixByBin::
+fill_cache() STIR_MUTABLE_CONST
+{
+  if (this->cache_disabled)
+    return;
+  assert(!is_null_ptr(this->proj_data_info_for_cache_sptr));
+  const ProjDataInfo& proj_data_info = *this->proj_data_info_for_cache_sptr;
+  // we cannot throw inside a parallel region, so keep the first error message
+  bool error_occurred = false;
+  std::string error_message;
+#ifdef STIR_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for (int view_num=proj_data_info.get_min_view_num(); view_num<=proj_data_info.get_max_view_num(); ++view_num)
+    {
+      ProjMatrixElemsForOneBin probabilities;
+      for (int segment_num=proj_data_info.get_min_segment_num(); segment_num<=proj_data_info.get_max_segment_num(); ++segment_num)
+        for (int axial_pos_num=proj_data_info.get_min_axial_pos_num(segment_num);
+             axial_pos_num<=proj_data_info.get_max_axial_pos_num(segment_num);
+             ++axial_pos_num)
+          for (int tangential_pos_num=proj_data_info.get_min_tangential_pos_num();
+               tangential_pos_num<=proj_data_info.get_max_tangential_pos_num();
+               ++tangential_pos_num)
+            {
+              const Bin bin(segment_num, view_num, axial_pos_num, tangential_pos_num);
+              // only basic bins are cached in that case
+              if (this->cache_stores_only_basic_bins && !this->symmetries_ptr->is_basic(bin))
+                continue;
+              try
+                {
+                  this->get_proj_matrix_elems_for_one_bin(probabilities, bin);
+                }
+              catch (std::string& msg)
+                {
+#ifdef STIR_OPENMP
+#pragma omp critical(PROJMATRIXBYBINFILLCACHEERROR)
+#endif
+                  if (!error_occurred)
+                    {
+                      error_occurred = true;
+                      error_message = msg;
+                    }
+                }
+              catch (std::exception& e)
+                {
+#ifdef STIR_OPENMP
+#pragma omp critical(PROJMATRIXBYBINFILLCACHEERROR)
+#endif
+                  if (!error_occurred)
+                    {
+                      error_occurred = true;
+                      error_message = e.what();
+                    }
+                }
+            }
+    }
+  if (error_occurred)
+    error(boost::format("ProjMatrixByBin: error computing the elements for the cache (%1%)") % error_message);
+  this->cache_was_filled = true;
+}
+
+Succeeded
+ProjMatrixByBin::
+write_persistent_cache() STIR_MUTABLE_CONST
+{
+  if (this->persistent_cache_filename.size()==0 || this->cache_disabled ||
+      !is_null_ptr(this->persistent_cache_mapped_region_sptr))
+    return Succeeded::yes;
+
+  info(boost::format("ProjMatrixByBin: computing all bins for persistent cache %1%") % this->persistent_cache_filename);
+  this->fill_cache();
+  // a cache with missing bins would be used by later runs as if it was complete
+  if (this->num_cache_removals_since_set_up != 0)
+    {
+      warning(boost::format("ProjMatrixByBin: persistent cache %1% is not written as bins had to be removed\n"
+                            "from the cache due to its size limit. Increase \"maximum cache size in MB\".")
+              % this->persistent_cache_filename);
+      return Succeeded::no;
+    }
+  if (this->write_cache_to_file(this->persistent_cache_filename) == Succeeded::no)
+    {
+      warning(boost::format("ProjMatrixByBin: persistent cache %1% was not written")
+              % this->persistent_cache_filename);
+      return Succeeded::no;
+    }
+  info(boost::format("ProjMatrixByBin: persistent cache %1% written") % this->persistent_cache_filename);
+  return Succeeded::yes;
+}
+
+Succeeded
+ProjMatrixByBin::
+get_proj_matrix_elems_for_one_bin_from_persistent_cache(ProjMatrixElemsForOneBin& probabilities) const
+{
+  if (is_null_ptr(this->persistent_cache_mapped_region_sptr))
+    return Succeeded::no;
+
+  const Bin bin = probabilities.get_bin();
+  const MapPersistentCacheEntries& index = this->persistent_cache_index[bin.view_num()][bin.segment_num()];
+  const MapPersistentCacheEntries::const_iterator pos = index.find(cache_key(bin));
+  if (pos == index.end())
+    return Succeeded::no;
+
+  probabilities.erase();
+  probabilities.reserve(pos->second.num_elems);
+  const char * current_ptr = pos->second.data_ptr;
+  for (boost::uint32_t i=0; i<pos->second.num_elems; ++i)
+    {
+      const boost::int16_t c1 = read_value<boost::int16_t>(current_ptr);
+      const boost::int16_t c2 = read_value<boost::int16_t>(current_ptr);
+      const boost::int16_t c3 = read_value<boost::int16_t>(current_ptr);
+      const float value = read_value<float>(current_ptr);
+      probabilities.push_back(ProjMatrixElemsForOneBin::value_type(Coordinate3D<int>(c1,c2,c3), value));
+    }
+  return Succeeded::yes;
 }
 
 
@@ -176,14 +691,123 @@ cache_proj_matrix_elems_for_one_bin(
   //std::cerr << "cached lor size " << probabilities.size() << " capacity " << probabilities.capacity() << std::endl;    
   // insert probabilities into the collection	
   const Bin bin = probabilities.get_bin();
+  // estimate of the memory used by this entry (including some overhead of the map)
+  const std::size_t num_bytes =
+    sizeof(MapProjMatrixElemsForOneBin::value_type) + 2*sizeof(void *) +
+    probabilities.capacity()*sizeof(ProjMatrixElemsForOneBin::value_type);
+  bool inserted;
 #ifdef STIR_OPENMP
   omp_set_lock(&this->cache_locks[bin.view_num()][bin.segment_num()]);
 #endif
-  cache_collection[bin.view_num()][bin.segment_num()].insert(MapProjMatrixElemsForOneBin::value_type( cache_key(bin), 
-                                                                                                      probabilities));  
+  inserted =
+    cache_collection[bin.view_num()][bin.segment_num()].insert(MapProjMatrixElemsForOneBin::value_type( cache_key(bin), 
+                                                                                                        probabilities)).second;
+  if (inserted)
+    cache_num_bytes[bin.view_num()][bin.segment_num()] += num_bytes;
 #ifdef STIR_OPENMP
   omp_unset_lock(&this->cache_locks[bin.view_num()][bin.segment_num()]);
 #endif
+  if (!inserted)
+    return;
+  std::size_t new_total_cache_num_bytes;
+#if defined(STIR_OPENMP)
+# if _OPENMP >=201012
+#  pragma omp atomic capture
+# else
+#  pragma omp critical(PROJMATRIXBYBINTOTALCACHESIZE)
+# endif
+#endif
+  new_total_cache_num_bytes = total_cache_num_bytes += num_bytes;
+
+  if (max_cache_size_in_MB > 0 && new_total_cache_num_bytes > get_maximum_cache_size())
+    reduce_cache_size(bin);
+}
+
+void
+ProjMatrixByBin::
+reduce_cache_size(const Bin& bin) STIR_MUTABLE_CONST
+{
+  const std::size_t max_num_bytes = get_maximum_cache_size();
+  const std::size_t target_num_bytes = max_num_bytes - max_num_bytes/10;
+#ifdef STIR_OPENMP
+#pragma omp critical(PROJMATRIXBYBINREDUCECACHE)
+#endif
+  {
+    std::size_t current_num_bytes;
+#if defined(STIR_OPENMP)
+# if _OPENMP >=201012
+#  pragma omp atomic read
+# else
+#  pragma omp critical(PROJMATRIXBYBINTOTALCACHESIZE)
+# endif
+#endif
+    current_num_bytes = total_cache_num_bytes;
+    // another thread might have reduced the cache already while we were waiting
+    if (current_num_bytes > max_num_bytes)
+      {
+        // find all non-empty views/segments (but not the current one), and sort them
+        // such that the least recently used come first
+        typedef std::pair<boost::uint64_t, std::pair<int,int> > access_and_view_segment_type;
+        std::vector<access_and_view_segment_type> entries;
+        for (int view_num=this->cache_collection.get_min_index();
+             view_num<=this->cache_collection.get_max_index();
+             ++view_num)
+          for (int segment_num=this->cache_collection[view_num].get_min_index();
+               segment_num<=this->cache_collection[view_num].get_max_index();
+               ++segment_num)
+            {
+              if (view_num == bin.view_num() && segment_num == bin.segment_num())
+                continue;
+              std::size_t num_bytes;
+              boost::uint64_t last_access;
+#ifdef STIR_OPENMP
+              omp_set_lock(&this->cache_locks[view_num][segment_num]);
+#endif
+              num_bytes = this->cache_num_bytes[view_num][segment_num];
+              last_access = this->cache_last_access[view_num][segment_num];
+#ifdef STIR_OPENMP
+              omp_unset_lock(&this->cache_locks[view_num][segment_num]);
+#endif
+              if (num_bytes != 0)
+                entries.push_back(access_and_view_segment_type(last_access, std::make_pair(view_num, segment_num)));
+            }
+        std::sort(entries.begin(), entries.end());
+
+        for (std::vector<access_and_view_segment_type>::const_iterator iter = entries.begin();
+             iter != entries.end() && current_num_bytes > target_num_bytes;
+             ++iter)
+          {
+            const int view_num = iter->second.first;
+            const int segment_num = iter->second.second;
+            std::size_t num_bytes;
+#ifdef STIR_OPENMP
+            omp_set_lock(&this->cache_locks[view_num][segment_num]);
+#endif
+            this->cache_collection[view_num][segment_num].clear();
+            num_bytes = this->cache_num_bytes[view_num][segment_num];
+            this->cache_num_bytes[view_num][segment_num] = 0;
+#ifdef STIR_OPENMP
+            omp_unset_lock(&this->cache_locks[view_num][segment_num]);
+#endif
+#if defined(STIR_OPENMP)
+# if _OPENMP >=201012
+#  pragma omp atomic capture
+# else
+#  pragma omp critical(PROJMATRIXBYBINTOTALCACHESIZE)
+# endif
+#endif
+            current_num_bytes = total_cache_num_bytes -= num_bytes;
+#ifdef STIR_OPENMP
+#pragma omp atomic
+#endif
+            ++num_cache_evictions;
+#ifdef STIR_OPENMP
+#pragma omp atomic
+#endif
+            ++num_cache_removals_since_set_up;
+          }
+      }
+  }
 }
 
 
@@ -207,9 +831,21 @@ get_cached_proj_matrix_elems_for_one_bin(
 #endif         
   
   bool found=false;
+  boost::uint64_t access_count;
+#if defined(STIR_OPENMP)
+# if _OPENMP >=201012
+#  pragma omp atomic capture
+# else
+#  pragma omp critical(PROJMATRIXBYBINACCESSCOUNTER)
+# endif
+#endif
+  access_count = ++cache_access_counter;
 #ifdef STIR_OPENMP
   omp_set_lock(&this->cache_locks[bin.view_num()][bin.segment_num()]);
 #endif
+  // note: with OpenMP, threads might store their time-stamp in a different order,
+  // but that is fine for our purposes
+  cache_last_access[bin.view_num()][bin.segment_num()] = access_count;
 
   {
     const_MapProjMatrixElemsForOneBinIterator pos = 
@@ -227,10 +863,23 @@ get_cached_proj_matrix_elems_for_one_bin(
 #ifdef STIR_OPENMP
   omp_unset_lock(&this->cache_locks[bin.view_num()][bin.segment_num()]);
 #endif
+  if (!found)
+    found =
+      get_proj_matrix_elems_for_one_bin_from_persistent_cache(probabilities) == Succeeded::yes;
   if (found)
-    return Succeeded::yes;	
+    {
+#ifdef STIR_OPENMP
+#pragma omp atomic
+#endif
+      ++num_cache_hits;
+      return Succeeded::yes;	
+    }
   else
     {
+#ifdef STIR_OPENMP
+#pragma omp atomic
+#endif
+      ++num_cache_misses;
       //cout << " This entry  is not in the cache :" << Key << endl;	
       return Succeeded::no;
     }
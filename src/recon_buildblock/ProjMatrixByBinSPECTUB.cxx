@@ -107,6 +107,7 @@ initialise_keymap()
   parser.add_key("mask type", &mask_type);
   parser.add_key("mask file", &mask_file);
   parser.add_key("keep_all_views_in_cache", &keep_all_views_in_cache);
+  parser.add_key("precompute all views", &precompute_all_views);
 
   parser.add_stop_key("End Projection Matrix By Bin SPECT UB Parameters");
 }
@@ -120,6 +121,7 @@ ProjMatrixByBinSPECTUB::set_defaults()
   this->already_setup= false;
 
   this->keep_all_views_in_cache=false;
+  this->precompute_all_views=false;
   minimum_weight=0.0;
   maximum_number_of_sigmas= 2.;
   spatial_resolution_PSF= 0.00001;
@@ -142,6 +144,12 @@ ProjMatrixByBinSPECTUB::post_processing()
 
   this->already_setup= false;
 
+  if (this->precompute_all_views && !this->keep_all_views_in_cache)
+    {
+      warning("SPECTUB matrix: precomputing all views needs keep_all_views_in_cache to be set");
+      return true;
+    }
+
   return false;
 }
 
@@ -179,7 +187,10 @@ set_up(
 	     this->origin == image_info_ptr->get_origin() &&    
          *proj_data_info_ptr_v == *this->proj_data_info_ptr)
 	  {
-		  // stored matrix should be compatible, so we can just reuse it
+		  // stored matrix should be compatible, so we can just reuse the set-up.
+		  // However, ProjMatrixByBin::set_up() has emptied the cache.
+		  if (this->precompute_all_views)
+		    this->compute_all_subsets();
 		  return;
 	  }
 	  else
@@ -499,38 +510,21 @@ set_up(
 	  NITEMS[kOS] = new int [ wm.NbOS ];
 	}
 
-	//... double array wm.val and wm.col .....................................................
-
-	if ( ( wm.val = new (nothrow) float * [ wm.NbOS ] ) == NULL ) 
-          {
-            //error_wm_SPECT( 200, "wm.val[]" );
-            error("Error allocating space to store values for SPECTUB matrix");
-          }
-	if ( ( wm.col = new (nothrow) int   * [ wm.NbOS ] ) == NULL ) 
-          {
-            //error_wm_SPECT( 200, "wm.col[]" );
-            error("Error allocating space to store column indices for SPECTUB matrix");
-          }
-
-	//... array wm.ne .........................................................................
-
-	if ( ( wm.ne = new (nothrow) int [ wm.NbOS + 1 ]) == 0 ) 
-          {
-            // error_wm_SPECT(200,"wm.ne[]");
-            error("Error allocating space to store number of elements for SPECTUB matrix");
-          }
-
+	//... the arrays for the matrix values are allocated per subset in compute_one_subset()
 
-	//... STIR indices .......................................................................
+	//... STIR image indices (these do not depend on the subset) .............................
 
 	if ( wm.do_save_STIR ){
-		wm.ns = new int [ prj.NbOS ];
-		wm.nb = new int [ prj.NbOS ];
-		wm.na = new int [ prj.NbOS ];
-
 		wm.nx = new short int [ vol.Nvox ];
 		wm.ny = new short int [ vol.Nvox ];
 		wm.nz = new short int [ vol.Nvox ];
+
+		for ( int iv = 0 ; iv < vol.Nvox ; iv++ ){
+			const int ip = iv % vol.Npix;
+			wm.nx[ iv ] = (short int)( ip % vol.Ncol - (int) floor( vol.Ncold2 ) );  // centered index for STIR format
+			wm.ny[ iv ] = (short int)( ip / vol.Ncol - (int) floor( vol.Nrowd2 ) );  // centered index for STIR format
+			wm.nz[ iv ] = (short int)( iv / vol.Npix );                            // non-centered index for STIR format
+		}
 	}
 
 	//... memory allocation for wmh .........................................................
@@ -542,8 +536,15 @@ set_up(
 	//... CALCULATION OF MATRICES ..............................................................
 	//..........................................................................................
 
+#ifdef STIR_OPENMP
+	//... locks for computing the subsets (see calculate_proj_matrix_elems_for_one_bin) ....
+	destroy_subset_locks();
+	subset_locks.resize(prj.NOS);
+	for ( int kOS = 0 ; kOS < prj.NOS ; kOS++ )
+	  omp_init_lock(&subset_locks[kOS]);
+#endif
+
 	//... LOOP: Subsets .................................................................
-	subset_already_processed.assign(prj.NOS, false);
 	for ( int kOS = 0 ; kOS < prj.NOS ; kOS++ ){
 		wmh.subset_ind = kOS;
 
@@ -573,14 +574,48 @@ set_up(
 	// wm_SPECT ends here ---------------------------------------------------------------------------------------------
 
 	this->already_setup= true;
+
+	if (this->precompute_all_views)
+	  this->compute_all_subsets();
+}
+
+void
+ProjMatrixByBinSPECTUB::
+compute_all_subsets()
+{
+  CPUTimer timer;
+  timer.start();
+  // every thread computes complete subsets. The row loop in wm_calculation is then
+  // executed by a single thread (unless nested parallelism is enabled).
+#ifdef STIR_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for (int kOS=0; kOS<prj.NOS; ++kOS)
+    this->compute_one_subset(kOS);
+  info(boost::format("Done computing the matrix elements of all views. Execution (CPU) time %1% s ") % timer.value(),
+       2);
 }
 
 ProjMatrixByBinSPECTUB::
 ~ProjMatrixByBinSPECTUB()
 {
   delete_UB_SPECT_arrays();
+#ifdef STIR_OPENMP
+  destroy_subset_locks();
+#endif
 }
 
+#ifdef STIR_OPENMP
+void
+ProjMatrixByBinSPECTUB::
+destroy_subset_locks()
+{
+  for (std::size_t i=0; i<subset_locks.size(); ++i)
+    omp_destroy_lock(&subset_locks[i]);
+  subset_locks.clear();
+}
+#endif
+
 void
 ProjMatrixByBinSPECTUB::
 delete_UB_SPECT_arrays()
@@ -596,10 +631,6 @@ delete_UB_SPECT_arrays()
     }
   }
 
-  delete [] wm.val;
-  delete [] wm.col;
-  delete [] wm.ne;
-
   //... freeing memory .............................................
 
   delete [] prj.order;
@@ -622,9 +653,6 @@ delete_UB_SPECT_arrays()
   }
 
   if ( wm.do_save_STIR ){
-    delete [] wm.ns;
-    delete [] wm.nb;
-    delete [] wm.na;
     delete [] wm.nx;
     delete [] wm.ny;
     delete [] wm.nz;
@@ -642,16 +670,6 @@ compute_one_subset(const int kOS) const
   timer.start();
   // cout << "\n\n--- Processing subset: " << kOS+1 << "/" << prj.NOS << " ----------------------------------------\n" << endl;
 
-  //... to fill wmh fields related to the subset ..................................
-
-  wmh.subset_ind = kOS;
-
-  for ( int i = 0 ; i < prj.NangOS ; i ++ ){
-
-    wmh.index[ i ] = prj.order[ i + kOS * prj.NangOS ];
-    wmh.Rrad [ i ] = Rrad[ wmh.index[ i ] ];
-  }
-
   //... NITEMS initialization  ......................
 
   // for ( int i = 0 ; i < prj.NbOS ; i++ ) NITEMS[ i ] = 1;
@@ -674,17 +692,33 @@ compute_one_subset(const int kOS) const
        % ( wm.do_save_STIR ?  (ne + 10* prj.NbOS)/104857.6 : ne/131072),
        2);
 
+  //... weight matrix for this subset ..............................................
+  // (not the global variable wm, such that subsets can be computed in parallel)
+
+  std::vector<float *> val_ptrs(wm.NbOS);
+  std::vector<int *> col_ptrs(wm.NbOS);
+  std::vector<int> ne_subset(wm.NbOS + 1);
+  std::vector<int> na_subset(wm.NbOS), nb_subset(wm.NbOS), ns_subset(wm.NbOS);
+
+  wm_da_type wm_subset = wm;
+  wm_subset.val = &val_ptrs[0];
+  wm_subset.col = &col_ptrs[0];
+  wm_subset.ne = &ne_subset[0];
+  wm_subset.na = &na_subset[0];
+  wm_subset.nb = &nb_subset[0];
+  wm_subset.ns = &ns_subset[0];
+
   //... memory allocation for wm float arrays ...................................
 
   for( int i = 0 ; i < wmh.prj.NbOS ; i++ ){
 
-    if ( ( wm.val[ i ] = new (nothrow) float [ NITEMS[kOS][ i ] ]) == NULL) 
+    if ( ( wm_subset.val[ i ] = new (nothrow) float [ NITEMS[kOS][ i ] ]) == NULL) 
       {
         //error_wm_SPECT( 200, "wm.val[][]" );
         error("Error allocating space to store values for SPECTUB matrix");
       }
 
-    if ( ( wm.col[ i ] = new (nothrow) int   [ NITEMS[kOS][ i ] ]) == NULL) 
+    if ( ( wm_subset.col[ i ] = new (nothrow) int   [ NITEMS[kOS][ i ] ]) == NULL) 
       {
         //error_wm_SPECT( 200, "wm.col[]" );
         error("Error allocating space to store column indices for SPECTUB matrix");
@@ -693,46 +727,46 @@ compute_one_subset(const int kOS) const
 
   //... to initialize wm to zero ......................
 
-  for ( int i = 0 ; i < wm.NbOS ; i++ ){
+  for ( int i = 0 ; i < wm_subset.NbOS ; i++ ){
 
-    wm.ne[ i ] = 0;
+    wm_subset.ne[ i ] = 0;
 
     for( int j = 0 ; j < NITEMS[kOS][ i ] ; j++ ){
 
-      wm.val[ i ][ j ] = (float)0.;
-      wm.col[ i ][ j ] = 0;
+      wm_subset.val[ i ][ j ] = (float)0.;
+      wm_subset.col[ i ][ j ] = 0;
     }
   }
-  wm.ne[ wm.NbOS ] = 0;
+  wm_subset.ne[ wm_subset.NbOS ] = 0;
 
   //... wm calculation for this subset ...........................
 
-  wm_calculation ( kOS, ang, vox, bin, vol, prj, attmap, msk_3d, msk_2d, maxszb, &gaussdens, NITEMS[kOS] );
+  wm_calculation ( wm_subset, kOS, ang, vox, bin, vol, prj, attmap, msk_3d, msk_2d, maxszb, &gaussdens, NITEMS[kOS] );
   info(boost::format("Weight matrix calculation done. time %1% (s)") % timer.value(),
        2);
 
   //... fill lor .........................
 
-  for( int j = 0 ; j < wm.NbOS ; j++ ){
+  for( int j = 0 ; j < wm_subset.NbOS ; j++ ){
     ProjMatrixElemsForOneBin lor;
     Bin bin;
     bin.segment_num()=0;	
-    bin.view_num()=wm.na [ j ];	
-    bin.axial_pos_num()=wm.ns [ j ];	
-    bin.tangential_pos_num()=wm.nb [ j ];	
+    bin.view_num()=wm_subset.na [ j ];	
+    bin.axial_pos_num()=wm_subset.ns [ j ];	
+    bin.tangential_pos_num()=wm_subset.nb [ j ];	
     bin.set_bin_value(0);
     lor.set_bin(bin);
 
-    lor.reserve(wm.ne[ j ]);
-    for ( int i = 0 ; i < wm.ne[ j ] ; i++ ){
+    lor.reserve(wm_subset.ne[ j ]);
+    for ( int i = 0 ; i < wm_subset.ne[ j ] ; i++ ){
 
       const ProjMatrixElemsForOneBin::value_type 
-        elem(Coordinate3D<int>(wm.nz[ wm.col[ j ][ i ] ],wm.ny[ wm.col[ j ][ i ] ],wm.nx[ wm.col[ j ][ i ] ]), wm.val[ j ][ i ]);      
+        elem(Coordinate3D<int>(wm.nz[ wm_subset.col[ j ][ i ] ],wm.ny[ wm_subset.col[ j ][ i ] ],wm.nx[ wm_subset.col[ j ][ i ] ]), wm_subset.val[ j ][ i ]);      
       lor.push_back( elem);	
     }
 
-    delete [] wm.val[ j ];
-    delete [] wm.col[ j ];
+    delete [] wm_subset.val[ j ];
+    delete [] wm_subset.col[ j ];
 
     this->cache_proj_matrix_elems_for_one_bin(lor);
   }
@@ -757,23 +791,53 @@ calculate_proj_matrix_elems_for_one_bin(ProjMatrixElemsForOneBin& lor
       if (prj.order[kOS] == view_num)
 	break;
     }
+  // When all views are kept in the cache, only one thread computes a subset, but
+  // different subsets can be computed at the same time.
+  // Note that the bin might be in the cache now if another thread computed its subset in the mean time.
+  // Otherwise, the subset is computed (possibly again, as its elements can have been removed
+  // from the cache when the size of the cache is limited).
+  // When only a single view is kept, computing a view clears the cache, so clearing, computing
+  // and getting the elements is done by one thread at a time (otherwise threads would remove
+  // each other's elements).
+  bool found = true;
+  if (this->keep_all_views_in_cache)
+    {
 #ifdef STIR_OPENMP
-#pragma omp critical(PROJMATRIXBYBINUBONEVIEW)
+      omp_set_lock(&subset_locks[kOS]);
 #endif
-  if (!subset_already_processed[kOS])
+      lor.erase();
+      if (this->get_cached_proj_matrix_elems_for_one_bin(lor) == Succeeded::no)
+        {
+          info(boost::format("Computing matrix elements for view %1%") % view_num,
+               2);
+          compute_one_subset(kOS);
+          lor.erase();
+          found = this->get_cached_proj_matrix_elems_for_one_bin(lor) == Succeeded::yes;
+        }
+#ifdef STIR_OPENMP
+      omp_unset_lock(&subset_locks[kOS]);
+#endif
+    }
+  else
     {
-      if (!this->keep_all_views_in_cache)
-	{
-	  this->clear_cache();
-	  subset_already_processed.assign(prj.NOS,false);
-	}
-      info(boost::format("Computing matrix elements for view %1%") % view_num,
-        2);
-      compute_one_subset(kOS);
-      subset_already_processed[kOS]=true;
+#ifdef STIR_OPENMP
+#pragma omp critical(PROJMATRIXBYBINSPECTUBSINGLEVIEW)
+#endif
+      {
+        lor.erase();
+        if (this->get_cached_proj_matrix_elems_for_one_bin(lor) == Succeeded::no)
+          {
+            this->clear_cache();
+            info(boost::format("Computing matrix elements for view %1%") % view_num,
+                 2);
+            compute_one_subset(kOS);
+            lor.erase();
+            found = this->get_cached_proj_matrix_elems_for_one_bin(lor) == Succeeded::yes;
+          }
+      }
     }
-  lor.erase();
+  if (!found)
+    error("ProjMatrixByBinSPECTUB: matrix elements not found in the cache after computing them. Is the cache disabled?");
 }
 
 END_NAMESPACE_STIR
-
@@ -350,22 +350,36 @@ ProjMatrixElemsForOneBin::
 back_project(DiscretisedDensity<3,float>& density,   
              const Bin& single) const
 {   
-  {  
-    const float data = single.get_bin_value() ;     
-    // KT 21/02/2002 added check on 0
-    if (data == 0)
-      return;
-    
-    const_iterator element_ptr = 
-      begin();
-    while (element_ptr != end())
+  const float data = single.get_bin_value() ;     
+  // KT 21/02/2002 added check on 0
+  if (data == 0)
+    return;
+
+  // Elements are normally sorted on coordinates such that consecutive elements 
+  // are often in the same row of the image. We therefore keep a pointer to the
+  // current row to avoid repeated indexing via density[z][y].
+  // Note that we do not use density.get_full_data_ptr() and linearised offsets here.
+  // Checking that the image is contiguous needs a pass over all its rows, which
+  // costs more than projecting a single bin.
+  const int min_z = density.get_min_index();
+  const int max_z = density.get_max_index();
+  Array<1,float>* row_ptr = 0;
+  int current_z = 0, current_y = 0;
+
+  const const_iterator end_element_ptr = end();
+  for (const_iterator element_ptr = begin(); element_ptr != end_element_ptr; ++element_ptr)
     {
-      const BasicCoordinate<3,int> coords = element_ptr->get_coords();
-      if (coords[1] >= density.get_min_index() && coords[1] <= density.get_max_index())
-        density[coords[1]][coords[2]][coords[3]] += element_ptr->get_value() * data;		
-      element_ptr++;            
-    }    
-  }    
+      const int z = element_ptr->coord1();
+      if (z < min_z || z > max_z)
+        continue;
+      const int y = element_ptr->coord2();
+      if (row_ptr == 0 || z != current_z || y != current_y)
+        {
+          row_ptr = &density[z][y];
+          current_z = z; current_y = y;
+        }
+      (*row_ptr)[element_ptr->coord3()] += element_ptr->get_value() * data;
+    }
 }
 
 
@@ -374,19 +388,29 @@ ProjMatrixElemsForOneBin::
 forward_project(Bin& single,
                 const DiscretisedDensity<3,float>& density) const
 {
-  {  
-    
-    const_iterator element_ptr = begin();
-    
-    while (element_ptr != end())
+  // see back_project() for the use of row_ptr
+  const int min_z = density.get_min_index();
+  const int max_z = density.get_max_index();
+  const Array<1,float>* row_ptr = 0;
+  int current_z = 0, current_y = 0;
+  // accumulate in a local variable (in the same order as before)
+  float sum = single.get_bin_value();
+
+  const const_iterator end_element_ptr = end();
+  for (const_iterator element_ptr = begin(); element_ptr != end_element_ptr; ++element_ptr)
     {
-      const BasicCoordinate<3,int> coords = element_ptr->get_coords();
-      
-      if (coords[1] >= density.get_min_index() && coords[1] <= density.get_max_index())
-        single += density[coords[1]][coords[2]][coords[3]] * element_ptr->get_value();
-      ++element_ptr;		
-    }	      
-  }   
+      const int z = element_ptr->coord1();
+      if (z < min_z || z > max_z)
+        continue;
+      const int y = element_ptr->coord2();
+      if (row_ptr == 0 || z != current_z || y != current_y)
+        {
+          row_ptr = &density[z][y];
+          current_z = z; current_y = y;
+        }
+      sum += (*row_ptr)[element_ptr->coord3()] * element_ptr->get_value();
+    }
+  single.set_bin_value(sum);
 }
 
 
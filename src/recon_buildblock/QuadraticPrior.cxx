@@ -34,13 +34,14 @@
 #include "stir/IO/read_from_file.h"
 #include "stir/is_null_ptr.h"
 #include "stir/info.h"
+#include "stir/VectorWithOffset.h"
 #include <algorithm>
+#include <numeric>
+#include <vector>
+#include <cstddef>
 using std::min;
 using std::max;
 
-/* Pretty horrible code because we don't have an iterator of neigbhourhoods yet
- */
-
 START_NAMESPACE_STIR
 
 template <typename elemT>
@@ -206,6 +207,264 @@ compute_weights(Array<3,float>& weights, const CartesianCoordinate3D<float>& gri
         }
 }
 
+/* Implementation of the loops over the image and the neighbourhood.
+
+   The functions below compute for every voxel r
+     sum_dr weights[dr] * kappa[r] * kappa[r+dr] * term(image[r], image[r+dr])
+   where the sum is over the neighbours that are inside the image (as in the original
+   loops with clamping of the neighbourhood at the edges). Only the term differs
+   between compute_value(), compute_gradient() etc.
+
+   The image is accessed via a pointer to its (contiguous) data, and the neighbours
+   via a table of offsets in that data. For the voxels in the interior of the image
+   all neighbours are inside the image, so no checks are needed and the loop over x
+   can be vectorised by the compiler. Only the voxels near the edges use a loop
+   with checks. The loop over z is parallelised with OpenMP.
+*/
+namespace detail
+{
+  //! neighbours with non-zero weight, and their offsets in a contiguous image
+  class QuadraticPriorNeighbourhood
+  {
+  public:
+    QuadraticPriorNeighbourhood(const Array<3,float>& weights,
+                                const int size_y, const int size_x)
+      : min_dz(0), max_dz(0), min_dy(0), max_dy(0), min_dx(0), max_dx(0)
+    {
+      for (int dz=weights.get_min_index(); dz<=weights.get_max_index(); ++dz)
+        for (int dy=weights[dz].get_min_index(); dy<=weights[dz].get_max_index(); ++dy)
+          for (int dx=weights[dz][dy].get_min_index(); dx<=weights[dz][dy].get_max_index(); ++dx)
+            {
+              if (weights[dz][dy][dx] == 0)
+                continue;
+              this->dz.push_back(dz);
+              this->dy.push_back(dy);
+              this->dx.push_back(dx);
+              this->weight.push_back(weights[dz][dy][dx]);
+              this->offset.push_back((static_cast<std::ptrdiff_t>(dz)*size_y + dy)*size_x + dx);
+              min_dz = min(min_dz, dz); max_dz = max(max_dz, dz);
+              min_dy = min(min_dy, dy); max_dy = max(max_dy, dy);
+              min_dx = min(min_dx, dx); max_dx = max(max_dx, dx);
+            }
+    }
+
+    int size() const { return static_cast<int>(weight.size()); }
+
+    std::vector<int> dz, dy, dx;
+    std::vector<float> weight;
+    std::vector<std::ptrdiff_t> offset;
+    //! extent of the neighbourhood (including 0)
+    int min_dz, max_dz, min_dy, max_dy, min_dx, max_dx;
+  };
+
+  // terms for the different functions
+  template <typename elemT>
+  struct QuadraticPriorValueTerm
+  {
+    elemT operator()(const elemT centre, const elemT neighbour) const
+    { return square(centre - neighbour)/4; }
+  };
+
+  template <typename elemT>
+  struct QuadraticPriorGradientTerm
+  {
+    elemT operator()(const elemT centre, const elemT neighbour) const
+    { return centre - neighbour; }
+  };
+
+  template <typename elemT>
+  struct QuadraticPriorCurvatureTerm
+  {
+    // 1 comes from omega = psi'(t)/t = 2*t/2t =1
+    elemT operator()(const elemT, const elemT) const
+    { return 1; }
+  };
+
+  template <typename elemT>
+  struct QuadraticPriorHessianTerm
+  {
+    elemT operator()(const elemT, const elemT neighbour) const
+    { return neighbour; }
+  };
+
+  //! computes the sums for all voxels in one row
+  /*! \a image_row and \a kappa_row point to the first voxel of the row (\a kappa_row can be 0).
+    \a k and \a j are the z and y indices of the row, counting from 0.
+  */
+  template <typename elemT, class TermT>
+  static void
+  compute_quadratic_prior_row(elemT * const row_sums,
+                              const elemT * const image_row, const elemT * const kappa_row,
+                              const int k, const int j,
+                              const int size_z, const int size_y, const int size_x,
+                              const QuadraticPriorNeighbourhood& nbhd,
+                              const TermT& term)
+  {
+    // find range [first_i, end_i) where all neighbours are inside the image
+    int first_i = 0;
+    int end_i = 0;
+    if (k + nbhd.min_dz >= 0 && k + nbhd.max_dz < size_z &&
+        j + nbhd.min_dy >= 0 && j + nbhd.max_dy < size_y)
+      {
+        first_i = min(-nbhd.min_dx, size_x);
+        end_i = max(size_x - nbhd.max_dx, first_i);
+      }
+
+    // interior
+    std::fill(row_sums, row_sums + size_x, elemT(0));
+    for (int n=0; n<nbhd.size(); ++n)
+      {
+        const elemT weight = static_cast<elemT>(nbhd.weight[n]);
+        const elemT * const neighbour_row = image_row + nbhd.offset[n];
+        if (kappa_row == 0)
+          {
+            for (int i=first_i; i<end_i; ++i)
+              row_sums[i] += weight * term(image_row[i], neighbour_row[i]);
+          }
+        else
+          {
+            const elemT * const kappa_neighbour_row = kappa_row + nbhd.offset[n];
+            for (int i=first_i; i<end_i; ++i)
+              row_sums[i] += weight * term(image_row[i], neighbour_row[i]) * kappa_neighbour_row[i];
+          }
+      }
+
+    // edges, i.e. [0, first_i) and [end_i, size_x)
+    for (int i=0; i<size_x; ++i)
+      {
+        if (i == first_i && first_i < end_i)
+          i = end_i;
+        if (i == size_x)
+          break;
+        elemT sum = 0;
+        for (int n=0; n<nbhd.size(); ++n)
+          {
+            if (k + nbhd.dz[n] < 0 || k + nbhd.dz[n] >= size_z ||
+                j + nbhd.dy[n] < 0 || j + nbhd.dy[n] >= size_y ||
+                i + nbhd.dx[n] < 0 || i + nbhd.dx[n] >= size_x)
+              continue;
+            elemT current =
+              static_cast<elemT>(nbhd.weight[n]) * term(image_row[i], image_row[i + nbhd.offset[n]]);
+            if (kappa_row != 0)
+              current *= kappa_row[i + nbhd.offset[n]];
+            sum += current;
+          }
+        row_sums[i] = sum;
+      }
+
+    if (kappa_row != 0)
+      for (int i=0; i<size_x; ++i)
+        row_sums[i] *= kappa_row[i];
+  }
+
+  //! returns a pointer to the contiguous data of \a array, using \a copy if necessary
+  template <typename elemT>
+  static const elemT *
+  get_contiguous_data_ptr(const Array<3,elemT>& array, Array<3,elemT>& copy)
+  {
+    if (!array.get_index_range().is_regular())
+      error("QuadraticPrior: can only handle images with a regular index range");
+    if (array.is_contiguous())
+      return array.get_const_full_data_ptr();
+    copy.resize(array.get_index_range());
+    std::copy(array.begin_all(), array.end_all(), copy.begin_all());
+    return copy.get_const_full_data_ptr();
+  }
+
+  //! loops over all rows and calls \a row_output for the sums in every row
+  /*! \a row_output is called as <code>row_output(z, y, row_sums, size_x)</code> (with the
+    indices of the image). This happens in parallel for different planes.
+  */
+  template <typename elemT, class TermT, class RowOutputT>
+  static void
+  quadratic_prior_loop(const Array<3,elemT>& image,
+                       const shared_ptr<DiscretisedDensity<3,elemT> >& kappa_sptr,
+                       const Array<3,float>& weights,
+                       const TermT& term,
+                       const RowOutputT& row_output)
+  {
+    Array<3,elemT> image_copy;
+    Array<3,elemT> kappa_copy;
+    const elemT * const image_data_ptr = get_contiguous_data_ptr(image, image_copy);
+    const elemT * const kappa_data_ptr =
+      is_null_ptr(kappa_sptr) ? 0 : get_contiguous_data_ptr(*kappa_sptr, kappa_copy);
+
+    BasicCoordinate<3,int> min_indices, max_indices;
+    if (!image.get_regular_range(min_indices, max_indices))
+      return; // empty image
+    const int size_z = max_indices[1] - min_indices[1] + 1;
+    const int size_y = max_indices[2] - min_indices[2] + 1;
+    const int size_x = max_indices[3] - min_indices[3] + 1;
+    const QuadraticPriorNeighbourhood nbhd(weights, size_y, size_x);
+
+#ifdef STIR_OPENMP
+#pragma omp parallel
+#endif
+    {
+      std::vector<elemT> row_sums(size_x);
+#ifdef STIR_OPENMP
+#pragma omp for schedule(static)
+#endif
+      for (int k=0; k<size_z; ++k)
+        for (int j=0; j<size_y; ++j)
+          {
+            const std::ptrdiff_t row_offset = (static_cast<std::ptrdiff_t>(k)*size_y + j)*size_x;
+            compute_quadratic_prior_row(&row_sums[0],
+                                        image_data_ptr + row_offset,
+                                        kappa_data_ptr == 0 ? 0 : kappa_data_ptr + row_offset,
+                                        k, j, size_z, size_y, size_x,
+                                        nbhd, term);
+            row_output(k + min_indices[1], j + min_indices[2], &row_sums[0], size_x);
+          }
+    }
+  }
+
+  //! row output that sets (or adds) the sums multiplied with a factor in an image
+  template <typename elemT>
+  class QuadraticPriorImageOutput
+  {
+  public:
+    QuadraticPriorImageOutput(Array<3,elemT>& output_v, const float factor_v, const bool add_v)
+      : output(output_v), factor(factor_v), add(add_v)
+    {}
+    void operator()(const int z, const int y, const elemT * const row_sums, const int) const
+    {
+      Array<1,elemT>& row = output[z][y];
+      const int min_x = row.get_min_index();
+      if (add)
+        for (int x=min_x; x<=row.get_max_index(); ++x)
+          row[x] += row_sums[x-min_x] * factor;
+      else
+        for (int x=min_x; x<=row.get_max_index(); ++x)
+          row[x] = row_sums[x-min_x] * factor;
+    }
+  private:
+    Array<3,elemT>& output;
+    const float factor;
+    const bool add;
+  };
+
+  //! row output that sums the values for every plane
+  template <typename elemT>
+  class QuadraticPriorSumOutput
+  {
+  public:
+    explicit QuadraticPriorSumOutput(VectorWithOffset<double>& plane_sums_v)
+      : plane_sums(plane_sums_v)
+    {}
+    void operator()(const int z, const int, const elemT * const row_sums, const int size_x) const
+    {
+      double sum = 0;
+      for (int i=0; i<size_x; ++i)
+        sum += static_cast<double>(row_sums[i]);
+      // note: different threads handle different planes, so this is safe
+      plane_sums[z] += sum;
+    }
+  private:
+    VectorWithOffset<double>& plane_sums;
+  };
+} // end of namespace detail
+
 template <typename elemT>
 double
 QuadraticPrior<elemT>::
@@ -231,53 +490,20 @@ compute_value(const DiscretisedDensity<3,elemT> &current_image_estimate)
     error("QuadraticPrior: kappa image has not the same index range as the reconstructed image\n");
 
 
-  double result = 0.;
-  const int min_z = current_image_estimate.get_min_index(); 
-  const int max_z = current_image_estimate.get_max_index(); 
-  for (int z=min_z; z<=max_z; z++)
-    {
-      const int min_dz = max(weights.get_min_index(), min_z-z);
-      const int max_dz = min(weights.get_max_index(), max_z-z);
-        
-      const int min_y = current_image_estimate[z].get_min_index();
-      const int max_y = current_image_estimate[z].get_max_index();
-
-        for (int y=min_y;y<= max_y;y++)
-          {
-            const int min_dy = max(weights[0].get_min_index(), min_y-y);
-            const int max_dy = min(weights[0].get_max_index(), max_y-y);            
-
-            const int min_x = current_image_estimate[z][y].get_min_index(); 
-            const int max_x = current_image_estimate[z][y].get_max_index(); 
-
-            for (int x=min_x;x<= max_x;x++)       
-              {
-                const int min_dx = max(weights[0][0].get_min_index(), min_x-x);
-                const int max_dx = min(weights[0][0].get_max_index(), max_x-x);
-                
-                /* formula:
-                  sum_dx,dy,dz
-                   1/4 weights[dz][dy][dx] *
-                   (current_image_estimate[z][y][x] - current_image_estimate[z+dz][y+dy][x+dx])^2 *
-                   (*kappa_ptr)[z][y][x] * (*kappa_ptr)[z+dz][y+dy][x+dx];
-                */
-                for (int dz=min_dz;dz<=max_dz;++dz)
-                  for (int dy=min_dy;dy<=max_dy;++dy)
-                    for (int dx=min_dx;dx<=max_dx;++dx)
-                      {
-                        elemT current =
-                          weights[dz][dy][dx] *
-                          square(current_image_estimate[z][y][x] - current_image_estimate[z+dz][y+dy][x+dx])/4;
-
-                        if (do_kappa)
-                          current *= 
-                            (*kappa_ptr)[z][y][x] * (*kappa_ptr)[z+dz][y+dy][x+dx];
-
-                        result += static_cast<double>(current);
-                      }
-              }              
-          }
-    }
+  /* formula:
+     sum_dx,dy,dz
+       1/4 weights[dz][dy][dx] *
+       (current_image_estimate[z][y][x] - current_image_estimate[z+dz][y+dy][x+dx])^2 *
+       (*kappa_ptr)[z][y][x] * (*kappa_ptr)[z+dz][y+dy][x+dx];
+  */
+  // sum per plane first, such that the result does not depend on the number of threads
+  VectorWithOffset<double> plane_sums(current_image_estimate.get_min_index(),
+                                      current_image_estimate.get_max_index());
+  plane_sums.fill(0.);
+  detail::quadratic_prior_loop(current_image_estimate, kappa_ptr, this->weights,
+                               detail::QuadraticPriorValueTerm<elemT>(),
+                               detail::QuadraticPriorSumOutput<elemT>(plane_sums));
+  const double result = std::accumulate(plane_sums.begin(), plane_sums.end(), 0.);
   return result * this->penalisation_factor;
 }
 
@@ -309,101 +535,17 @@ compute_gradient(DiscretisedDensity<3,elemT>& prior_gradient,
   if (do_kappa && !kappa_ptr->has_same_characteristics(current_image_estimate))
     error("QuadraticPrior: kappa image has not the same index range as the reconstructed image\n");
 
-  const int min_z = current_image_estimate.get_min_index();  
-  const int max_z = current_image_estimate.get_max_index();  
-  for (int z=min_z; z<=max_z; z++) 
-    { 
-      const int min_dz = max(weights.get_min_index(), min_z-z); 
-      const int max_dz = min(weights.get_max_index(), max_z-z); 
-      
-      const int min_y = current_image_estimate[z].get_min_index(); 
-      const int max_y = current_image_estimate[z].get_max_index(); 
-      
-      for (int y=min_y;y<= max_y;y++) 
-        { 
-          const int min_dy = max(weights[0].get_min_index(), min_y-y); 
-          const int max_dy = min(weights[0].get_max_index(), max_y-y);             
-          
-          const int min_x = current_image_estimate[z][y].get_min_index();
-          const int max_x = current_image_estimate[z][y].get_max_index();  
-          
-          for (int x=min_x;x<= max_x;x++)
-            {
-              const int min_dx = max(weights[0][0].get_min_index(), min_x-x);
-              const int max_dx = min(weights[0][0].get_max_index(), max_x-x);
-                
-                /* formula:
-                  sum_dx,dy,dz
-                   weights[dz][dy][dx] *
-                   (current_image_estimate[z][y][x] - current_image_estimate[z+dz][y+dy][x+dx]) *
-                   (*kappa_ptr)[z][y][x] * (*kappa_ptr)[z+dz][y+dy][x+dx];
-                */
-#if 1
-                elemT gradient = 0;
-                for (int dz=min_dz;dz<=max_dz;++dz)
-                  for (int dy=min_dy;dy<=max_dy;++dy)
-                    for (int dx=min_dx;dx<=max_dx;++dx)
-                      {
-                        elemT current =
-                          weights[dz][dy][dx] *
-                          (current_image_estimate[z][y][x] - current_image_estimate[z+dz][y+dy][x+dx]);
-
-                        if (do_kappa)
-                          current *= 
-                            (*kappa_ptr)[z][y][x] * (*kappa_ptr)[z+dz][y+dy][x+dx];
-
-                        gradient += current;
-                      }
-#else
-                // attempt to speed up by precomputing the sum of weights.
-                // The current code gives identical results but is actually slower
-                // than the above, at least when kappas are present.
-
-
-                // precompute sum of weights
-                // TODO without kappas, this is just weights.sum() most of the time, 
-                // but not near edges
-                float sum_of_weights = 0;
-                {
-                  if (do_kappa)
-                    {                
-                      for (int dz=min_dz;dz<=max_dz;++dz)
-                        for (int dy=min_dy;dy<=max_dy;++dy)
-                          for (int dx=min_dx;dx<=max_dx;++dx)
-                            sum_of_weights +=  weights[dz][dy][dx]*(*kappa_ptr)[z+dz][y+dy][x+dx];
-                    }
-                  else
-                    {
-                      for (int dz=min_dz;dz<=max_dz;++dz)
-                        for (int dy=min_dy;dy<=max_dy;++dy)
-                          for (int dx=min_dx;dx<=max_dx;++dx)
-                            sum_of_weights +=  weights[dz][dy][dx];
-                    }
-                }
-                // now compute contribution of central term
-                elemT gradient = sum_of_weights * current_image_estimate[z][y][x] ;
-
-                // subtract the rest
-                for (int dz=min_dz;dz<=max_dz;++dz)
-                  for (int dy=min_dy;dy<=max_dy;++dy)
-                    for (int dx=min_dx;dx<=max_dx;++dx)
-                      {
-                        elemT current =
-                          weights[dz][dy][dx] * current_image_estimate[z+dz][y+dy][x+dx];
-
-                        if (do_kappa)
-                          current *= (*kappa_ptr)[z+dz][y+dy][x+dx];
-
-                        gradient -= current;
-                      }
-                // multiply with central kappa
-                if (do_kappa)
-                  gradient *= (*kappa_ptr)[z][y][x];
-#endif
-                prior_gradient[z][y][x]= gradient * this->penalisation_factor;
-              }              
-          }
-    }
+  /* formula:
+     sum_dx,dy,dz
+       weights[dz][dy][dx] *
+       (current_image_estimate[z][y][x] - current_image_estimate[z+dz][y+dy][x+dx]) *
+       (*kappa_ptr)[z][y][x] * (*kappa_ptr)[z+dz][y+dy][x+dx];
+  */
+  detail::quadratic_prior_loop(current_image_estimate, kappa_ptr, this->weights,
+                               detail::QuadraticPriorGradientTerm<elemT>(),
+                               detail::QuadraticPriorImageOutput<elemT>(prior_gradient,
+                                                                        this->penalisation_factor,
+                                                                        /* add = */ false));
 
   info(boost::format("Prior gradient max %1%, min %2%\n") % prior_gradient.find_max() % prior_gradient.find_min());
 
@@ -509,48 +651,11 @@ QuadraticPrior<elemT>::parabolic_surrogate_curvature(DiscretisedDensity<3,elemT>
   if (do_kappa && !kappa_ptr->has_same_characteristics(current_image_estimate))
     error("QuadraticPrior: kappa image has not the same index range as the reconstructed image\n");
 
-  const int min_z = current_image_estimate.get_min_index();   
-  const int max_z = current_image_estimate.get_max_index();   
-  for (int z=min_z; z<=max_z; z++)  
-    {  
-      const int min_dz = max(weights.get_min_index(), min_z-z);  
-      const int max_dz = min(weights.get_max_index(), max_z-z);  
-       
-      const int min_y = current_image_estimate[z].get_min_index();  
-      const int max_y = current_image_estimate[z].get_max_index();  
-       
-      for (int y=min_y;y<= max_y;y++)  
-        {  
-          const int min_dy = max(weights[0].get_min_index(), min_y-y);  
-          const int max_dy = min(weights[0].get_max_index(), max_y-y);              
-           
-          const int min_x = current_image_estimate[z][y].get_min_index(); 
-          const int max_x = current_image_estimate[z][y].get_max_index();   
-          for (int x=min_x;x<= max_x;x++) 
-            { 
-              const int min_dx = max(weights[0][0].get_min_index(), min_x-x); 
-              const int max_dx = min(weights[0][0].get_max_index(), max_x-x); 
-                
-                elemT gradient = 0;
-                for (int dz=min_dz;dz<=max_dz;++dz)
-                  for (int dy=min_dy;dy<=max_dy;++dy)
-                    for (int dx=min_dx;dx<=max_dx;++dx)
-                      {
-                        // 1 comes from omega = psi'(t)/t = 2*t/2t =1                  
-                        elemT current =
-                          weights[dz][dy][dx] *1;
-
-                         if (do_kappa)
-                          current *= 
-                            (*kappa_ptr)[z][y][x] * (*kappa_ptr)[z+dz][y+dy][x+dx];
-
-                        gradient += current;
-                      }
-                
-                parabolic_surrogate_curvature[z][y][x]= gradient * this->penalisation_factor;
-              }              
-          }
-    }
+  detail::quadratic_prior_loop(current_image_estimate, kappa_ptr, this->weights,
+                               detail::QuadraticPriorCurvatureTerm<elemT>(),
+                               detail::QuadraticPriorImageOutput<elemT>(parabolic_surrogate_curvature,
+                                                                        this->penalisation_factor,
+                                                                        /* add = */ false));
 
   info(boost::format("parabolic_surrogate_curvature max %1%, min %2%\n") % parabolic_surrogate_curvature.find_max() % parabolic_surrogate_curvature.find_min());
   /*{
@@ -568,7 +673,7 @@ QuadraticPrior<elemT>::
 add_multiplication_with_approximate_Hessian(DiscretisedDensity<3,elemT>& output,
                                             const DiscretisedDensity<3,elemT>& input) const
 {
-  // TODO this function overlaps enormously with parabolic_surrogate_curvature
+  // note: this function uses the same loops as parabolic_surrogate_curvature,
   // the only difference is that parabolic_surrogate_curvature uses input==1
 
   assert( output.has_same_characteristics(input));  
@@ -590,47 +695,11 @@ add_multiplication_with_approximate_Hessian(DiscretisedDensity<3,elemT>& output,
   if (do_kappa && !kappa_ptr->has_same_characteristics(input))
     error("QuadraticPrior: kappa image has not the same index range as the reconstructed image\n");
 
-  const int min_z = output.get_min_index();   
-  const int max_z = output.get_max_index();   
-  for (int z=min_z; z<=max_z; z++)  
-    {  
-      const int min_dz = max(weights.get_min_index(), min_z-z);  
-      const int max_dz = min(weights.get_max_index(), max_z-z);  
-      
-      const int min_y = output[z].get_min_index();  
-      const int max_y = output[z].get_max_index();  
-       
-      for (int y=min_y;y<= max_y;y++)  
-        {  
-          const int min_dy = max(weights[0].get_min_index(), min_y-y);  
-          const int max_dy = min(weights[0].get_max_index(), max_y-y);              
-           
-          const int min_x = output[z][y].get_min_index(); 
-          const int max_x = output[z][y].get_max_index();   
-
-          for (int x=min_x;x<= max_x;x++) 
-            { 
-              const int min_dx = max(weights[0][0].get_min_index(), min_x-x); 
-              const int max_dx = min(weights[0][0].get_max_index(), max_x-x); 
-                
-                elemT result = 0;
-                for (int dz=min_dz;dz<=max_dz;++dz)
-                  for (int dy=min_dy;dy<=max_dy;++dy)
-                    for (int dx=min_dx;dx<=max_dx;++dx)
-                      {
-                        elemT current =
-                          weights[dz][dy][dx] * input[z+dz][y+dy][x+dx];
-
-                         if (do_kappa)
-                          current *= 
-                            (*kappa_ptr)[z][y][x] * (*kappa_ptr)[z+dz][y+dy][x+dx];
-                         result += current;
-                      }
-                
-                output[z][y][x] += result * this->penalisation_factor;
-            }              
-        }
-    }
+  detail::quadratic_prior_loop(input, kappa_ptr, this->weights,
+                               detail::QuadraticPriorHessianTerm<elemT>(),
+                               detail::QuadraticPriorImageOutput<elemT>(output,
+                                                                        this->penalisation_factor,
+                                                                        /* add = */ true));
   return Succeeded::yes;
 }
 
@@ -32,7 +32,11 @@
 #include <iostream>
 #include <stdlib.h>
 #include <string>
+#include <vector>
 #include <math.h>
+#ifdef STIR_OPENMP
+#include <omp.h>
+#endif
 
 namespace SPECTUB {
 
@@ -51,11 +55,21 @@ namespace SPECTUB {
 #define REF_DIST 5.    //reference distance for fanbeam PSF
 
 using namespace std;
+
+//! element of the weight matrix, as computed by a thread in wm_calculation
+typedef struct
+{
+	int jp;     // row index of the weight matrix
+	int col;    // column index (volume index of the voxel)
+	float val;  // weight
+} wm_element_type;
+
 //==========================================================================
 //=== wm_calculation =======================================================
 //==========================================================================
 
-void wm_calculation( const int kOS,
+void wm_calculation( wm_da_type& wm,
+					const int kOS,
 					const angle_type *const ang, 
 					voxel_type vox, 
 				        bin_type bin, 
@@ -68,11 +82,56 @@ void wm_calculation( const int kOS,
 					const discrf_type *const gaussdens,
 		     const int *const  NITEMS)
 {
+	//... angle indices of the projections in this subset (see wmh.index) .........
+	
+	const int * const index = prj.order + kOS * prj.NangOS;
 	
+	//... to fill projection indices for STIR format .............................
+	
+	if ( wm.do_save_STIR ){ 
+		
+		int jp = -1;										// projection index (row index of the weight matrix )
+		int j1;
+		
+		for ( int j = 0 ; j < prj.NangOS ; j++ ){
+			
+			j1 = index[ j ];			
+			
+			for ( int k = 0 ; k < prj.Nsli ; k++ ){
+				
+				for ( int i = 0 ; i < prj.Nbin ; i++){
+					
+					jp++;
+					wm.na[ jp ] = j1;
+					wm.nb[ jp ] = i - (int)prj.Nbind2;
+					wm.ns[ jp ] = k;
+				}
+			}
+		}
+	}	
+	
+	//... elements computed by threads other than thread 0 ..............................
+	// Image rows are distributed over the threads in contiguous blocks (in order of
+	// the thread number). Thread 0 stores its weights directly in wm, the other threads
+	// in a list which is appended to wm after the loop, such that the elements of every
+	// row of wm are in the same order as in the serial code.
+	
+	std::vector< std::vector<wm_element_type> > thread_elements;
+	
+#ifdef STIR_OPENMP
+#pragma omp parallel firstprivate(vox, bin) shared(thread_elements)
+#endif
+  {
 	float weight;
 	float coeff_att = (float) 1.;
 	int   jp;
 	float eff;
+	int thread_num = 0;
+#ifdef STIR_OPENMP
+	thread_num = omp_get_thread_num();
+#pragma omp single
+	thread_elements.resize( omp_get_num_threads() );
+#endif
     
     //... variables for geometric component ..............................................
 	
@@ -120,36 +179,16 @@ void wm_calculation( const int kOS,
 		}
 	}
 	
-	//... to fill projection indices for STIR format .............................
-	
-	if ( wm.do_save_STIR ){ 
-		
-		jp = -1;											// projection index (row index of the weight matrix )
-		int j1;
-		
-		for ( int j = 0 ; j < prj.NangOS ; j++ ){
-			
-			j1 = wmh.index[ j ];			
-			
-			for ( int k = 0 ; k < prj.Nsli ; k++ ){
-				
-				for ( int i = 0 ; i < prj.Nbin ; i++){
-					
-					jp++;
-					wm.na[ jp ] = j1;
-					wm.nb[ jp ] = i - (int)prj.Nbind2;
-					wm.ns[ jp ] = k;
-				}
-			}
-		}
-	}	
-	
 	//=== LOOP1: IMAGE ROWS =======================================================================
 	
-	for ( vox.irow = 0 ; vox.irow < vol.Nrow ; vox.irow++ ){
+#ifdef STIR_OPENMP
+#pragma omp for schedule(static)
+#endif
+	for ( int irow = 0 ; irow < vol.Nrow ; irow++ ){
 		
                 //cout << "weights: " << 100.*(vox.irow+1)/vol.Nrow << "%" << endl;
 		
+		vox.irow = irow;
 		vox.y = vol.y0 + vox.irow * vol.szcm ;       // y coordinate of the voxel (index 0->Nrow-1: irow)
 		
 		//=== LOOP2: IMAGE COLUMNS =================================================================
@@ -170,7 +209,7 @@ void wm_calculation( const int kOS,
 			
 			for( int k = 0 ; k < prj.NangOS ; k++ ){
 				
-				int ka = wmh.index[ k ];			// angle index of the current projection (considering the whole set of projections)
+				int ka = index[ k ];			// angle index of the current projection (considering the whole set of projections)
 						
 				//... perpendicular distance form voxel to detection plane ...........................
 				
@@ -262,21 +301,22 @@ void wm_calculation( const int kOS,
 						
 						weight = psf.val[ ie ] * eff * coeff_att ;
                         
-                        //... fill image STIR indices ...........................
-						
-                        if ( wm.do_save_STIR ){
-							wm.nx[ vox.iv ] = (short int)( vox.icol - (int) floor( vol.Ncold2 ) );  // centered index for STIR format
-							wm.ny[ vox.iv ] = (short int)( vox.irow - (int) floor( vol.Nrowd2 ) );  // centered index for STIR format
-							wm.nz[ vox.iv ] = (short int)  vox.islc ;                               // non-centered index for STIR format
-						}
-                        
                         //... fill wm values .....................
                         
-						wm.col[ jp ][ wm.ne[ jp ] ] = vox.iv;
-						wm.val[ jp ][ wm.ne[ jp ] ] = weight;
-						wm.ne[ jp ]++;
+						if ( thread_num == 0 ){
+							wm.col[ jp ][ wm.ne[ jp ] ] = vox.iv;
+							wm.val[ jp ][ wm.ne[ jp ] ] = weight;
+							wm.ne[ jp ]++;
 						
-						if ( wm.ne[ jp ] >= NITEMS[ jp ] ) error_weight3d(45, "" );
+							if ( wm.ne[ jp ] >= NITEMS[ jp ] ) error_weight3d(45, "" );
+						}
+						else{
+							wm_element_type elem;
+							elem.jp  = jp;
+							elem.col = vox.iv;
+							elem.val = weight;
+							thread_elements[ thread_num ].push_back( elem );
+						}
 					}   
 				}                    // end of LOOP4: image slices
 			}                        // end of LOOP3: projection angle into subset
@@ -297,13 +337,30 @@ void wm_calculation( const int kOS,
 	delete [] psf.ib;
 	delete [] psf.jb;
 	
-	if ( wmh.do_att ){
+	if ( wmh.do_att || wmh.do_msk_att ){
 		for ( int i = 0 ; i < sizeattpth ; i++ ){
 			delete [] attpth[ i ].dl;
 			delete [] attpth[ i ].iv;
 		}
 		delete [] attpth;
 	}
+  } // end of parallel section
+	
+	//... to append the elements of the other threads (in order of the thread number) ......
+	
+	for ( std::size_t t = 1 ; t < thread_elements.size() ; t++ ){
+		
+		for ( std::size_t i = 0 ; i < thread_elements[ t ].size() ; i++ ){
+			
+			const wm_element_type& elem = thread_elements[ t ][ i ];
+			
+			wm.col[ elem.jp ][ wm.ne[ elem.jp ] ] = elem.col;
+			wm.val[ elem.jp ][ wm.ne[ elem.jp ] ] = elem.val;
+			wm.ne[ elem.jp ]++;
+			
+			if ( wm.ne[ elem.jp ] >= NITEMS[ elem.jp ] ) error_weight3d(45, "" );
+		}
+	}
 }
 
 
@@ -161,6 +161,23 @@ zero_end_sinograms(ViewgramsPtr viewgrams_ptr)
     }
 }
 
+// reads related viewgrams from proj_data (without any locking)
+static
+void read_related_viewgrams(shared_ptr<RelatedViewgrams<float> >& viewgrams_sptr,
+                            const ProjData& proj_data,
+                            const shared_ptr<DataSymmetriesForViewSegmentNumbers>& symmetries_ptr,
+                            const ViewSegmentNumbers& view_segment_num)
+{
+#if !defined(_MSC_VER) || _MSC_VER>1300
+  viewgrams_sptr.reset(new RelatedViewgrams<float>
+                       (proj_data.get_related_viewgrams(view_segment_num, symmetries_ptr)));
+#else
+  // workaround VC++ 6.0 bug
+  RelatedViewgrams<float> tmp(proj_data.get_related_viewgrams(view_segment_num, symmetries_ptr));
+  viewgrams_sptr.reset(new RelatedViewgrams<float>(tmp));
+#endif        
+}
+
 static
 void get_viewgrams(shared_ptr<RelatedViewgrams<float> >& y,
                    shared_ptr<RelatedViewgrams<float> >& additive_binwise_correction_viewgrams,
@@ -173,45 +190,59 @@ void get_viewgrams(shared_ptr<RelatedViewgrams<float> >& y,
                    const double start_time_of_frame,
                    const double end_time_of_frame,
                    const shared_ptr<DataSymmetriesForViewSegmentNumbers>& symmetries_ptr,
-                   const ViewSegmentNumbers& view_segment_num
+                   const ViewSegmentNumbers& view_segment_num,
+                   double& reading_time,
+                   double& normalisation_time
                    )
 {
+  HighResWallClockTimer timer;
+  timer.start();
+  // Note: with OpenMP, we only need to serialise reading if the ProjData object is not thread-safe
+  // (only ProjDataFromMappedFile is, see read_interfile_PDFS()).
+  // We use different critical sections for the different objects, such that
+  // threads can read from them at the same time.
+  // Reading is not prefetched: a thread reads its viewgrams and then processes them,
+  // so it only overlaps with the processing done by other threads.
   if (!is_null_ptr(binwise_correction)) 
     {
 #ifdef STIR_OPENMP
+      if (binwise_correction->is_thread_safe_for_reading())
+        read_related_viewgrams(additive_binwise_correction_viewgrams, *binwise_correction,
+                               symmetries_ptr, view_segment_num);
+      else
+        {
 #pragma omp critical(ADDSINO)
-#endif
-#if !defined(_MSC_VER) || _MSC_VER>1300
-      additive_binwise_correction_viewgrams.reset(
-        new RelatedViewgrams<float>
-        (binwise_correction->get_related_viewgrams(view_segment_num, symmetries_ptr)));
+          read_related_viewgrams(additive_binwise_correction_viewgrams, *binwise_correction,
+                                 symmetries_ptr, view_segment_num);
+        }
 #else
-      RelatedViewgrams<float> tmp(binwise_correction->
-                                  get_related_viewgrams(view_segment_num, symmetries_ptr));
-      additive_binwise_correction_viewgrams.reset(new RelatedViewgrams<float>(tmp));
-#endif      
+      read_related_viewgrams(additive_binwise_correction_viewgrams, *binwise_correction,
+                             symmetries_ptr, view_segment_num);
+#endif
     }
                         
   if (read_from_proj_dat)
     {
 #ifdef STIR_OPENMP
+      if (proj_dat_ptr->is_thread_safe_for_reading())
+        read_related_viewgrams(y, *proj_dat_ptr, symmetries_ptr, view_segment_num);
+      else
+        {
 #pragma omp critical(VIEW)
-#endif
-#if !defined(_MSC_VER) || _MSC_VER>1300
-      y.reset(new RelatedViewgrams<float>
-	      (proj_dat_ptr->get_related_viewgrams(view_segment_num, symmetries_ptr)));
+          read_related_viewgrams(y, *proj_dat_ptr, symmetries_ptr, view_segment_num);
+        }
 #else
-      // workaround VC++ 6.0 bug
-      RelatedViewgrams<float> tmp(proj_dat_ptr->
-                                  get_related_viewgrams(view_segment_num, symmetries_ptr));
-      y.reset(new RelatedViewgrams<float>(tmp));
-#endif        
+      read_related_viewgrams(y, *proj_dat_ptr, symmetries_ptr, view_segment_num);
+#endif
     }
   else
     {
       y.reset(new RelatedViewgrams<float>
 	      (proj_dat_ptr->get_empty_related_viewgrams(view_segment_num, symmetries_ptr)));
     }
+  timer.stop();
+  reading_time = timer.value();
+  normalisation_time = 0.;
 
   // multiplicative correction
   if (!is_null_ptr(normalisation_sptr) && !normalisation_sptr->is_trivial())
@@ -219,10 +250,14 @@ void get_viewgrams(shared_ptr<RelatedViewgrams<float> >& y,
       mult_viewgrams_sptr.reset(
 				new RelatedViewgrams<float>(proj_dat_ptr->get_empty_related_viewgrams(view_segment_num, symmetries_ptr)));
       mult_viewgrams_sptr->fill(1.F);
+      timer.start(true);
+      // some normalisations read projection data or forward project, which is not thread-safe
 #ifdef STIR_OPENMP
 #pragma omp critical(MULT)
 #endif
       normalisation_sptr->undo(*mult_viewgrams_sptr,start_time_of_frame,end_time_of_frame);
+      timer.stop();
+      normalisation_time = timer.value();
     }
                         
   if (view_segment_num.segment_num()==0 && zero_seg0_end_planes)
@@ -294,7 +329,8 @@ void distributable_computation(
                                const double start_time_of_frame,
                                const double end_time_of_frame,
                                RPC_process_related_viewgrams_type * RPC_process_related_viewgrams,
-                               DistributedCachingInformation* caching_info_ptr)
+                               DistributedCachingInformation* caching_info_ptr,
+                               DistributableComputationTimings* timings_ptr)
 
 {
 #ifdef STIR_MPI 
@@ -431,13 +467,32 @@ void distributable_computation(
         shared_ptr<RelatedViewgrams<float> > y;
         shared_ptr<RelatedViewgrams<float> > additive_binwise_correction_viewgrams;
         shared_ptr<RelatedViewgrams<float> > mult_viewgrams_sptr;
+        double reading_time, normalisation_time;
 
         get_viewgrams(y, additive_binwise_correction_viewgrams, mult_viewgrams_sptr,
                       proj_dat_ptr, read_from_proj_dat,
                       zero_seg0_end_planes,
                       binwise_correction,
                       normalisation_sptr, start_time_of_frame, end_time_of_frame,
-                      symmetries_ptr, view_segment_num);
+                      symmetries_ptr, view_segment_num,
+                      reading_time, normalisation_time);
+        if (timings_ptr != NULL)
+          {
+            const double num_bins =
+              static_cast<double>(y->get_num_viewgrams())*y->get_num_axial_poss()*y->get_num_tangential_poss();
+#ifdef STIR_OPENMP
+#pragma omp atomic
+#endif
+            timings_ptr->reading_time += reading_time;
+#ifdef STIR_OPENMP
+#pragma omp atomic
+#endif
+            timings_ptr->normalisation_time += normalisation_time;
+#ifdef STIR_OPENMP
+#pragma omp atomic
+#endif
+            timings_ptr->num_bins += num_bins;
+          }
 #ifdef STIR_MPI     
 
           //send viewgrams, the slave will immediatelly start calculation
@@ -472,6 +527,8 @@ void distributable_computation(
           info(boost::format("calculating segment_num: %d, view_num: %d")
                % view_segment_num.segment_num() % view_segment_num.view_num());
 #endif
+          HighResWallClockTimer processing_timer;
+          processing_timer.start();
 #ifdef STIR_OPENMP
           if (output_image_ptr != NULL)
             {
@@ -494,6 +551,15 @@ void distributable_computation(
                                         additive_binwise_correction_viewgrams.get(),
                                         mult_viewgrams_sptr.get());
 #endif // OPENMP                                    
+          processing_timer.stop();
+          if (timings_ptr != NULL)
+            {
+              const double processing_time = processing_timer.value();
+#ifdef STIR_OPENMP
+#pragma omp atomic
+#endif
+              timings_ptr->processing_time += processing_time;
+            }
 #endif // MPI
       } // end of for-loop 
   } // end of parallel section of openmp
@@ -571,6 +637,8 @@ void distributable_computation(
 
   CPU_timer.stop();
   wall_clock_timer.stop();
+  if (timings_ptr != NULL)
+    timings_ptr->total_time += wall_clock_timer.value();
   info(boost::format("Computation times for distributable_computation, CPU %1%s, wall-clock %2%s") 
        % CPU_timer.value() % wall_clock_timer.value());
 }
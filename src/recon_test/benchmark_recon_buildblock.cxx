@@ -0,0 +1,648 @@
+/*
+    Copyright (C) 2026, STIR contributors
+    This file is part of STIR.
+
+    This file is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.
+
+    This file is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    See STIR/LICENSE.txt for details
+*/
+/*!
+  \file
+  \ingroup recontest
+  \brief Performance benchmarks for projectors, priors, projection data I/O and
+  list mode binning
+
+  \author STIR contributors
+
+  This program times a number of computationally intensive parts of STIR
+  on synthetic data (i.e. it does not need any input files) such that the
+  effect of changes to these parts can be measured in a reproducible way.
+
+  \par Usage
+  \verbatim
+  benchmark_recon_buildblock [--sizes small,medium,large] [--threads 1,2,4]  \
+       [--repeats 3] [--num-events 5000000] [--lm-par LmToProjData.par] \
+       [benchmark_name ...]
+  \endverbatim
+  Without benchmark names, all benchmarks are run. Available benchmarks are
+  <ul>
+  <li> \c forward_ray_tracing: ForwardProjectorByBinUsingRayTracing
+  <li> \c back_interpolation: BackProjectorByBinUsingInterpolation
+  <li> \c forward_matrix_no_cache: ForwardProjectorByBinUsingProjMatrixByBin with
+       ProjMatrixByBinUsingRayTracing, caching disabled
+  <li> \c forward_matrix_cached: as above, but with caching enabled (the cache is
+       filled before timing)
+  <li> \c quadratic_prior_gradient: QuadraticPrior::compute_gradient()
+  <li> \c projdata_stream_read: reading all viewgrams via ProjDataFromStream
+  <li> \c projdata_read: reading all viewgrams via ProjDataFromMappedFile
+  <li> \c lm_binning: LmToProjData::process_data() on a synthetic list mode file
+       in the ECAT8 32-bit format with uniformly distributed, random events
+  <li> \c lm_to_projdata: LmToProjData::process_data(), only run when a
+       parameter file is given with \c --lm-par
+  </ul>
+  Sizes correspond to different scanners with different span and mashing:
+  \c small is an ECAT 953, \c medium an ECAT HR+ (962) and \c large an ECAT
+  HR++ (966). Default sizes are \c small and \c medium.
+
+  Every benchmark is run \c repeats times and the shortest (wall-clock) time is
+  reported. Benchmarks which are multi-threaded (when STIR is compiled with OpenMP)
+  are run for each thread count (default: 1, 2, 4, ... up to get_default_num_threads()),
+  and the speed-up with respect to the first thread count is reported.
+
+  Output is a table on stdout, one line per benchmark, size and thread count.
+*/
+
+#include "stir/recon_buildblock/ForwardProjectorByBinUsingRayTracing.h"
+#include "stir/recon_buildblock/BackProjectorByBinUsingInterpolation.h"
+#include "stir/recon_buildblock/ForwardProjectorByBinUsingProjMatrixByBin.h"
+#include "stir/recon_buildblock/ProjMatrixByBinUsingRayTracing.h"
+#include "stir/recon_buildblock/QuadraticPrior.h"
+#include "stir/listmode/LmToProjData.h"
+#include "stir/ProjDataInfoCylindricalNoArcCorr.h"
+#include "stir/ProjDataInMemory.h"
+#include "stir/ProjDataInterfile.h"
+#include "stir/ProjDataFromMappedFile.h"
+#include "stir/IO/interfile.h"
+#include "stir/SegmentByView.h"
+#include "stir/Viewgram.h"
+#include "stir/VoxelsOnCartesianGrid.h"
+#include "stir/ExamInfo.h"
+#include "stir/Scanner.h"
+#include "stir/HighResWallClockTimer.h"
+#include "stir/num_threads.h"
+#include "stir/is_null_ptr.h"
+#include "stir/Succeeded.h"
+#include "stir/error.h"
+#include <boost/format.hpp>
+#include <iostream>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifndef STIR_NO_NAMESPACES
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+#endif
+
+USING_NAMESPACE_STIR
+
+namespace {
+
+//! description of the synthetic geometry used for a benchmark
+struct BenchmarkSize
+{
+  const char * name;
+  Scanner::Type scanner_type;
+  int span;
+  int max_delta;
+  int view_mashing_factor;
+};
+
+const BenchmarkSize benchmark_sizes[] =
+  {
+    { "small", Scanner::E953, 3, 7, 2 },
+    { "medium", Scanner::E962, 9, 22, 2 },
+    { "large", Scanner::E966, 9, 31, 1 }
+  };
+const int num_benchmark_sizes = sizeof(benchmark_sizes)/sizeof(benchmark_sizes[0]);
+
+const char * const benchmark_names[] =
+  {
+    "forward_ray_tracing",
+    "back_interpolation",
+    "forward_matrix_no_cache",
+    "forward_matrix_cached",
+    "quadratic_prior_gradient",
+    "projdata_stream_read",
+    "projdata_read",
+    "lm_binning",
+    "lm_to_projdata"
+  };
+const int num_benchmark_names = sizeof(benchmark_names)/sizeof(benchmark_names[0]);
+
+//! data that is shared between the benchmarks for one size
+struct BenchmarkData
+{
+  shared_ptr<ExamInfo> exam_info_sptr;
+  shared_ptr<ProjDataInfo> proj_data_info_sptr;
+  shared_ptr<DiscretisedDensity<3,float> > image_sptr;
+  shared_ptr<ProjData> proj_data_sptr;
+};
+
+//! result of a single benchmark run
+struct BenchmarkResult
+{
+  double time;
+  double work;
+};
+
+//! a benchmark is a function that does its work and returns the amount of work done
+/*! It has to start and stop the timer itself, such that set-up can be excluded. */
+typedef double (*BenchmarkFunction)(BenchmarkData&, HighResWallClockTimer&);
+
+void usage(const char * const program_name)
+{
+  cerr << "Usage:\n" << program_name
+       << " [--sizes small,medium,large] [--threads 1,2,4] [--repeats 3] \\\n"
+       << "      [--num-events 5000000] [--lm-par LmToProjData.par] [benchmark_name ...]\n"
+       << "Available benchmarks:\n";
+  for (int i=0; i<num_benchmark_names; ++i)
+    cerr << "   " << benchmark_names[i] << '\n';
+  cerr << "Available sizes:\n";
+  for (int i=0; i<num_benchmark_sizes; ++i)
+    cerr << "   " << benchmark_sizes[i].name << '\n';
+}
+
+vector<string> split_at_commas(const string& str)
+{
+  vector<string> result;
+  string::size_type start = 0;
+  while (start <= str.size())
+    {
+      const string::size_type end = std::min(str.find(',', start), str.size());
+      if (end > start)
+        result.push_back(str.substr(start, end-start));
+      start = end + 1;
+    }
+  return result;
+}
+
+double get_num_bins(const ProjDataInfo& proj_data_info)
+{
+  double num_bins = 0;
+  for (int segment_num=proj_data_info.get_min_segment_num();
+       segment_num<=proj_data_info.get_max_segment_num();
+       ++segment_num)
+    num_bins +=
+      static_cast<double>(proj_data_info.get_num_axial_poss(segment_num)) *
+      proj_data_info.get_num_views() * proj_data_info.get_num_tangential_poss();
+  return num_bins;
+}
+
+void set_up_benchmark_data(BenchmarkData& data, const BenchmarkSize& size)
+{
+  shared_ptr<Scanner> scanner_sptr(new Scanner(size.scanner_type));
+  data.exam_info_sptr.reset(new ExamInfo);
+  data.proj_data_info_sptr.reset
+    (ProjDataInfo::ProjDataInfoCTI(scanner_sptr, size.span, size.max_delta,
+                                   scanner_sptr->get_num_detectors_per_ring()/2/size.view_mashing_factor,
+                                   scanner_sptr->get_max_num_non_arccorrected_bins(),
+                                   /* arc_corrected = */ false));
+  VoxelsOnCartesianGrid<float> * image_ptr =
+    new VoxelsOnCartesianGrid<float>(*data.proj_data_info_sptr);
+  data.image_sptr.reset(image_ptr);
+  // fill a cylinder that covers most of the FOV
+  const float radius_squared =
+    square(image_ptr->get_max_x() * .8F);
+  for (int z=image_ptr->get_min_z(); z<=image_ptr->get_max_z(); ++z)
+    for (int y=image_ptr->get_min_y(); y<=image_ptr->get_max_y(); ++y)
+      for (int x=image_ptr->get_min_x(); x<=image_ptr->get_max_x(); ++x)
+        (*image_ptr)[z][y][x] = x*x + y*y < radius_squared ? 1.F : 0.F;
+
+  // fill the projection data by forward projection
+  data.proj_data_sptr.reset(new ProjDataInMemory(data.exam_info_sptr, data.proj_data_info_sptr));
+  ForwardProjectorByBinUsingRayTracing forward_projector;
+  forward_projector.set_up(data.proj_data_info_sptr, data.image_sptr);
+  forward_projector.forward_project(*data.proj_data_sptr, *data.image_sptr);
+}
+
+/******************** the benchmarks *********************************/
+
+double forward_ray_tracing(BenchmarkData& data, HighResWallClockTimer& timer)
+{
+  ForwardProjectorByBinUsingRayTracing forward_projector;
+  forward_projector.set_up(data.proj_data_info_sptr, data.image_sptr);
+  ProjDataInMemory output(data.exam_info_sptr, data.proj_data_info_sptr);
+  timer.start();
+  forward_projector.forward_project(output, *data.image_sptr);
+  timer.stop();
+  return get_num_bins(*data.proj_data_info_sptr);
+}
+
+double back_interpolation(BenchmarkData& data, HighResWallClockTimer& timer)
+{
+  BackProjectorByBinUsingInterpolation back_projector;
+  back_projector.set_up(data.proj_data_info_sptr, data.image_sptr);
+  shared_ptr<DiscretisedDensity<3,float> > output_sptr(data.image_sptr->get_empty_copy());
+  timer.start();
+  back_projector.back_project(*output_sptr, *data.proj_data_sptr);
+  timer.stop();
+  return get_num_bins(*data.proj_data_info_sptr);
+}
+
+double forward_matrix(BenchmarkData& data, HighResWallClockTimer& timer, const bool use_cache)
+{
+  shared_ptr<ProjMatrixByBin> proj_matrix_sptr(new ProjMatrixByBinUsingRayTracing);
+  proj_matrix_sptr->enable_cache(use_cache);
+  ForwardProjectorByBinUsingProjMatrixByBin forward_projector(proj_matrix_sptr);
+  forward_projector.set_up(data.proj_data_info_sptr, data.image_sptr);
+  ProjDataInMemory output(data.exam_info_sptr, data.proj_data_info_sptr);
+  if (use_cache)
+    {
+      // fill the cache (not timed)
+      forward_projector.forward_project(output, *data.image_sptr);
+    }
+  timer.start();
+  forward_projector.forward_project(output, *data.image_sptr);
+  timer.stop();
+  return get_num_bins(*data.proj_data_info_sptr);
+}
+
+double forward_matrix_no_cache(BenchmarkData& data, HighResWallClockTimer& timer)
+{
+  return forward_matrix(data, timer, false);
+}
+
+double forward_matrix_cached(BenchmarkData& data, HighResWallClockTimer& timer)
+{
+  return forward_matrix(data, timer, true);
+}
+
+double quadratic_prior_gradient(BenchmarkData& data, HighResWallClockTimer& timer)
+{
+  QuadraticPrior<float> prior(/* only_2D = */ false, /* penalisation_factor = */ 1.F);
+  shared_ptr<DiscretisedDensity<3,float> > gradient_sptr(data.image_sptr->get_empty_copy());
+  timer.start();
+  prior.compute_gradient(*gradient_sptr, *data.image_sptr);
+  timer.stop();
+  return static_cast<double>(data.image_sptr->size_all());
+}
+
+const char * const tmp_projdata_filename = "benchmark_recon_buildblock_tmp.hs";
+const char * const tmp_projdata_data_filename = "benchmark_recon_buildblock_tmp.s";
+
+void write_tmp_projdata(BenchmarkData& data)
+{
+  ProjDataInterfile proj_data(data.exam_info_sptr, data.proj_data_info_sptr, tmp_projdata_filename);
+  for (int segment_num=proj_data.get_min_segment_num(); segment_num<=proj_data.get_max_segment_num(); ++segment_num)
+    if (proj_data.set_segment(data.proj_data_sptr->get_segment_by_view(segment_num)) == Succeeded::no)
+      error("Error writing temporary projection data");
+}
+
+void remove_tmp_projdata()
+{
+  std::remove(tmp_projdata_filename);
+  std::remove(tmp_projdata_data_filename);
+}
+
+double read_all_viewgrams(const ProjData& proj_data, HighResWallClockTimer& timer)
+{
+  // use a checksum to avoid the compiler optimising the reading away
+  double sum = 0;
+  timer.start();
+  for (int segment_num=proj_data.get_min_segment_num(); segment_num<=proj_data.get_max_segment_num(); ++segment_num)
+    {
+      const int min_view_num = proj_data.get_min_view_num();
+      const int max_view_num = proj_data.get_max_view_num();
+      if (proj_data.is_thread_safe_for_reading())
+        {
+#ifdef STIR_OPENMP
+#pragma omp parallel for schedule(runtime) reduction(+:sum)
+#endif
+          for (int view_num=min_view_num; view_num<=max_view_num; ++view_num)
+            sum += proj_data.get_viewgram(view_num, segment_num).sum();
+        }
+      else
+        {
+          for (int view_num=min_view_num; view_num<=max_view_num; ++view_num)
+            sum += proj_data.get_viewgram(view_num, segment_num).sum();
+        }
+    }
+  timer.stop();
+  if (sum < 0)
+    cerr << "Unexpected negative data\n";
+  return get_num_bins(*proj_data.get_proj_data_info_ptr())*sizeof(float)/1.E6;
+}
+
+double projdata_stream_read(BenchmarkData& data, HighResWallClockTimer& timer)
+{
+  write_tmp_projdata(data);
+  double MB;
+  {
+    // opening in read-write mode gives a ProjDataFromStream
+    shared_ptr<ProjData> proj_data_sptr =
+      ProjData::read_from_file(tmp_projdata_filename, std::ios::in | std::ios::out);
+    MB = read_all_viewgrams(*proj_data_sptr, timer);
+  }
+  remove_tmp_projdata();
+  return MB;
+}
+
+double projdata_read(BenchmarkData& data, HighResWallClockTimer& timer)
+{
+  write_tmp_projdata(data);
+  double MB;
+  {
+    // find the file layout from the Interfile header
+    shared_ptr<ProjDataFromStream> stream_sptr(read_interfile_PDFS(tmp_projdata_filename, std::ios::in));
+    if (is_null_ptr(stream_sptr))
+      error("Error reading temporary projection data");
+    shared_ptr<std::iostream> data_in(new std::fstream(tmp_projdata_data_filename, std::ios::in | std::ios::binary));
+    ProjDataFromMappedFile proj_data(stream_sptr->get_exam_info_sptr(),
+                                     stream_sptr->get_proj_data_info_ptr()->create_shared_clone(),
+                                     data_in, tmp_projdata_data_filename,
+                                     stream_sptr->get_offset_in_stream(),
+                                     stream_sptr->get_segment_sequence_in_stream(),
+                                     stream_sptr->get_storage_order(),
+                                     stream_sptr->get_data_type_in_stream(),
+                                     stream_sptr->get_byte_order_in_stream(),
+                                     stream_sptr->get_scale_factor());
+    MB = read_all_viewgrams(proj_data, timer);
+  }
+  remove_tmp_projdata();
+  return MB;
+}
+
+int num_events = 5000000;
+
+const char * const tmp_lm_header_filename = "benchmark_recon_buildblock_tmp.l.hdr";
+const char * const tmp_lm_data_filename = "benchmark_recon_buildblock_tmp.l";
+const char * const tmp_lm_par_filename = "benchmark_recon_buildblock_tmp_lm.par";
+const char * const tmp_lm_output_prefix = "benchmark_recon_buildblock_tmp_lm";
+
+// write a 32-bit word in little endian byte order
+void write_little_endian(std::ostream& s, const unsigned word)
+{
+  const char bytes[4] =
+    { static_cast<char>(word & 0xff), static_cast<char>((word >> 8) & 0xff),
+      static_cast<char>((word >> 16) & 0xff), static_cast<char>((word >> 24) & 0xff) };
+  s.write(bytes, 4);
+}
+
+/* Writes a list mode file in the ECAT8 32-bit format with num_events prompts
+   (and a time tick every 1000 events), a template projdata for the benchmark size
+   and a parameter file for LmToProjData.
+   Events are stored as an offset in an uncompressed sinogram (see CListEventECAT8_32bit).
+*/
+void write_tmp_lm_files(BenchmarkData& data)
+{
+  const Scanner& scanner = *data.proj_data_info_sptr->get_scanner_ptr();
+  const int num_rings = scanner.get_num_rings();
+  const int num_views = scanner.get_num_detectors_per_ring()/2;
+  const int num_tangential_poss = scanner.get_default_num_arccorrected_bins();
+  const unsigned num_offsets =
+    static_cast<unsigned>(num_tangential_poss) * num_views * num_rings * num_rings;
+  const int num_records = num_events + num_events/1000 + 1;
+
+  {
+    std::ofstream header(tmp_lm_header_filename);
+    header << "!INTERFILE:=\n"
+           << "originating system:=" << scanner.get_name() << '\n'
+           << "name of data file:=" << tmp_lm_data_filename << '\n'
+           << "type of data:=PET\n"
+           << "imagedata byte order:=LITTLEENDIAN\n"
+           << "number format:=signed integer\n"
+           << "number of bytes per pixel:=4\n"
+           << "number of dimensions:=1\n"
+           << "matrix size[1]:=" << num_records << '\n'
+           << "%axial_compression:=1\n"
+           << "%maximum_ring_difference:=" << num_rings-1 << '\n'
+           << "%number_of_projections:=" << num_tangential_poss << '\n'
+           << "%number_of_views:=" << num_views << '\n'
+           << "%number_of_segments:=" << 2*num_rings-1 << '\n'
+           << "number of time frames:=1\n"
+           << "image duration (sec)[1]:=" << num_events/1000/1000 + 1 << '\n'
+           << "!END OF INTERFILE:=\n";
+    if (!header)
+      error(boost::format("Error writing %1%") % tmp_lm_header_filename);
+  }
+  {
+    std::ofstream lm_data(tmp_lm_data_filename, std::ios::out | std::ios::binary);
+    std::srand(42);
+    for (int i=0; i<num_events; ++i)
+      {
+        if (i%1000 == 0)
+          write_little_endian(lm_data, (1U << 31) | static_cast<unsigned>(i/1000)); // time tick in ms
+        // prompt: type bit 0, "delayed" bit 1
+        const unsigned offset =
+          static_cast<unsigned>((static_cast<double>(std::rand())/(RAND_MAX+1.))*num_offsets);
+        write_little_endian(lm_data, (1U << 30) | offset);
+      }
+    write_little_endian(lm_data, (1U << 31) | static_cast<unsigned>(num_events/1000));
+    if (!lm_data)
+      error(boost::format("Error writing %1%") % tmp_lm_data_filename);
+  }
+  write_tmp_projdata(data);
+  {
+    std::ofstream par(tmp_lm_par_filename);
+    par << "lm_to_projdata Parameters:=\n"
+        << "input file:=" << tmp_lm_header_filename << '\n'
+        << "template_projdata:=" << tmp_projdata_filename << '\n'
+        << "output filename prefix:=" << tmp_lm_output_prefix << '\n'
+        << "num_events_to_store:=" << num_events << '\n'
+        << "store prompts:=1\n"
+        << "store delayeds:=0\n"
+        << "END:=\n";
+    if (!par)
+      error(boost::format("Error writing %1%") % tmp_lm_par_filename);
+  }
+}
+
+void remove_tmp_lm_files()
+{
+  std::remove(tmp_lm_header_filename);
+  std::remove(tmp_lm_data_filename);
+  std::remove(tmp_lm_par_filename);
+  const string output_filename = string(tmp_lm_output_prefix) + "_f1g1d0b0";
+  std::remove(output_filename.c_str());
+  std::remove((output_filename + ".hs").c_str());
+  std::remove((output_filename + ".s").c_str());
+  remove_tmp_projdata();
+}
+
+double lm_binning(BenchmarkData& data, HighResWallClockTimer& timer)
+{
+  write_tmp_lm_files(data);
+  {
+    LmToProjData application(tmp_lm_par_filename);
+    timer.start();
+    application.process_data();
+    timer.stop();
+  }
+  remove_tmp_lm_files();
+  return num_events;
+}
+
+string lm_par_filename;
+
+double lm_to_projdata(BenchmarkData&, HighResWallClockTimer& timer)
+{
+  LmToProjData application(lm_par_filename.c_str());
+  timer.start();
+  application.process_data();
+  timer.stop();
+  // we don't know how many events were processed, so return 1 run
+  return 1;
+}
+
+struct BenchmarkInfo
+{
+  BenchmarkFunction function;
+  const char * unit;
+  bool is_multi_threaded;
+  bool depends_on_size;
+};
+
+BenchmarkInfo get_benchmark_info(const string& name)
+{
+  BenchmarkInfo info;
+  info.is_multi_threaded = true;
+  info.depends_on_size = true;
+  if (name == "forward_ray_tracing")
+    { info.function = &forward_ray_tracing; info.unit = "bins/s"; }
+  else if (name == "back_interpolation")
+    { info.function = &back_interpolation; info.unit = "bins/s"; }
+  else if (name == "forward_matrix_no_cache")
+    { info.function = &forward_matrix_no_cache; info.unit = "bins/s"; }
+  else if (name == "forward_matrix_cached")
+    { info.function = &forward_matrix_cached; info.unit = "bins/s"; }
+  else if (name == "quadratic_prior_gradient")
+    { info.function = &quadratic_prior_gradient; info.unit = "voxels/s"; }
+  else if (name == "projdata_stream_read")
+    { info.function = &projdata_stream_read; info.unit = "MB/s"; info.is_multi_threaded = false; }
+  else if (name == "projdata_read")
+    { info.function = &projdata_read; info.unit = "MB/s"; }
+  else if (name == "lm_binning")
+    { info.function = &lm_binning; info.unit = "events/s"; }
+  else if (name == "lm_to_projdata")
+    { info.function = &lm_to_projdata; info.unit = "runs/s"; info.depends_on_size = false; }
+  else
+    error(boost::format("Unknown benchmark name '%1%'") % name);
+  return info;
+}
+
+} // end of anonymous namespace
+
+/*************************** main ***********************************/
+
+int
+main(int argc, char *argv[])
+{
+  const char * const program_name = argv[0];
+  vector<string> size_names;
+  size_names.push_back("small");
+  size_names.push_back("medium");
+  vector<int> thread_counts;
+  int num_repeats = 3;
+
+  // skip program name
+  --argc; ++argv;
+  while (argc>1 && argv[0][0] == '-')
+    {
+      const string option = argv[0];
+      const string value = argv[1];
+      if (option == "--sizes")
+        size_names = split_at_commas(value);
+      else if (option == "--threads")
+        {
+          const vector<string> counts = split_at_commas(value);
+          for (unsigned i=0; i<counts.size(); ++i)
+            thread_counts.push_back(std::atoi(counts[i].c_str()));
+        }
+      else if (option == "--repeats")
+        num_repeats = std::atoi(value.c_str());
+      else if (option == "--num-events")
+        num_events = std::atoi(value.c_str());
+      else if (option == "--lm-par")
+        lm_par_filename = value;
+      else
+        {
+          usage(program_name);
+          return EXIT_FAILURE;
+        }
+      argc -= 2; argv += 2;
+    }
+  if ((argc>0 && argv[0][0] == '-') || num_repeats<1 || num_events<1)
+    {
+      usage(program_name);
+      return EXIT_FAILURE;
+    }
+
+  vector<string> names(argv, argv + argc);
+  if (names.empty())
+    {
+      names.assign(benchmark_names, benchmark_names + num_benchmark_names);
+      if (lm_par_filename.empty())
+        names.pop_back();
+    }
+
+  vector<BenchmarkSize> sizes;
+  for (unsigned i=0; i<size_names.size(); ++i)
+    {
+      int s=0;
+      while (s<num_benchmark_sizes && size_names[i] != benchmark_sizes[s].name)
+        ++s;
+      if (s==num_benchmark_sizes)
+        {
+          usage(program_name);
+          return EXIT_FAILURE;
+        }
+      sizes.push_back(benchmark_sizes[s]);
+    }
+
+  if (thread_counts.empty())
+    {
+      for (int num_threads=1; num_threads<get_default_num_threads(); num_threads*=2)
+        thread_counts.push_back(num_threads);
+      thread_counts.push_back(get_default_num_threads());
+    }
+
+  cout << boost::format("%-26s %-8s %8s %12s %14s %-9s %8s\n")
+    % "benchmark" % "size" % "threads" % "time(s)" % "throughput" % "unit" % "speed-up";
+
+  for (unsigned i=0; i<names.size(); ++i)
+    {
+      const BenchmarkInfo info = get_benchmark_info(names[i]);
+      if (names[i] == "lm_to_projdata" && lm_par_filename.empty())
+        error("The lm_to_projdata benchmark needs a parameter file (use --lm-par)");
+
+      for (unsigned s=0; s<(info.depends_on_size ? sizes.size() : 1U); ++s)
+        {
+          BenchmarkData data;
+          if (info.depends_on_size)
+            set_up_benchmark_data(data, sizes[s]);
+
+          double reference_time = 0;
+          for (unsigned t=0; t<(info.is_multi_threaded ? thread_counts.size() : 1U); ++t)
+            {
+              const int num_threads = info.is_multi_threaded ? thread_counts[t] : 1;
+              set_num_threads(num_threads);
+              BenchmarkResult result;
+              for (int r=0; r<num_repeats; ++r)
+                {
+                  HighResWallClockTimer timer;
+                  const double work = (*info.function)(data, timer);
+                  if (r==0 || timer.value() < result.time)
+                    {
+                      result.time = timer.value();
+                      result.work = work;
+                    }
+                }
+              if (t==0)
+                reference_time = result.time;
+              cout << boost::format("%-26s %-8s %8d %12.4f %14.5g %-9s %8.2f\n")
+                % names[i] % (info.depends_on_size ? sizes[s].name : "-") % num_threads
+                % result.time % (result.time > 0 ? result.work/result.time : 0.) % info.unit
+                % (result.time > 0 ? reference_time/result.time : 0.);
+              cout.flush();
+            }
+        }
+    }
+  // restore default
+  set_default_num_threads();
+  return EXIT_SUCCESS;
+}
@@ -3,9 +3,15 @@
 dir := recon_test
 
 $(dir)_SOURCES = bcktest.cxx fwdtest.cxx \
+  benchmark_recon_buildblock.cxx \
   test_DataSymmetriesForBins_PET_CartesianGrid.cxx \
   test_PoissonLogLikelihoodWithLinearModelForMeanAndProjData.cxx
 
+ifeq ($(HAVE_LLN_MATRIX),1)
+  # needs an ECAT7 normalisation file as argument
+  $(dir)_SOURCES += test_BinNormalisationFromECAT7.cxx
+endif
+
 # rules that do not link with all registries to save time during linking
 # Beware: the pattern below is dangerous as it relies on a naming style.
 # Note: have to be before the include below as that resets $(dir)
@@ -0,0 +1,208 @@
+/*
+    Copyright (C) 2026, STIR contributors
+    This file is part of STIR.
+
+    This file is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.
+
+    This file is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    See STIR/LICENSE.txt for details
+*/
+/*!
+  \file
+  \ingroup recontest
+  \ingroup ECAT
+
+  \brief Test program for the cache of normalisation factors in
+  stir::ecat::ecat7::BinNormalisationFromECAT7
+
+  \author STIR contributors
+
+  The test compares the factors computed for every bin with the ones
+  from the cache in memory, and then with the ones from a cache file that is
+  written by one object and memory-mapped by another.
+
+  \par Usage
+  \verbatim
+  test_BinNormalisationFromECAT7 normalisation.n template_proj_data [cache_filename_prefix]
+  \endverbatim
+  The template projection data has to be for the scanner of the normalisation file
+  (only its ProjDataInfo is used). The cache file is written as
+  <tt>cache_filename_prefix.nrmcache</tt> and removed at the end.
+*/
+
+#include "stir/recon_buildblock/BinNormalisationFromECAT7.h"
+#include "stir/ProjData.h"
+#include "stir/ProjDataInfo.h"
+#include "stir/RelatedViewgrams.h"
+#include "stir/recon_buildblock/TrivialDataSymmetriesForBins.h"
+#include "stir/Bin.h"
+#include "stir/Succeeded.h"
+#include "stir/RunTests.h"
+#include <iostream>
+#include <sstream>
+#include <fstream>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+
+using std::cerr;
+using std::string;
+
+START_NAMESPACE_STIR
+START_NAMESPACE_ECAT
+START_NAMESPACE_ECAT7
+
+/*!
+  \ingroup test
+  \brief Test class for the cache of BinNormalisationFromECAT7
+*/
+class BinNormalisationFromECAT7Tests : public RunTests
+{
+public:
+  BinNormalisationFromECAT7Tests(const string& norm_filename,
+                                 const string& template_proj_data_filename,
+                                 const string& cache_filename_prefix)
+    : norm_filename(norm_filename),
+      template_proj_data_filename(template_proj_data_filename),
+      cache_filename_prefix(cache_filename_prefix)
+  {}
+
+  void run_tests();
+
+private:
+  string norm_filename;
+  string template_proj_data_filename;
+  string cache_filename_prefix;
+
+  //! parses a BinNormalisationFromECAT7 object with the given cache settings
+  shared_ptr<BinNormalisationFromECAT7>
+    create_normalisation(const bool cache_factors, const string& prefix);
+  //! compares the factors of all bins, and apply() for some viewgrams
+  void compare(const BinNormalisationFromECAT7& computed, const BinNormalisationFromECAT7& cached,
+               const ProjDataInfo& proj_data_info, const ProjData& template_proj_data,
+               const string& str);
+};
+
+shared_ptr<BinNormalisationFromECAT7>
+BinNormalisationFromECAT7Tests::
+create_normalisation(const bool cache_factors, const string& prefix)
+{
+  std::stringstream par;
+  par << "Bin Normalisation From ECAT7:=\n"
+      << "normalisation_filename:=" << this->norm_filename << '\n'
+      << "cache_normalisation_factors:=" << (cache_factors ? 1 : 0) << '\n'
+      << "cache_filename_prefix:=" << prefix << '\n'
+      << "End Bin Normalisation From ECAT7:=\n";
+  shared_ptr<BinNormalisationFromECAT7> norm_sptr(new BinNormalisationFromECAT7);
+  check(norm_sptr->parse(par), "parsing normalisation parameters");
+  return norm_sptr;
+}
+
+void
+BinNormalisationFromECAT7Tests::
+compare(const BinNormalisationFromECAT7& computed, const BinNormalisationFromECAT7& cached,
+        const ProjDataInfo& proj_data_info, const ProjData& template_proj_data,
+        const string& str)
+{
+  Bin bin;
+  for (bin.segment_num()=proj_data_info.get_min_segment_num();
+       bin.segment_num()<=proj_data_info.get_max_segment_num();
+       ++bin.segment_num())
+    for (bin.axial_pos_num()=proj_data_info.get_min_axial_pos_num(bin.segment_num());
+         bin.axial_pos_num()<=proj_data_info.get_max_axial_pos_num(bin.segment_num());
+         ++bin.axial_pos_num())
+      for (bin.view_num()=proj_data_info.get_min_view_num();
+           bin.view_num()<=proj_data_info.get_max_view_num();
+           ++bin.view_num())
+        for (bin.tangential_pos_num()=proj_data_info.get_min_tangential_pos_num();
+             bin.tangential_pos_num()<=proj_data_info.get_max_tangential_pos_num();
+             ++bin.tangential_pos_num())
+          {
+            if (!check_if_equal(computed.get_bin_efficiency(bin, 0., 0.),
+                                cached.get_bin_efficiency(bin, 0., 0.),
+                                str + ": factor for a bin"))
+              {
+                cerr << "bin (segment, axial position, view, tangential position): ("
+                     << bin.segment_num() << ", " << bin.axial_pos_num() << ", "
+                     << bin.view_num() << ", " << bin.tangential_pos_num() << ")\n";
+                return;
+              }
+          }
+
+  // apply() uses the cache for a whole viewgram at once
+  const int segment_num = proj_data_info.get_max_segment_num();
+  const int view_num = proj_data_info.get_min_view_num();
+  shared_ptr<DataSymmetriesForViewSegmentNumbers>
+    symmetries_sptr(new TrivialDataSymmetriesForBins(template_proj_data.get_proj_data_info_ptr()->create_shared_clone()));
+  RelatedViewgrams<float> viewgrams_computed =
+    template_proj_data.get_empty_related_viewgrams(ViewSegmentNumbers(view_num, segment_num), symmetries_sptr);
+  viewgrams_computed.fill(1.F);
+  RelatedViewgrams<float> viewgrams_cached = viewgrams_computed;
+  computed.apply(viewgrams_computed, 0., 0.);
+  cached.apply(viewgrams_cached, 0., 0.);
+  RelatedViewgrams<float>::const_iterator iter_cached = viewgrams_cached.begin();
+  for (RelatedViewgrams<float>::const_iterator iter_computed = viewgrams_computed.begin();
+       iter_computed != viewgrams_computed.end();
+       ++iter_computed, ++iter_cached)
+    check_if_equal(*iter_computed, *iter_cached, str + ": apply()");
+}
+
+void
+BinNormalisationFromECAT7Tests::
+run_tests()
+{
+  cerr << "Tests for the cache of BinNormalisationFromECAT7\n";
+
+  shared_ptr<ProjData> template_proj_data_sptr = ProjData::read_from_file(this->template_proj_data_filename);
+  shared_ptr<ProjDataInfo> proj_data_info_sptr(template_proj_data_sptr->get_proj_data_info_ptr()->clone());
+  const string cache_filename = this->cache_filename_prefix + ".nrmcache";
+  std::remove(cache_filename.c_str());
+
+  shared_ptr<BinNormalisationFromECAT7> computed_sptr = this->create_normalisation(false, "");
+  check(computed_sptr->set_up(proj_data_info_sptr) == Succeeded::yes, "set_up without cache");
+
+  {
+    shared_ptr<BinNormalisationFromECAT7> cached_sptr = this->create_normalisation(true, "");
+    check(cached_sptr->set_up(proj_data_info_sptr) == Succeeded::yes, "set_up with cache in memory");
+    this->compare(*computed_sptr, *cached_sptr, *proj_data_info_sptr, *template_proj_data_sptr,
+                  "cache in memory");
+  }
+  {
+    // this one computes the factors and writes the file
+    shared_ptr<BinNormalisationFromECAT7> writer_sptr = this->create_normalisation(true, this->cache_filename_prefix);
+    check(writer_sptr->set_up(proj_data_info_sptr) == Succeeded::yes, "set_up writing the cache file");
+    check(std::ifstream(cache_filename.c_str()).good(), "cache file should have been written");
+    // this one maps the file
+    shared_ptr<BinNormalisationFromECAT7> reader_sptr = this->create_normalisation(true, this->cache_filename_prefix);
+    check(reader_sptr->set_up(proj_data_info_sptr) == Succeeded::yes, "set_up reading the cache file");
+    this->compare(*computed_sptr, *reader_sptr, *proj_data_info_sptr, *template_proj_data_sptr,
+                  "cache file");
+  }
+  std::remove(cache_filename.c_str());
+}
+
+END_NAMESPACE_ECAT7
+END_NAMESPACE_ECAT
+END_NAMESPACE_STIR
+
+USING_NAMESPACE_STIR
+
+int main(int argc, char **argv)
+{
+  if (argc < 3 || argc > 4)
+    {
+      cerr << "Usage : " << argv[0] << " normalisation.n template_proj_data [cache_filename_prefix]\n";
+      return EXIT_FAILURE;
+    }
+  ecat::ecat7::BinNormalisationFromECAT7Tests
+    tests(argv[1], argv[2], argc>3 ? argv[3] : "test_BinNormalisationFromECAT7");
+  tests.run_tests();
+  return tests.main_return_value();
+}
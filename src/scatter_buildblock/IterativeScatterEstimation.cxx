@@ -0,0 +1,316 @@
+/*
+    Copyright (C) 2026, STIR contributors
+    This file is part of STIR.
+
+    This file is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.
+
+    This file is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    See STIR/LICENSE.txt for details
+*/
+/*!
+  \file
+  \ingroup scatter
+  \brief Implementation of class stir::IterativeScatterEstimation
+
+  \author STIR contributors
+*/
+
+#include "stir/scatter/IterativeScatterEstimation.h"
+#include "stir/OSMAPOSL/OSMAPOSLReconstruction.h"
+#include "stir/recon_buildblock/PoissonLogLikelihoodWithLinearModelForMeanAndProjData.h"
+#include "stir/recon_buildblock/BinNormalisation.h"
+#include "stir/recon_buildblock/TrivialBinNormalisation.h"
+#include "stir/ProjDataInMemory.h"
+#include "stir/ProjDataInterfile.h"
+#include "stir/ProjDataInfo.h"
+#include "stir/ExamInfo.h"
+#include "stir/SegmentBySinogram.h"
+#include "stir/HighResWallClockTimer.h"
+#include "stir/IO/read_from_file.h"
+#include "stir/thresholding.h"
+#include "stir/Succeeded.h"
+#include "stir/is_null_ptr.h"
+#include "stir/info.h"
+#include "stir/error.h"
+#include <boost/format.hpp>
+
+START_NAMESPACE_STIR
+
+void
+IterativeScatterEstimation::
+set_defaults()
+{
+  this->input_filename = "";
+  this->background_proj_data_filename = "";
+  this->tail_mask_filename = "";
+  this->scatter_simulation_parameter_filename = "";
+  this->reconstruction_parameter_filename = "";
+  this->initial_activity_image_filename = "";
+  this->num_scatter_iterations = 5;
+  this->min_scale_factor = .4F;
+  this->max_scale_factor = 100.F;
+  this->half_filter_width = 3;
+  this->remove_interleaving = true;
+  this->unscaled_scatter_output_filename_prefix = "scatter_estimate_wrong_scale";
+  this->scatter_output_filename_prefix = "scatter_estimate";
+  this->activity_image_output_filename_prefix = "activity_image";
+  this->scatter_normalisation_sptr.reset(new TrivialBinNormalisation);
+}
+
+void
+IterativeScatterEstimation::
+initialise_keymap()
+{
+  this->parser.add_start_key("Iterative Scatter Estimation Parameters");
+  this->parser.add_stop_key("end Iterative Scatter Estimation Parameters");
+  this->parser.add_key("input file", &this->input_filename);
+  this->parser.add_key("background projdata filename", &this->background_proj_data_filename);
+  this->parser.add_key("tail mask filename", &this->tail_mask_filename);
+  this->parser.add_parsing_key("scatter normalisation type", &this->scatter_normalisation_sptr);
+  this->parser.add_key("scatter simulation parameter filename", &this->scatter_simulation_parameter_filename);
+  this->parser.add_key("reconstruction parameter filename", &this->reconstruction_parameter_filename);
+  this->parser.add_key("initial activity image filename", &this->initial_activity_image_filename);
+  this->parser.add_key("number of scatter iterations", &this->num_scatter_iterations);
+  this->parser.add_key("minimum scale factor", &this->min_scale_factor);
+  this->parser.add_key("maximum scale factor", &this->max_scale_factor);
+  this->parser.add_key("half filter width", &this->half_filter_width);
+  this->parser.add_key("remove interleaving", &this->remove_interleaving);
+  this->parser.add_key("unscaled scatter estimate output filename prefix", &this->unscaled_scatter_output_filename_prefix);
+  this->parser.add_key("scatter estimate output filename prefix", &this->scatter_output_filename_prefix);
+  this->parser.add_key("activity image output filename prefix", &this->activity_image_output_filename_prefix);
+}
+
+bool
+IterativeScatterEstimation::
+post_processing()
+{
+  if (this->num_scatter_iterations < 1)
+    { warning("IterativeScatterEstimation: number of scatter iterations should be at least 1"); return true; }
+  if (this->half_filter_width < 0)
+    { warning("IterativeScatterEstimation: half filter width should be non-negative"); return true; }
+
+  this->input_proj_data_sptr = ProjData::read_from_file(this->input_filename);
+  if (is_null_ptr(this->input_proj_data_sptr))
+    { warning(boost::format("IterativeScatterEstimation: error reading input file %1%") % this->input_filename); return true; }
+
+  if (this->background_proj_data_filename.size()>0)
+    {
+      this->background_proj_data_sptr = ProjData::read_from_file(this->background_proj_data_filename);
+      if (is_null_ptr(this->background_proj_data_sptr))
+        { warning(boost::format("IterativeScatterEstimation: error reading background %1%") % this->background_proj_data_filename); return true; }
+    }
+
+  this->tail_mask_proj_data_sptr = ProjData::read_from_file(this->tail_mask_filename);
+  if (is_null_ptr(this->tail_mask_proj_data_sptr))
+    { warning(boost::format("IterativeScatterEstimation: error reading tail mask %1%") % this->tail_mask_filename); return true; }
+
+  if (is_null_ptr(this->scatter_normalisation_sptr))
+    { warning("IterativeScatterEstimation: invalid scatter normalisation"); return true; }
+  if (this->scatter_normalisation_sptr->set_up(this->input_proj_data_sptr->get_proj_data_info_ptr()->create_shared_clone())
+      != Succeeded::yes)
+    { warning("IterativeScatterEstimation: set-up of scatter normalisation failed"); return true; }
+
+  this->scatter_simulation_sptr.reset(new ScatterEstimationByBin);
+  if (!this->scatter_simulation_sptr->parse(this->scatter_simulation_parameter_filename.c_str()))
+    { warning("IterativeScatterEstimation: error parsing scatter simulation parameters"); return true; }
+
+  this->reconstruction_sptr.reset(new OSMAPOSLReconstruction<TargetT>(this->reconstruction_parameter_filename));
+
+  if (this->initial_activity_image_filename.size()>0)
+    {
+      this->activity_image_sptr = read_from_file<TargetT>(this->initial_activity_image_filename);
+      if (is_null_ptr(this->activity_image_sptr))
+        { warning(boost::format("IterativeScatterEstimation: error reading initial activity image %1%") % this->initial_activity_image_filename); return true; }
+    }
+
+  return false;
+}
+
+IterativeScatterEstimation::
+IterativeScatterEstimation()
+{
+  this->set_defaults();
+}
+
+const shared_ptr<IterativeScatterEstimation::TargetT>&
+IterativeScatterEstimation::
+get_activity_image_sptr() const
+{
+  return this->activity_image_sptr;
+}
+
+Succeeded
+IterativeScatterEstimation::
+set_up_reconstruction()
+{
+  PoissonLogLikelihoodWithLinearModelForMeanAndProjData<TargetT> * const objective_function_ptr =
+    dynamic_cast<PoissonLogLikelihoodWithLinearModelForMeanAndProjData<TargetT> *>
+    (this->reconstruction_sptr->get_objective_function_sptr().get());
+  if (objective_function_ptr == 0)
+    error("IterativeScatterEstimation: the objective function of the reconstruction needs to be\n"
+          "of type PoissonLogLikelihoodWithLinearModelForMeanAndProjData");
+
+  objective_function_ptr->set_proj_data_sptr(this->input_proj_data_sptr);
+
+  shared_ptr<BinNormalisation> normalisation_sptr = objective_function_ptr->get_normalisation_sptr();
+  if (is_null_ptr(normalisation_sptr))
+    {
+      normalisation_sptr.reset(new TrivialBinNormalisation);
+      objective_function_ptr->set_normalisation_sptr(normalisation_sptr);
+    }
+  if (normalisation_sptr->set_up(this->input_proj_data_sptr->get_proj_data_info_ptr()->create_shared_clone())
+      != Succeeded::yes)
+    error("IterativeScatterEstimation: set-up of the normalisation of the reconstruction failed");
+
+  // we keep the additive sinogram in memory, and update it in every iteration
+  this->additive_proj_data_sptr.reset(new ProjDataInMemory(this->input_proj_data_sptr->get_exam_info_sptr(),
+                                                           this->input_proj_data_sptr->get_proj_data_info_ptr()->create_shared_clone()));
+  objective_function_ptr->set_additive_proj_data_sptr(this->additive_proj_data_sptr);
+
+  // data to fit the scatter tails to
+  if (is_null_ptr(this->background_proj_data_sptr))
+    this->data_to_fit_sptr = this->input_proj_data_sptr;
+  else
+    {
+      this->data_to_fit_sptr.reset(new ProjDataInMemory(this->input_proj_data_sptr->get_exam_info_sptr(),
+                                                        this->input_proj_data_sptr->get_proj_data_info_ptr()->create_shared_clone(),
+                                                        false));
+      for (int segment_num=this->input_proj_data_sptr->get_min_segment_num();
+           segment_num<=this->input_proj_data_sptr->get_max_segment_num();
+           ++segment_num)
+        {
+          SegmentBySinogram<float> segment =
+            this->input_proj_data_sptr->get_segment_by_sinogram(segment_num);
+          segment -= this->background_proj_data_sptr->get_segment_by_sinogram(segment_num);
+          if (this->data_to_fit_sptr->set_segment(segment) != Succeeded::yes)
+            error("IterativeScatterEstimation: error subtracting background from the data");
+        }
+    }
+
+  // the reconstruction is only set up once. Later on, only the contents of the
+  // additive sinogram change, which does not need a new set-up.
+  // (note: set_up() is only public in the base class)
+  Reconstruction<TargetT>& reconstruction = *this->reconstruction_sptr;
+  if (reconstruction.set_up(this->activity_image_sptr) != Succeeded::yes)
+    {
+      warning("IterativeScatterEstimation: set-up of the reconstruction failed");
+      return Succeeded::no;
+    }
+  return Succeeded::yes;
+}
+
+void
+IterativeScatterEstimation::
+set_additive_proj_data(const ProjData * const scatter_proj_data_ptr)
+{
+  for (int segment_num=this->additive_proj_data_sptr->get_min_segment_num();
+       segment_num<=this->additive_proj_data_sptr->get_max_segment_num();
+       ++segment_num)
+    {
+      SegmentBySinogram<float> segment =
+        this->additive_proj_data_sptr->get_empty_segment_by_sinogram(segment_num);
+      if (scatter_proj_data_ptr != 0)
+        segment += scatter_proj_data_ptr->get_segment_by_sinogram(segment_num);
+      if (!is_null_ptr(this->background_proj_data_sptr))
+        segment += this->background_proj_data_sptr->get_segment_by_sinogram(segment_num);
+      if (this->additive_proj_data_sptr->set_segment(segment) != Succeeded::yes)
+        error("IterativeScatterEstimation: error setting additive sinogram");
+    }
+
+  // the additive term of the objective function is in "corrected" units
+  const TimeFrameDefinitions& time_frame_defs =
+    this->input_proj_data_sptr->get_exam_info_sptr()->time_frame_definitions;
+  PoissonLogLikelihoodWithLinearModelForMeanAndProjData<TargetT>& objective_function =
+    static_cast<PoissonLogLikelihoodWithLinearModelForMeanAndProjData<TargetT>&>
+    (*this->reconstruction_sptr->get_objective_function_sptr());
+  objective_function.get_normalisation_sptr()->
+    apply(*this->additive_proj_data_sptr,
+          time_frame_defs.get_start_time(), time_frame_defs.get_end_time());
+  objective_function.set_additive_proj_data_sptr(this->additive_proj_data_sptr);
+}
+
+Succeeded
+IterativeScatterEstimation::
+reconstruct(const int iteration_num)
+{
+  this->reconstruction_sptr->
+    set_output_filename_prefix(boost::str(boost::format("%1%_%2%") %
+                                          this->activity_image_output_filename_prefix % iteration_num));
+  // note: reconstruct(target) does not call set_up(), see set_up_reconstruction()
+  return this->reconstruction_sptr->reconstruct(this->activity_image_sptr);
+}
+
+Succeeded
+IterativeScatterEstimation::
+process_data()
+{
+  const bool reconstruct_initial_activity_image = is_null_ptr(this->activity_image_sptr);
+  if (reconstruct_initial_activity_image)
+    this->activity_image_sptr.reset(this->reconstruction_sptr->get_initial_data_ptr());
+
+  if (this->set_up_reconstruction() != Succeeded::yes)
+    return Succeeded::no;
+
+  HighResWallClockTimer timer;
+  if (reconstruct_initial_activity_image)
+    {
+      info("IterativeScatterEstimation: reconstructing initial activity image without scatter correction");
+      this->set_additive_proj_data(0);
+      if (this->reconstruct(0) != Succeeded::yes)
+        return Succeeded::no;
+    }
+
+  for (int iteration_num=1; iteration_num<=this->num_scatter_iterations; ++iteration_num)
+    {
+      info(boost::format("IterativeScatterEstimation: starting scatter iteration %1%") % iteration_num);
+      timer.reset(); timer.start();
+
+      // scatter simulation only needs a non-negative activity image
+      // note: the cached attenuation integrals are kept by the scatter simulation object
+      shared_ptr<TargetT> thresholded_activity_image_sptr(this->activity_image_sptr->clone());
+      threshold_lower(thresholded_activity_image_sptr->begin_all(),
+                      thresholded_activity_image_sptr->end_all(),
+                      0.F);
+      this->scatter_simulation_sptr->set_activity_image_sptr(thresholded_activity_image_sptr);
+      this->scatter_simulation_sptr->
+        set_output_proj_data(boost::str(boost::format("%1%_%2%") %
+                                        this->unscaled_scatter_output_filename_prefix % iteration_num));
+      if (this->scatter_simulation_sptr->process_data() != Succeeded::yes)
+        return Succeeded::no;
+
+      ProjDataInterfile scaled_scatter_proj_data(this->input_proj_data_sptr->get_exam_info_sptr(),
+                                                 this->input_proj_data_sptr->get_proj_data_info_ptr()->create_shared_clone(),
+                                                 boost::str(boost::format("%1%_%2%") %
+                                                            this->scatter_output_filename_prefix % iteration_num),
+                                                 std::ios::in | std::ios::out | std::ios::trunc);
+      ScatterEstimationByBin::
+        upsample_and_fit_scatter_estimate(scaled_scatter_proj_data,
+                                          *this->data_to_fit_sptr,
+                                          *this->scatter_simulation_sptr->get_output_proj_data_sptr(),
+                                          *this->scatter_normalisation_sptr,
+                                          *this->tail_mask_proj_data_sptr,
+                                          this->min_scale_factor,
+                                          this->max_scale_factor,
+                                          static_cast<unsigned>(this->half_filter_width),
+                                          BSpline::linear,
+                                          this->remove_interleaving);
+      timer.stop();
+      info(boost::format("IterativeScatterEstimation: scatter estimate of iteration %1% took %2% sec")
+           % iteration_num % timer.value());
+
+      this->set_additive_proj_data(&scaled_scatter_proj_data);
+      if (this->reconstruct(iteration_num) != Succeeded::yes)
+        return Succeeded::no;
+    }
+
+  return Succeeded::yes;
+}
+
+END_NAMESPACE_STIR
@@ -49,6 +49,7 @@ set_defaults()
 {
   this->attenuation_threshold =  0.01 ;
   this->random = true;
+  this->random_seed = 0;
   this->use_cache = true;
   this->energy_resolution = .22 ;
   this->reference_energy = 511.F;
@@ -72,6 +73,7 @@ initialise_keymap()
   this->parser.add_stop_key("end Scatter Estimation Parameters");
   this->parser.add_key("attenuation_threshold", &this->attenuation_threshold);
   this->parser.add_key("random", &this->random);
+  this->parser.add_key("random_seed", &this->random_seed);
 
   this->parser.add_key("use_cache", &this->use_cache);
   this->parser.add_key("energy_resolution", &this->energy_resolution);
@@ -89,7 +91,9 @@ bool
 ScatterEstimationByBin::
 post_processing()
 {
-  this->set_activity_image(this->activity_image_filename);
+  // the activity image and output can be set later, e.g. by IterativeScatterEstimation
+  if (this->activity_image_filename.size()>0)
+    this->set_activity_image(this->activity_image_filename);
   this->set_density_image(this->density_image_filename);
   this->set_density_image_for_scatter_points(this->density_image_for_scatter_points_filename);
         
@@ -100,7 +104,8 @@ post_processing()
 
   this->set_template_proj_data_info(this->template_proj_data_filename);
   // create output (has to be AFTER set_template_proj_data_info)
-  this->set_output_proj_data(this->output_proj_data_filename);
+  if (this->output_proj_data_filename.size()>0)
+    this->set_output_proj_data(this->output_proj_data_filename);
 
   return false;
 }
@@ -204,6 +209,7 @@ set_template_proj_data_info_sptr(const shared_ptr<ProjDataInfo>& new_sptr)
     this->proj_data_info_ptr->get_scanner_ptr()->get_num_rings()*
     this->proj_data_info_ptr->get_scanner_ptr()->get_num_detectors_per_ring ();
   // reserve space to avoid reallocation, but the actual size will grow dynamically
+  this->detection_points_vector.resize(0);
   this->detection_points_vector.reserve(total_detectors);
 
   // remove any cached values as they'd be incorrect if the sizes changes
@@ -238,9 +244,18 @@ set_output_proj_data(const std::string& filename)
   this->output_proj_data_filename = filename;
   // TODO get ExamInfo from image
   shared_ptr<ExamInfo> exam_info_sptr(new ExamInfo);
+  // open for reading as well, such that the output can be used via get_output_proj_data_sptr()
   this->output_proj_data_sptr.reset(new ProjDataInterfile(exam_info_sptr,
                                                           this->proj_data_info_ptr->create_shared_clone(),
-                                                          this->output_proj_data_filename));
+                                                          this->output_proj_data_filename,
+                                                          std::ios::in | std::ios::out | std::ios::trunc));
+}
+
+const shared_ptr<ProjData>&
+ScatterEstimationByBin::
+get_output_proj_data_sptr() const
+{
+  return this->output_proj_data_sptr;
 }
 
 /****************** functions to compute scatter **********************/
@@ -249,6 +264,11 @@ Succeeded
 ScatterEstimationByBin::
 process_data()
 {               
+  if (is_null_ptr(this->activity_image_sptr))
+    error("ScatterEstimationByBin: activity image has not been set");
+  if (is_null_ptr(this->output_proj_data_sptr))
+    error("ScatterEstimationByBin: output projection data have not been set");
+
   this->initialise_cache_for_scattpoint_det_integrals_over_attenuation();
   this->initialise_cache_for_scattpoint_det_integrals_over_activity();
  
@@ -303,6 +323,17 @@ process_data()
   this->shift_detector_coordinates_to_origin =
     CartesianCoordinate3D<float>(this->proj_data_info_ptr->get_m(Bin(0,0,0,0)),0, 0);
 
+  // Fill the caches before the (parallel) loop over the bins, as opposed to on the fly.
+  // This needs all detection points first.
+  this->set_up_detection_points_vector();
+  this->precompute_cache_for_scattpoint_det_integrals();
+  wall_clock_timer.stop();
+  info(boost::format("Integrals from %1% scatter points to %2% detection points computed in %3% sec") 
+       % this->scatt_points_vector.size() % this->detection_points_vector.size()
+       % wall_clock_timer.value());
+  previous_timer = wall_clock_timer.value();
+  wall_clock_timer.start();
+
   float total_scatter = 0 ;
 
   for (vs_num.segment_num()=this->proj_data_info_ptr->get_min_segment_num();
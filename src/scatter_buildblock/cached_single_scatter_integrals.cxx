@@ -84,6 +84,46 @@ initialise_cache_for_scattpoint_det_integrals_over_activity()
   this->cached_activity_integral_scattpoint_det.fill(cache_init_value);
 }
 
+void
+ScatterEstimationByBin::
+precompute_cache_for_scattpoint_det_integrals()
+{
+  if (!this->use_cache)
+    return;
+
+  this->initialise_cache_for_scattpoint_det_integrals_over_attenuation();
+  this->initialise_cache_for_scattpoint_det_integrals_over_activity();
+
+  const int num_scatter_points = static_cast<int>(this->scatt_points_vector.size());
+  const int num_detection_points = static_cast<int>(this->detection_points_vector.size());
+
+  // every thread fills different rows of the caches, so no synchronisation is needed
+#ifdef STIR_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for (int scatter_point_num=0; scatter_point_num<num_scatter_points; ++scatter_point_num)
+    {
+      const CartesianCoordinate3D<float>& scatter_point = 
+        this->scatt_points_vector[scatter_point_num].coord;
+      for (int det_num=0; det_num<num_detection_points; ++det_num)
+        {
+          float& attenuation_integral =
+            this->cached_attenuation_integral_scattpoint_det[scatter_point_num][det_num];
+          if (attenuation_integral == cache_init_value)
+            attenuation_integral = 
+              exp_integral_over_attenuation_image_between_scattpoint_det
+              (scatter_point, this->detection_points_vector[det_num]);
+
+          float& activity_integral =
+            this->cached_activity_integral_scattpoint_det[scatter_point_num][det_num];
+          if (activity_integral == cache_init_value)
+            activity_integral = 
+              integral_over_activity_image_between_scattpoint_det
+              (scatter_point, this->detection_points_vector[det_num]);
+        }
+    }
+}
+
 float 
 ScatterEstimationByBin::
 cached_integral_over_activity_image_between_scattpoint_det(const unsigned scatter_point_num, 
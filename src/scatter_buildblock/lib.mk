@@ -11,7 +11,8 @@ $(dir)_LIB_SOURCES:= \
         cached_single_scatter_integrals.cxx \
 	scatter_estimate_for_one_scatter_point.cxx \
 	upsample_and_fit_scatter_estimate.cxx \
-	ScatterEstimationByBin.cxx 
+	ScatterEstimationByBin.cxx \
+	IterativeScatterEstimation.cxx 
 
 #$(dir)_REGISTRY_SOURCES:= scatter_buildblock_registries.cxx
 
@@ -28,15 +28,20 @@
 
 #include "stir/scatter/ScatterEstimationByBin.h"
 #include "stir/VoxelsOnCartesianGrid.h"
+#include <boost/random/uniform_01.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/cstdint.hpp>
 #include <time.h>
 
 using namespace std;
 START_NAMESPACE_STIR
 
-static inline float random_point(const float low, const float high)
+typedef boost::uniform_01<boost::mt19937> random01_type;
+
+static inline float random_point(random01_type& random01, const float low, const float high)
 {
   /* returns a pseudo random number which holds in the bounds low and high */
-  const float result= (rand()*(high-low))/RAND_MAX  + low;
+  const float result= static_cast<float>(random01()*(high-low)  + low);
   assert(low <= result);
   assert(high >= result);
   return result;
@@ -52,7 +57,6 @@ sample_scatter_points()
     (*this->density_image_for_scatter_points_sptr);
 
   BasicCoordinate<3,int> min_index, max_index ;
-  CartesianCoordinate3D<int> coord;
   if(!this->density_image_for_scatter_points_sptr->get_regular_range(min_index, max_index))
     error("scatter points sampling works only on regular ranges, at the moment\n");    
   const VoxelsOnCartesianGrid<float>& image =
@@ -68,31 +72,59 @@ sample_scatter_points()
 
   this->scatter_volume = voxel_size[1]*voxel_size[2]*voxel_size[3];
 
-  if(this->random)
+  // Every plane uses its own random number generator, seeded from random_seed and the plane number.
+  // The scatter points are therefore independent of the number of threads (and of the order
+  // in which planes are handled).
+  boost::uint32_t seed = static_cast<boost::uint32_t>(this->random_seed);
+  if (this->random && this->random_seed == 0)
     { // Initialize Pseudo Random Number generator using time  
-      srand((unsigned)time( NULL ));
+      seed = static_cast<boost::uint32_t>(time( NULL ));
     }
-  this->scatt_points_vector.resize(0); // make sure we don't keep scatter points from a previous run
-  this->scatt_points_vector.reserve(1000);  
 
-  // coord[] is in voxels units       
-  for(coord[1]=min_index[1];coord[1]<=max_index[1];++coord[1])
-    for(coord[2]=min_index[2];coord[2]<=max_index[2];++coord[2])
-      for(coord[3]=min_index[3];coord[3]<=max_index[3];++coord[3])   
-        if(attenuation_map[coord] >= this->attenuation_threshold)
-          {
-            ScatterPoint scatter_point;                                 
-            scatter_point.coord = convert_int_to_float(coord);
-            if (random)
-              scatter_point.coord +=
-                CartesianCoordinate3D<float>(random_point(-.5,.5),
-                                             random_point(-.5,.5),
-                                             random_point(-.5,.5));
-            scatter_point.coord =
-              voxel_size*scatter_point.coord + origin;
-            scatter_point.mu_value = attenuation_map[coord];
-            this->scatt_points_vector.push_back(scatter_point);
-          }
+  std::vector<std::vector<ScatterPoint> > scatt_points_per_plane(max_index[1]-min_index[1]+1);
+
+#ifdef STIR_OPENMP
+#pragma omp parallel for schedule(dynamic) shared(scatt_points_per_plane, attenuation_map)
+#endif
+  for(int z=min_index[1];z<=max_index[1];++z)
+    {
+      random01_type random01(boost::mt19937(seed + static_cast<boost::uint32_t>(z-min_index[1])));
+      std::vector<ScatterPoint>& scatt_points_in_plane = scatt_points_per_plane[z-min_index[1]];
+      // coord[] is in voxels units       
+      CartesianCoordinate3D<int> coord;
+      coord[1]=z;
+      for(coord[2]=min_index[2];coord[2]<=max_index[2];++coord[2])
+        for(coord[3]=min_index[3];coord[3]<=max_index[3];++coord[3])   
+          if(attenuation_map[coord] >= this->attenuation_threshold)
+            {
+              ScatterPoint scatter_point;                                 
+              scatter_point.coord = convert_int_to_float(coord);
+              if (random)
+                {
+                  // use separate statements to make sure the order of the calls is fixed
+                  const float random_z = random_point(random01,-.5,.5);
+                  const float random_y = random_point(random01,-.5,.5);
+                  const float random_x = random_point(random01,-.5,.5);
+                  scatter_point.coord +=
+                    CartesianCoordinate3D<float>(random_z, random_y, random_x);
+                }
+              scatter_point.coord =
+                voxel_size*scatter_point.coord + origin;
+              scatter_point.mu_value = attenuation_map[coord];
+              scatt_points_in_plane.push_back(scatter_point);
+            }
+    }
+
+  this->scatt_points_vector.resize(0); // make sure we don't keep scatter points from a previous run
+  {
+    std::size_t num_scatter_points = 0;
+    for (std::size_t i=0; i<scatt_points_per_plane.size(); ++i)
+      num_scatter_points += scatt_points_per_plane[i].size();
+    this->scatt_points_vector.reserve(num_scatter_points);
+  }
+  for (std::size_t i=0; i<scatt_points_per_plane.size(); ++i)
+    this->scatt_points_vector.insert(this->scatt_points_vector.end(),
+                                     scatt_points_per_plane[i].begin(), scatt_points_per_plane[i].end());
   this->remove_cache_for_integrals_over_activity();
   this->remove_cache_for_integrals_over_attenuation();
 }
@@ -62,6 +62,34 @@ find_in_detection_points_vector(const CartesianCoordinate3D<float>& coord) const
   return ret_value;
 }
 
+void
+ScatterEstimationByBin::
+set_up_detection_points_vector()
+{
+  // nothing to do if all detectors have been found already (e.g. by a previous run)
+  if (this->detection_points_vector.size() == static_cast<std::size_t>(this->total_detectors))
+    return;
+
+  Bin bin;
+  for (bin.segment_num()=this->proj_data_info_ptr->get_min_segment_num();
+       bin.segment_num()<=this->proj_data_info_ptr->get_max_segment_num();
+       ++bin.segment_num())
+    for (bin.view_num()=this->proj_data_info_ptr->get_min_view_num();
+         bin.view_num()<=this->proj_data_info_ptr->get_max_view_num();
+         ++bin.view_num())
+      for (bin.axial_pos_num()=this->proj_data_info_ptr->get_min_axial_pos_num(bin.segment_num());
+           bin.axial_pos_num()<=this->proj_data_info_ptr->get_max_axial_pos_num(bin.segment_num());
+           ++bin.axial_pos_num())
+        for (bin.tangential_pos_num()=this->proj_data_info_ptr->get_min_tangential_pos_num();
+             bin.tangential_pos_num()<=this->proj_data_info_ptr->get_max_tangential_pos_num();
+             ++bin.tangential_pos_num())
+          {
+            unsigned det_num_A = 0; // initialise to avoid compiler warnings
+            unsigned det_num_B = 0;
+            this->find_detectors(det_num_A, det_num_B, bin);
+          }
+}
+
 void
 ScatterEstimationByBin::
 find_detectors(unsigned& det_num_A, unsigned& det_num_B, const Bin& bin) const
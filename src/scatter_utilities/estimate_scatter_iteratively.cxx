@@ -0,0 +1,51 @@
+/*
+  Copyright (C) 2026, STIR contributors
+  This file is part of STIR.
+
+  This file is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation; either version 2.1 of the License, or
+  (at your option) any later version.
+
+  This file is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details. 
+
+  See STIR/LICENSE.txt for details
+*/
+/*!
+  \file
+  \ingroup utilities
+  \ingroup scatter
+  \brief Estimates the scatter by alternating reconstruction and scatter simulation
+
+  \author STIR contributors
+  
+  \par Usage:
+  \code
+  estimate_scatter_iteratively parfile
+  \endcode
+  See stir::IterativeScatterEstimation documentation for the format
+  of the parameter file.
+*/
+
+#include "stir/scatter/IterativeScatterEstimation.h"
+#include "stir/Succeeded.h"
+/***********************************************************/     
+
+int main(int argc, const char *argv[])                                  
+{         
+  stir::IterativeScatterEstimation scatter_estimation;
+
+  if (argc==2)
+    {
+      if (scatter_estimation.parse(argv[1]) == false)
+        return EXIT_FAILURE;
+    }
+  else
+    scatter_estimation.ask_parameters();
+
+  return scatter_estimation.process_data() == stir::Succeeded::yes ?
+    EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -5,6 +5,7 @@ dir := scatter_utilities
 $(dir)_SOURCES := \
 	estimate_scatter.cxx \
 	create_tail_mask_from_ACFs.cxx \
-	upsample_and_fit_single_scatter.cxx
+	upsample_and_fit_single_scatter.cxx \
+	estimate_scatter_iteratively.cxx
 
 include $(WORKSPACE)/exe.mk
@@ -10,7 +10,8 @@ $(dir)_TEST_SOURCES := \
 	test_BSplines.cxx \
 	test_BSplinesRegularGrid1D.cxx \
 	test_BSplinesRegularGrid.cxx \
-	test_erf.cxx
+	test_erf.cxx \
+	test_fourier.cxx
 
 
 
@@ -27,6 +28,9 @@ ${DEST}$(dir)/test_overlap_interpolate: ${DEST}$(dir)/test_overlap_interpolate${
 ${DEST}$(dir)/test_integrate_discrete_function: ${DEST}$(dir)/test_integrate_discrete_function${O_SUFFIX} $(STIR_LIB) 
 	$(LINK) $(EXE_OUTFLAG)$(@)$(EXE_SUFFIX) $< $(STIR_LIB)  $(LINKFLAGS) $(SYS_LIBS)
 
+${DEST}$(dir)/test_fourier: ${DEST}$(dir)/test_fourier${O_SUFFIX} $(STIR_LIB) 
+	$(LINK) $(EXE_OUTFLAG)$(@)$(EXE_SUFFIX) $< $(STIR_LIB)  $(LINKFLAGS) $(SYS_LIBS)
+
 ifeq ("$(FAST_test)","")
 
 ${DEST}$(dir)/test_BSplinesRegularGrid: ${DEST}$(dir)/test_BSplinesRegularGrid$(O_SUFFIX) $(STIR_LIB) 
@@ -0,0 +1,289 @@
+/*
+    Copyright (C) 2026, STIR contributors
+    This file is part of STIR.
+
+    This file is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.
+
+    This file is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    See STIR/LICENSE.txt for details
+*/
+/*!
+  \file
+  \ingroup numerics_test
+  \brief tests the functions in the DFT group, comparing with a direct implementation
+  of the discrete fourier transform
+
+  \author STIR contributors
+
+*/
+
+#include "stir/RunTests.h"
+#include "stir/numerics/fourier.h"
+#include "stir/numerics/norm.h"
+#include "stir/Array.h"
+#include "stir/IndexRange2D.h"
+#include "stir/IndexRange3D.h"
+#include <boost/format.hpp>
+#include <complex>
+#include <algorithm>
+#include <cstdlib>
+
+START_NAMESPACE_STIR
+
+/*!
+  \ingroup numerics_test
+  \brief A simple class to test the DFT functions.
+
+  Results are compared with a direct (i.e. O(n^2)) computation of the DFT, for
+  lengths which are a power of 2, and others.
+*/
+class FourierTests : public RunTests
+{
+public:
+  void run_tests();
+private:
+  typedef std::complex<float> complex_t;
+
+  static float rand1()
+  { return 2*(std::rand()-RAND_MAX/2.F)/RAND_MAX; }
+
+  static Array<1,complex_t> random_complex_array(const int length);
+  static Array<1,complex_t> direct_dft(const Array<1,complex_t>& c, const int sign);
+
+  //! checks if the norm of the difference is small compared to the norm of \a reference
+  template <class ArrayT>
+  bool check_if_close(const ArrayT& result, const ArrayT& reference, const std::string& str)
+  {
+    ArrayT diff = result;
+    diff -= reference;
+    return
+      check(norm(diff.begin_all(), diff.end_all()) <=
+            1.E-4*(norm(reference.begin_all(), reference.end_all())+1.E-10),
+            str);
+  }
+
+  void test_1d(const int length, const int sign);
+  void test_real_1d(const int length, const int sign);
+  void test_2d(const int num_rows, const int num_columns, const int sign);
+  void test_real_3d(const int num_planes, const int num_rows, const int num_columns, const int sign);
+  void test_multithreaded();
+};
+
+Array<1,std::complex<float> >
+FourierTests::
+random_complex_array(const int length)
+{
+  Array<1,complex_t> c(length);
+  for (int i=0; i<length; ++i)
+    c[i] = complex_t(rand1(), rand1());
+  return c;
+}
+
+Array<1,std::complex<float> >
+FourierTests::
+direct_dft(const Array<1,complex_t>& c, const int sign)
+{
+  const int n = c.get_length();
+  Array<1,complex_t> result(n);
+  for (int s=0; s<n; ++s)
+    {
+      std::complex<double> sum = 0;
+      for (int r=0; r<n; ++r)
+        sum +=
+          std::complex<double>(c[r].real(), c[r].imag()) *
+          std::exp(std::complex<double>(0, (sign*2*_PI*((r*s)%n))/n));
+      result[s] = complex_t(static_cast<float>(sum.real()), static_cast<float>(sum.imag()));
+    }
+  return result;
+}
+
+void
+FourierTests::
+test_1d(const int length, const int sign)
+{
+  const Array<1,complex_t> c = random_complex_array(length);
+  Array<1,complex_t> result = c;
+  fourier(result, sign);
+  check_if_close(result, direct_dft(c, sign),
+                 boost::str(boost::format("fourier: length %1%, sign %2%") % length % sign));
+  inverse_fourier(result, sign);
+  check_if_close(result, c,
+                 boost::str(boost::format("inverse_fourier: length %1%, sign %2%") % length % sign));
+}
+
+void
+FourierTests::
+test_real_1d(const int length, const int sign)
+{
+  Array<1,float> v(length);
+  for (int i=0; i<length; ++i)
+    v[i] = rand1();
+  Array<1,complex_t> c(length);
+  std::copy(v.begin(), v.end(), c.begin());
+
+  const Array<1,complex_t> pos_frequencies = fourier_1d_for_real_data(v, sign);
+  check_if_close(pos_frequencies_to_all(pos_frequencies), direct_dft(c, sign),
+                 boost::str(boost::format("fourier_1d_for_real_data: length %1%, sign %2%") % length % sign));
+  check_if_close(inverse_fourier_1d_for_real_data(pos_frequencies, sign), v,
+                 boost::str(boost::format("inverse_fourier_1d_for_real_data: length %1%, sign %2%") % length % sign));
+}
+
+void
+FourierTests::
+test_2d(const int num_rows, const int num_columns, const int sign)
+{
+  Array<2,complex_t> c(IndexRange2D(num_rows, num_columns));
+  Array<2,float> v(IndexRange2D(num_rows, num_columns));
+  for (int i=0; i<num_rows; ++i)
+    {
+      c[i] = random_complex_array(num_columns);
+      for (int j=0; j<num_columns; ++j)
+        v[i][j] = rand1();
+    }
+  // direct DFT, first on the rows, then on the columns
+  Array<2,complex_t> reference(c.get_index_range());
+  for (int i=0; i<num_rows; ++i)
+    reference[i] = direct_dft(c[i], sign);
+  for (int j=0; j<num_columns; ++j)
+    {
+      Array<1,complex_t> column(num_rows);
+      for (int i=0; i<num_rows; ++i)
+        column[i] = reference[i][j];
+      column = direct_dft(column, sign);
+      for (int i=0; i<num_rows; ++i)
+        reference[i][j] = column[i];
+    }
+  Array<2,complex_t> result = c;
+  fourier(result, sign);
+  check_if_close(result, reference,
+                 boost::str(boost::format("fourier 2D: sizes %1%x%2%, sign %3%") % num_rows % num_columns % sign));
+
+  if (num_columns%2 != 0)
+    return;
+
+  // real data
+  Array<2,complex_t> v_complex(v.get_index_range());
+  std::copy(v.begin_all(), v.end_all(), v_complex.begin_all());
+  fourier(v_complex, sign);
+  const Array<2,complex_t> pos_frequencies = fourier_for_real_data(v, sign);
+  check_if_close(pos_frequencies_to_all(pos_frequencies), v_complex,
+                 boost::str(boost::format("fourier_for_real_data 2D: sizes %1%x%2%, sign %3%") % num_rows % num_columns % sign));
+  check_if_close(inverse_fourier_for_real_data(pos_frequencies, sign), v,
+                 boost::str(boost::format("inverse_fourier_for_real_data 2D: sizes %1%x%2%, sign %3%") % num_rows % num_columns % sign));
+
+  // rows
+  {
+    const Array<2,complex_t> rows_result = fourier_1d_for_real_data_of_rows(v, sign);
+    check(rows_result.get_index_range() == IndexRange2D(num_rows, num_columns/2+1),
+          "fourier_1d_for_real_data_of_rows: index range");
+    for (int i=0; i<num_rows; ++i)
+      check_if_close(rows_result[i], fourier_1d_for_real_data(v[i], sign),
+                     "fourier_1d_for_real_data_of_rows: comparison with fourier_1d_for_real_data");
+    Array<2,complex_t> rows_copy = rows_result;
+    check_if_close(inverse_fourier_1d_for_real_data_of_rows_corrupting_input(rows_copy, sign), v,
+                   "inverse_fourier_1d_for_real_data_of_rows_corrupting_input");
+  }
+}
+
+void
+FourierTests::
+test_real_3d(const int num_planes, const int num_rows, const int num_columns, const int sign)
+{
+  Array<3,float> v(IndexRange3D(num_planes, num_rows, num_columns));
+  for (Array<3,float>::full_iterator iter = v.begin_all(); iter != v.end_all(); ++iter)
+    *iter = rand1();
+  Array<3,complex_t> v_complex(v.get_index_range());
+  std::copy(v.begin_all(), v.end_all(), v_complex.begin_all());
+  fourier(v_complex, sign);
+
+  const Array<3,complex_t> pos_frequencies = fourier_for_real_data(v, sign);
+  check_if_close(pos_frequencies_to_all(pos_frequencies), v_complex,
+                 boost::str(boost::format("fourier_for_real_data 3D: sizes %1%x%2%x%3%") % num_planes % num_rows % num_columns));
+  check_if_close(inverse_fourier_for_real_data(pos_frequencies, sign), v,
+                 boost::str(boost::format("inverse_fourier_for_real_data 3D: sizes %1%x%2%x%3%") % num_planes % num_rows % num_columns));
+}
+
+void
+FourierTests::
+test_multithreaded()
+{
+  // different threads use (and hence create) the plans for different lengths at the same time
+  const int num_arrays = 64;
+  VectorWithOffset<Array<1,complex_t> > arrays(num_arrays);
+  VectorWithOffset<Array<1,complex_t> > results(num_arrays);
+  for (int i=0; i<num_arrays; ++i)
+    {
+      arrays[i] = random_complex_array(200 + 3*(i%16));
+      results[i] = arrays[i];
+    }
+#ifdef STIR_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for (int i=0; i<num_arrays; ++i)
+    fourier(results[i]);
+
+  for (int i=0; i<num_arrays; ++i)
+    check_if_close(results[i], direct_dft(arrays[i], 1),
+                   boost::str(boost::format("fourier in parallel: length %1%") % arrays[i].get_length()));
+}
+
+void
+FourierTests::
+run_tests()
+{
+  std::cerr << "Testing DFT functions..." << std::endl;
+
+  std::cerr << "... 1D complex" << std::endl;
+  for (int length=1; length<=40; ++length)
+    {
+      test_1d(length, 1);
+      test_1d(length, -1);
+    }
+  test_1d(128, 1);
+  test_1d(97, 1);
+  test_1d(360, -1);
+
+  std::cerr << "... 1D real" << std::endl;
+  for (int length=2; length<=40; length+=2)
+    {
+      test_real_1d(length, 1);
+      test_real_1d(length, -1);
+    }
+  test_real_1d(256, 1);
+  test_real_1d(300, -1);
+
+  std::cerr << "... 2D" << std::endl;
+  test_2d(8, 16, 1);
+  test_2d(6, 10, -1);
+  test_2d(9, 7, 1);
+  test_2d(15, 12, 1);
+
+  std::cerr << "... 3D real" << std::endl;
+  test_real_3d(4, 8, 16, 1);
+  test_real_3d(3, 5, 12, -1);
+
+  std::cerr << "... multi-threaded" << std::endl;
+  test_multithreaded();
+}
+
+END_NAMESPACE_STIR
+USING_NAMESPACE_STIR
+
+int main(int argc, char **argv)
+{
+  if (argc != 1)
+  {
+    std::cerr << "Usage : " << argv[0] << " \n";
+    return EXIT_FAILURE;
+  }
+  FourierTests tests;
+  tests.run_tests();
+  return tests.main_return_value();
+}
@@ -10,6 +10,7 @@ $(dir)_TEST_SOURCES := test_Array.cxx test_NestedIterator.cxx \
 	test_coordinates.cxx \
 	test_linear_regression.cxx \
 	test_filename_functions.cxx \
+	test_cache_file.cxx \
 	test_coordinates.cxx \
 	test_VoxelsOnCartesianGrid.cxx \
 	test_zoom_image.cxx \
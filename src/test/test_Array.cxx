@@ -465,6 +465,37 @@ ArrayTests::run_tests()
       check_if_equal(test2.size(), size_t(3), "test size() with irregular range");
       check_if_equal(test2.size_all(), size_t(6+2), "test size_all() with irregular range");
     }
+    // contiguous storage
+    {
+      const IndexRange<2> range(Coordinate2D<int>(-1,1),Coordinate2D<int>(1,3));
+      Array<2,float> test2(range);
+      check(test2.is_contiguous(), "test is_contiguous() with regular range");
+      test2[0][2] = 2.F;
+      test2[1][3] = 3.F;
+      {
+        const float * data_ptr = test2.get_const_full_data_ptr();
+        check_if_equal(data_ptr[3+1], 2.F, "test get_const_full_data_ptr() [0][2]");
+        check_if_equal(data_ptr[6+2], 3.F, "test get_const_full_data_ptr() [1][3]");
+        check_if_equal(reinterpret_cast<std::size_t>(data_ptr) % detail::array_data_alignment, std::size_t(0),
+                       "test alignment of get_const_full_data_ptr()");
+        test2.release_const_full_data_ptr();
+      }
+      Array<2,float> copy(test2);
+      check(copy.is_contiguous(), "test is_contiguous() after copy constructor");
+      check_if_equal(copy, test2, "test copy constructor of contiguous array");
+      Array<2,float> assigned;
+      assigned = test2;
+      check(assigned.is_contiguous(), "test is_contiguous() after assignment");
+      check_if_equal(assigned, test2, "test assignment of contiguous array");
+
+      test2[0].resize(-1,3);
+      check(!test2.is_contiguous(), "test is_contiguous() after resizing a row");
+      check_if_equal(test2[0][2], 2.F, "test value after resizing a row");
+      check_if_equal(test2[1][3], 3.F, "test value after resizing a row");
+      test2.resize(range);
+      check(test2.is_contiguous(), "test is_contiguous() after resize to regular range");
+      check_if_equal(test2, copy, "test values after resize to regular range");
+    }
     // full iterator
     {
       IndexRange<2> range(Coordinate2D<int>(0,0),Coordinate2D<int>(2,2));
@@ -0,0 +1,151 @@
+/*!
+
+  \file
+  \ingroup test
+
+  \brief Test program for the cache file functions defined in cache_file.h
+
+  \author STIR contributors
+*/
+/*
+    Copyright (C) 2026, STIR contributors
+    This file is part of STIR.
+
+    This file is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.
+
+    This file is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    See STIR/LICENSE.txt for details
+*/
+#include "stir/cache_file.h"
+#include "stir/Succeeded.h"
+#include "stir/RunTests.h"
+#include <fstream>
+#include <vector>
+#include <string>
+#include <cstdio>
+
+#ifndef STIR_NO_NAMESPACES
+using std::cerr;
+using std::endl;
+using std::string;
+#endif
+
+START_NAMESPACE_STIR
+
+/*!
+  \brief Test class for the cache file functions defined in cache_file.h
+  \ingroup test
+*/
+class CacheFileTests : public RunTests
+{
+public:
+  void run_tests();
+private:
+  //! writes a cache file with the given description and data
+  Succeeded write(const string& filename, const string& description,
+                  const std::vector<float>& data);
+  //! reads the header of the cache file and returns the data size
+  Succeeded read_header(const string& filename, const boost::uint32_t version,
+                        const string& description, boost::uint64_t& data_size);
+};
+
+namespace {
+  const char test_magic[8] = { 'S','T','I','R','T','S','T','\0' };
+  const boost::uint32_t test_version = 3;
+  const boost::uint32_t test_flags = 5;
+}
+
+Succeeded
+CacheFileTests::
+write(const string& filename, const string& description,
+      const std::vector<float>& data)
+{
+  std::ofstream s;
+  const string tmp_filename = open_cache_file_for_writing(s, filename);
+  if (tmp_filename.empty())
+    return Succeeded::no;
+  write_cache_file_header(s, test_magic, test_version, test_flags,
+                          data.size()*sizeof(float), description);
+  s.write(reinterpret_cast<const char *>(&data[0]), data.size()*sizeof(float));
+  return finish_writing_cache_file(s, tmp_filename, filename);
+}
+
+Succeeded
+CacheFileTests::
+read_header(const string& filename, const boost::uint32_t version,
+            const string& description, boost::uint64_t& data_size)
+{
+  std::ifstream s(filename.c_str(), std::ios::in | std::ios::binary);
+  boost::uint32_t flags;
+  return read_cache_file_header(s, test_magic, version, description, flags, data_size);
+}
+
+void CacheFileTests::run_tests()
+{
+  cerr << "Testing cache file functions" << endl;
+
+  const string filename = "test_cache_file.cache";
+  const string description = "test description\nwith a second line\n";
+  std::vector<float> data(37);
+  for (std::size_t i=0; i<data.size(); ++i)
+    data[i] = static_cast<float>(i)*1.5F - 3.F;
+
+  check(write(filename, description, data) == Succeeded::yes, "writing the cache file");
+
+  {
+    std::ifstream s(filename.c_str(), std::ios::in | std::ios::binary);
+    boost::uint32_t flags;
+    boost::uint64_t data_size;
+    check(read_cache_file_header(s, test_magic, test_version, description, flags, data_size) == Succeeded::yes,
+          "reading the header");
+    check_if_equal(flags, test_flags, "flags");
+    check_if_equal(static_cast<std::size_t>(data_size), data.size()*sizeof(float), "data size");
+    check_if_equal(static_cast<std::size_t>(s.tellg()), get_cache_file_header_size(description),
+                   "start of the data");
+    check_if_equal(get_cache_file_header_size(description) % 16, std::size_t(0),
+                   "alignment of the data");
+    std::vector<float> data_in_file(data.size());
+    s.read(reinterpret_cast<char *>(&data_in_file[0]), data.size()*sizeof(float));
+    check(!s.fail(), "reading the data");
+    check(data_in_file == data, "data");
+  }
+
+  boost::uint64_t data_size;
+  check(read_header(filename, test_version+1, description, data_size) == Succeeded::no,
+        "a different version should not be accepted");
+  check(read_header(filename, test_version, description + "x", data_size) == Succeeded::no,
+        "a different description should not be accepted");
+  check(read_header(filename, test_version, "test description\nwith a second lin3\n", data_size) == Succeeded::no,
+        "a description of the same size but different content should not be accepted");
+
+  {
+    // truncate the file, as if writing had been interrupted
+    std::vector<float> shorter_data(data.begin(), data.end()-1);
+    std::ofstream s(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    write_cache_file_header(s, test_magic, test_version, test_flags, data.size()*sizeof(float), description);
+    s.write(reinterpret_cast<const char *>(&shorter_data[0]), shorter_data.size()*sizeof(float));
+  }
+  check(read_header(filename, test_version, description, data_size) == Succeeded::no,
+        "an incomplete file should not be accepted");
+
+  check(get_file_signature(filename) != "file not found", "signature of an existing file");
+  std::remove(filename.c_str());
+  check(get_file_signature(filename) == "file not found", "signature of a file that does not exist");
+}
+
+END_NAMESPACE_STIR
+
+USING_NAMESPACE_STIR
+int main()
+{
+  CacheFileTests tests;
+  tests.run_tests();
+  return tests.main_return_value();
+}
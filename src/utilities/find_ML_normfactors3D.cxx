@@ -85,17 +85,26 @@ int main(int argc, char **argv)
   BlockData3D norm_block_data(num_axial_blocks, num_transaxial_blocks,
                               num_axial_blocks-1, num_transaxial_blocks-1);
   {
-    // next could be local if KL is not computed below
+    // only needed if KL is computed below
     FanProjData measured_fan_data;
-    float threshold_for_KL;
+    float threshold_for_KL = 0;
     // compute factors dependent on the data
     {
-      make_fan_data(measured_fan_data, *measured_data);
-      threshold_for_KL = measured_fan_data.find_max()/100000.F;
-      //display(measured_fan_data, "measured data");
+      if (do_KL)
+        {
+          make_fan_data(measured_fan_data, *measured_data);
+          threshold_for_KL = measured_fan_data.find_max()/100000.F;
+          //display(measured_fan_data, "measured data");
       
-      make_fan_sum_data(data_fan_sums, measured_fan_data);
-      make_block_data(measured_block_data, measured_fan_data);
+          make_fan_sum_data(data_fan_sums, measured_fan_data);
+          make_block_data(measured_block_data, measured_fan_data);
+        }
+      else
+        {
+          // avoid keeping the measured data in memory
+          make_fan_sum_data(data_fan_sums, *measured_data);
+          make_block_data(measured_block_data, *measured_data);
+        }
       if (do_display)
         display(measured_block_data, "raw block data from measurements");	
       